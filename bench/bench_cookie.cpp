@@ -0,0 +1,114 @@
+/*
+ * bench_cookie.cpp - Cookie jar lookup benchmark
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Download workers asking the jar for a Cookie header while responses feed
+// Set-Cookie back into it, as DownloadManager does: most responses resend the
+// cookies the jar already has, and now and then one carries a new value.
+//
+// Usage: bench_cookie [seconds per run] [max threads]
+
+#include "efgrabber/cookie.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace efgrabber;
+
+namespace {
+
+const char* const FILE_URL = "https://www.justice.gov/epstein/files/DataSet%2011/EFTA02205655.pdf";
+
+void fill_jar(CookieJar& jar) {
+    // Roughly what a browser session on justice.gov carries (Akamai, Drupal, age gate)
+    jar.add_from_cookie_string("justiceGovAgeVerified=true; QueueITAccepted-SDFrts345E-V3_usdojfiles="
+                               "EventId%3Dusdojfiles%26RedirectType%3Dsafetynet", "www.justice.gov");
+    for (int i = 0; i < 12; ++i) {
+        jar.add_from_header("Set-Cookie: ak_cookie_" + std::to_string(i) + "=" + std::string(48, 'a' + i) +
+                            "; Domain=.justice.gov; Path=/; Secure", "www.justice.gov");
+    }
+}
+
+void run(int threads, double seconds) {
+    CookieJar jar;
+    fill_jar(jar);
+
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> lookups{0};
+    std::atomic<int64_t> length{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            int64_t n = 0;
+            size_t bytes = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                bytes += jar.get_cookies_for_url(FILE_URL).size();
+                ++n;
+            }
+            lookups += n;
+            length += static_cast<int64_t>(bytes / std::max<int64_t>(n, 1));
+        });
+    }
+
+    // One response thread: the same cookies every 100 us, a new bm_sv value every 50 ms
+    std::thread responses([&]() {
+        int round = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            jar.add_from_header("Set-Cookie: ak_cookie_3=" + std::string(48, 'd') +
+                                "; Domain=.justice.gov; Path=/; Secure", "www.justice.gov");
+            if (++round % 500 == 0) {
+                jar.add_from_header("Set-Cookie: bm_sv=" + std::to_string(round) +
+                                    "; Domain=.justice.gov; Path=/; Secure", "www.justice.gov");
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) worker.join();
+    responses.join();
+
+    double rate = static_cast<double>(lookups.load()) / seconds;
+    std::printf("  %4d threads %14.0f lookups/s %10.1f ns/lookup/thread  (%lld byte header)\n",
+                threads, rate, threads * 1e9 / rate, static_cast<long long>(length.load() / threads));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+    if (seconds <= 0) seconds = 1.0;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : 64;
+    if (max_threads <= 0) max_threads = 64;
+
+    std::printf("%.1f s per run, %u hardware threads\n\n", seconds, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= max_threads; threads *= 4) {
+        run(threads, seconds);
+    }
+    return 0;
+}
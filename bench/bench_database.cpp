@@ -0,0 +1,202 @@
+/*
+ * bench_database.cpp - Prepared statement cache micro-benchmark
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares the per-call prepare/step/finalize pattern Database used to follow
+// against the cached statements it uses now, on the same database and queries,
+// and the per-record file_exists() dedup enqueueing used to do against the
+// KnownIdIndex it uses now.
+//
+// Usage: bench_database [iterations]
+
+#include "efgrabber/database.h"
+#include "efgrabber/known_id_index.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace efgrabber;
+
+namespace {
+
+constexpr int DATA_SET = 1;
+constexpr int FILE_COUNT = 10000;
+
+std::string make_file_id(int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "EFTA%08d", i);
+    return buf;
+}
+
+double run(const char* label, int iterations, const std::function<void(int)>& body,
+           const char* unit = "stmt/s") {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double rate = iterations / elapsed.count();
+    std::printf("  %-28s %12.0f %s\n", label, rate, unit);
+    return rate;
+}
+
+// One prepare/bind/step/finalize round trip, as the uncached code did
+bool uncached_exists(sqlite3* db, const std::string& file_id) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM files WHERE file_id = ? AND data_set = ? LIMIT 1",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, file_id.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, DATA_SET);
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+bool uncached_update(sqlite3* db, int64_t id) {
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = R"(
+        UPDATE files SET status = ?, error_message = ?, file_size = ?,
+                        lease_owner = NULL, lease_expires = 0,
+                        updated_at = datetime('now')
+        WHERE id = ?
+    )";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, "COMPLETED", -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, "", -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, 1024);
+    sqlite3_bind_int64(stmt, 4, id);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+void report(const char* name, double before, double after) {
+    std::printf("  %-28s %11.2fx\n\n", name, after / before);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    if (iterations <= 0) iterations = 200000;
+
+    auto path = std::filesystem::temp_directory_path() / "efgrabber_bench_database.db";
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + "-wal");
+    std::filesystem::remove(path.string() + "-shm");
+
+    Database db(path.string());
+    if (!db.initialize()) {
+        std::cerr << "initialize failed: " << db.get_last_error() << std::endl;
+        return 1;
+    }
+
+    std::vector<FileRecord> records;
+    for (int i = 1; i <= FILE_COUNT; ++i) {
+        FileRecord record;
+        record.data_set = DATA_SET;
+        record.file_id = make_file_id(i);
+        record.url = "https://example.invalid/" + record.file_id + ".pdf";
+        record.local_path = "/tmp/" + record.file_id + ".pdf";
+        records.push_back(std::move(record));
+    }
+    db.add_files_batch(records);
+    db.add_pages_batch(DATA_SET, 0, 100);
+
+    // Second connection for the uncached baseline, same file and settings
+    sqlite3* raw = nullptr;
+    if (sqlite3_open(path.string().c_str(), &raw) != SQLITE_OK) {
+        std::cerr << "open failed" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < FILE_COUNT; ++i) ids.push_back(make_file_id(i + 1));
+
+    std::printf("%d iterations, %d files\n\n", iterations, FILE_COUNT);
+
+    std::printf("file_exists\n");
+    double before = run("prepare per call", iterations,
+                        [&](int i) { uncached_exists(raw, ids[i % FILE_COUNT]); });
+    double after = run("cached statement", iterations,
+                       [&](int i) { db.file_exists(ids[i % FILE_COUNT], DATA_SET); });
+    report("speedup", before, after);
+
+    // Updates are wrapped in one transaction each side so fsync doesn't dominate
+    int update_iterations = iterations / 4 > 0 ? iterations / 4 : 1;
+    std::printf("update_file_status\n");
+    sqlite3_exec(raw, "BEGIN", nullptr, nullptr, nullptr);
+    before = run("prepare per call", update_iterations,
+                 [&](int i) { uncached_update(raw, i % FILE_COUNT + 1); });
+    sqlite3_exec(raw, "COMMIT", nullptr, nullptr, nullptr);
+    db.begin_transaction();
+    after = run("cached statement", update_iterations,
+                [&](int i) { db.update_file_status(i % FILE_COUNT + 1, DownloadStatus::COMPLETED, "", 1024); });
+    db.commit_transaction();
+    report("speedup", before, after);
+
+    sqlite3_close(raw);
+
+    // A scraped page's worth of links, half of them already in the files table
+    constexpr int PAGE_LINKS = 50;
+    std::vector<FileRecord> page(PAGE_LINKS);
+    for (int i = 0; i < PAGE_LINKS; ++i) {
+        page[i].data_set = DATA_SET;
+        page[i].file_id = make_file_id(FILE_COUNT - PAGE_LINKS / 2 + i + 1);
+    }
+    int page_iterations = iterations / PAGE_LINKS > 0 ? iterations / PAGE_LINKS : 1;
+    std::printf("enqueue dedup (%d links per page)\n", PAGE_LINKS);
+    before = run("file_exists per link", page_iterations, [&](int) {
+        for (const auto& record : page) db.file_exists(record.file_id, DATA_SET);
+    }, "pages/s");
+    KnownIdIndex known_ids;
+    auto load_start = std::chrono::steady_clock::now();
+    known_ids.load(db);
+    std::chrono::duration<double> load_elapsed = std::chrono::steady_clock::now() - load_start;
+    after = run("known ID index", page_iterations, [&](int) {
+        std::vector<FileRecord> batch = page;
+        known_ids.insert_new(batch);
+        known_ids.erase(batch);
+    }, "pages/s");
+    report("speedup", before, after);
+    std::printf("  %-28s %12.1f ms\n\n", "index load", load_elapsed.count() * 1000);
+
+    // get_stats runs three statements per call, dominated by the GROUP BY scan
+    std::printf("get_stats (3 statements per call)\n");
+    run("cached statement", iterations / 100 > 0 ? iterations / 100 : 1,
+        [&](int) { db.get_stats(DATA_SET); }, "calls/s");
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + "-wal");
+    std::filesystem::remove(path.string() + "-shm");
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * bench_events.cpp - Manager-to-UI event delivery benchmark
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares the two ways DownloadManager can hand file status changes to the
+// UI: a std::function callback called under the callback mutex, as every
+// status change used to be, and a push into the EventChannel. Several
+// producer threads stand in for download workers; one consumer drains the
+// channel the way the GUI's log flush timer does.
+//
+// Usage: bench_events [events per thread] [threads]
+
+#include "efgrabber/event_channel.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace efgrabber;
+
+namespace {
+
+std::vector<std::string> make_ids(int count) {
+    std::vector<std::string> ids;
+    ids.reserve(count);
+    char id[16];
+    for (int i = 0; i < count; ++i) {
+        std::snprintf(id, sizeof(id), "EFTA%08d", 2205655 + i);
+        ids.emplace_back(id);
+    }
+    return ids;
+}
+
+double run(const char* label, int threads, int per_thread, const std::function<void(int)>& producer) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(producer, t);
+    }
+    for (auto& worker : workers) worker.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double rate = static_cast<double>(threads) * per_thread / elapsed.count() / 1e6;
+    std::printf("  %-10s %10.2f M events/s\n", label, rate);
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int per_thread = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 4;
+    if (per_thread <= 0) per_thread = 1000000;
+    if (threads <= 0) threads = 4;
+
+    auto ids = make_ids(4096);
+    std::printf("%d threads x %d events\n\n", threads, per_thread);
+
+    // The callback does what the GUI's used to: a level check and a counter
+    std::mutex callback_mutex;
+    uint64_t delivered = 0;
+    std::function<void(const std::string&, DownloadStatus)> on_file_status_change =
+        [&](const std::string&, DownloadStatus status) {
+            if (status == DownloadStatus::COMPLETED) delivered++;
+        };
+    double before = run("callback", threads, per_thread, [&](int t) {
+        for (int i = 0; i < per_thread; ++i) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            on_file_status_change(ids[(t + i) & 4095], DownloadStatus::COMPLETED);
+        }
+    });
+
+    EventChannel channel;
+    std::atomic<bool> producing{true};
+    uint64_t drained = 0;
+    std::thread consumer([&]() {
+        std::vector<ManagerEvent> batch;
+        batch.reserve(channel.capacity());
+        for (;;) {
+            bool last = !producing.load(std::memory_order_acquire);
+            batch.clear();
+            size_t count = channel.drain(batch);
+            drained += count;
+            if (count > 0) continue;
+            if (last) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    double after = run("channel", threads, per_thread, [&](int t) {
+        for (int i = 0; i < per_thread; ++i) {
+            channel.push(ManagerEvent::file_status(ids[(t + i) & 4095], DownloadStatus::COMPLETED));
+        }
+    });
+    producing.store(false, std::memory_order_release);
+    consumer.join();
+
+    std::printf("  %-10s %10.1fx\n", "speedup", after / before);
+    std::printf("\n  callback delivered %llu, channel drained %llu, dropped %llu\n",
+                static_cast<unsigned long long>(delivered),
+                static_cast<unsigned long long>(drained),
+                static_cast<unsigned long long>(channel.dropped()));
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * bench_scraper.cpp - Link extraction benchmark
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares the std::regex link extraction Scraper used to do against the
+// memchr() scanner it uses now, on a synthetic index page shaped like the
+// DOJ listing (navigation markup, 50 file rows, links to other data sets).
+//
+// Usage: bench_scraper [iterations]
+
+#include "efgrabber/scraper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace efgrabber;
+
+namespace {
+
+constexpr int DATA_SET = 11;
+
+// The regex extraction as Scraper implemented it before the scanner
+std::vector<PdfLink> regex_extract(const std::string& html, const DataSetConfig& config) {
+    static const std::regex link_regex(
+        R"(href\s*=\s*["']([^"']*(?:DataSet(?:%20|\s))" + std::to_string(DATA_SET) +
+        R"(/)[^"']*\.pdf)["'])", std::regex::icase | std::regex::optimize);
+    static const std::regex id_regex(R"(EFTA(\d{8}))", std::regex::optimize);
+
+    std::vector<PdfLink> links;
+    for (std::sregex_iterator it(html.begin(), html.end(), link_regex), end; it != end; ++it) {
+        std::string href = (*it)[1].str();
+        std::smatch id;
+        if (!std::regex_search(href, id, id_regex)) continue;
+
+        PdfLink link;
+        link.file_id = config.file_prefix + id[1].str();
+        if (href.find("http") != 0) {
+            link.url = "https://www." + std::string(TARGET_DOMAIN) + (href[0] == '/' ? "" : "/") + href;
+        } else {
+            link.url = href;
+        }
+        links.push_back(std::move(link));
+    }
+    std::sort(links.begin(), links.end(),
+              [](const PdfLink& a, const PdfLink& b) { return a.file_id < b.file_id; });
+    links.erase(std::unique(links.begin(), links.end(),
+                [](const PdfLink& a, const PdfLink& b) { return a.file_id == b.file_id; }),
+                links.end());
+    return links;
+}
+
+std::string make_page() {
+    std::string html = "<!DOCTYPE html><html><head><title>DataSet 11 | Epstein Files</title>";
+    for (int i = 0; i < 40; ++i) {
+        html += "<link rel=\"stylesheet\" href=\"/sites/default/files/css/css_" + std::to_string(i) +
+                ".css?delta=0&amp;language=en&amp;theme=doj\" media=\"all\" />\n";
+    }
+    html += "</head><body class=\"path-node page-node-type-page\">";
+    for (int i = 0; i < 300; ++i) {
+        html += "<li class=\"usa-nav__submenu-item\"><a href=\"/epstein/section-" + std::to_string(i) +
+                "\" data-drupal-link-system-path=\"node/" + std::to_string(10000 + i) +
+                "\" class=\"usa-nav__link\"><span>Menu entry " + std::to_string(i) + "</span></a></li>\n";
+    }
+    html += "<table class=\"usa-table\"><tbody>";
+    for (int i = 0; i < 50; ++i) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "%08d", 2205655 + i);
+        html += "<tr><td><a href=\"/epstein/files/DataSet%2011/EFTA";
+        html += id;
+        html += ".pdf\" type=\"application/pdf\" title=\"EFTA";
+        html += id;
+        html += ".pdf\">EFTA";
+        html += id;
+        html += ".pdf</a></td><td>PDF</td><td>1.2 MB</td></tr>\n";
+    }
+    for (int i = 0; i < 20; ++i) {
+        html += "<tr><td><a href=\"https://www.justice.gov/epstein/files/DataSet%201/EFTA0000";
+        html += std::to_string(1000 + i) + ".pdf\">other data set</a></td></tr>\n";
+    }
+    html += "</tbody></table>";
+    while (html.size() < 200 * 1024) {
+        html += "<p class=\"usa-footer__text\">The Department of Justice provides these records as "
+                "released under the Epstein Files Transparency Act; see <a href=\"/about\">about</a>.</p>\n";
+    }
+    html += "</body></html>";
+    return html;
+}
+
+double run(const char* label, int iterations, size_t bytes, const std::function<size_t()>& body) {
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        found += body();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double rate = static_cast<double>(bytes) * iterations / elapsed.count() / (1 << 20);
+    std::printf("  %-10s %10.1f MB/s %10.1f pages/s  (%zu links)\n", label, rate,
+                iterations / elapsed.count(), found / static_cast<size_t>(iterations));
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    if (iterations <= 0) iterations = 200;
+
+    DataSetConfig config = get_data_set_config(DATA_SET);
+    Scraper scraper(config);
+    std::string html = make_page();
+
+    auto expected = regex_extract(html, config);
+    auto actual = scraper.extract_pdf_links(html);
+    bool same = expected.size() == actual.size() &&
+                std::equal(expected.begin(), expected.end(), actual.begin(),
+                           [](const PdfLink& a, const PdfLink& b) {
+                               return a.file_id == b.file_id && a.url == b.url;
+                           });
+    if (!same) {
+        std::fprintf(stderr, "scanner and regex disagree (%zu vs %zu links)\n",
+                     actual.size(), expected.size());
+        return 1;
+    }
+
+    std::printf("%d iterations, %zu byte page\n\n", iterations, html.size());
+    double before = run("std::regex", std::max(1, iterations / 20), html.size(),
+                        [&]() { return regex_extract(html, config).size(); });
+    double after = run("scanner", iterations, html.size(),
+                       [&]() { return scraper.extract_pdf_links(html).size(); });
+    std::printf("  %-10s %10.1fx\n", "speedup", after / before);
+    return 0;
+}
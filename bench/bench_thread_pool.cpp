@@ -0,0 +1,218 @@
+/*
+ * bench_thread_pool.cpp - Thread pool submission benchmark
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Submits tasks shaped like DownloadManager's (a lambda capturing a
+// FileRecord) to the single-queue pool ThreadPool used to be and to the
+// work-stealing one. The dispatcher keeps at most two tasks per thread
+// outstanding, as download_worker() does with its slots, or leaves that to
+// the pool's own bound. The fan-out case submits from the workers
+// themselves. Heap allocations are counted through a replaced operator new.
+//
+// Usage: bench_thread_pool [tasks] [threads]
+
+#include "efgrabber/common.h"
+#include "efgrabber/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace efgrabber;
+
+namespace {
+std::atomic<size_t> allocations{0};
+}
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// ThreadPool as it was: one std::function queue behind one mutex
+class LegacyPool {
+public:
+    explicit LegacyPool(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { worker(); });
+        }
+    }
+
+    ~LegacyPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    void submit_detached(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    void worker() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_ = false;
+};
+
+FileRecord make_record() {
+    FileRecord record{};
+    record.id = 1;
+    record.data_set = 11;
+    record.file_id = "EFTA02205655";
+    record.url = "https://www.justice.gov/epstein/files/DataSet%2011/EFTA02205655.pdf";
+    record.local_path = "downloads/DataSet11/022/EFTA02205655.pdf";
+    record.status = DownloadStatus::IN_PROGRESS;
+    return record;
+}
+
+// Waits until count tasks have run
+struct Latch {
+    std::atomic<size_t> done{0};
+    void wait(size_t count) const {
+        while (done.load(std::memory_order_acquire) < count) std::this_thread::yield();
+    }
+};
+
+// outstanding = 0 submits as fast as the pool accepts
+template<typename Pool>
+void run_flat(const char* label, Pool& pool, size_t tasks, size_t outstanding) {
+    const FileRecord record = make_record();
+    Latch latch;
+    std::atomic<size_t> sink{0};
+
+    size_t allocations_before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        while (outstanding > 0 && i - latch.done.load(std::memory_order_acquire) >= outstanding) {
+            std::this_thread::yield();
+        }
+        // Copying the record allocates for its long strings either way; the
+        // difference is the task storage itself
+        pool.submit_detached([&latch, &sink, file = record]() {
+            sink.fetch_add(file.url.size(), std::memory_order_relaxed);
+            latch.done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    latch.wait(tasks);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double per_task = static_cast<double>(allocations.load() - allocations_before) / tasks;
+    std::printf("  %-14s %12.0f tasks/s %8.2f allocs/task\n", label, tasks / elapsed.count(), per_task);
+}
+
+// Each root task fans out into children submitted from the worker it runs
+// on; at most outstanding roots' worth of children are in flight
+template<typename Pool>
+void run_fan_out(const char* label, Pool& pool, size_t tasks, size_t outstanding) {
+    constexpr size_t FAN_OUT = 16;
+    size_t roots = tasks / FAN_OUT;
+    Latch latch;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < roots; ++i) {
+        while (i * FAN_OUT - latch.done.load(std::memory_order_acquire) >= outstanding * FAN_OUT) {
+            std::this_thread::yield();
+        }
+        pool.submit_detached([&pool, &latch]() {
+            for (size_t j = 0; j < FAN_OUT; ++j) {
+                pool.submit_detached([&latch]() { latch.done.fetch_add(1, std::memory_order_release); });
+            }
+        });
+    }
+    latch.wait(roots * FAN_OUT);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("  %-14s %12.0f tasks/s\n", label, roots * FAN_OUT / elapsed.count());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t tasks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    if (tasks == 0) tasks = 200000;
+    if (threads == 0) threads = 8;
+
+    size_t slots = threads * 2;
+    std::printf("%zu tasks, %zu threads\n\nFileRecord tasks from one dispatcher, %zu outstanding\n",
+                tasks, threads, slots);
+    {
+        LegacyPool pool(threads);
+        run_flat("single queue", pool, tasks, slots);
+    }
+    {
+        ThreadPool pool(threads);
+        run_flat("work stealing", pool, tasks, slots);
+        std::printf("  %-14s %12zu steals, peak queue %zu\n", "", pool.steal_count(), pool.peak_queue_size());
+    }
+    {
+        ThreadPool pool(threads, slots);
+        run_flat("bounded queue", pool, tasks, 0);
+        std::printf("  %-14s %12zu steals, peak queue %zu\n", "", pool.steal_count(), pool.peak_queue_size());
+    }
+
+    std::printf("\nFan-out from workers, %zu roots outstanding\n", slots);
+    {
+        LegacyPool pool(threads);
+        run_fan_out("single queue", pool, tasks, slots);
+    }
+    {
+        ThreadPool pool(threads);
+        run_fan_out("work stealing", pool, tasks, slots);
+        std::printf("  %-14s %12zu steals, peak queue %zu\n", "", pool.steal_count(), pool.peak_queue_size());
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * bench_writer.cpp - Disk write path benchmark
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Replays curl-sized chunks through each FileWriter as download_to_file()
+// would, comparing the original ofstream path against the pooled and
+// O_DIRECT writers. Write syscalls come from /proc/self/io (Linux).
+//
+// Usage: bench_writer [directory] [total MB]
+
+#include "efgrabber/file_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace efgrabber;
+
+namespace {
+
+constexpr size_t CURL_CHUNK = 16 * 1024;  // CURL_MAX_WRITE_SIZE, curl's default delivery size
+
+// Write syscalls issued by this process so far, or -1 if unavailable
+long long write_syscalls() {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    long long value = 0;
+    while (io >> key >> value) {
+        if (key == "syscw:") return value;
+    }
+    return -1;
+}
+
+struct Workload {
+    const char* label;
+    size_t file_size;
+    size_t files;
+};
+
+void run(WriteMode mode, const Workload& workload, const std::string& dir,
+         const std::vector<char>& payload) {
+    long long calls_before = write_syscalls();
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < workload.files; ++i) {
+        std::string path = dir + "/f" + std::to_string(i) + ".part";
+        auto writer = make_file_writer(mode);
+        if (!writer->open(path, false)) {
+            std::fprintf(stderr, "open failed: %s\n", path.c_str());
+            std::exit(1);
+        }
+        writer->preallocate(static_cast<int64_t>(workload.file_size));
+        for (size_t offset = 0; offset < workload.file_size; offset += CURL_CHUNK) {
+            size_t n = std::min(CURL_CHUNK, workload.file_size - offset);
+            if (!writer->write(payload.data() + offset, n)) {
+                std::fprintf(stderr, "write failed: %s\n", path.c_str());
+                std::exit(1);
+            }
+        }
+        if (!writer->close()) {
+            std::fprintf(stderr, "close failed: %s\n", path.c_str());
+            std::exit(1);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    long long calls = calls_before < 0 ? -1 : write_syscalls() - calls_before;
+    double mb = static_cast<double>(workload.file_size * workload.files) / (1 << 20);
+    std::printf("  %-8s %10.1f MB/s %12.1f files/s %10lld writes\n", write_mode_name(mode),
+                mb / elapsed.count(), workload.files / elapsed.count(), calls);
+
+    for (size_t i = 0; i < workload.files; ++i) {
+        std::filesystem::remove(dir + "/f" + std::to_string(i) + ".part");
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "bench_writer.tmp";
+    size_t total_mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+    if (total_mb == 0) total_mb = 256;
+    std::filesystem::create_directories(dir);
+
+    const Workload workloads[] = {
+        {"small files (96 KiB)", 96 * 1024, total_mb * 1024 / 96},
+        {"medium files (2 MiB)", 2 << 20, total_mb / 2},
+        {"large files (64 MiB)", 64 << 20, std::max<size_t>(1, total_mb / 64)},
+    };
+
+    size_t largest = 0;
+    for (const auto& workload : workloads) largest = std::max(largest, workload.file_size);
+    std::vector<char> payload(largest);
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>(i * 31 + 7);
+
+    std::printf("%zu MB per workload in %s, %zu byte chunks\n\n", total_mb, dir.c_str(), CURL_CHUNK);
+    for (const auto& workload : workloads) {
+        std::printf("%s x %zu\n", workload.label, workload.files);
+        for (WriteMode mode : {WriteMode::STREAM, WriteMode::POOLED, WriteMode::DIRECT}) {
+            run(mode, workload, dir, payload);
+        }
+        std::printf("\n");
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,569 @@
+/*
+ * efgrabber_bench.cpp - Benchmark suite with JSON results
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Times the hot paths of the current code and an end-to-end run against a
+// local mock of the DOJ site, and writes the figures as JSON so that runs on
+// different commits can be compared. Every figure is a rate, so higher is
+// better throughout. The bench_* programs next to this one compare a single
+// change against the code it replaced; this is the one to track over time.
+//
+// Usage: efgrabber-bench [--quick] [--filter TEXT] [--json FILE] [--baseline FILE]
+//                        [--latency MS] [--not-found RATE] [--rate-limit RATE]
+//                        [--pages N] [--links N] [--ids N] [--file-kb N]
+//                        [--concurrency N] [--retries N]
+
+#include "efgrabber/cookie.h"
+#include "efgrabber/database.h"
+#include "efgrabber/download_manager.h"
+#include "efgrabber/scraper.h"
+#include "efgrabber/thread_pool.h"
+#include "mock_server.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+using namespace efgrabber;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int DATA_SET = 11;
+
+struct Options {
+    bool quick = false;
+    std::string filter;
+    std::string json_path;
+    std::string baseline_path;
+    MockServerOptions mock;
+    uint64_t brute_ids = 20000;
+    int concurrency = 64;
+    int retries = 0;  // Retries back off for seconds, which would swamp the figures
+};
+
+struct Result {
+    std::string name;
+    double value = 0;
+    std::string unit;
+    int64_t iterations = 0;
+    double seconds = 0;
+    std::vector<std::pair<std::string, double>> details;
+};
+
+class Suite {
+public:
+    // The table goes to stderr when the JSON takes stdout
+    explicit Suite(const Options& options)
+        : options_(options), out_(options.json_path == "-" ? stderr : stdout) {}
+
+    bool selected(const std::string& name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+    int scale(int iterations) const { return options_.quick ? std::max(1, iterations / 10) : iterations; }
+
+    void add(Result result) {
+        std::fprintf(out_, "  %-34s %14.1f %-8s (%lld in %.3f s)\n", result.name.c_str(), result.value,
+                     result.unit.c_str(), static_cast<long long>(result.iterations), result.seconds);
+        for (const auto& [key, value] : result.details) {
+            std::fprintf(out_, "  %-34s %14.1f %s\n", "", value, key.c_str());
+        }
+        std::fflush(out_);
+        results_.push_back(std::move(result));
+    }
+
+    const std::vector<Result>& results() const { return results_; }
+    FILE* out() const { return out_; }
+
+private:
+    const Options& options_;
+    FILE* out_;
+    std::vector<Result> results_;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Result rate(const std::string& name, const std::string& unit, int64_t count, double seconds,
+            int64_t iterations = -1) {
+    Result result;
+    result.name = name;
+    result.unit = unit;
+    result.iterations = iterations < 0 ? count : iterations;
+    result.seconds = seconds;
+    result.value = seconds > 0 ? static_cast<double>(count) / seconds : 0;
+    return result;
+}
+
+std::string make_file_id(uint64_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "EFTA%08llu", static_cast<unsigned long long>(i));
+    return buf;
+}
+
+// A listing page of about 200 KB: navigation, 50 file rows, links to other sets
+std::string make_index_page() {
+    std::string html = "<!DOCTYPE html><html><head><title>DataSet 11 | Epstein Files</title></head><body>";
+    for (int i = 0; i < 300; ++i) {
+        html += "<li class=\"usa-nav__submenu-item\"><a href=\"/epstein/section-" + std::to_string(i) +
+                "\" data-drupal-link-system-path=\"node/" + std::to_string(10000 + i) +
+                "\" class=\"usa-nav__link\"><span>Menu entry " + std::to_string(i) + "</span></a></li>\n";
+    }
+    html += "<table class=\"usa-table\"><tbody>";
+    for (int i = 0; i < 50; ++i) {
+        std::string id = make_file_id(2205655 + i);
+        html += "<tr><td><a href=\"/epstein/files/DataSet%2011/" + id + ".pdf\" type=\"application/pdf\">" +
+                id + ".pdf</a></td><td>PDF</td><td>1.2 MB</td></tr>\n";
+    }
+    for (int i = 0; i < 20; ++i) {
+        html += "<tr><td><a href=\"https://www.justice.gov/epstein/files/DataSet%201/" + make_file_id(1000 + i) +
+                ".pdf\">other data set</a></td></tr>\n";
+    }
+    html += "</tbody></table>";
+    while (html.size() < 200 * 1024) {
+        html += "<p class=\"usa-footer__text\">The Department of Justice provides these records as released "
+                "under the Epstein Files Transparency Act; see <a href=\"/about\">about</a>.</p>\n";
+    }
+    return html + "</body></html>";
+}
+
+void bench_scraper(Suite& suite) {
+    if (!suite.selected("scraper.extract_pdf_links")) return;
+
+    Scraper scraper(get_data_set_config(DATA_SET));
+    std::string html = make_index_page();
+    int iterations = suite.scale(500);
+
+    size_t links = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        links += scraper.extract_pdf_links(html).size();
+    }
+    double seconds = seconds_since(start);
+
+    Result result = rate("scraper.extract_pdf_links", "MB/s",
+                         static_cast<int64_t>(html.size()) * iterations, seconds, iterations);
+    result.value /= 1 << 20;
+    result.details.emplace_back("pages/s", seconds > 0 ? iterations / seconds : 0);
+    result.details.emplace_back("links per page", static_cast<double>(links) / iterations);
+    suite.add(std::move(result));
+}
+
+void bench_database(Suite& suite, const fs::path& dir) {
+    if (!suite.selected("database.")) return;
+
+    fs::path db_path = dir / "bench.db";
+    Database db(db_path.string());
+    if (!db.initialize()) {
+        std::fprintf(stderr, "Failed to open %s\n", db_path.c_str());
+        return;
+    }
+
+    const int rows = suite.scale(50000);
+    std::vector<FileRecord> records;
+    records.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        FileRecord record{};
+        record.data_set = DATA_SET;
+        record.file_id = make_file_id(static_cast<uint64_t>(i));
+        record.url = "https://www.justice.gov/epstein/files/DataSet%2011/" + record.file_id + ".pdf";
+        record.local_path = (dir / (record.file_id + ".pdf")).string();
+        record.status = DownloadStatus::PENDING;
+        records.push_back(std::move(record));
+    }
+
+    // Batches of a scraped page's worth of links and larger, as enqueueing does
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records.size(); i += 500) {
+        std::vector<FileRecord> batch(records.begin() + i,
+                                      records.begin() + std::min(records.size(), i + 500));
+        db.add_files_batch(batch);
+    }
+    if (suite.selected("database.add_files_batch")) {
+        suite.add(rate("database.add_files_batch", "rows/s", rows, seconds_since(start)));
+    }
+
+    // The work queue's refill: lease 100 at a time until nothing is left
+    std::vector<int64_t> claimed;
+    claimed.reserve(rows);
+    start = std::chrono::steady_clock::now();
+    for (;;) {
+        auto batch = db.claim_pending_files(DATA_SET, 100, "bench");
+        if (batch.empty()) break;
+        for (const auto& record : batch) claimed.push_back(record.id);
+    }
+    if (suite.selected("database.claim_pending_files")) {
+        suite.add(rate("database.claim_pending_files", "rows/s", static_cast<int64_t>(claimed.size()),
+                       seconds_since(start)));
+    }
+
+    // The status journal's flush: one transaction per 100 finished downloads
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < claimed.size(); i += 100) {
+        std::vector<StatusUpdate> updates;
+        for (size_t j = i; j < std::min(claimed.size(), i + 100); ++j) {
+            StatusUpdate update;
+            update.id = claimed[j];
+            update.status = DownloadStatus::COMPLETED;
+            update.file_size = 1 << 20;
+            updates.push_back(std::move(update));
+        }
+        db.apply_status_updates(updates);
+    }
+    if (suite.selected("database.apply_status_updates")) {
+        suite.add(rate("database.apply_status_updates", "rows/s", static_cast<int64_t>(claimed.size()),
+                       seconds_since(start)));
+    }
+}
+
+void bench_thread_pool(Suite& suite) {
+    if (!suite.selected("thread_pool.submit")) return;
+
+    const int tasks = suite.scale(1000000);
+    size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    std::atomic<int> done{0};
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(threads);
+        for (int i = 0; i < tasks; ++i) {
+            pool.submit_detached([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load() < tasks) std::this_thread::yield();
+    }
+    Result result = rate("thread_pool.submit", "tasks/s", tasks, seconds_since(start));
+    result.details.emplace_back("threads", static_cast<double>(threads));
+    suite.add(std::move(result));
+}
+
+void bench_cookie_jar(Suite& suite) {
+    if (!suite.selected("cookie_jar.get_cookies_for_url")) return;
+
+    // Roughly what a browser session on justice.gov carries (Akamai, Drupal, age gate)
+    CookieJar jar;
+    jar.add_from_cookie_string("justiceGovAgeVerified=true; QueueITAccepted-SDFrts345E-V3_usdojfiles="
+                               "EventId%3Dusdojfiles%26RedirectType%3Dsafetynet", "www.justice.gov");
+    for (int i = 0; i < 12; ++i) {
+        jar.add_from_header("Set-Cookie: ak_cookie_" + std::to_string(i) + "=" + std::string(48, 'a' + i) +
+                            "; Domain=.justice.gov; Path=/; Secure", "www.justice.gov");
+    }
+
+    const int lookups = suite.scale(1000000);
+    const std::string url = "https://www.justice.gov/epstein/files/DataSet%2011/EFTA02205655.pdf";
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        bytes += jar.get_cookies_for_url(url).size();
+    }
+    Result result = rate("cookie_jar.get_cookies_for_url", "calls/s", lookups, seconds_since(start));
+    result.details.emplace_back("header bytes", static_cast<double>(bytes) / lookups);
+    suite.add(std::move(result));
+}
+
+// One DownloadManager run against the mock site; false if it did not finish
+bool run_manager(const Options& options, const DataSetJob& job, const fs::path& dir,
+                 DownloadStats& stats, double& seconds) {
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    DownloadManager manager((dir / "efgrabber.db").string(), (dir / "downloads").string());
+    if (!manager.initialize()) return false;
+    manager.set_max_concurrent_downloads(options.concurrency);
+    manager.set_max_concurrent_scrapes(std::min(options.concurrency, 16));
+    manager.set_retry_attempts(options.retries);
+
+    auto start = std::chrono::steady_clock::now();
+    manager.start(std::vector<DataSetJob>{job});
+    while (manager.is_running() && seconds_since(start) < 600) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    seconds = seconds_since(start);
+    bool finished = !manager.is_running();
+    manager.stop();
+    stats = manager.get_stats();
+    return finished;
+}
+
+void add_server_details(Result& result, const MockDojServer& server, double seconds) {
+    MockDojServer::Counters counters = server.counters();
+    result.details.emplace_back("MB/s served", seconds > 0 ? counters.body_bytes / seconds / (1 << 20) : 0);
+    result.details.emplace_back("index requests", static_cast<double>(counters.index_requests));
+    result.details.emplace_back("file requests", static_cast<double>(counters.file_requests));
+    result.details.emplace_back("404 responses", static_cast<double>(counters.not_found));
+    result.details.emplace_back("429 responses", static_cast<double>(counters.rate_limited));
+}
+
+void bench_end_to_end(Suite& suite, const Options& options, const fs::path& dir) {
+    if (suite.selected("e2e.scrape")) {
+        MockServerOptions mock = options.mock;
+        if (options.quick) mock.pages = std::max(1, mock.pages / 10);
+        MockDojServer server(mock);
+        if (!server.start()) {
+            std::fprintf(stderr, "Failed to start the mock server\n");
+            return;
+        }
+
+        DataSetJob job;
+        job.config = get_data_set_config(DATA_SET);
+        job.config.base_url = server.index_url();
+        job.config.file_url_base = server.file_url_base();
+        job.mode = OperationMode::SCRAPER;
+
+        DownloadStats stats{};
+        double seconds = 0;
+        bool finished = run_manager(options, job, dir / "scrape", stats, seconds);
+        Result result = rate("e2e.scrape", "files/s", stats.files_completed, seconds);
+        result.details.emplace_back("pages scraped", static_cast<double>(stats.pages_scraped));
+        result.details.emplace_back("files completed", static_cast<double>(stats.files_completed));
+        result.details.emplace_back("files expected", static_cast<double>(server.listed_files()));
+        result.details.emplace_back("files failed", static_cast<double>(stats.files_failed));
+        result.details.emplace_back("files not found", static_cast<double>(stats.files_not_found));
+        add_server_details(result, server, seconds);
+        if (!finished) std::fprintf(stderr, "e2e.scrape did not finish\n");
+        suite.add(std::move(result));
+    }
+
+    if (suite.selected("e2e.brute")) {
+        MockDojServer server(options.mock);
+        if (!server.start()) {
+            std::fprintf(stderr, "Failed to start the mock server\n");
+            return;
+        }
+
+        uint64_t ids = options.quick ? std::max<uint64_t>(1, options.brute_ids / 10) : options.brute_ids;
+        DataSetJob job;
+        job.config = get_data_set_config(DATA_SET);
+        job.config.base_url = server.index_url();
+        job.config.file_url_base = server.file_url_base();
+        job.config.first_file_id = options.mock.first_id;
+        job.config.last_file_id = options.mock.first_id + ids - 1;
+        job.mode = OperationMode::BRUTE_FORCE;
+
+        DownloadStats stats{};
+        double seconds = 0;
+        bool finished = run_manager(options, job, dir / "brute", stats, seconds);
+        Result result = rate("e2e.brute", "ids/s", static_cast<int64_t>(stats.brute_force_probed), seconds);
+        result.details.emplace_back("ids probed", static_cast<double>(stats.brute_force_probed));
+        result.details.emplace_back("ids found", static_cast<double>(stats.brute_force_found));
+        result.details.emplace_back("files completed", static_cast<double>(stats.files_completed));
+        result.details.emplace_back("files failed", static_cast<double>(stats.files_failed));
+        add_server_details(result, server, seconds);
+        if (!finished) std::fprintf(stderr, "e2e.brute did not finish\n");
+        suite.add(std::move(result));
+    }
+}
+
+std::string json_string(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+std::string json_number(double value) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+#if defined(__clang__)
+constexpr const char* COMPILER = "clang " __clang_version__;
+#elif defined(__GNUC__)
+constexpr const char* COMPILER = "gcc " __VERSION__;
+#else
+constexpr const char* COMPILER = "unknown";
+#endif
+
+// One result per line, so a baseline can be read back without a JSON parser
+std::string format_results(const Options& options, const std::vector<Result>& results) {
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    const MockServerOptions& mock = options.mock;
+    std::ostringstream out;
+    out << "{\n"
+        << "  \"format\": 1,\n"
+        << "  \"timestamp\": " << json_string(timestamp) << ",\n"
+        << "  \"compiler\": " << json_string(COMPILER) << ",\n"
+        << "  \"cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"quick\": " << (options.quick ? "true" : "false") << ",\n"
+        << "  \"mock\": {\"pages\": " << mock.pages << ", \"links_per_page\": " << mock.links_per_page
+        << ", \"file_bytes\": " << mock.file_bytes << ", \"latency_ms\": " << mock.latency_ms
+        << ", \"not_found_rate\": " << json_number(mock.not_found_rate)
+        << ", \"rate_limit_rate\": " << json_number(mock.rate_limit_rate)
+        << ", \"brute_ids\": " << options.brute_ids << ", \"concurrency\": " << options.concurrency
+        << ", \"retries\": " << options.retries << "},\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        out << "    {\"name\": " << json_string(result.name) << ", \"value\": " << json_number(result.value)
+            << ", \"unit\": " << json_string(result.unit) << ", \"iterations\": " << result.iterations
+            << ", \"seconds\": " << json_number(result.seconds) << ", \"details\": {";
+        for (size_t j = 0; j < result.details.size(); ++j) {
+            out << (j ? ", " : "") << json_string(result.details[j].first) << ": "
+                << json_number(result.details[j].second);
+        }
+        out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// name -> value from a file written by format_results()
+std::vector<std::pair<std::string, double>> read_baseline(const std::string& path) {
+    std::vector<std::pair<std::string, double>> values;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("{\"name\": \"");
+        size_t value = line.find("\"value\": ");
+        if (name == std::string::npos || value == std::string::npos) continue;
+        name += 10;
+        values.emplace_back(line.substr(name, line.find('"', name) - name), std::atof(line.c_str() + value + 9));
+    }
+    return values;
+}
+
+void compare(const Suite& suite, const std::vector<std::pair<std::string, double>>& baseline) {
+    std::fprintf(suite.out(), "\n  %-34s %14s %14s %9s\n", "compared to baseline", "before", "after", "change");
+    for (const Result& result : suite.results()) {
+        for (const auto& [name, before] : baseline) {
+            if (name != result.name) continue;
+            double change = before > 0 ? 100.0 * (result.value - before) / before : 0;
+            std::fprintf(suite.out(), "  %-34s %14.1f %14.1f %+8.1f%%\n", name.c_str(), before, result.value,
+                         change);
+        }
+    }
+}
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [--quick] [--filter TEXT] [--json FILE] [--baseline FILE]\n"
+                 "          [--latency MS] [--not-found RATE] [--rate-limit RATE]\n"
+                 "          [--pages N] [--links N] [--ids N] [--file-kb N]\n"
+                 "          [--concurrency N] [--retries N]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    options.mock.data_set = DATA_SET;
+    options.mock.pages = 40;
+    options.mock.latency_ms = 2;
+    options.mock.not_found_rate = 0.3;
+    options.mock.rate_limit_rate = 0.01;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--filter") {
+            options.filter = value();
+        } else if (arg == "--json") {
+            options.json_path = value();
+        } else if (arg == "--baseline") {
+            options.baseline_path = value();
+        } else if (arg == "--latency") {
+            options.mock.latency_ms = std::atoi(value());
+        } else if (arg == "--not-found") {
+            options.mock.not_found_rate = std::atof(value());
+        } else if (arg == "--rate-limit") {
+            options.mock.rate_limit_rate = std::atof(value());
+        } else if (arg == "--pages") {
+            options.mock.pages = std::max(1, std::atoi(value()));
+        } else if (arg == "--links") {
+            options.mock.links_per_page = std::max(1, std::atoi(value()));
+        } else if (arg == "--ids") {
+            options.brute_ids = std::max<uint64_t>(1, std::strtoull(value(), nullptr, 10));
+        } else if (arg == "--file-kb") {
+            options.mock.file_bytes = static_cast<size_t>(std::max(1, std::atoi(value()))) << 10;
+        } else if (arg == "--concurrency") {
+            options.concurrency = std::max(1, std::atoi(value()));
+        } else if (arg == "--retries") {
+            options.retries = std::max(0, std::atoi(value()));
+        } else {
+            usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    fs::path dir = fs::temp_directory_path() / ("efgrabber-bench-" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    Suite suite(options);
+    std::fprintf(suite.out(), "efgrabber-bench%s\n\n", options.quick ? " (quick)" : "");
+    bench_scraper(suite);
+    bench_database(suite, dir);
+    bench_thread_pool(suite);
+    bench_cookie_jar(suite);
+    bench_end_to_end(suite, options, dir);
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+
+    if (!options.baseline_path.empty()) {
+        auto baseline = read_baseline(options.baseline_path);
+        if (baseline.empty()) {
+            std::fprintf(stderr, "No results in %s\n", options.baseline_path.c_str());
+        } else {
+            compare(suite, baseline);
+        }
+    }
+
+    if (!options.json_path.empty()) {
+        std::string json = format_results(options, suite.results());
+        if (options.json_path == "-") {
+            std::cout << json;
+        } else {
+            std::ofstream out(options.json_path);
+            out << json;
+            if (!out) {
+                std::fprintf(stderr, "Failed to write %s\n", options.json_path.c_str());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * mock_server.cpp - Local stand-in for the DOJ site, for benchmarks
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mock_server.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace efgrabber {
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finaliser
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1)
+double fraction(uint64_t x) {
+    return static_cast<double>(mix(x) >> 11) / static_cast<double>(1ULL << 53);
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+MockDojServer::MockDojServer(const MockServerOptions& options) : options_(options) {
+    index_path_ = "/epstein/doj-disclosures/data-set-" + std::to_string(options_.data_set) + "-files";
+    file_path_ = "/epstein/files/DataSet%20" + std::to_string(options_.data_set) + "/";
+    pdf_body_ = "%PDF-1.4\n";
+    while (pdf_body_.size() < options_.file_bytes) {
+        pdf_body_ += "% efgrabber benchmark filler, not a real document\n";
+    }
+    pdf_body_.resize(std::max(options_.file_bytes, size_t{9}));
+}
+
+MockDojServer::~MockDojServer() {
+    stop();
+}
+
+bool MockDojServer::start() {
+    if (running_) return true;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1024) != 0) {
+        close(fd);
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+    listen_fd_ = fd;
+    running_ = true;
+    thread_ = std::thread(&MockDojServer::serve, this);
+    return true;
+}
+
+void MockDojServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    {
+        // Wake connections blocked in poll(); each closes its own socket
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (int fd : connection_fds_) shutdown(fd, SHUT_RDWR);
+    }
+    for (auto& connection : connections_) {
+        if (connection.joinable()) connection.join();
+    }
+    connections_.clear();
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+std::string MockDojServer::index_url() const {
+    return "http://127.0.0.1:" + std::to_string(port_) + index_path_;
+}
+
+std::string MockDojServer::file_url_base() const {
+    return "http://127.0.0.1:" + std::to_string(port_) + file_path_;
+}
+
+bool MockDojServer::exists(uint64_t id) const {
+    return fraction(id ^ (options_.seed << 32)) >= options_.not_found_rate;
+}
+
+uint64_t MockDojServer::listed_files() const {
+    uint64_t count = 0;
+    uint64_t listed = static_cast<uint64_t>(options_.pages) * options_.links_per_page;
+    for (uint64_t id = options_.first_id; id < options_.first_id + listed; ++id) {
+        count += exists(id);
+    }
+    return count;
+}
+
+MockDojServer::Counters MockDojServer::counters() const {
+    Counters counters;
+    counters.index_requests = index_requests_.load();
+    counters.file_requests = file_requests_.load();
+    counters.not_found = not_found_.load();
+    counters.rate_limited = rate_limited_.load();
+    counters.body_bytes = body_bytes_.load();
+    return counters;
+}
+
+void MockDojServer::serve() {
+    while (running_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        int one = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connection_fds_.push_back(client);
+        connections_.emplace_back(&MockDojServer::handle_connection, this, client);
+    }
+}
+
+void MockDojServer::handle_connection(int fd) {
+    std::string buffer;
+    char chunk[8192];
+    bool keep_alive = true;
+
+    while (running_ && keep_alive) {
+        size_t end = buffer.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            pollfd pfd{fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, 100);
+            if (ready == 0) continue;
+            ssize_t n = ready > 0 ? recv(fd, chunk, sizeof(chunk), 0) : -1;
+            if (n <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(n));
+            if (buffer.size() > 65536) break;
+            continue;
+        }
+
+        std::string head = buffer.substr(0, end);
+        buffer.erase(0, end + 4);
+
+        size_t method_end = head.find(' ');
+        size_t target_end = method_end == std::string::npos ? method_end : head.find(' ', method_end + 1);
+        if (target_end == std::string::npos) break;
+        std::string method = head.substr(0, method_end);
+        std::string target = head.substr(method_end + 1, target_end - method_end - 1);
+
+        std::transform(head.begin(), head.end(), head.begin(), [](unsigned char c) { return std::tolower(c); });
+        keep_alive = head.find("\r\nconnection: close") == std::string::npos;
+
+        std::string response = respond(method, target, keep_alive);
+        if (options_.latency_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options_.latency_ms));
+        }
+        if (!send_all(fd, response)) break;
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connection_fds_.erase(std::find(connection_fds_.begin(), connection_fds_.end(), fd));
+    close(fd);
+}
+
+std::string MockDojServer::respond(const std::string& method, const std::string& target, bool& keep_alive) {
+    bool head_only = method == "HEAD";
+    std::string path = target.substr(0, target.find('?'));
+    std::string query = target.size() > path.size() ? target.substr(path.size() + 1) : "";
+    uint64_t request = requests_++;
+
+    int status = 404;
+    std::string type = "text/html";
+    std::string body = "<html><body>Not Found</body></html>";
+    std::string extra;
+
+    if (method != "GET" && method != "HEAD") {
+        status = 405;
+        body.clear();
+        keep_alive = false;
+    } else if (path == index_path_) {
+        index_requests_++;
+        int page = 0;
+        size_t at = query.find("page=");
+        if (at != std::string::npos) page = std::atoi(query.c_str() + at + 5);
+        status = 200;
+        body = index_page(page);
+    } else if (path.compare(0, file_path_.size(), file_path_) == 0 && path.size() > file_path_.size() + 4 &&
+               path.compare(path.size() - 4, 4, ".pdf") == 0) {
+        file_requests_++;
+        uint64_t id = std::strtoull(path.c_str() + file_path_.size() + 4, nullptr, 10);  // Past "EFTA"
+        if (!exists(id)) {
+            not_found_++;
+        } else if (fraction(request ^ (options_.seed << 48) ^ 0x5bd1e995) < options_.rate_limit_rate) {
+            rate_limited_++;
+            status = 429;
+            body = "<html><body>Too Many Requests</body></html>";
+            extra = "Retry-After: 1\r\n";
+        } else {
+            status = 200;
+            type = "application/pdf";
+            body = pdf_body_;
+        }
+    }
+
+    const char* reason = status == 200 ? "OK" : status == 404 ? "Not Found"
+                       : status == 429 ? "Too Many Requests" : "Method Not Allowed";
+    std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason +
+                           "\r\nContent-Type: " + type +
+                           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n" + extra +
+                           (keep_alive ? "" : "Connection: close\r\n") + "\r\n";
+    if (!head_only) {
+        response += body;
+        body_bytes_ += body.size();
+    }
+    return response;
+}
+
+std::string MockDojServer::index_page(int page) const {
+    std::string html = "<!DOCTYPE html><html><head><title>DataSet " + std::to_string(options_.data_set) +
+                       " | Epstein Files</title></head><body>";
+    for (int i = 0; i < 100; ++i) {
+        html += "<li class=\"usa-nav__submenu-item\"><a href=\"/epstein/section-" + std::to_string(i) +
+                "\" class=\"usa-nav__link\"><span>Menu entry " + std::to_string(i) + "</span></a></li>\n";
+    }
+    if (page < 0 || page >= options_.pages) {
+        return html + "<p>No files found.</p></body></html>";
+    }
+
+    html += "<table class=\"usa-table\"><tbody>";
+    std::string prefix = "<tr><td><a href=\"" + file_url_base() + "EFTA";
+    for (int i = 0; i < options_.links_per_page; ++i) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "%08llu",
+                      static_cast<unsigned long long>(options_.first_id +
+                                                      static_cast<uint64_t>(page) * options_.links_per_page + i));
+        html += prefix + id + ".pdf\">EFTA" + id + ".pdf</a></td><td>PDF</td></tr>\n";
+    }
+    return html + "</tbody></table></body></html>";
+}
+
+} // namespace efgrabber
@@ -0,0 +1,111 @@
+/*
+ * mock_server.h - Local stand-in for the DOJ site, for benchmarks
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace efgrabber {
+
+// What the mock site looks like and how badly it behaves
+struct MockServerOptions {
+    int data_set = 11;
+    int pages = 20;              // Index pages with links; the ones after have none
+    int links_per_page = 50;
+    uint64_t first_id = 1000000; // Page N lists first_id + N * links_per_page onwards
+    size_t file_bytes = 64 * 1024;
+    int latency_ms = 0;          // Added before every response
+    double not_found_rate = 0;   // Share of file IDs that are 404, fixed per ID
+    double rate_limit_rate = 0;  // Share of file requests answered 429, per request
+    uint64_t seed = 1;
+};
+
+// HTTP/1.1 server on 127.0.0.1 with keep-alive and a thread per connection.
+// It serves a data set's index pages, shaped like the DOJ listing, and PDFs
+// under the file URL layout. 429s are only injected on files; on index pages
+// they would stop the scrape, as a real block does.
+class MockDojServer {
+public:
+    struct Counters {
+        uint64_t index_requests = 0;
+        uint64_t file_requests = 0;
+        uint64_t not_found = 0;
+        uint64_t rate_limited = 0;
+        uint64_t body_bytes = 0;
+    };
+
+    explicit MockDojServer(const MockServerOptions& options);
+    ~MockDojServer();
+
+    MockDojServer(const MockDojServer&) = delete;
+    MockDojServer& operator=(const MockDojServer&) = delete;
+
+    // Listen on an ephemeral port; false if the socket could not be set up
+    bool start();
+    void stop();
+    int port() const { return port_; }
+
+    // For DataSetConfig::base_url and file_url_base
+    std::string index_url() const;
+    std::string file_url_base() const;
+
+    // Whether the file with this number is served (not a 404)
+    bool exists(uint64_t id) const;
+    // IDs listed on the index pages that exist
+    uint64_t listed_files() const;
+
+    Counters counters() const;
+
+private:
+    void serve();
+    void handle_connection(int fd);
+    std::string respond(const std::string& method, const std::string& target, bool& keep_alive);
+    std::string index_page(int page) const;
+
+    MockServerOptions options_;
+    std::string index_path_;
+    std::string file_path_;
+    std::string pdf_body_;
+
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::mutex connections_mutex_;
+    std::vector<int> connection_fds_;
+    std::vector<std::thread> connections_;
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> index_requests_{0};
+    std::atomic<uint64_t> file_requests_{0};
+    std::atomic<uint64_t> not_found_{0};
+    std::atomic<uint64_t> rate_limited_{0};
+    std::atomic<uint64_t> body_bytes_{0};
+};
+
+} // namespace efgrabber
@@ -142,13 +142,14 @@ constexpr int MIN_DATA_SET = 1;
 constexpr int MAX_DATA_SET = 12;
 
 // Download status for a single file
+// Values are stored in the database; do not renumber
 enum class DownloadStatus {
-    PENDING,
-    IN_PROGRESS,
-    COMPLETED,
-    FAILED,
-    NOT_FOUND,    // 404
-    SKIPPED       // Already exists
+    PENDING = 0,
+    IN_PROGRESS = 1,
+    COMPLETED = 2,
+    FAILED = 3,
+    NOT_FOUND = 4,    // 404
+    SKIPPED = 5       // Already exists
 };
 
 // File record in database
@@ -166,6 +167,32 @@ struct FileRecord {
     std::chrono::system_clock::time_point updated_at;
 };
 
+// Deferred file status change, applied in batches by StatusJournal
+struct StatusUpdate {
+    int64_t id = 0;             // Database row ID
+    DownloadStatus status = DownloadStatus::PENDING;
+    std::string error_message;
+    int64_t file_size = 0;
+    bool increment_retry = false;  // Also bump retry_count
+    int64_t next_attempt_at = 0;   // FAILED rows: unix time the retry is due (0 stores NULL)
+    std::string sha256;            // COMPLETED rows: hex digest of the body ("" keeps the column)
+    int is_pdf = -1;               // COMPLETED rows: 1 if the body starts like a PDF (-1 keeps the column)
+};
+
+// Where PackStore put a completed download (see pack_store.h)
+struct PackedFile {
+    int64_t id = 0;                // Database row ID
+    int pack_id = 0;
+    int64_t pack_offset = 0;       // Of the member's data in the pack file
+    int64_t file_size = 0;
+};
+
+// When a FAILED row becomes eligible for another attempt (see RetryScheduler)
+struct RetryDeadline {
+    int64_t id = 0;                // Database row ID
+    int64_t next_attempt_at = 0;   // Unix seconds
+};
+
 // Page record in database
 struct PageRecord {
     int64_t id;
@@ -174,6 +201,9 @@ struct PageRecord {
     bool scraped;
     int pdf_count;              // Number of PDFs found on this page
     std::chrono::system_clock::time_point scraped_at;
+    std::string etag;           // Validators from the last successful fetch
+    std::string last_modified;
+    uint64_t content_hash = 0;  // LinkScanner::links_hash() of that fetch; 0 if unknown
 };
 
 // Statistics for progress display
@@ -182,6 +212,7 @@ struct DownloadStats {
     int64_t total_pages;
     int64_t pages_scraped;
     int64_t total_files_found;
+    int64_t pages_unchanged;    // Revalidated pages that were a 304 or had the same links
 
     // Download stats
     int64_t files_pending;
@@ -190,25 +221,86 @@ struct DownloadStats {
     int64_t files_failed;
     int64_t files_not_found;
     int64_t files_skipped;
+    int64_t files_on_disk;      // Found by the startup scan (DiskCheck::SCAN)...
+    int64_t files_reconciled;   // ...of which the database did not have as done
+    int64_t files_packed;       // Moved into pack files this run (StorageMode::PACK)
+    int64_t files_rejected;     // Bodies that were not PDFs (block or error pages), retried
+    int64_t files_deduplicated; // Hard-linked to an identical earlier download (--dedup)
 
     // Brute force mode stats
     uint64_t brute_force_current;
     uint64_t brute_force_start;
     uint64_t brute_force_end;
+    uint64_t brute_force_probed;    // IDs whose existence is known
+    uint64_t brute_force_found;     // ...of which exist
+    int brute_force_pass;           // 0, then one per retry of failed probes (see ProbePlanner)
 
     // Timing
     std::chrono::system_clock::time_point start_time;
     int64_t bytes_downloaded;
     double current_speed_bps;   // Wall time speed: bytes / total elapsed time
     double wire_speed_bps;      // Wire time speed: bytes / actual transfer time
+    int64_t bytes_resumed;      // Bytes not refetched because a .part file was resumed
+
+    // Connection usage
+    int64_t connections_open;   // Sockets currently open to the server
+    int64_t streams_active;     // HTTP/2 streams the multi engine multiplexes (0 otherwise)
+
+    // Concurrency limit in force; with adaptive concurrency it moves, and
+    // concurrency_reason says why it last did
+    int64_t concurrency_limit;
+    std::string concurrency_reason;
 };
 
 // Constants
 constexpr int MAX_CONCURRENT_DOWNLOADS = 1000;
 constexpr int MAX_CONCURRENT_PAGE_SCRAPES = 30;
+constexpr int MAX_INDEX_PAGES = 100000;        // Upper bound for page count detection
+constexpr int MULTI_TRANSFERS_PER_LOOP = 256;  // Target transfers per curl_multi event loop
+constexpr int MULTI_COMPLETION_THREADS = 4;    // Record multi engine results off the loop threads
+constexpr int ADAPTIVE_MIN_CONCURRENCY = 4;    // Default lower bound of the adaptive limit
+constexpr int ADAPTIVE_WINDOW_MS = 2000;       // Concurrency controller measurement window
+constexpr int ADAPTIVE_MIN_SAMPLES = 8;        // Transfers a window needs to judge goodput/latency
+constexpr int ADAPTIVE_HOLD_WINDOWS = 5;       // Windows the limit is held after a block
+constexpr double ADAPTIVE_BLOCK_RATE = 0.02;   // 403/429 share of a window that halves the limit
+constexpr double ADAPTIVE_FAILURE_RATE = 0.10; // Failure share of a window that backs it off
+constexpr double ADAPTIVE_SLOW_START_GRADIENT = 0.9;  // Slow start ends once latency rises ~10%
+constexpr double ADAPTIVE_BASELINE_DRIFT = 1.001;     // Per-window rise of the unloaded latency
+constexpr int DEFAULT_MAX_STREAMS_PER_CONNECTION = 100;  // HTTP/2 streams multiplexed per socket
 constexpr int MAX_RETRY_ATTEMPTS = 3;
+constexpr int WORK_LEASE_SECONDS = 900;        // Claimed rows are reclaimable after 15 minutes
+constexpr int STATUS_FLUSH_INTERVAL_MS = 50;   // Status journal group commit interval
+constexpr int STATUS_FLUSH_BATCH = 512;        // ...or sooner once this many updates queue up
+constexpr int STATUS_RETRY_MAX_MS = 5000;      // Longest wait before retrying a failed batch
+constexpr int STATUS_STOP_ATTEMPTS = 5;        // Tries for the last batch when stopping
 constexpr int DOWNLOAD_TIMEOUT_SECONDS = 300;  // 5 minutes
 constexpr int PAGE_TIMEOUT_SECONDS = 60;       // 1 minute
+constexpr int PROBE_TIMEOUT_SECONDS = 10;      // Brute force existence probe
+constexpr int BRUTE_FORCE_CHECKPOINT_PROBES = 2000;  // Probes between saves of the ID bitmap
+constexpr size_t MAX_LINK_CARRY = 64 * 1024;   // Longest href value LinkScanner holds across chunks
+constexpr size_t SCRAPE_LINK_BATCH = 32;       // Streamed links queued to the database per batch
+constexpr size_t BLOCK_SCAN_BYTES = 16 * 1024; // Start of a page body checked for challenge markup
+constexpr size_t EVENT_CHANNEL_CAPACITY = 1 << 16;  // UI events queued between drains (see EventChannel)
+constexpr int DISK_SCAN_THREADS = 16;          // Directories read at once by the startup scan
+constexpr int64_t PACK_FILE_BYTES = 4LL << 30; // Pack files roll over at this size
+constexpr int PACK_BATCH_FILES = 64;           // Files appended per pack sync and index transaction
+constexpr int SHARD_DEFAULT_PORT = 8790;       // Coordinator of a distributed run (see shard.h)
+constexpr int SHARD_LEASE_SECONDS = 120;       // A lease not renewed for this long is reassigned
+constexpr int SHARD_RENEW_SECONDS = 30;        // Workers renew their lease this often
+constexpr int SHARD_PAGES_PER_LEASE = 20;      // Index pages per page range lease
+constexpr uint64_t SHARD_IDS_PER_LEASE = 20000; // File IDs per brute force range lease
+constexpr size_t SHARD_REPORT_LINES = 2000;    // Result lines per report a worker sends
+constexpr int SHARD_WAIT_SECONDS = 5;          // Workers ask again after this when nothing is free
+constexpr const char* PARTIAL_FILE_SUFFIX = ".part";       // Download in progress
+constexpr const char* PARTIAL_META_SUFFIX = ".part.meta";  // Resume validator for a .part file
+constexpr int64_t MIN_SEGMENT_BYTES = 4LL << 20;           // Smallest range of a segmented download
+constexpr int64_t DEFAULT_SEGMENT_THRESHOLD = 64LL << 20;  // Split files larger than this...
+constexpr int DEFAULT_SEGMENTS_PER_FILE = 4;               // ...into this many parallel ranges
+constexpr int MAX_SEGMENTS_PER_FILE = 16;
+constexpr size_t WRITE_BUFFER_BYTES = 256 * 1024;          // Per-transfer disk write buffer
+constexpr size_t WRITE_BUFFER_ALIGNMENT = 4096;            // Satisfies O_DIRECT on common filesystems
+constexpr size_t WRITE_BUFFER_POOL_IDLE = 64;              // Buffers kept around between transfers
+constexpr size_t DEDUP_DIGEST_CACHE = 65536;              // Recent digests kept for --dedup; older ones come from the database
 constexpr const char* REQUIRED_COOKIE = "justiceGovAgeVerified=true";
 constexpr const char* USER_AGENT = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/144.0.0.0 Safari/537.36 Edg/144.0.0.0";
 constexpr const char* TARGET_DOMAIN = "justice.gov";
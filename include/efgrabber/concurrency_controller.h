@@ -0,0 +1,96 @@
+/*
+ * concurrency_controller.h - Adaptive download concurrency limit
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include "efgrabber/common.h"
+
+namespace efgrabber {
+
+// How a finished transfer counts towards the concurrency limit
+enum class TransferOutcome {
+    OK,         // Got an answer (including 404): bytes and latency are measured
+    BLOCKED,    // 403/429 from the anti-bot layer
+    FAILED      // Network error or other HTTP failure
+};
+
+// AIMD/gradient controller for the number of simultaneous downloads, kept
+// between a user-set minimum and maximum. Transfers report their outcome as
+// they finish; once per window the controller looks at the window's block
+// rate, failure rate, goodput and mean latency and moves the limit:
+//   - a significant 403/429 rate halves it and holds it for a few windows
+//   - a high failure rate backs it off by a tenth
+//   - goodput falling right after an increase undoes that increase
+//   - otherwise limit * (unloaded latency / mean latency) + sqrt(limit),
+//     after a slow start that doubles it while latency stays flat
+// Increases only happen while the current limit is actually in use.
+// record() is lock-free; update() is meant to be called from one thread.
+class ConcurrencyController {
+public:
+    ConcurrencyController(int min_limit, int max_limit);
+
+    // Report a finished transfer (any thread)
+    void record(TransferOutcome outcome, int64_t bytes, int64_t latency_ms);
+
+    // Close the current window, which lasted window_seconds, with in_flight
+    // transfers running now. Returns true if the limit changed.
+    bool update(double window_seconds, int64_t in_flight);
+
+    // Change the bounds at runtime; the limit is clamped into them
+    void set_bounds(int min_limit, int max_limit);
+
+    int limit() const { return limit_.load(std::memory_order_relaxed); }
+    int min_limit() const { return min_limit_.load(std::memory_order_relaxed); }
+    int max_limit() const { return max_limit_.load(std::memory_order_relaxed); }
+    // Why the limit last changed (or why it is being held)
+    std::string reason() const;
+
+private:
+    void set_limit(int limit, std::string reason);
+
+    std::atomic<int> min_limit_;
+    std::atomic<int> max_limit_;
+    std::atomic<int> limit_;
+
+    // Current window, filled by record()
+    std::atomic<int64_t> ok_{0};
+    std::atomic<int64_t> blocked_{0};
+    std::atomic<int64_t> failed_{0};
+    std::atomic<int64_t> bytes_{0};
+    std::atomic<int64_t> latency_ms_{0};
+
+    // Controller state, only touched by update()
+    bool slow_start_ = true;
+    int hold_windows_ = 0;          // Windows left before the limit may rise again
+    int previous_limit_ = 0;        // Limit before the last increase (0: last change was not one)
+    double last_goodput_ = 0;       // Bytes/s of the previous measured window
+    double best_latency_ms_ = 0;    // Lowest window mean latency, drifting up slowly
+
+    mutable std::mutex reason_mutex_;
+    std::string reason_;
+};
+
+} // namespace efgrabber
@@ -0,0 +1,82 @@
+/*
+ * content_digest.h - SHA-256 and PDF signature check of streamed bodies
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace efgrabber {
+
+// FIPS 180-4 SHA-256, fed incrementally
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    Sha256();
+    void update(const void* data, size_t size);
+    // The digest of everything fed so far; the object must be reset() to reuse
+    Digest finish();
+    void reset();
+
+    static std::string hex(const Digest& digest);
+
+private:
+    void compress(const uint8_t* block);
+
+    uint32_t state_[8];
+    uint8_t buffer_[64];
+    size_t buffered_ = 0;
+    uint64_t length_ = 0;  // Bytes fed
+};
+
+// Watches a download body go by on its way to disk: hashes it and checks
+// that it starts like a PDF, so neither needs a second read of the file.
+// Acrobat accepts the %PDF- header anywhere in the first 1024 bytes, and so
+// does this.
+class ContentInspector {
+public:
+    void update(const char* data, size_t size);
+    void reset();
+
+    // Hex SHA-256 of the whole body; call once, after the last update()
+    std::string hex_digest();
+    bool looks_like_pdf() const;
+    uint64_t size() const { return size_; }
+
+private:
+    static constexpr size_t HEAD_BYTES = 1024;
+
+    Sha256 hash_;
+    char head_[HEAD_BYTES];
+    size_t head_size_ = 0;
+    uint64_t size_ = 0;
+};
+
+// Feed size bytes of the file at path, starting at offset, to inspector;
+// false on a read error or if the file is shorter
+bool inspect_file(const std::string& path, int64_t offset, int64_t size, ContentInspector& inspector);
+
+} // namespace efgrabber
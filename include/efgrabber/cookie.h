@@ -25,7 +25,9 @@
 
 #include <string>
 #include <ctime>
+#include <memory>
 #include <mutex>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <atomic>
@@ -76,9 +78,13 @@ public:
     // Add from standard cookie string (key=value; key2=value2)
     void add_from_cookie_string(const std::string& cookie_string, const std::string& domain);
 
-    // Get cookies string for a specific request
+    // Get cookies string for a specific request. Served from the published
+    // snapshot without taking the jar mutex once the host has been seen.
     std::string get_cookies_for_url(const std::string& url);
 
+    // Bumped every time the set of cookies changes
+    uint64_t version() const { return snapshot_.load(std::memory_order_acquire)->version; }
+
     // Manual eviction
     void cleanup_expired();
 
@@ -87,15 +93,44 @@ public:
     void stop_reaper();
 
 private:
+    // A cookie resent unchanged only has its expiry pushed out (under the
+    // mutex) once the stored expiry falls this far behind the new one
+    static constexpr time_t EXPIRY_SLACK_SECONDS = 3600;
+
+    // Immutable view of the jar, republished (RCU style) whenever a cookie is
+    // added, changed or reaped. Cookie headers are built on the first request
+    // for a (domain, secure) pair and published in a copy of the snapshot, so
+    // later requests for it are an atomic load and a short scan.
+    struct Snapshot {
+        struct Header {
+            std::string domain;
+            bool secure;
+            std::string value;
+        };
+
+        uint64_t version = 0;
+        std::shared_ptr<const std::vector<Cookie>> cookies;
+        time_t valid_until = 0;         // Earliest expiry; headers are stale after it
+        std::vector<Header> headers;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
     // Helper to parse domain from URL
-    std::string extract_domain(const std::string& url) const;
-    bool is_url_secure(const std::string& url) const;
+    std::string_view extract_domain(std::string_view url) const;
+    bool is_url_secure(std::string_view url) const;
     void reaper_thread_func(int interval_seconds);
+    // Drop expired cookies; returns how many were removed. Caller holds mutex_.
+    size_t remove_expired_locked(time_t now);
+    // Rebuild and publish the snapshot from cookies_. Caller holds mutex_.
+    void publish_locked();
+    std::string build_header(SnapshotPtr snapshot, std::string_view domain, bool secure);
 
     // Storage: domain -> list of cookies
     // This simplifies matching. We could also just use a flat list for small numbers.
     std::unordered_map<std::string, std::vector<Cookie>> cookies_;
-    mutable std::mutex mutex_;
+    mutable std::mutex mutex_;      // Serialises writers; readers use snapshot_
+    uint64_t version_ = 0;          // Guarded by mutex_
+    std::atomic<SnapshotPtr> snapshot_;
 
     // Reaper state
     std::atomic<bool> reaper_running_{false};
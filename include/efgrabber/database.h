@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <climits>
 #include <string>
 #include <vector>
 #include <optional>
@@ -30,8 +31,10 @@
 #include <memory>
 #include <mutex>
 #include "efgrabber/common.h"
+#include "efgrabber/id_bitmap.h"
 
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace efgrabber {
 
@@ -54,9 +57,14 @@ public:
     // File operations
     bool add_file(const FileRecord& record);
     bool add_files_batch(const std::vector<FileRecord>& records);
+    // Files found complete on disk: rows not already COMPLETED or SKIPPED
+    // become COMPLETED with the record's file_size, and missing rows are
+    // inserted that way. One transaction; returns rows changed, -1 on error.
+    int reconcile_local_files(const std::vector<FileRecord>& records);
+    // next_attempt_at is the unix time a FAILED row is due for retry; 0 stores NULL
     bool update_file_status(int64_t id, DownloadStatus status,
                            const std::string& error_msg = "",
-                           int64_t file_size = 0);
+                           int64_t file_size = 0, int64_t next_attempt_at = 0);
     bool update_file_status_by_file_id(const std::string& file_id, int data_set,
                                        DownloadStatus status,
                                        const std::string& error_msg = "",
@@ -64,22 +72,50 @@ public:
     std::optional<FileRecord> get_file(int64_t id);
     std::optional<FileRecord> get_file_by_file_id(const std::string& file_id, int data_set);
     std::vector<FileRecord> get_pending_files(int limit = 100);
+    // Atomically lease up to limit PENDING rows (or rows whose lease held by another
+    // owner has expired) to owner: marks them IN_PROGRESS and returns them
+    std::vector<FileRecord> claim_pending_files(int data_set, int limit, const std::string& owner,
+                                                int lease_seconds = WORK_LEASE_SECONDS);
+    // Return leased-but-unstarted rows to PENDING
+    bool release_files(const std::vector<int64_t>& ids);
     std::vector<FileRecord> get_failed_files(int max_retries = MAX_RETRY_ATTEMPTS, int limit = 100);
+    // Deadlines of FAILED rows with retries left, earliest first
+    std::vector<RetryDeadline> get_retry_deadlines(int data_set, int max_retries);
+    // Lease the given FAILED rows whose deadline is at or before now (unix
+    // seconds); rows no longer FAILED or not yet due are skipped
+    std::vector<FileRecord> claim_retry_files(const std::vector<int64_t>& ids, int64_t now,
+                                              const std::string& owner,
+                                              int lease_seconds = WORK_LEASE_SECONDS);
     bool increment_retry_count(int64_t id);
+    // Apply many status updates in one transaction (see StatusJournal)
+    bool apply_status_updates(const std::vector<StatusUpdate>& updates);
     bool file_exists(const std::string& file_id, int data_set);
 
     // Page operations
     bool add_page(int data_set, int page_number);
     bool add_pages_batch(int data_set, int start_page, int end_page);
-    bool mark_page_scraped(int data_set, int page_number, int pdf_count);
+    // Empty validators and a zero hash are stored as NULL
+    bool mark_page_scraped(int data_set, int page_number, int pdf_count,
+                           const std::string& etag = "", const std::string& last_modified = "",
+                           uint64_t content_hash = 0);
     std::optional<PageRecord> get_page(int data_set, int page_number);
-    std::vector<int> get_unscraped_pages(int data_set, int limit = 30);
+    // Lowest-numbered unscraped pages, optionally only those in [first_page, last_page]
+    std::vector<int> get_unscraped_pages(int data_set, int limit = 30, int first_page = 0,
+                                         int last_page = INT_MAX);
     bool page_exists(int data_set, int page_number);
+    // Mark every scraped page unscraped again, keeping validators and hashes,
+    // so the scraper revalidates them (refresh mode); returns pages reset
+    int reset_scraped_pages(int data_set);
+    // Drop pages past the last one, once it is known; returns pages removed
+    int remove_pages_after(int data_set, int last_page);
 
     // Statistics
     DownloadStats get_stats(int data_set);
     int64_t get_total_files(int data_set);
     int64_t get_completed_files(int data_set);
+    // Statistics read from counter tables maintained by triggers; this recomputes
+    // them from the files/pages tables in case they ever drift
+    bool reconcile_counters(int data_set);
 
     // Resume/retry operations
     int reset_in_progress_files(int data_set);  // Reset IN_PROGRESS to PENDING (for crash recovery)
@@ -91,6 +127,33 @@ public:
     // Brute force mode tracking
     bool set_brute_force_progress(int data_set, uint64_t current_id);
     uint64_t get_brute_force_progress(int data_set);
+    // Probe state of the data set's brute force range; load returns false
+    // if none is stored
+    bool save_id_bitmap(int data_set, const IdBitmap& bitmap);
+    bool load_id_bitmap(int data_set, IdBitmap& bitmap);
+    // Call visit for every files row of the data set. It runs under the
+    // database lock, so it must not call back into the Database.
+    void for_each_file_status(int data_set,
+                              const std::function<void(const std::string&, DownloadStatus)>& visit);
+    // Call visit(data_set, file_id) for every files row of every data set, in
+    // one scan and under the database lock; false if the scan failed
+    bool for_each_file(const std::function<void(int, const std::string&)>& visit);
+
+    // Pack files (see PackStore): the data set's highest pack number and the
+    // end of its last indexed member; false if nothing is packed yet
+    bool get_pack_end(int data_set, int& pack_id, int64_t& end);
+    // COMPLETED or SKIPPED rows still stored loose, by id after after_id
+    std::vector<FileRecord> get_unpacked_files(int data_set, int64_t after_id, int limit);
+    // Record where files were packed, in one transaction
+    bool set_pack_locations(const std::vector<PackedFile>& files);
+
+    // local_path of a loose COMPLETED row other than exclude_id whose body
+    // had this digest; "" if there is none
+    std::string find_file_by_sha256(const std::string& sha256, int64_t exclude_id);
+
+    // Last detected index page number (0-based); -1 if never detected
+    bool set_max_page(int data_set, int max_page);
+    int get_max_page(int data_set);
 
     // Transaction support
     bool begin_transaction();
@@ -105,7 +168,26 @@ public:
 
 private:
     bool execute(const std::string& sql);
+    bool ensure_column(const std::string& table, const std::string& column,
+                       const std::string& definition);
+    bool rebuild_counters(const std::string& where);  // Caller holds mutex_ and a transaction
+
+    // Versioned schema migrations (see MIGRATIONS in database.cpp)
+    using Migration = bool (Database::*)();
+    static const Migration MIGRATIONS[];
+    int user_version();
+    bool migrate_v1();
+    bool migrate_v2();
+    bool migrate_v3();
+    bool migrate_v4();
+    bool migrate_v5();
+    bool migrate_v6();
+    bool migrate_v7();
+    bool migrate_v8();
+    // Prepared statement cache, indexed by the StatementId enum in database.cpp.
+    // Guarded by mutex_ like the connection itself.
     bool prepare_statements();
+    sqlite3_stmt* statement(size_t id);
     void close();
 
     sqlite3* db_ = nullptr;
@@ -113,6 +195,8 @@ private:
     std::string last_error_;
     std::optional<ErrorInfo> last_error_info_; // Structured error info
     mutable std::mutex mutex_;
+    std::vector<sqlite3_stmt*> statements_;
+    bool vacuum_after_migration_ = false;
 };
 
 } // namespace efgrabber
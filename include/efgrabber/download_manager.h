@@ -29,12 +29,26 @@
 #include <condition_variable>
 #include <functional>
 #include <chrono>
+#include <unordered_map>
+#include <list>
 #include "efgrabber/common.h"
 #include "efgrabber/database.h"
 #include "efgrabber/downloader.h"
+#include "efgrabber/multi_downloader.h"
 #include "efgrabber/scraper.h"
 #include "efgrabber/thread_pool.h"
+#include "efgrabber/work_queue.h"
+#include "efgrabber/status_journal.h"
+#include "efgrabber/concurrency_controller.h"
+#include "efgrabber/retry_scheduler.h"
+#include "efgrabber/metrics.h"
+#include "efgrabber/probe_planner.h"
+#include "efgrabber/known_id_index.h"
+#include "efgrabber/download_tree.h"
+#include "efgrabber/pack_store.h"
 #include "efgrabber/cookie.h"
+#include "efgrabber/event_channel.h"
+#include "efgrabber/fair_scheduler.h"
 
 namespace efgrabber {
 
@@ -42,7 +56,14 @@ namespace efgrabber {
 enum class OperationMode {
     SCRAPER,        // Scrape index pages and download found PDFs
     BRUTE_FORCE,    // Iterate through all possible file IDs
-    HYBRID          // Combine both modes
+    HYBRID,         // Combine both modes
+    REFRESH         // Re-scrape a scraped data set with conditional requests
+};
+
+// Download engine
+enum class DownloadEngine {
+    THREAD_POOL,    // One blocking transfer per pool thread
+    CURL_MULTI      // Event loop threads driving many transfers each
 };
 
 // Callbacks for GUI updates - structured events, no string logging
@@ -54,6 +75,21 @@ struct DownloadCallbacks {
     std::function<void(const std::string& error)> on_error;
     // Worker lifecycle events
     std::function<void(const std::string& worker_name, bool started)> on_worker_state;
+    // Index page scraping hit a 403/429 or a bot challenge. Scraping stops for
+    // the rest of the run (downloads carry on) and the pages not yet scraped
+    // stay that way, for a browser to take over. Unset, on_error is told.
+    std::function<void(int page_number, const std::string& reason)> on_scrape_blocked;
+};
+
+// One data set of a run and how it is worked
+struct DataSetJob {
+    DataSetConfig config;
+    OperationMode mode = OperationMode::SCRAPER;
+    int weight = 1;  // Share of the download slots while several sets have work
+    // Scrape only index pages first_page..last_page, without detecting the
+    // page count; -1 scrapes them all
+    int first_page = 0;
+    int last_page = -1;
 };
 
 class DownloadManager {
@@ -70,6 +106,9 @@ public:
 
     // Start downloading
     void start(const DataSetConfig& config, OperationMode mode);
+    // Run several data sets at once over the same pools, connections and
+    // database, sharing download slots between them by weight
+    void start(const std::vector<DataSetJob>& jobs);
     void start_download_only(const DataSetConfig& config);  // Only download, don't scrape or brute force
 
     // Stop downloading
@@ -83,11 +122,22 @@ public:
     bool is_running() const { return running_.load(); }
     bool is_paused() const { return paused_.load(); }
 
-    // Get current statistics
+    // Get current statistics, summed over every data set of the run
     DownloadStats get_stats() const;
+    // One data set's share; connection and concurrency figures are the manager's
+    DownloadStats get_stats(int data_set) const;
+    // Data sets of the current (or last) run, in the order they were given
+    std::vector<int> get_data_sets() const;
+    // Timing histograms and HTTP codes of every finished file transfer
+    const TransferMetrics& get_transfer_metrics() const { return transfer_metrics_; }
 
     // Set callbacks for progress updates
     void set_callbacks(const DownloadCallbacks& callbacks);
+    // Deliver file status changes and scraped pages as ManagerEvents on
+    // channel instead of on_file_status_change / on_page_scraped, so workers
+    // never take the callback lock for them. The channel must outlive the
+    // run; nullptr goes back to the callbacks.
+    void set_event_channel(EventChannel* channel);
 
     // Configuration
     void set_max_concurrent_downloads(int max);
@@ -95,10 +145,39 @@ public:
     void set_retry_attempts(int attempts);
     void set_cookie_file(const std::string& cookie_file);
     void set_cookie_string(const std::string& cookies);  // Direct cookie string
+    // Cookies exported from a browser session, domain, secure flag and expiry intact
+    void import_cookies(const std::vector<Cookie>& cookies);
     void set_overwrite_existing(bool overwrite);  // Overwrite existing files on disk
+    void set_download_engine(DownloadEngine engine);  // Takes effect on next start
+    void set_http2(bool enabled);  // HTTP/2 multiplexing (multi engine); next start
+    void set_max_streams_per_connection(int streams);  // HTTP/2 stream cap; next start
+    // Split files above threshold_bytes into parallel ranges (threads engine; 1 disables)
+    void set_segmented_downloads(int segments, int64_t threshold_bytes);
+    void set_write_mode(WriteMode mode);  // Disk write path for downloads
+    // How downloads find out a file is already on disk; takes effect on next start
+    void set_disk_check(DiskCheck mode);
+    // Keep completed downloads loose or in pack files of up to pack_bytes;
+    // takes effect on next start
+    void set_storage(StorageMode mode, int64_t pack_bytes = PACK_FILE_BYTES);
+    // Fail (and retry) downloads whose body has no %PDF- header; on by default
+    void set_require_pdf(bool require);
+    // Hard-link a download to an earlier loose file with the same SHA-256
+    void set_dedup(bool enabled);
+    // Let a ConcurrencyController pick the number of simultaneous downloads
+    // between min_limit and the max set above; takes effect on next start
+    void set_adaptive_concurrency(bool enabled, int min_limit = ADAPTIVE_MIN_CONCURRENCY);
 
     // Get current thread count
     int get_max_concurrent_downloads() const { return max_concurrent_downloads_.load(); }
+    bool get_adaptive_concurrency() const { return adaptive_concurrency_.load(); }
+    DownloadEngine get_download_engine() const { return download_engine_; }
+    bool get_http2() const { return http2_; }
+    DiskCheck get_disk_check() const { return disk_check_; }
+    StorageMode get_storage() const { return storage_; }
+    bool get_require_pdf() const { return require_pdf_; }
+    bool get_dedup() const { return dedup_; }
+    // Page scraping stopped on a block this run (see on_scrape_blocked)
+    bool scrape_blocked() const { return scrape_blocked_; }
 
     // Signal that external scraping is active (prevents download worker from exiting)
     void set_external_scraping_active(bool active);
@@ -113,6 +192,7 @@ public:
     int reset_all_to_pending(int data_set);          // Reset ALL statuses to PENDING for redownload
     bool has_pending_work(int data_set);            // Check if there's work to resume
     int clear_data_set(int data_set);               // Delete all records for a data set
+    bool reconcile_stats(int data_set);             // Recompute stats counters from scratch
 
     // Page tracking for scraper
     void mark_page_scraped(int data_set, int page_number, int pdf_count);
@@ -120,48 +200,158 @@ public:
     std::vector<int> get_unscraped_pages(int data_set, int max_page);
 
 private:
+    // Everything a run keeps per data set. Created by start() and left in
+    // place until the next one, so workers hold plain references.
+    struct DataSetRun {
+        DataSetJob job;
+        std::unique_ptr<Scraper> scraper;
+        std::unique_ptr<PackStore> pack_store;  // Set while running with StorageMode::PACK
+        std::thread scraper_thread;
+        std::thread brute_force_thread;
+        DownloadStats stats;  // Guarded by stats_mutex_
+
+        std::atomic<int64_t> total_pages{0};
+        std::atomic<int64_t> pages_unchanged{0};
+        std::atomic<int64_t> bytes_downloaded{0};
+        std::atomic<int64_t> files_rejected{0};
+        std::atomic<int64_t> files_deduplicated{0};
+        std::atomic<uint64_t> brute_force_current{0};
+        std::atomic<uint64_t> brute_force_probed{0};
+        std::atomic<uint64_t> brute_force_found{0};
+        std::atomic<int> brute_force_pass{0};
+    };
+
+    void start_runs(const std::vector<DataSetJob>& jobs, bool download_only);
+    DataSetRun* find_run(int data_set) const;
+    int primary_data_set() const;  // The first data set of the run
+    void join_producers();          // Scraper and brute force threads of every run
+
     // Worker methods
-    void scraper_worker();
-    void brute_force_worker();
+    void scraper_worker(DataSetRun& run);
+    void brute_force_worker(DataSetRun& run);
+    // HTTP status of an existence probe for the file with this numeric ID
+    int probe_file_id(DataSetRun& run, uint64_t id);
     void download_worker();
     void stats_worker();
 
     // Scraping
-    void scrape_page(int page_number);
-    void queue_pdf_for_download(const PdfLink& pdf);
+    void scrape_page(DataSetRun& run, int page_number);
+
+    // Page count detection. Every index page up to the last one lists files of
+    // the data set and none after it does, so the last page can be searched for.
+    enum class PageProbe { LINKS, EMPTY, ERROR };
+    PageProbe probe_page(DataSetRun& run, int page_number);
+    // Block detection for page fetches: the first BLOCK_SCAN_BYTES of a body
+    // are kept for block_reason(), and the first block found is reported
+    static void keep_page_head(std::string& head, const char* data, size_t size);
+    void report_scrape_block(int page_number, const std::string& reason);
+    // Per-file and per-page notifications: to the event channel if one is set
+    void notify_file_status(const std::string& file_id, DownloadStatus status);
+    void notify_page_scraped(int page_number, int pdf_count);
+    // In parallel on scrape_pool_
+    std::vector<PageProbe> probe_pages(DataSetRun& run, const std::vector<int>& pages);
+    // Last page with links, given the highest page known to have links (-1 for
+    // none) and the lowest known not to (-1 for unbounded); -1 if none found
+    int search_max_page(DataSetRun& run, int with_links, int without_links);
+    int detect_max_page(DataSetRun& run);
+
+    // Work dispatch
+    void start_work_queue();
+    void stop_work_queue();  // Releases claimed-but-undispatched rows back to PENDING
+    void notify_new_work();  // Producers call this after inserting PENDING rows
+    // Insert the records whose IDs are not yet known in one batch, dropping
+    // the rest; returns how many were inserted (-1 if the insert failed)
+    int enqueue_files(std::vector<FileRecord>& records);
+    // Due retries first, then pending rows shared between data sets by scheduler_
+    std::vector<FileRecord> refill_work(size_t want);
+    void release_slot();     // A download finished; wakes the dispatcher
+    void arm_retry_wakeup(); // Have the work queue refill when the next retry is due
+    // Queue a final file status on the journal (written behind, batched)
+    void record_status(int64_t id, DownloadStatus status, const std::string& error_msg = "",
+                       int64_t file_size = 0, bool increment_retry = false,
+                       int64_t next_attempt_at = 0, const std::string& sha256 = "",
+                       int is_pdf = -1);
+    // Record a failed attempt and schedule the next one if any are left
+    void record_failure(const FileRecord& file, const std::string& error_msg);
 
     // Downloading
     void download_file(const FileRecord& file);
-    std::string get_local_path(const std::string& file_id) const;
+    void submit_download(const FileRecord& file);
+    void create_download_engine();
+    bool prepare_download(const FileRecord& file);  // False if no transfer is needed
+    // DiskCheck::SCAN: mark every finished download found on disk COMPLETED
+    void reconcile_download_dir(DataSetRun& run);
+    // StorageMode::PACK: open the data set's pack store, unless it can't be
+    void start_pack_store(DataSetRun& run);
+    // Replace file's download with a hard link to an identical earlier one;
+    // true if it was linked
+    bool link_duplicate(const FileRecord& file, const std::string& sha256);
+    void handle_download_result(const FileRecord& file, const DownloadResult& result);
+    std::string cookie_header_for(const std::string& url) const;
+    void configure_cookies(Downloader& downloader, const std::string& url) const;
+    std::string get_local_path(int data_set, const std::string& file_id) const;
 
     // Helper methods
     void log(const std::string& message);
     void update_stats();
+    // Simultaneous downloads allowed right now (the adaptive limit, if enabled)
+    int concurrency_limit() const;
+    void adjust_concurrency(double window_seconds);
 
     // Core components
+    // The socket counter and share are declared first so they outlive every
+    // handle attached to them
+    std::atomic<int64_t> open_connections_{0};
+    std::unique_ptr<CurlShare> curl_share_;
+    std::unique_ptr<DownloaderPool> downloader_pool_;
     std::unique_ptr<Database> db_;
+    std::unique_ptr<StatusJournal> status_journal_;  // Destroyed (and flushed) before db_
     std::unique_ptr<ThreadPool> download_pool_;
+    std::unique_ptr<ThreadPool> completion_pool_;  // Outlives the loops that feed it
+    std::unique_ptr<MultiDownloader> multi_downloader_;
     std::unique_ptr<ThreadPool> scrape_pool_;
-    std::unique_ptr<Scraper> scraper_;
     std::unique_ptr<CookieJar> cookie_jar_;
+    std::unique_ptr<WorkQueue> work_queue_;
+    std::unique_ptr<ConcurrencyController> concurrency_;  // Set while adaptive and running
+    RetryScheduler retry_scheduler_;
+    FairScheduler scheduler_;
+    TransferMetrics transfer_metrics_;
+    KnownIdIndex known_ids_;  // Every file ID with a files row, loaded by initialize()
+    DirectoryCache directories_;  // Shard directories created this run
+    std::string lease_owner_;
 
     // Configuration
     std::string db_path_;
     std::string download_dir_;
-    DataSetConfig current_config_;
-    OperationMode current_mode_;
+    std::vector<std::unique_ptr<DataSetRun>> runs_;
     std::atomic<int> max_concurrent_downloads_{50};  // Default 50 threads
     int max_concurrent_scrapes_ = MAX_CONCURRENT_PAGE_SCRAPES;
     int max_retry_attempts_ = MAX_RETRY_ATTEMPTS;
     std::string cookie_file_;
     std::string cookie_string_;  // Direct cookie string from browser
     bool overwrite_existing_{false};  // Overwrite files that already exist on disk
+    DownloadEngine download_engine_ = DownloadEngine::THREAD_POOL;
+    bool http2_ = false;
+    int max_streams_per_connection_ = DEFAULT_MAX_STREAMS_PER_CONNECTION;
+    std::atomic<int> segments_per_file_{DEFAULT_SEGMENTS_PER_FILE};
+    std::atomic<int64_t> segment_threshold_{DEFAULT_SEGMENT_THRESHOLD};
+    std::atomic<WriteMode> write_mode_{WriteMode::POOLED};
+    DiskCheck disk_check_ = DiskCheck::STAT;
+    StorageMode storage_ = StorageMode::FILES;
+    int64_t pack_bytes_ = PACK_FILE_BYTES;
+    std::atomic<bool> require_pdf_{true};
+    std::atomic<bool> dedup_{false};
+    std::atomic<bool> adaptive_concurrency_{false};
+    std::atomic<int> adaptive_min_{ADAPTIVE_MIN_CONCURRENCY};
 
     // State
     std::atomic<bool> running_{false};
     std::atomic<bool> paused_{false};
     std::atomic<bool> stop_requested_{false};
     std::atomic<bool> external_scraping_active_{false};  // True when browser scraping is active
+    std::atomic<bool> scrape_blocked_{false};
+    std::atomic<int> active_producers_{0};  // Scraper and brute force workers still running
+    std::atomic<EventChannel*> events_{nullptr};
 
     // Statistics
     mutable std::mutex stats_mutex_;
@@ -169,6 +359,15 @@ private:
     std::chrono::steady_clock::time_point start_time_;
     std::atomic<int64_t> active_downloads_{0};
     std::atomic<int64_t> bytes_this_session_{0};
+    std::atomic<int64_t> bytes_resumed_{0};
+
+    // Digest -> local_path of recent loose downloads, for set_dedup. Covers
+    // rows the status journal hasn't written yet; capped at DEDUP_DIGEST_CACHE
+    // with the least recently used digest evicted, older ones are looked up
+    // through the sha256 index instead
+    std::mutex digests_mutex_;
+    std::list<std::pair<std::string, std::string>> digest_order_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> digests_;
     std::atomic<int64_t> wire_time_ms_{0};  // Sum of individual transfer times (for per-connection speed)
 
     // Active transfer time tracking (for aggregate wire speed)
@@ -178,22 +377,22 @@ private:
     std::atomic<int64_t> active_transfer_wall_ms_{0};  // Wall time during which downloads were active
     std::atomic<bool> any_download_active_{false};
 
-    // Brute force state
+    // Last ID probed by any data set's brute force worker
     std::atomic<uint64_t> brute_force_current_{0};
 
     // Callbacks
     DownloadCallbacks callbacks_;
     mutable std::mutex callback_mutex_;
 
-    // Threads
-    std::thread scraper_thread_;
-    std::thread brute_force_thread_;
+    // Threads; scraper and brute force threads belong to their DataSetRun
     std::thread download_thread_;
     std::thread stats_thread_;
 
     // Synchronization
     std::mutex pause_mutex_;
     std::condition_variable pause_cv_;
+    std::mutex slot_mutex_;
+    std::condition_variable slot_cv_;  // Signalled when a download slot frees up
 };
 
 } // namespace efgrabber
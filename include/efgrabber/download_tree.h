@@ -0,0 +1,76 @@
+/*
+ * download_tree.h - What is already on disk under the download directory
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace efgrabber {
+
+// How a download decides whether its file is already on disk
+enum class DiskCheck {
+    STAT,       // stat() the file before every download (the original path)
+    SCAN,       // Walk the data set's directory once at start, then trust the database
+    TRUST_DB    // Never look: the database alone says what is done
+};
+
+// Parse "stat", "scan" or "trust"
+bool parse_disk_check(const std::string& name, DiskCheck& mode);
+const char* disk_check_name(DiskCheck mode);
+
+// Where a data set's file is downloaded, sharded by the first three digits
+// of its number: <download_dir>/DataSet11/022/EFTA02205655.pdf
+std::string download_path(const std::string& download_dir, int data_set, const std::string& file_id);
+
+// A finished download found on disk
+struct LocalFile {
+    std::string file_id;  // File name without the .pdf extension
+    std::string path;
+    int64_t size;
+};
+
+// Every non-empty <file_id>.pdf in the subdirectories of root, which is laid
+// out as download_path() shards it. Partial downloads are
+// .part files and are never listed. Subdirectories are read threads at a
+// time, each with one readdir() pass and an fstatat() per file, which keeps
+// network filesystems busy instead of waiting on one lookup after another.
+std::vector<LocalFile> scan_download_tree(const std::string& root, int threads);
+
+// Directories known to exist, so each is created at most once per run.
+// Thread-safe.
+class DirectoryCache {
+public:
+    // Create path and its parents unless already done; false on failure
+    bool ensure(const std::string& path);
+    void clear();
+
+private:
+    std::mutex mutex_;
+    std::unordered_set<std::string> created_;
+};
+
+} // namespace efgrabber
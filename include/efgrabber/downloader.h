@@ -30,11 +30,25 @@
 #include <atomic>
 #include <mutex>
 #include "efgrabber/common.h"
+#include "efgrabber/file_writer.h"
 
 typedef void CURL;
+typedef void CURLSH;
 
 namespace efgrabber {
 
+// Per-transfer timings as curl reports them: cumulative from the start of
+// the request, in microseconds, -1 where curl had none
+struct TransferTiming {
+    int64_t namelookup_us = -1;     // DNS resolved
+    int64_t connect_us = -1;        // TCP connected
+    int64_t appconnect_us = -1;     // TLS handshake done (0 for plain HTTP)
+    int64_t starttransfer_us = -1;  // First response byte
+    int64_t total_us = -1;
+    int64_t new_connections = 0;    // 0 when an existing connection was reused
+    std::string primary_ip;         // Server (CDN edge) address used
+};
+
 // Download result
 struct DownloadResult {
     bool success;
@@ -46,11 +60,42 @@ struct DownloadResult {
     std::string content_type;
     std::vector<std::string> set_cookie_headers; // Captured Set-Cookie headers
     int64_t download_time_ms;    // Actual transfer time in milliseconds (wire time)
+    int64_t resumed_bytes;       // Bytes kept from an earlier partial file (file size = this + content_length)
+    bool not_modified;           // 304 to a conditional page request (success, no body)
+    std::string etag;            // Response validators, for the next conditional request
+    std::string last_modified;
+    TransferTiming timing;
+    std::string sha256;          // File downloads: hex digest of the finished file
+    bool pdf_signature;          // File downloads: %PDF- header within the first 1024 bytes
+};
+
+// Validators from an earlier response for the same URL, sent as
+// If-None-Match / If-Modified-Since so an unchanged page comes back as a 304
+struct PageValidators {
+    std::string etag;
+    std::string last_modified;
+
+    bool empty() const { return etag.empty() && last_modified.empty(); }
 };
 
 // Progress callback signature
 using ProgressCallback = std::function<void(int64_t downloaded, int64_t total)>;
 
+// Body chunk callback for streamed downloads; return false to abort the transfer
+using DataCallback = std::function<bool(const char* data, size_t size)>;
+
+// Opaque per-transfer state for the split begin/finish file transfer API
+struct FileTransfer;
+struct HeaderData;
+struct RangeRequest;
+struct FileTransferDeleter {
+    void operator()(FileTransfer* transfer) const;
+};
+using FileTransferPtr = std::unique_ptr<FileTransfer, FileTransferDeleter>;
+
+class CurlShare;
+class DownloaderPool;
+
 class Downloader {
 public:
     Downloader();
@@ -65,22 +110,79 @@ public:
     // Download to memory
     DownloadResult download(const std::string& url, int timeout_seconds = DOWNLOAD_TIMEOUT_SECONDS);
 
-    // Download to file
+    // Download to file. Data is written to filepath + PARTIAL_FILE_SUFFIX and renamed
+    // into place on success. If the server advertised byte ranges and a validator
+    // (strong ETag or Last-Modified), a failed transfer keeps the .part file and the
+    // next call for the same path resumes it with Range/If-Range.
     DownloadResult download_to_file(const std::string& url, const std::string& filepath,
                                     ProgressCallback progress_cb = nullptr,
                                     int timeout_seconds = DOWNLOAD_TIMEOUT_SECONDS);
 
+    // Split file transfer API for event-driven engines (see MultiDownloader).
+    // begin_file_transfer() configures the easy handle without performing it and
+    // returns nullptr (with error set) if the target cannot be opened. The caller
+    // drives handle() itself and hands the final CURLcode to finish_file_transfer().
+    // The caller must have exclusive use of this Downloader between the two calls.
+    FileTransferPtr begin_file_transfer(const std::string& url, const std::string& filepath,
+                                        std::string& error,
+                                        ProgressCallback progress_cb = nullptr,
+                                        int timeout_seconds = DOWNLOAD_TIMEOUT_SECONDS);
+    DownloadResult finish_file_transfer(FileTransferPtr transfer, int curl_code);
+    // Drop a transfer that was never finished, keeping its .part file if resumable
+    void abandon_file_transfer(FileTransferPtr transfer);
+    CURL* handle() const { return curl_; }
+
     // Download HTML page
     DownloadResult download_page(const std::string& url, int timeout_seconds = PAGE_TIMEOUT_SECONDS);
+    // Stream a page instead of buffering it: on_data gets each chunk of a 2xx body
+    // from the curl write callback, and result.data stays empty
+    DownloadResult download_page(const std::string& url, const DataCallback& on_data,
+                                 int timeout_seconds = PAGE_TIMEOUT_SECONDS);
+    // Conditional stream: a 304 is reported as success with not_modified set
+    DownloadResult download_page(const std::string& url, const DataCallback& on_data,
+                                 const PageValidators& validators,
+                                 int timeout_seconds = PAGE_TIMEOUT_SECONDS);
 
     // Check if URL exists (HEAD request)
     bool url_exists(const std::string& url);
+    // HTTP status of a HEAD for url, or of a one-byte range GET when the
+    // server refuses HEAD (a 206 is reported as 200); 0 if nothing answered
+    int probe_url(const std::string& url, int timeout_seconds = PROBE_TIMEOUT_SECONDS);
 
     // Set custom headers
     void set_cookie(const std::string& cookie);
     void set_cookie_file(const std::string& cookie_file);
     void set_user_agent(const std::string& user_agent);
 
+    // Attach shared DNS/TLS session caches (nullptr detaches).
+    // The share must outlive this Downloader.
+    void set_share(CurlShare* share);
+
+    // Restore default cookie and user agent before reusing a pooled handle
+    void reset_defaults();
+
+    // Negotiate HTTP/2 over TLS and wait for a multiplexable connection
+    // instead of opening a new one (PIPEWAIT only matters under curl_multi)
+    void set_http2(bool enabled);
+
+    // Count open sockets in *counter (nullptr disables); must outlive the handle
+    void set_socket_counter(std::atomic<int64_t>* counter);
+
+    // Segmented download_to_file(): files are fetched as a single stream unless the
+    // first response's Content-Length exceeds threshold_bytes and the server takes
+    // ranges. That transfer is then stopped before any body is written and the file
+    // fetched as up to `segments` parallel ranges on extra handles, each written in
+    // place through its own FileWriter. 1 disables (the default, restored by
+    // reset_defaults()). The progress callback is then invoked from several
+    // threads, one call at a time. The extra handles come from pool when given,
+    // keeping their connections warm between files, and are created per file
+    // otherwise.
+    void set_segmentation(int segments, int64_t threshold_bytes = DEFAULT_SEGMENT_THRESHOLD,
+                          DownloaderPool* pool = nullptr);
+
+    // How download_to_file() and begin_file_transfer() write the .part file
+    void set_write_mode(WriteMode mode);
+
     // Cancel current download
     void cancel();
     bool is_cancelled() const { return cancelled_.load(); }
@@ -93,16 +195,95 @@ private:
     void init_curl();
     void cleanup_curl();
     void setup_common_options(CURL* curl, const std::string& url);
+    DownloadResult perform_get(const std::string& url, const DataCallback* sink,
+                               const PageValidators* validators, int timeout_seconds);
+    void copy_settings_from(const Downloader& other);
+    void perform_range(const std::string& url, const std::string& if_range,
+                       RangeRequest& request, int timeout_seconds);
+    DownloadResult download_segmented(const std::string& url, const std::string& filepath,
+                                      const HeaderData& first, const TransferTiming& timing,
+                                      ProgressCallback progress_cb, int timeout_seconds);
 
     CURL* curl_ = nullptr;
     std::string cookie_;
     std::string cookie_file_;
     std::string user_agent_;
+    CurlShare* share_ = nullptr;
+    bool http2_ = false;
+    std::atomic<int64_t>* socket_counter_ = nullptr;
+    int segments_ = 1;
+    int64_t segment_threshold_ = DEFAULT_SEGMENT_THRESHOLD;
+    DownloaderPool* segment_pool_ = nullptr;
+    WriteMode write_mode_ = WriteMode::POOLED;
     std::atomic<bool> cancelled_{false};
     std::atomic<int64_t> bytes_downloaded_{0};
     mutable std::mutex mutex_;
 };
 
+// DNS cache and TLS session cache shared by many easy handles, so new
+// connections to the same host skip the lookup and resume the TLS session.
+// Thread-safe: libcurl serialises access through the lock callbacks.
+class CurlShare {
+public:
+    CurlShare();
+    ~CurlShare();
+
+    CurlShare(const CurlShare&) = delete;
+    CurlShare& operator=(const CurlShare&) = delete;
+
+    CURLSH* handle() const { return share_; }
+
+private:
+    friend struct CurlShareCallbacks;
+    static constexpr size_t LOCK_SLOTS = 8;  // >= CURL_LOCK_DATA_LAST
+
+    CURLSH* share_ = nullptr;
+    std::mutex locks_[LOCK_SLOTS];
+};
+
+// Pool of idle Downloaders so workers keep long-lived easy handles (and their
+// warm connections) instead of creating one per request.
+class DownloaderPool {
+public:
+    explicit DownloaderPool(CurlShare* share = nullptr,
+                            std::atomic<int64_t>* socket_counter = nullptr)
+        : share_(share), socket_counter_(socket_counter) {}
+
+    // Applied to every Downloader handed out from now on
+    void set_http2(bool enabled) { http2_ = enabled; }
+
+    // Take an idle Downloader, or create one attached to the share
+    std::unique_ptr<Downloader> acquire();
+
+    // Return a Downloader for reuse; its cookies and user agent are reset
+    void release(std::unique_ptr<Downloader> downloader);
+
+    size_t idle_count() const;
+
+    // RAII handle that returns the Downloader to the pool on destruction
+    class Lease {
+    public:
+        explicit Lease(DownloaderPool& pool) : pool_(pool), downloader_(pool.acquire()) {}
+        ~Lease() { pool_.release(std::move(downloader_)); }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        Downloader& operator*() const { return *downloader_; }
+        Downloader* operator->() const { return downloader_.get(); }
+
+    private:
+        DownloaderPool& pool_;
+        std::unique_ptr<Downloader> downloader_;
+    };
+
+private:
+    CurlShare* share_;
+    std::atomic<int64_t>* socket_counter_;
+    std::atomic<bool> http2_{false};
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Downloader>> idle_;
+};
+
 // RAII wrapper for CURL global init
 class CurlGlobalInit {
 public:
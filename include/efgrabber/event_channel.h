@@ -0,0 +1,84 @@
+/*
+ * event_channel.h - Lock-free queue of download events for a UI thread
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "efgrabber/common.h"
+
+namespace efgrabber {
+
+// A file status change or a scraped index page, copied by value
+struct ManagerEvent {
+    enum class Kind : uint8_t {
+        FILE_STATUS,
+        PAGE_SCRAPED,
+    };
+
+    Kind kind = Kind::FILE_STATUS;
+    DownloadStatus status = DownloadStatus::PENDING;  // FILE_STATUS
+    int32_t page = 0;                                 // PAGE_SCRAPED
+    int32_t count = 0;                                // PAGE_SCRAPED: links found
+    char file_id[16] = {};                            // FILE_STATUS, NUL-terminated
+
+    static ManagerEvent file_status(std::string_view file_id, DownloadStatus status);
+    static ManagerEvent page_scraped(int page, int count);
+};
+
+// Bounded multi-producer, single-consumer queue of ManagerEvents, after
+// Vyukov's bounded MPMC queue: each slot carries a sequence number, so a
+// producer claims a slot with one CAS and never waits on another producer
+// or on the consumer. Workers push from the download path; the UI drains
+// batches on a timer. Events that find the queue full are dropped and
+// counted rather than blocking a worker.
+class EventChannel {
+public:
+    // Capacity is rounded up to a power of two
+    explicit EventChannel(size_t capacity = EVENT_CHANNEL_CAPACITY);
+
+    bool push(const ManagerEvent& event);
+    // Append up to max queued events to out; one consumer thread only
+    size_t drain(std::vector<ManagerEvent>& out, size_t max = SIZE_MAX);
+
+    size_t capacity() const { return mask_ + 1; }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        ManagerEvent event;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> tail_{0};  // Next slot a producer claims
+    alignas(64) size_t head_ = 0;              // Next slot the consumer reads
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace efgrabber
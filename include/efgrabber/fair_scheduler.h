@@ -0,0 +1,69 @@
+/*
+ * fair_scheduler.h - Weighted sharing of download slots between data sets
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace efgrabber {
+
+// Deficit round robin over data sets (Shreedhar and Varghese). Every refill
+// of the work queue is split into rounds; each round credits every data set
+// with a share of the slots still wanted in proportion to its weight, and a
+// set claims as many whole slots as its credit covers. A set that claims
+// fewer than it asked for has nothing pending: it drops out for the rest of
+// the refill and loses its credit, so what it could not use goes to the
+// others. Fractions carry over, so small refills stay fair over time too.
+//
+// Not thread-safe; the work queue's refill is its only caller.
+class FairScheduler {
+public:
+    // Claim up to count files of data_set, returning how many were claimed
+    using Claim = std::function<size_t(int data_set, size_t count)>;
+
+    void add(int data_set, int weight);
+    void clear();
+
+    // Claim up to want files across the data sets; returns how many were claimed
+    size_t distribute(size_t want, const Claim& claim);
+
+    // Files claimed for data_set since it was added
+    uint64_t served(int data_set) const;
+    size_t size() const { return flows_.size(); }
+
+private:
+    struct Flow {
+        int data_set;
+        int weight;
+        double deficit = 0;
+        uint64_t served = 0;
+    };
+
+    std::vector<Flow> flows_;
+    size_t next_ = 0;  // Flow the next round starts with
+};
+
+} // namespace efgrabber
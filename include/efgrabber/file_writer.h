@@ -0,0 +1,95 @@
+/*
+ * file_writer.h - Disk write path for downloaded files
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "efgrabber/common.h"
+
+namespace efgrabber {
+
+// How download_to_file() puts bytes on disk
+enum class WriteMode {
+    STREAM,     // std::ofstream, one write per curl chunk (the original path)
+    POOLED,     // Pooled aligned buffers, preallocation and pwritev()
+    DIRECT      // POOLED with O_DIRECT where the filesystem supports it
+};
+
+// Shared pool of WRITE_BUFFER_BYTES buffers aligned to WRITE_BUFFER_ALIGNMENT,
+// so hundreds of concurrent transfers don't each allocate and fault in their own.
+// Thread-safe; at most max_idle buffers are kept between uses.
+class WriteBufferPool {
+public:
+    explicit WriteBufferPool(size_t max_idle = WRITE_BUFFER_POOL_IDLE);
+    ~WriteBufferPool();
+
+    WriteBufferPool(const WriteBufferPool&) = delete;
+    WriteBufferPool& operator=(const WriteBufferPool&) = delete;
+
+    // nullptr if the allocation failed
+    char* acquire();
+    void release(char* buffer);
+
+    size_t idle_count() const;
+
+    static WriteBufferPool& shared();
+
+private:
+    size_t max_idle_;
+    mutable std::mutex mutex_;
+    std::vector<char*> idle_;
+};
+
+// Sequential writer for one output file. Implementations must behave the same
+// from the caller's point of view: bytes appear in the file in write() order
+// and are all on disk (in the page cache) once close() returns true.
+class FileWriter {
+public:
+    virtual ~FileWriter() = default;
+
+    // Create or open path; append keeps the existing contents and writes after them
+    virtual bool open(const std::string& path, bool append) = 0;
+    // Drop everything in the file, including what was there before open()
+    virtual bool truncate() = 0;
+    // The file is expected to end up final_size bytes long. Only a hint: the
+    // visible file size still grows with the data written.
+    virtual void preallocate(int64_t /*final_size*/) {}
+    virtual bool write(const char* data, size_t size) = 0;
+    // Carry on writing at offset without resizing the file; buffered bytes go
+    // out first. Lets several writers fill disjoint ranges of one file.
+    virtual bool seek(int64_t offset) = 0;
+    // Flush and close; false if any write failed
+    virtual bool close() = 0;
+    virtual bool is_open() const = 0;
+};
+
+std::unique_ptr<FileWriter> make_file_writer(WriteMode mode);
+
+// Parse "stream", "pooled" or "direct"
+bool parse_write_mode(const std::string& name, WriteMode& mode);
+const char* write_mode_name(WriteMode mode);
+
+} // namespace efgrabber
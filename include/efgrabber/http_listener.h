@@ -0,0 +1,80 @@
+/*
+ * http_listener.h - Minimal HTTP server for the local control endpoints
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace efgrabber {
+
+struct HttpRequest {
+    std::string method;   // "GET", "POST", ...
+    std::string path;     // Without the query string
+    std::string body;     // By Content-Length
+};
+
+struct HttpResponse {
+    std::string status = "200 OK";
+    std::string content_type = "text/plain";
+    std::string body;
+};
+
+// One request per connection ("Connection: close"), answered in turn on a
+// background thread. Enough for the metrics endpoint and the shard
+// coordinator, which both answer quickly from memory.
+class HttpListener {
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+    // Clients get timeout_seconds per read or write; a body longer than
+    // max_body bytes drops the connection
+    HttpListener(Handler handler, int timeout_seconds, size_t max_body);
+    ~HttpListener();
+
+    HttpListener(const HttpListener&) = delete;
+    HttpListener& operator=(const HttpListener&) = delete;
+
+    // Listen on bind_address:port (0 picks a free port); false if the socket
+    // could not be set up
+    bool start(int port, const std::string& bind_address, int backlog = 16);
+    void stop();
+
+    int port() const { return port_; }
+
+private:
+    void serve();
+    void handle_client(int fd);
+
+    Handler handler_;
+    int timeout_seconds_;
+    size_t max_body_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+} // namespace efgrabber
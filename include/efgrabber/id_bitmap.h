@@ -0,0 +1,82 @@
+/*
+ * id_bitmap.h - Two-bit probe state for every ID of a brute force range
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace efgrabber {
+
+// What brute force knows about one file ID
+enum class IdState : uint8_t {
+    UNKNOWN = 0,    // Not probed yet, or the probe failed
+    MISSING = 1,    // Probed: 404
+    PRESENT = 2     // Exists, so it has a row in the files table
+};
+
+// Probe state of every ID in [first, last], packed 32 to a 64-bit word.
+// This replaces one PENDING files row per ID: Data Set 9's 1.22M IDs take
+// about 300 KB, and only IDs found PRESENT get a row. Not thread-safe; the
+// brute force worker owns it.
+class IdBitmap {
+public:
+    IdBitmap() = default;
+    IdBitmap(uint64_t first, uint64_t last);
+
+    uint64_t first() const { return first_; }
+    uint64_t last() const { return last_; }
+    uint64_t size() const { return empty() ? 0 : last_ - first_ + 1; }
+    bool empty() const { return last_ < first_; }
+    bool contains(uint64_t id) const { return id >= first_ && id <= last_; }
+
+    // IDs outside the range read as UNKNOWN and are ignored by set()
+    IdState get(uint64_t id) const;
+    void set(uint64_t id, IdState state);
+
+    // Kept up to date by set()
+    uint64_t count(IdState state) const;
+
+    // First UNKNOWN ID at or after from, or last() + 1 if there is none
+    uint64_t next_unknown(uint64_t from) const;
+
+    // The states as little-endian words, for storing in the database
+    std::string serialize() const;
+    // Inverse of serialize() for the same range; nullopt if the size is wrong
+    static std::optional<IdBitmap> deserialize(uint64_t first, uint64_t last, const std::string& bytes);
+
+    // A bitmap over [first, last] keeping the states of the IDs both share
+    IdBitmap rebased(uint64_t first, uint64_t last) const;
+
+private:
+    static constexpr int IDS_PER_WORD = 32;
+
+    uint64_t first_ = 1;
+    uint64_t last_ = 0;
+    std::vector<uint64_t> words_;
+    uint64_t counts_[3] = {0, 0, 0};
+};
+
+} // namespace efgrabber
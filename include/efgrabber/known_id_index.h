@@ -0,0 +1,80 @@
+/*
+ * known_id_index.h - In-memory set of the file IDs already in the database
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "efgrabber/common.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace efgrabber {
+
+class Database;
+
+// Every (data set, file ID) pair with a files row, so enqueueing can drop
+// links it has already seen without a query each. Canonical IDs (EFTA plus
+// eight digits) are kept as bits in 64K-ID chunks, about 8 KB per chunk
+// touched; anything else falls back to a string set. Thread-safe.
+class KnownIdIndex {
+public:
+    // Replace the contents with every files row (one scan); false on error
+    bool load(Database& db);
+
+    // Add the ID; false if it was already known
+    bool insert(int data_set, const std::string& file_id);
+    bool contains(int data_set, const std::string& file_id) const;
+    void erase(int data_set, const std::string& file_id);
+
+    // Drop records whose ID is already known (or repeats an earlier record)
+    // and mark the rest known, under one lock; returns how many were dropped
+    size_t insert_new(std::vector<FileRecord>& records);
+    // Forget IDs insert_new() kept, e.g. after the insert into the database failed
+    void erase(const std::vector<FileRecord>& records);
+
+    void clear(int data_set);
+    size_t size(int data_set) const;
+
+private:
+    static constexpr uint64_t CHUNK_IDS = 65536;
+    using Chunk = std::array<uint64_t, CHUNK_IDS / 64>;
+
+    struct DataSetIds {
+        std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+        std::unordered_set<std::string> others;
+        size_t count = 0;
+    };
+
+    bool insert_locked(int data_set, const std::string& file_id);
+    void erase_locked(int data_set, const std::string& file_id);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, DataSetIds> data_sets_;
+};
+
+} // namespace efgrabber
@@ -0,0 +1,160 @@
+/*
+ * metrics.h - Transfer timing histograms and metrics endpoint
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "efgrabber/common.h"
+#include "efgrabber/downloader.h"
+#include "efgrabber/http_listener.h"
+
+namespace efgrabber {
+
+// Fixed-bucket histogram that observe() updates with relaxed atomics only,
+// so any number of transfer threads can record into it without a lock.
+// Bounds are inclusive upper bucket limits in ascending order; values above
+// the last bound land in an overflow bucket.
+class Histogram {
+public:
+    explicit Histogram(std::vector<int64_t> bounds);
+
+    void observe(int64_t value);
+
+    struct Snapshot {
+        std::vector<int64_t> bounds;
+        std::vector<uint64_t> counts;   // bounds.size() + 1 entries, not cumulative
+        uint64_t count = 0;
+        int64_t sum = 0;
+
+        // Estimated value at quantile q (0..1), interpolated within the bucket
+        double quantile(double q) const;
+        double mean() const { return count ? static_cast<double>(sum) / count : 0; }
+    };
+
+    // Consistent enough for reporting; concurrent observe() calls may be
+    // split across the fields
+    Snapshot snapshot() const;
+
+    // 1, 2, 5 steps per decade from first to last
+    static std::vector<int64_t> decades(int64_t first, int64_t last);
+
+private:
+    std::vector<int64_t> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> sum_{0};
+};
+
+// Transfer phases as durations, derived from curl's cumulative timings
+enum class TransferPhase {
+    DNS,        // Name lookup
+    CONNECT,    // TCP handshake
+    TLS,        // TLS handshake
+    TTFB,       // Request sent to first response byte (server time)
+    BODY,       // First to last response byte
+    TOTAL,
+    COUNT
+};
+
+const char* transfer_phase_name(TransferPhase phase);
+
+// Per-transfer timings, HTTP codes and sizes recorded by DownloadManager for
+// every finished file and reported by efgrabber-cli. The connection phases
+// are only recorded for transfers that opened a new connection, since a
+// reused connection reports them as zero. Per-edge figures are keyed by the
+// server address curl connected to, to single out a bad CDN edge.
+class TransferMetrics {
+public:
+    TransferMetrics();
+
+    void record(const DownloadResult& result);
+
+    Histogram::Snapshot phase(TransferPhase which) const;
+    Histogram::Snapshot sizes() const { return sizes_.snapshot(); }
+    // Count per HTTP code; 0 counts transfers that got no response at all
+    std::map<int, uint64_t> status_codes() const;
+    uint64_t connections_opened() const { return connections_opened_.load(std::memory_order_relaxed); }
+
+    struct EdgeStats {
+        uint64_t transfers = 0;
+        uint64_t errors = 0;        // No response, 403/429 or 5xx
+        int64_t ttfb_us_sum = 0;    // Request start to first byte, connection setup included
+        int64_t total_us_sum = 0;
+    };
+    std::map<std::string, EdgeStats> edges() const;
+
+    static constexpr size_t MAX_EDGES = 64;     // Further addresses are not tracked
+
+private:
+    static constexpr int MAX_HTTP_CODE = 600;
+
+    std::array<std::unique_ptr<Histogram>, static_cast<size_t>(TransferPhase::COUNT)> phases_;
+    Histogram sizes_;
+    std::array<std::atomic<uint64_t>, MAX_HTTP_CODE> status_codes_{};
+    std::atomic<uint64_t> connections_opened_{0};
+
+    mutable std::mutex edges_mutex_;
+    std::map<std::string, EdgeStats> edges_;
+};
+
+// Prometheus text exposition of the run's counters and the transfer metrics
+std::string format_prometheus(const DownloadStats& stats, const TransferMetrics& metrics);
+
+// The same as one line of JSON: counters, phase percentiles in milliseconds,
+// HTTP codes and per-edge figures
+std::string format_json(const DownloadStats& stats, const TransferMetrics& metrics);
+
+// Minimal HTTP server for scraping: answers GET /metrics with whatever the
+// handler returns and everything else with 404, one connection at a time.
+class MetricsServer {
+public:
+    using Handler = std::function<std::string()>;
+
+    explicit MetricsServer(Handler handler);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listen on bind_address:port; false if the socket could not be set up
+    bool start(int port, const std::string& bind_address = "127.0.0.1");
+    void stop();
+
+    int port() const { return listener_.port(); }
+
+private:
+    HttpResponse respond(const HttpRequest& request);
+
+    Handler handler_;
+    HttpListener listener_;
+};
+
+} // namespace efgrabber
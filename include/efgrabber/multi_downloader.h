@@ -0,0 +1,98 @@
+/*
+ * multi_downloader.h - Event-driven download engine built on curl_multi
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include "efgrabber/common.h"
+#include "efgrabber/downloader.h"
+
+namespace efgrabber {
+
+// A file transfer queued on the multi engine
+struct MultiTransferRequest {
+    std::string url;
+    std::string filepath;
+    std::string cookie;          // Cookie header value (preferred)
+    std::string cookie_file;     // Netscape cookie file, used if cookie is empty
+    int timeout_seconds = DOWNLOAD_TIMEOUT_SECONDS;
+    // Invoked on the event loop thread when the transfer finishes - keep it short
+    std::function<void(const DownloadResult&)> on_complete;
+};
+
+// Engine settings, fixed for the lifetime of a MultiDownloader
+struct MultiDownloaderConfig {
+    size_t loop_threads = 1;
+    CurlShare* share = nullptr;                    // Optional DNS/TLS session share
+    bool http2 = false;                            // Multiplex transfers as HTTP/2 streams
+    long max_streams = DEFAULT_MAX_STREAMS_PER_CONNECTION;  // Per connection, when http2
+    std::atomic<int64_t>* socket_counter = nullptr;  // Optional open socket count
+    WriteMode write_mode = WriteMode::POOLED;
+};
+
+// Event-driven download engine.
+// Each event loop thread drives many concurrent transfers over one CURLM handle,
+// so high concurrency costs file descriptors instead of OS threads. Easy handles
+// are recycled per loop, which also keeps their connection caches warm.
+// An optional CurlShare extends DNS and TLS session reuse across loops. In
+// HTTP/2 mode new transfers wait for a multiplexable connection, so a loop
+// needs roughly one socket per max_streams transfers.
+class MultiDownloader {
+public:
+    explicit MultiDownloader(const MultiDownloaderConfig& config = MultiDownloaderConfig());
+    ~MultiDownloader();
+
+    // Non-copyable, non-movable
+    MultiDownloader(const MultiDownloader&) = delete;
+    MultiDownloader& operator=(const MultiDownloader&) = delete;
+    MultiDownloader(MultiDownloader&&) = delete;
+    MultiDownloader& operator=(MultiDownloader&&) = delete;
+
+    // Queue a transfer; returns false if the engine is shut down
+    bool submit(MultiTransferRequest request);
+
+    // Abort all transfers and join the loop threads.
+    // Completion callbacks are not invoked for aborted transfers.
+    void shutdown();
+
+    // Engine status
+    size_t active_transfers() const;
+    size_t queued_transfers() const;
+    size_t loop_count() const { return loops_.size(); }
+    bool is_running() const { return !stop_.load(); }
+
+private:
+    struct Loop;
+    void loop_thread(Loop* loop);
+
+    MultiDownloaderConfig config_;
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::atomic<size_t> next_loop_{0};
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace efgrabber
@@ -0,0 +1,163 @@
+/*
+ * pack_store.h - Append-only tar pack files for completed downloads
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "efgrabber/common.h"
+
+namespace efgrabber {
+
+class Database;
+
+// Where completed downloads are kept
+enum class StorageMode {
+    FILES,  // One file per document under the ID-sharded directories
+    PACK    // Appended to rolling pack files, indexed in the files table
+};
+
+// Parse "files" or "pack"
+bool parse_storage_mode(const std::string& name, StorageMode& mode);
+const char* storage_mode_name(StorageMode mode);
+
+// One document inside a pack: its name (the path it would have under the
+// download directory) and where its bytes start
+struct PackMember {
+    std::string name;
+    int64_t offset;  // Of the data, past the 512-byte header
+    int64_t size;
+};
+
+// Appends members to pack files named <prefix>-NNNNN.tar in a directory.
+// The layout is plain ustar, so `tar tf` and `tar xf` read a pack as is, and
+// every member's data is contiguous at a known offset. The end-of-archive
+// blocks are written by close() and overwritten by the next open(), so a
+// pack is only a complete tar archive while no writer has it open.
+// Not thread-safe; PackStore owns one.
+class PackWriter {
+public:
+    PackWriter(std::string directory, std::string prefix, int64_t max_bytes = PACK_FILE_BYTES);
+    ~PackWriter();
+
+    PackWriter(const PackWriter&) = delete;
+    PackWriter& operator=(const PackWriter&) = delete;
+
+    // Continue pack_id at end (the end of its last indexed member), dropping
+    // whatever follows: a torn append or the end-of-archive blocks. A pack
+    // shorter than end, or end -1, starts the first pack number from pack_id
+    // on that does not exist yet.
+    bool open(int pack_id, int64_t end);
+    // Copy the file at source_path in as name, rolling over to a new pack
+    // first if this one would grow past max_bytes; nullopt on error, with
+    // the pack left as it was
+    std::optional<PackMember> append(const std::string& name, const std::string& source_path);
+    // Make everything appended so far durable
+    bool sync();
+    // Write the end-of-archive blocks and close
+    void close();
+
+    int pack_id() const { return pack_id_; }
+    int64_t end() const { return end_; }
+    std::string pack_path(int pack_id) const;
+
+private:
+    bool open_new(int first_id);
+
+    std::string directory_;
+    std::string prefix_;
+    int64_t max_bytes_;
+    int fd_ = -1;
+    int pack_id_ = -1;
+    int64_t end_ = 0;
+};
+
+// Every member of the pack at path, in order; false if the file can't be
+// read or a header is corrupt (members before it are still returned)
+bool read_pack_index(const std::string& path, std::vector<PackMember>& members);
+// Copy one member out of a pack to out_path, creating its directories
+bool extract_pack_member(const std::string& pack_path, const PackMember& member,
+                         const std::string& out_path);
+
+// Moves completed downloads of one data set into packs on its own thread, so
+// transfers never wait on the copy. Files are appended in batches; each batch
+// is synced, then indexed (pack_id/pack_offset in the files table) in one
+// transaction, and only then are the loose files removed. A crash at any
+// point leaves every document either loose or indexed in a pack. When live
+// submissions run dry it also packs COMPLETED rows an earlier run left loose.
+class PackStore {
+public:
+    PackStore(Database& db, int data_set, const std::string& download_dir,
+              int64_t max_pack_bytes = PACK_FILE_BYTES);
+    ~PackStore();  // stop()
+
+    PackStore(const PackStore&) = delete;
+    PackStore& operator=(const PackStore&) = delete;
+
+    // Reopen the data set's last pack and start packing; false on error
+    bool start();
+    // Queue a completed download (callable from any thread)
+    void submit(int64_t file_row_id, const std::string& local_path);
+    // Pack what is queued (not the backlog), then close the pack
+    void stop();
+
+    int64_t files_packed() const { return files_packed_.load(); }
+    int64_t bytes_packed() const { return bytes_packed_.load(); }
+
+private:
+    struct Entry {
+        int64_t id;
+        std::string path;
+    };
+
+    void packer_thread();
+    std::vector<Entry> next_batch();       // Blocks until there is work or stop
+    void pack_batch(const std::vector<Entry>& batch);
+    std::string member_name(const std::string& path) const;
+
+    Database& db_;
+    int data_set_;
+    std::string download_dir_;
+    PackWriter writer_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Entry> queue_;
+    bool stop_ = false;
+    bool backlog_done_ = false;
+    int64_t backlog_after_ = 0;            // Last row id the backlog scan returned
+    std::unordered_set<int64_t> packed_;   // Packed rows above the backlog cursor (live and backlog overlap)
+    std::atomic<int64_t> files_packed_{0};
+    std::atomic<int64_t> bytes_packed_{0};
+    std::thread thread_;
+};
+
+} // namespace efgrabber
@@ -0,0 +1,103 @@
+/*
+ * probe_planner.h - Order of brute force existence probes
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "efgrabber/common.h"
+#include "efgrabber/id_bitmap.h"
+
+namespace efgrabber {
+
+// Decides which IDs brute force probes next. File IDs are Bates page
+// numbers: an existing file is followed by as many missing IDs as it has
+// pages, and a probe inside a document looks just like one in a real gap.
+// So no ID can be skipped, but the order matters a great deal: right after
+// a hit the next document is likely a few IDs away, deep into a long run of
+// misses it is not.
+//
+// The range is split into short regions, each walked one ID at a time.
+// Every round probes the IDs with the best chance of being a document
+// start: the walk's distance from its last hit (its "age") is looked up in
+// the hazard P(length = age | length >= age) of the document lengths seen
+// so far, taken from the gaps between consecutive hits in the bitmap. Walks
+// in dense runs of short documents race ahead, walks inside long documents
+// wait, and every ID is still visited exactly once.
+//
+// IDs whose probe failed stay UNKNOWN; once every walk is done, up to
+// retry_passes further passes revisit them. Walks and document lengths are
+// recomputed from the bitmap, so a resumed run only needs the bitmap.
+class ProbePlanner {
+public:
+    ProbePlanner(const IdBitmap& bitmap, int width, int retry_passes = MAX_RETRY_ATTEMPTS);
+
+    // Up to width IDs to probe now, moving on to the next pass when the
+    // current one is exhausted; empty once every pass is done. Returned IDs
+    // should be reported before the following call.
+    std::vector<uint64_t> next_batch();
+
+    // Outcome of probing id; UNKNOWN for a failed probe. The caller updates
+    // the bitmap itself.
+    void report(uint64_t id, IdState state);
+
+    int pass() const { return pass_; }
+    bool done() const { return done_; }
+    uint64_t documents_measured() const { return measured_; }
+
+    static constexpr uint64_t REGION_IDS = 32;       // IDs per walk...
+    static constexpr size_t MAX_REGIONS = 16384;     // ...up to this many walks
+    static constexpr size_t MAX_TRACKED_LENGTH = 4096;  // Longer documents share one bucket
+
+private:
+    struct Walk {
+        uint64_t first;
+        uint64_t last;
+        uint64_t next;          // First ID not handed out yet
+        uint64_t last_hit;      // Latest PRESENT ID before next, or first - 1
+        int outstanding;        // Handed out, not reported
+    };
+
+    void start_pass();
+    void learn_lengths();
+    void record_length(uint64_t length);
+    double hazard(uint64_t age);
+    void skip_known(Walk& walk);     // Moves next past IDs an earlier run settled
+    void hand_out(Walk& walk, std::vector<uint64_t>& batch);
+    Walk* walk_for(uint64_t id);
+
+    const IdBitmap& bitmap_;
+    size_t width_;
+    std::vector<Walk> walks_;
+    int pass_ = 0;
+    int retry_passes_;
+    bool done_ = false;
+
+    // Document lengths from closed gaps, and the hazard table built from them
+    std::vector<uint64_t> lengths_;
+    uint64_t measured_ = 0;
+    std::vector<double> hazard_;
+    bool hazard_stale_ = true;
+};
+
+} // namespace efgrabber
@@ -0,0 +1,74 @@
+/*
+ * retry_scheduler.h - Deadline-ordered queue of failed downloads awaiting retry
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+#include "efgrabber/common.h"
+
+namespace efgrabber {
+
+// Min-heap of retry deadlines for FAILED rows, keyed by the next_attempt_at
+// column (unix seconds). DownloadManager seeds it from the database when a
+// run starts and schedules each new failure; the work queue takes whatever
+// is due on every refill, alongside pending rows.
+//
+// Entries are never removed early. One that went stale (the row was reset
+// or retried some other way) is harmless: claiming re-checks the row's
+// status and deadline in the database.
+class RetryScheduler {
+public:
+    // Seconds to wait before attempt retry_count + 1: an S-curve that stays
+    // short for the first few failures, then climbs to a ten minute plateau
+    static int64_t backoff_seconds(int retry_count);
+
+    void schedule(int64_t id, int64_t due);
+    void schedule(const std::vector<RetryDeadline>& deadlines);
+
+    // Remove and return up to limit ids whose deadline is at or before now
+    std::vector<int64_t> take_due(int64_t now, size_t limit);
+
+    // Earliest deadline still queued
+    std::optional<int64_t> next_due() const;
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+private:
+    using Entry = RetryDeadline;
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.next_attempt_at > b.next_attempt_at;
+        }
+    };
+
+    mutable std::mutex mutex_;
+    std::priority_queue<Entry, std::vector<Entry>, Later> heap_;
+};
+
+} // namespace efgrabber
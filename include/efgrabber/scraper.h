@@ -25,7 +25,9 @@
 
 #include <string>
 #include <vector>
-#include <regex>
+#include <string_view>
+#include <functional>
+#include <unordered_set>
 #include "efgrabber/common.h"
 
 namespace efgrabber {
@@ -66,11 +68,58 @@ public:
     const DataSetConfig& config() const { return config_; }
 
 private:
-    static std::string build_pdf_regex(int data_set_id);
+    friend class LinkScanner;
+
+    // Invoke on_href(std::string_view) for each of this data set's PDF hrefs;
+    // returns how much of html is decided (all of it when final)
+    template <typename Callback>
+    size_t scan_pdf_hrefs(std::string_view html, bool final, Callback&& on_href) const;
+    bool make_link(std::string_view href, PdfLink& link) const;
 
     DataSetConfig config_;
-    std::regex pdf_link_regex_;
-    std::regex file_id_regex_;
+    std::string data_set_id_;   // Decimal data set number, as it appears in links
+};
+
+// Why an index page response is a block rather than a listing: "HTTP 403" /
+// "HTTP 429", or the challenge markup found in head (the start of the body).
+// "" for anything else. Only bodies without links need the markup check.
+std::string block_reason(int http_code, std::string_view head);
+
+// Incremental extract_pdf_links() for a page that arrives in chunks, e.g. from
+// a curl write callback. Only an href still open at the end of a chunk is kept
+// between feeds, so the page is never buffered whole. Links are reported once
+// each, in page order, as soon as their closing quote arrives.
+class LinkScanner {
+public:
+    using LinkCallback = std::function<void(PdfLink&& link)>;
+
+    // The scraper must outlive the scanner
+    LinkScanner(const Scraper& scraper, LinkCallback on_link);
+
+    void feed(const char* data, size_t size);
+    // End of page: settles whatever the last chunk left open
+    void finish();
+
+    size_t links_found() const { return links_found_; }
+    size_t bytes_scanned() const { return bytes_scanned_; }
+    // FNV-1a over the reported links in order. Unlike a hash of the body it
+    // ignores markup that changes on every request (tokens, timestamps).
+    uint64_t links_hash() const { return links_hash_; }
+
+private:
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    size_t scan(std::string_view text, bool final);
+
+    const Scraper& scraper_;
+    LinkCallback on_link_;
+    std::string carry_;                      // Undecided tail of the previous chunk
+    std::unordered_set<std::string> seen_;   // File IDs already reported
+    size_t links_found_ = 0;
+    size_t bytes_scanned_ = 0;
+    uint64_t links_hash_ = FNV_OFFSET_BASIS;
+    bool finished_ = false;
 };
 
 } // namespace efgrabber
@@ -0,0 +1,199 @@
+/*
+ * shard.h - Coordinator and workers of a run spread over several nodes
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "efgrabber/common.h"
+#include "efgrabber/database.h"
+#include "efgrabber/download_manager.h"
+#include "efgrabber/http_listener.h"
+#include "efgrabber/id_bitmap.h"
+
+namespace efgrabber {
+
+// A distributed run has one coordinator, which owns the database, and any
+// number of workers, each on its own egress IP. The coordinator leases out
+// ranges of index pages and of brute force IDs; a worker runs an ordinary
+// DownloadManager over its range with a scratch database, renews the lease
+// while it works, and reports what it found when it is done. A lease that is
+// not renewed in SHARD_LEASE_SECONDS is handed to the next worker that asks.
+//
+// Requests are HTTP POSTs with line-based text bodies:
+//
+//   /lease   "worker NAME"      -> "lease ID pages|ids DATA_SET FIRST LAST"
+//                                  plus "base_url URL" and "file_url_base URL",
+//                                  "wait SECONDS" or "done"
+//   /renew   "lease ID"         -> "ok", or "lost" once it was reassigned
+//   /report  "lease ID" and up to SHARD_REPORT_LINES of
+//              "page NUMBER PDF_COUNT"       (a page that was scraped)
+//              "file FILE_ID STATUS SIZE"    (a files row)
+//              "ids FIRST STATES"            (IdState digits from FIRST on)
+//                               -> "ok" or "lost"; results count either way
+//   /done    "lease ID"         -> "ok" or "lost"
+
+// A range of work handed to one worker
+struct ShardLease {
+    enum class Kind { PAGES, IDS };
+
+    int64_t id = 0;
+    Kind kind = Kind::PAGES;
+    int data_set = 0;
+    uint64_t first = 0;  // Index pages or file IDs, inclusive
+    uint64_t last = 0;
+};
+
+class ShardCoordinator {
+public:
+    // Hands out the work of jobs, as a single-node run of them would do it.
+    // download_dir is where workers' files are recorded as being; copy their
+    // output directories into it to have them in one place.
+    ShardCoordinator(Database& db, const std::vector<DataSetJob>& jobs, const std::string& download_dir);
+    ~ShardCoordinator();
+
+    ShardCoordinator(const ShardCoordinator&) = delete;
+    ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+
+    // Read page counts, unscraped pages and ID bitmaps from the database
+    void load();
+
+    // Listen on bind_address:port; false if the socket could not be set up
+    bool start(int port, const std::string& bind_address = "127.0.0.1");
+    void stop();
+    int port() const { return listener_.port(); }
+
+    // Answer one request; the server calls this for every POST
+    std::string handle(const std::string& path, const std::string& body);
+
+    // Nothing left to lease and no lease outstanding
+    bool finished() const;
+    size_t active_leases() const;
+    size_t workers_seen() const;
+    int64_t leases_reassigned() const { return reassigned_.load(); }
+
+private:
+    struct ActiveLease {
+        ShardLease lease;
+        std::string worker;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // What is left to hand out for one data set
+    struct DataSetWork {
+        DataSetJob job;
+        bool pages = false;  // Page ranges to lease (scraper, hybrid and refresh modes)
+        bool ids = false;    // ID ranges to lease (brute force and hybrid modes)
+        bool pages_done = false;
+        bool ids_done = false;
+
+        // Pages: queued ranges are leased first, as far as they are still
+        // unscraped, then the frontier moves on until a page has no links
+        std::deque<std::pair<int64_t, int64_t>> page_ranges;
+        int64_t next_page = 0;
+        int64_t last_page = -1;
+        bool end_known = false;
+
+        // IDs: passes over the bitmap's UNKNOWN IDs, reclaimed ranges first
+        IdBitmap bitmap;
+        uint64_t next_id = 0;
+        int pass = 0;
+        std::deque<std::pair<uint64_t, uint64_t>> id_ranges;
+    };
+
+    // Called with mutex_ held
+    std::string acquire(const std::string& worker);
+    std::optional<ShardLease> next_lease();
+    std::optional<ShardLease> next_page_lease(DataSetWork& work);
+    std::optional<ShardLease> next_id_lease(DataSetWork& work);
+    bool leases_outstanding(int data_set, ShardLease::Kind kind) const;
+    bool all_done() const;
+    void reclaim_expired();
+    void requeue(const ShardLease& lease);
+    void apply_report(DataSetWork& work, const std::vector<std::string>& lines);
+    void end_of_pages(DataSetWork& work, int64_t empty_page);
+    DataSetWork* find_work(int data_set);
+
+    HttpResponse respond(const HttpRequest& request);
+
+    Database& db_;
+    std::string download_dir_;
+    std::vector<DataSetWork> sets_;
+    std::map<int64_t, ActiveLease> leases_;
+    std::map<int64_t, ShardLease> issued_;  // Every lease handed out, for late reports
+    size_t next_set_ = 0;
+    std::set<std::string> workers_;
+    int64_t next_lease_id_ = 1;
+    std::atomic<int64_t> reassigned_{0};
+    mutable std::mutex mutex_;
+
+    HttpListener listener_;  // Last, so it stops before the state it serves goes
+};
+
+class ShardWorker {
+public:
+    // Called on every lease's DownloadManager before it starts, to apply
+    // the command line's options
+    using Configure = std::function<void(DownloadManager&)>;
+    // Called after each lease with the stats of its run
+    using LeaseDone = std::function<void(const ShardLease&, const DownloadStats&, bool completed)>;
+
+    // coordinator is "HOST:PORT"; scratch databases live in download_dir/.shard
+    ShardWorker(const std::string& coordinator, const std::string& download_dir,
+                const std::string& name, Configure configure);
+
+    // Work leases until the coordinator has none left or interrupted is set;
+    // returns the number of leases completed
+    int run(const std::atomic<bool>& interrupted);
+
+    void set_on_lease_done(LeaseDone callback) { on_lease_done_ = std::move(callback); }
+    // The scrape of a lease was blocked; run() stops so another node's IP takes over
+    bool blocked() const { return blocked_; }
+
+private:
+    // Run one lease; false if it was lost or interrupted
+    bool work(const ShardLease& lease, const DataSetConfig& config, const IdBitmap& known,
+              const std::atomic<bool>& interrupted);
+    bool send_results(const ShardLease& lease, const std::string& db_path);
+    std::optional<std::string> post(const std::string& path, const std::string& body);
+
+    std::string base_url_;
+    std::string download_dir_;
+    std::string name_;
+    Configure configure_;
+    LeaseDone on_lease_done_;
+    bool blocked_ = false;
+};
+
+} // namespace efgrabber
@@ -0,0 +1,103 @@
+/*
+ * status_journal.h - Write-behind group commit of file status updates
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include "efgrabber/common.h"
+#include "efgrabber/database.h"
+
+namespace efgrabber {
+
+// Write-behind journal for file status updates.
+// Workers push() into a lock-free MPSC list; a flusher thread applies the
+// accumulated updates in a single transaction every flush_interval, or as
+// soon as batch_size updates are waiting. Updates for the same row are
+// applied in push order.
+//
+// A batch the database rejects (busy, locked, disk full) is kept and retried
+// ahead of newer updates, with the wait doubling up to STATUS_RETRY_MAX_MS.
+// Its rows are IN_PROGRESS under this process's lease, which no claim in the
+// same run takes back, so dropping it would leave the run waiting on them.
+//
+// Crash semantics: updates still in the journal when the process dies are
+// lost. The affected rows simply remain IN_PROGRESS (as claimed by the work
+// queue), so reset_in_progress_files() or lease expiry returns them to
+// PENDING and they are downloaded again on the next run. Completed files
+// already on disk are then skipped by the existing-file check.
+class StatusJournal {
+public:
+    StatusJournal(Database& db,
+                  std::chrono::milliseconds flush_interval = std::chrono::milliseconds(STATUS_FLUSH_INTERVAL_MS),
+                  size_t batch_size = STATUS_FLUSH_BATCH);
+    ~StatusJournal();  // Stops the flusher and flushes what is left
+
+    // Non-copyable
+    StatusJournal(const StatusJournal&) = delete;
+    StatusJournal& operator=(const StatusJournal&) = delete;
+
+    // Queue an update (lock-free, callable from any thread)
+    void push(StatusUpdate update);
+
+    // Apply everything pushed so far before returning; on failure the
+    // updates stay queued for the next flush()
+    bool flush();
+
+    void stop();
+
+    // Statistics
+    size_t pending() const { return pending_.load() + retrying_.load(); }
+    int64_t flushed_total() const { return flushed_total_.load(); }
+    int64_t transactions() const { return transactions_.load(); }
+
+private:
+    struct Node {
+        StatusUpdate update;
+        Node* next;
+    };
+
+    void flusher_thread();
+
+    Database& db_;
+    std::chrono::milliseconds flush_interval_;
+    size_t batch_size_;
+
+    std::atomic<Node*> head_{nullptr};   // Newest first (Treiber stack)
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> retrying_{0};    // Size of failed_
+    std::atomic<int64_t> flushed_total_{0};
+    std::atomic<int64_t> transactions_{0};
+
+    std::mutex flush_mutex_;             // Serialises flushes so per-row order holds
+    std::vector<StatusUpdate> failed_;   // Rejected batch, applied before newer updates
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+} // namespace efgrabber
@@ -1,5 +1,5 @@
 /*
- * thread_pool.h - Generic thread pool implementation
+ * thread_pool.h - Work-stealing thread pool
  * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -25,19 +25,119 @@
 
 #include <thread>
 #include <vector>
-#include <queue>
 #include <functional>
 #include <mutex>
 #include <condition_variable>
+#include <cstddef>
 #include <atomic>
 #include <future>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace efgrabber {
 
+// Move-only type-erased void() callable. Callables up to INLINE_SIZE bytes
+// with a noexcept move are stored in place, so submitting a lambda that
+// captures a FileRecord does not allocate; larger ones go to the heap.
+class Task {
+public:
+    static constexpr size_t INLINE_SIZE = 208;
+
+    Task() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {  // NOLINT: implicit, so lambdas convert at submit_detached()
+        using Callable = std::decay_t<F>;
+        if constexpr (fits_inline<Callable>()) {
+            ::new (static_cast<void*>(buffer_)) Callable(std::forward<F>(f));
+            ops_ = &inline_ops<Callable>;
+        } else {
+            ::new (static_cast<void*>(buffer_)) Callable*(new Callable(std::forward<F>(f)));
+            ops_ = &heap_ops<Callable>;
+        }
+    }
+
+    Task(Task&& other) noexcept { take(other); }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    void operator()() { ops_->invoke(buffer_); }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* to, void* from);  // Leaves from destroyed
+        void (*destroy)(void* storage);
+    };
+
+    template<typename Callable>
+    static constexpr bool fits_inline() {
+        return sizeof(Callable) <= INLINE_SIZE &&
+               alignof(Callable) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Callable>;
+    }
+
+    template<typename Callable>
+    static constexpr Ops inline_ops = {
+        [](void* storage) { (*static_cast<Callable*>(storage))(); },
+        [](void* to, void* from) {
+            ::new (to) Callable(std::move(*static_cast<Callable*>(from)));
+            static_cast<Callable*>(from)->~Callable();
+        },
+        [](void* storage) { static_cast<Callable*>(storage)->~Callable(); },
+    };
+
+    template<typename Callable>
+    static constexpr Ops heap_ops = {
+        [](void* storage) { (**static_cast<Callable**>(storage))(); },
+        [](void* to, void* from) { ::new (to) Callable*(*static_cast<Callable**>(from)); },
+        [](void* storage) { delete *static_cast<Callable**>(storage); },
+    };
+
+    void take(Task& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(buffer_, other.buffer_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(buffer_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char buffer_[INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+};
+
+// Work-stealing pool. Each worker owns a deque: tasks submitted from outside
+// are dealt round-robin across the deques, tasks submitted from a worker go
+// to its own, and a worker whose deque is empty steals from the others
+// before it sleeps.
+//
+// max_queued bounds the tasks waiting to run (0 = unbounded). When full,
+// submit_detached() and submit() block until a worker takes a task, and
+// try_submit_detached() fails. Submissions made from one of the pool's own
+// workers are never bounded, since blocking there could deadlock the pool.
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t num_threads);
+    explicit ThreadPool(size_t num_threads, size_t max_queued = 0);
     ~ThreadPool();
 
     // Non-copyable, non-movable
@@ -51,11 +151,19 @@ public:
     auto submit(F&& f, Args&&... args) -> std::future<decltype(f(args...))>;
 
     // Submit a task without caring about the result
-    void submit_detached(std::function<void()> task);
+    void submit_detached(Task task);
+    // As submit_detached(), but false instead of waiting if the pool is full
+    // (or stopped)
+    bool try_submit_detached(Task task);
 
     // Get pool status
-    size_t queue_size() const;
+    size_t queue_size() const { return queued_.load(); }  // Tasks waiting to run
+    size_t peak_queue_size() const { return peak_queued_.load(); }
+    size_t max_queued() const { return max_queued_; }
     size_t active_tasks() const { return active_tasks_.load(); }
+    size_t completed_tasks() const { return completed_tasks_.load(); }
+    size_t steal_count() const { return steals_.load(); }       // Tasks run by a worker other than the one queued on
+    size_t rejected_tasks() const { return rejected_.load(); }  // try_submit_detached() refusals
     size_t thread_count() const { return workers_.size(); }
     bool is_running() const { return !stop_.load(); }
 
@@ -70,19 +178,53 @@ public:
     void set_error_handler(ErrorHandler handler);
 
 private:
-    void worker_thread();
+    // One per worker, on its own cache line. A growable ring rather than a
+    // std::deque, which would allocate a block every other Task.
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::vector<Task> ring;
+        size_t head = 0;
+        size_t count = 0;
+        std::atomic<size_t> size{0};  // count, readable without the lock by thieves
+
+        void push_back(Task task);
+        bool pop_front(Task& task);
+    };
+
+    void worker_thread(size_t index);
+    // Count one more task, waiting for room if bounded and wait; returns the
+    // new count, or 0 if stopped (or full and !wait)
+    size_t reserve(bool wait);
+    void enqueue(Task task, size_t queued);  // After reserve()
+    bool take(size_t index, Task& task);  // Own deque first, then steal
+    int worker_index() const;    // Calling worker's index, or -1 for outside threads
+    void wake_worker(bool force);
 
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-
-    mutable std::mutex queue_mutex_;
-    std::condition_variable condition_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    size_t max_queued_;
+
+    // Tasks from reserve() until a worker takes them, including pushes still
+    // in progress; a worker that finds it nonzero but every deque empty yields
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> peak_queued_{0};
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<size_t> idle_workers_{0};        // Waiting on work_condition_
+    std::atomic<size_t> waking_{0};              // Of those, notified but not yet running
+    std::atomic<size_t> waiting_submitters_{0};  // Waiting on space_condition_
+
+    // Sleeping workers, blocked submitters and wait_all() all wait here. The
+    // counters above let the hot paths skip the lock when nobody is waiting.
+    mutable std::mutex sleep_mutex_;
+    std::condition_variable work_condition_;
+    std::condition_variable space_condition_;
     std::condition_variable completion_condition_;
 
     std::atomic<bool> stop_{false};
     std::atomic<size_t> active_tasks_{0};
-    std::atomic<size_t> total_tasks_{0};
     std::atomic<size_t> completed_tasks_{0};
+    std::atomic<size_t> steals_{0};
+    std::atomic<size_t> rejected_{0};
 
     ErrorHandler error_handler_;
     mutable std::mutex error_handler_mutex_;
@@ -93,22 +235,17 @@ template<typename F, typename... Args>
 auto ThreadPool::submit(F&& f, Args&&... args) -> std::future<decltype(f(args...))> {
     using return_type = decltype(f(args...));
 
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
+    std::packaged_task<return_type()> task(
         std::bind(std::forward<F>(f), std::forward<Args>(args)...)
     );
 
-    std::future<return_type> result = task->get_future();
+    std::future<return_type> result = task.get_future();
 
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        if (stop_) {
-            throw std::runtime_error("Cannot submit to stopped thread pool");
-        }
-        tasks_.emplace([task]() { (*task)(); });
-        total_tasks_++;
+    size_t queued = reserve(true);
+    if (queued == 0) {
+        throw std::runtime_error("Cannot submit to stopped thread pool");
     }
-
-    condition_.notify_one();
+    enqueue(Task(std::move(task)), queued);
     return result;
 }
 
@@ -0,0 +1,98 @@
+/*
+ * work_queue.h - In-memory queue of leased download work
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "efgrabber/common.h"
+
+namespace efgrabber {
+
+// Queue of claimed FileRecords, refilled in the background.
+// The refill thread calls refill(want) whenever the queue drops below the
+// low-water mark; refill is expected to lease rows in bulk (see
+// Database::claim_pending_files). Once a refill comes back short the queue
+// is considered exhausted and only refills again when a producer calls
+// notify(), when a deadline passed to notify_at() arrives (a scheduled retry
+// falling due), or after idle_refill_interval as a safety net.
+class WorkQueue {
+public:
+    using RefillFunction = std::function<std::vector<FileRecord>(size_t want)>;
+
+    WorkQueue(RefillFunction refill, size_t batch_size, size_t low_water,
+              std::chrono::milliseconds idle_refill_interval = std::chrono::milliseconds(1000));
+    ~WorkQueue();
+
+    // Non-copyable
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+
+    void start();
+    // Stop the refill thread and return whatever was claimed but never popped
+    std::vector<FileRecord> stop();
+
+    // Wait up to timeout for the next record; nullopt on timeout or stop
+    std::optional<FileRecord> pop(std::chrono::milliseconds timeout);
+
+    // Producers call this after inserting new PENDING rows
+    void notify();
+    // Refill once deadline passes, even if the queue is exhausted by then;
+    // only the earliest outstanding deadline is kept
+    void notify_at(std::chrono::steady_clock::time_point deadline);
+
+    // Resize the refill window (e.g. when the concurrency limit changes)
+    void set_batch_size(size_t batch_size, size_t low_water);
+
+    size_t size() const;
+    // True if the queue is empty and the last refill found nothing new
+    bool drained() const;
+
+private:
+    void refill_thread();
+
+    RefillFunction refill_;
+    size_t batch_size_;
+    size_t low_water_;
+    std::chrono::milliseconds idle_refill_interval_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable items_cv_;   // Consumers wait for items
+    std::condition_variable refill_cv_;  // Refill thread waits for demand/notify
+    std::deque<FileRecord> items_;
+    bool exhausted_ = false;     // Last refill returned fewer rows than asked for
+    bool notified_ = false;      // A producer added work since the last refill
+    std::optional<std::chrono::steady_clock::time_point> wake_at_;  // From notify_at()
+    bool refilling_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace efgrabber
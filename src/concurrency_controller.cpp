@@ -0,0 +1,190 @@
+/*
+ * concurrency_controller.cpp - AIMD controller for download concurrency
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/concurrency_controller.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace efgrabber {
+
+namespace {
+
+std::string format_rate(double bytes_per_second) {
+    std::ostringstream out;
+    out.precision(1);
+    out << std::fixed;
+    if (bytes_per_second >= 1 << 20) out << bytes_per_second / (1 << 20) << " MB/s";
+    else out << bytes_per_second / 1024 << " KB/s";
+    return out.str();
+}
+
+} // namespace
+
+ConcurrencyController::ConcurrencyController(int min_limit, int max_limit)
+    : min_limit_(std::max(1, min_limit)),
+      max_limit_(std::max(std::max(1, min_limit), max_limit)),
+      limit_(min_limit_.load()),
+      reason_("starting at the minimum") {
+}
+
+void ConcurrencyController::record(TransferOutcome outcome, int64_t bytes, int64_t latency_ms) {
+    switch (outcome) {
+        case TransferOutcome::OK:
+            ok_.fetch_add(1, std::memory_order_relaxed);
+            bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            latency_ms_.fetch_add(latency_ms, std::memory_order_relaxed);
+            break;
+        case TransferOutcome::BLOCKED:
+            blocked_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case TransferOutcome::FAILED:
+            failed_.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+}
+
+bool ConcurrencyController::update(double window_seconds, int64_t in_flight) {
+    int64_t ok = ok_.exchange(0, std::memory_order_relaxed);
+    int64_t blocked = blocked_.exchange(0, std::memory_order_relaxed);
+    int64_t failed = failed_.exchange(0, std::memory_order_relaxed);
+    int64_t bytes = bytes_.exchange(0, std::memory_order_relaxed);
+    int64_t latency_ms = latency_ms_.exchange(0, std::memory_order_relaxed);
+    int64_t total = ok + blocked + failed;
+
+    int current = limit();
+    int lowest = min_limit();
+    int highest = max_limit();
+
+    // Blocking is the one signal acted on without waiting for a full sample
+    if (blocked > 0 && blocked >= ADAPTIVE_BLOCK_RATE * static_cast<double>(total)) {
+        slow_start_ = false;
+        hold_windows_ = ADAPTIVE_HOLD_WINDOWS;
+        previous_limit_ = 0;
+        int next = std::max(lowest, current / 2);
+        set_limit(next, std::to_string(blocked) + " of " + std::to_string(total) +
+                        " responses blocked (403/429)");
+        return next != current;
+    }
+
+    if (total < ADAPTIVE_MIN_SAMPLES || window_seconds <= 0) {
+        return false;
+    }
+
+    double goodput = static_cast<double>(bytes) / window_seconds;
+    double mean_latency = ok > 0 ? static_cast<double>(latency_ms) / static_cast<double>(ok) : 0;
+    double best_goodput = last_goodput_;
+    last_goodput_ = goodput;
+
+    // The best latency is the no-load baseline. It drifts up very slowly so a
+    // server that has become slower for good is not mistaken for queueing forever.
+    if (ok > 0 && (best_latency_ms_ <= 0 || mean_latency < best_latency_ms_)) {
+        best_latency_ms_ = mean_latency;
+    } else {
+        best_latency_ms_ *= ADAPTIVE_BASELINE_DRIFT;
+    }
+
+    if (failed >= ADAPTIVE_FAILURE_RATE * static_cast<double>(total)) {
+        slow_start_ = false;
+        previous_limit_ = 0;
+        int next = std::max(lowest, current - std::max(1, current / 10));
+        set_limit(next, std::to_string(failed) + " of " + std::to_string(total) + " transfers failed");
+        return next != current;
+    }
+
+    if (previous_limit_ > 0 && goodput < 0.9 * best_goodput) {
+        // The last increase made things worse; go back to where it was
+        int next = std::clamp(previous_limit_, lowest, highest);
+        previous_limit_ = 0;
+        slow_start_ = false;
+        set_limit(next, "goodput fell to " + format_rate(goodput) + " after raising the limit");
+        return next != current;
+    }
+
+    if (hold_windows_ > 0) {
+        --hold_windows_;
+        return false;
+    }
+
+    // Gradient step: shrink in proportion to how far latency has risen over
+    // the baseline, then allow sqrt(limit) transfers of queue on top. Settles
+    // where the queue the extra transfers build matches the step.
+    double gradient = ok > 0 && mean_latency > 0 ? std::clamp(best_latency_ms_ / mean_latency, 0.5, 1.0) : 1.0;
+    double target;
+    if (slow_start_ && gradient >= ADAPTIVE_SLOW_START_GRADIENT) {
+        target = 2.0 * current;
+    } else {
+        slow_start_ = false;
+        target = current * gradient + std::sqrt(static_cast<double>(current));
+    }
+
+    int next = std::clamp(static_cast<int>(target), lowest, highest);
+    if (next > current && in_flight < current) {
+        // Raising a limit the workload does not reach measures nothing
+        previous_limit_ = 0;
+        return false;
+    }
+    if (next == current) {
+        previous_limit_ = 0;
+        return false;
+    }
+
+    std::string latency = std::to_string(static_cast<int64_t>(mean_latency)) + " ms";
+    if (next > current) {
+        previous_limit_ = current;
+        set_limit(next, "goodput " + format_rate(goodput) + " at " + latency + ", probing up" +
+                        (slow_start_ ? " (slow start)" : ""));
+    } else {
+        previous_limit_ = 0;
+        set_limit(next, "latency " + latency + " vs " +
+                        std::to_string(static_cast<int64_t>(best_latency_ms_)) + " ms unloaded, goodput " +
+                        format_rate(goodput));
+    }
+    return true;
+}
+
+void ConcurrencyController::set_bounds(int min_limit, int max_limit) {
+    min_limit = std::max(1, min_limit);
+    max_limit = std::max(min_limit, max_limit);
+    min_limit_ = min_limit;
+    max_limit_ = max_limit;
+    int current = limit();
+    int clamped = std::clamp(current, min_limit, max_limit);
+    if (clamped != current) {
+        set_limit(clamped, "bounds changed to " + std::to_string(min_limit) + ".." +
+                           std::to_string(max_limit));
+    }
+}
+
+std::string ConcurrencyController::reason() const {
+    std::lock_guard<std::mutex> lock(reason_mutex_);
+    return reason_;
+}
+
+void ConcurrencyController::set_limit(int limit, std::string reason) {
+    limit_.store(limit, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(reason_mutex_);
+    reason_ = std::move(reason);
+}
+
+} // namespace efgrabber
@@ -0,0 +1,199 @@
+/*
+ * content_digest.cpp - SHA-256 and PDF signature check of streamed bodies
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/content_digest.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace efgrabber {
+
+namespace {
+
+constexpr uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+constexpr char PDF_SIGNATURE[] = "%PDF-";
+constexpr size_t PDF_SIGNATURE_LENGTH = sizeof(PDF_SIGNATURE) - 1;
+constexpr size_t READ_BUFFER_BYTES = 1 << 20;
+
+inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+} // namespace
+
+Sha256::Sha256() {
+    reset();
+}
+
+void Sha256::reset() {
+    std::memcpy(state_, INITIAL_STATE, sizeof(state_));
+    buffered_ = 0;
+    length_ = 0;
+}
+
+void Sha256::compress(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (uint32_t{block[i * 4]} << 24) | (uint32_t{block[i * 4 + 1]} << 16) |
+               (uint32_t{block[i * 4 + 2]} << 8) | uint32_t{block[i * 4 + 3]};
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                      ROUND_CONSTANTS[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+    state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+}
+
+void Sha256::update(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    length_ += size;
+
+    if (buffered_ > 0) {
+        size_t take = std::min(size, sizeof(buffer_) - buffered_);
+        std::memcpy(buffer_ + buffered_, bytes, take);
+        buffered_ += take;
+        bytes += take;
+        size -= take;
+        if (buffered_ < sizeof(buffer_)) return;
+        compress(buffer_);
+        buffered_ = 0;
+    }
+    // Whole blocks straight from the caller's buffer
+    for (; size >= sizeof(buffer_); bytes += sizeof(buffer_), size -= sizeof(buffer_)) {
+        compress(bytes);
+    }
+    std::memcpy(buffer_, bytes, size);
+    buffered_ = size;
+}
+
+Sha256::Digest Sha256::finish() {
+    uint64_t bits = length_ * 8;
+    uint8_t padding[72] = {0x80};
+    size_t pad = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; ++i) {
+        padding[pad + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    update(padding, pad + 8);
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(state_[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state_[i]);
+    }
+    return digest;
+}
+
+std::string Sha256::hex(const Digest& digest) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        out += digits[byte >> 4];
+        out += digits[byte & 0xf];
+    }
+    return out;
+}
+
+void ContentInspector::update(const char* data, size_t size) {
+    if (head_size_ < HEAD_BYTES) {
+        size_t take = std::min(size, HEAD_BYTES - head_size_);
+        std::memcpy(head_ + head_size_, data, take);
+        head_size_ += take;
+    }
+    hash_.update(data, size);
+    size_ += size;
+}
+
+void ContentInspector::reset() {
+    hash_.reset();
+    head_size_ = 0;
+    size_ = 0;
+}
+
+std::string ContentInspector::hex_digest() {
+    return Sha256::hex(hash_.finish());
+}
+
+bool ContentInspector::looks_like_pdf() const {
+    return std::search(head_, head_ + head_size_, PDF_SIGNATURE,
+                       PDF_SIGNATURE + PDF_SIGNATURE_LENGTH) != head_ + head_size_;
+}
+
+bool inspect_file(const std::string& path, int64_t offset, int64_t size, ContentInspector& inspector) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    std::vector<char> buffer(READ_BUFFER_BYTES);
+    int64_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, buffer.data(),
+                          static_cast<size_t>(std::min<int64_t>(size - done, READ_BUFFER_BYTES)),
+                          offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        inspector.update(buffer.data(), static_cast<size_t>(n));
+        done += n;
+    }
+    ::close(fd);
+    return done == size;
+}
+
+} // namespace efgrabber
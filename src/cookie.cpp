@@ -26,6 +26,7 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <limits>
 
 namespace efgrabber {
 
@@ -69,13 +70,26 @@ std::string Cookie::to_string() const {
 
 // --- CookieJar Implementation ---
 
-CookieJar::CookieJar() {}
+CookieJar::CookieJar() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    publish_locked();
+}
 
 CookieJar::~CookieJar() {
     stop_reaper();
 }
 
 void CookieJar::add_cookie(const Cookie& cookie) {
+    // Servers resend the same cookies on most responses; those need no new snapshot
+    SnapshotPtr snapshot = snapshot_.load(std::memory_order_acquire);
+    for (const auto& c : *snapshot->cookies) {
+        if (c.domain() == cookie.domain() && c.key() == cookie.key() &&
+            c.value() == cookie.value() && c.is_secure() == cookie.is_secure() &&
+            c.expiry() >= cookie.expiry() - EXPIRY_SLACK_SECONDS) {
+            return;
+        }
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
 
     auto& list = cookies_[cookie.domain()];
@@ -90,6 +104,8 @@ void CookieJar::add_cookie(const Cookie& cookie) {
     } else {
         list.push_back(cookie);
     }
+
+    publish_locked();
 }
 
 void CookieJar::add_from_header(const std::string& header_line, const std::string& default_domain) {
@@ -173,33 +189,59 @@ void CookieJar::add_from_cookie_string(const std::string& cookie_string, const s
 }
 
 std::string CookieJar::get_cookies_for_url(const std::string& url) {
-    std::string req_domain = extract_domain(url);
+    std::string_view req_domain = extract_domain(url);
     bool secure = is_url_secure(url);
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::stringstream ss;
-    bool first = true;
+    SnapshotPtr snapshot = snapshot_.load(std::memory_order_acquire);
+    if (std::time(nullptr) > snapshot->valid_until) {
+        // A cookie has expired since the snapshot was built; reap it now
+        // rather than sending it until the next reaper pass
+        cleanup_expired();
+        snapshot = snapshot_.load(std::memory_order_acquire);
+    }
 
-    // Iterate all lists (since domain matching is loose)
-    // For optimization, we could store by domain suffix
-    for (const auto& pair : cookies_) {
-        const auto& domain_cookies = pair.second;
-        for (const auto& cookie : domain_cookies) {
-            if (cookie.matches(req_domain, secure)) {
-                if (!first) ss << "; ";
-                ss << cookie.to_string();
-                first = false;
-            }
+    for (const auto& header : snapshot->headers) {
+        if (header.secure == secure && header.domain == req_domain) {
+            return header.value;
         }
     }
 
-    return ss.str();
+    return build_header(std::move(snapshot), req_domain, secure);
+}
+
+std::string CookieJar::build_header(SnapshotPtr snapshot, std::string_view domain, bool secure) {
+    std::string req_domain(domain);
+    std::string value;
+
+    for (const auto& cookie : *snapshot->cookies) {
+        if (cookie.matches(req_domain, secure)) {
+            if (!value.empty()) value += "; ";
+            value += cookie.to_string();
+        }
+    }
+
+    // Publish the header in a copy of the snapshot. If a writer (or another
+    // reader) got there first, the header is still right for this request and
+    // the next miss will build it again.
+    auto next = std::make_shared<Snapshot>(*snapshot);
+    next->headers.push_back(Snapshot::Header{std::move(req_domain), secure, value});
+    snapshot_.compare_exchange_strong(snapshot, SnapshotPtr(std::move(next)),
+                                      std::memory_order_acq_rel, std::memory_order_acquire);
+    return value;
 }
 
 void CookieJar::cleanup_expired() {
     std::lock_guard<std::mutex> lock(mutex_);
-    time_t now = std::time(nullptr);
-    int removed_count = 0;
+    size_t removed_count = remove_expired_locked(std::time(nullptr));
+
+    if (removed_count > 0) {
+        // Logging removed count could go here if we had the logger
+        publish_locked();
+    }
+}
+
+size_t CookieJar::remove_expired_locked(time_t now) {
+    size_t removed_count = 0;
 
     for (auto it = cookies_.begin(); it != cookies_.end();) {
         auto& list = it->second;
@@ -218,9 +260,24 @@ void CookieJar::cleanup_expired() {
         }
     }
 
-    if (removed_count > 0) {
-        // Logging removed count could go here if we had the logger
+    return removed_count;
+}
+
+void CookieJar::publish_locked() {
+    auto cookies = std::make_shared<std::vector<Cookie>>();
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->version = ++version_;
+    snapshot->valid_until = std::numeric_limits<time_t>::max();
+
+    for (const auto& pair : cookies_) {
+        for (const auto& cookie : pair.second) {
+            cookies->push_back(cookie);
+            snapshot->valid_until = std::min(snapshot->valid_until, cookie.expiry());
+        }
     }
+
+    snapshot->cookies = std::move(cookies);
+    snapshot_.store(std::move(snapshot), std::memory_order_release);
 }
 
 void CookieJar::start_reaper(int interval_seconds) {
@@ -256,22 +313,22 @@ void CookieJar::reaper_thread_func(int interval_seconds) {
     }
 }
 
-std::string CookieJar::extract_domain(const std::string& url) const {
+std::string_view CookieJar::extract_domain(std::string_view url) const {
     size_t start = url.find("://");
-    if (start == std::string::npos) start = 0;
+    if (start == std::string_view::npos) start = 0;
     else start += 3;
 
     size_t end = url.find('/', start);
-    if (end == std::string::npos) end = url.length();
+    if (end == std::string_view::npos) end = url.length();
 
     size_t port_pos = url.find(':', start);
-    if (port_pos != std::string::npos && port_pos < end) end = port_pos;
+    if (port_pos != std::string_view::npos && port_pos < end) end = port_pos;
 
     return url.substr(start, end - start);
 }
 
-bool CookieJar::is_url_secure(const std::string& url) const {
-    return url.find("https://") == 0;
+bool CookieJar::is_url_secure(std::string_view url) const {
+    return url.rfind("https://", 0) == 0;
 }
 
 } // namespace efgrabber
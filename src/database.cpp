@@ -31,6 +31,263 @@
 
 namespace efgrabber {
 
+namespace {
+
+// Every statement the Database runs more than once. They are prepared once in
+// initialize() and reset/rebound per call, so the hot paths (status updates,
+// claims, existence checks) skip SQL parsing and planning entirely.
+enum StatementId : size_t {
+    STMT_ADD_FILE,
+    STMT_UPDATE_STATUS,
+    STMT_UPDATE_STATUS_BY_FILE_ID,
+    STMT_GET_FILE,
+    STMT_GET_FILE_BY_FILE_ID,
+    STMT_GET_PENDING,
+    STMT_CLAIM_PENDING,
+    STMT_RELEASE_FILE,
+    STMT_GET_FAILED,
+    STMT_GET_RETRY_DEADLINES,
+    STMT_CLAIM_RETRY,
+    STMT_INCREMENT_RETRY,
+    STMT_APPLY_STATUS_UPDATE,
+    STMT_FILE_EXISTS,
+    STMT_ADD_PAGE,
+    STMT_MARK_PAGE_SCRAPED,
+    STMT_GET_UNSCRAPED_PAGES,
+    STMT_GET_PAGE,
+    STMT_PAGE_EXISTS,
+    STMT_RESET_SCRAPED_PAGES,
+    STMT_COUNT_FILES,
+    STMT_COUNT_COMPLETED,
+    STMT_RESET_IN_PROGRESS,
+    STMT_RESET_FAILED,
+    STMT_RESET_ALL,
+    STMT_HAS_WORK,
+    STMT_SET_BRUTE_FORCE,
+    STMT_GET_BRUTE_FORCE,
+    STMT_SET_MAX_PAGE,
+    STMT_GET_MAX_PAGE,
+    STMT_PAGE_STATS,
+    STMT_FILE_STATUS_COUNTS,
+    STMT_DELETE_FILES,
+    STMT_DELETE_PAGES,
+    STMT_DELETE_PROGRESS,
+    STMT_SAVE_ID_BITMAP,
+    STMT_LOAD_ID_BITMAP,
+    STMT_DELETE_ID_BITMAP,
+    STMT_FILE_STATUSES,
+    STMT_ALL_FILE_IDS,
+    STMT_RECONCILE_LOCAL_FILE,
+    STMT_GET_PACK_END,
+    STMT_GET_UNPACKED,
+    STMT_SET_PACK_LOCATION,
+    STMT_FIND_BY_SHA256,
+    STMT_REMOVE_PAGES_AFTER,
+    STMT_COUNT
+};
+
+// SQL text indexed by StatementId
+const char* const STATEMENT_SQL[STMT_COUNT] = {
+    R"(
+        INSERT OR IGNORE INTO files (data_set, file_id, url, local_path, status)
+        VALUES (?, ?, ?, ?, ?)
+    )",
+    R"(
+        UPDATE files SET status = ?, error_message = ?, file_size = ?,
+                        next_attempt_at = ?,
+                        lease_owner = NULL, lease_expires = 0,
+                        updated_at = datetime('now')
+        WHERE id = ?
+    )",
+    R"(
+        UPDATE files SET status = ?, error_message = ?, file_size = ?,
+                        lease_owner = NULL, lease_expires = 0,
+                        updated_at = datetime('now')
+        WHERE file_id = ? AND data_set = ?
+    )",
+    R"(
+        SELECT id, data_set, file_id, url, local_path, status, file_size,
+               retry_count, error_message
+        FROM files WHERE id = ?
+    )",
+    R"(
+        SELECT id, data_set, file_id, url, local_path, status, file_size,
+               retry_count, error_message
+        FROM files WHERE file_id = ? AND data_set = ?
+    )",
+    R"(
+        SELECT id, data_set, file_id, url, local_path, status, file_size,
+               retry_count, error_message
+        FROM files WHERE status IN (0, 1, 3) AND status = 0 LIMIT ?
+    )",
+    R"(
+        UPDATE files SET status = 1, lease_owner = ?1,
+                         lease_expires = CAST(strftime('%s', 'now') AS INTEGER) + ?2,
+                         updated_at = datetime('now')
+        WHERE id IN (
+            SELECT id FROM files
+            WHERE status IN (0, 1, 3) AND data_set = ?3 AND (
+                status = 0 OR
+                (status = 1 AND lease_owner IS NOT ?1 AND
+                 lease_expires > 0 AND lease_expires < CAST(strftime('%s', 'now') AS INTEGER))
+            )
+            LIMIT ?4
+        )
+        RETURNING id, data_set, file_id, url, local_path, status, file_size,
+                  retry_count, error_message
+    )",
+    R"(
+        UPDATE files SET status = 0, lease_owner = NULL, lease_expires = 0
+        WHERE id = ? AND status = 1
+    )",
+    R"(
+        SELECT id, data_set, file_id, url, local_path, status, file_size,
+               retry_count, error_message, strftime('%s', updated_at)
+        FROM files WHERE status IN (0, 1, 3) AND status = 3 AND retry_count < ?
+        ORDER BY updated_at ASC LIMIT ?
+    )",
+    R"(
+        SELECT id, next_attempt_at FROM files
+        WHERE status = 3 AND data_set = ? AND retry_count < ?
+        ORDER BY next_attempt_at
+    )",
+    R"(
+        UPDATE files SET status = 1, lease_owner = ?1,
+                         lease_expires = CAST(strftime('%s', 'now') AS INTEGER) + ?2,
+                         updated_at = datetime('now')
+        WHERE id = ?3 AND status = 3 AND COALESCE(next_attempt_at, 0) <= ?4
+        RETURNING id, data_set, file_id, url, local_path, status, file_size,
+                  retry_count, error_message
+    )",
+    "UPDATE files SET retry_count = retry_count + 1 WHERE id = ?",
+    R"(
+        UPDATE files SET status = ?, error_message = ?, file_size = ?,
+                        retry_count = retry_count + ?, next_attempt_at = ?,
+                        sha256 = COALESCE(?, sha256), is_pdf = COALESCE(?, is_pdf),
+                        lease_owner = NULL, lease_expires = 0,
+                        updated_at = datetime('now')
+        WHERE id = ?
+    )",
+    "SELECT 1 FROM files WHERE file_id = ? AND data_set = ? LIMIT 1",
+    "INSERT OR IGNORE INTO pages (data_set, page_number) VALUES (?, ?)",
+    R"(
+        UPDATE pages SET scraped = 1, pdf_count = ?, etag = ?, last_modified = ?,
+                         content_hash = ?, scraped_at = datetime('now')
+        WHERE data_set = ? AND page_number = ?
+    )",
+    R"(
+        SELECT page_number FROM pages
+        WHERE data_set = ? AND scraped = 0 AND page_number BETWEEN ? AND ?
+        ORDER BY page_number
+        LIMIT ?
+    )",
+    R"(
+        SELECT id, data_set, page_number, scraped, pdf_count, scraped_at,
+               etag, last_modified, content_hash
+        FROM pages WHERE data_set = ? AND page_number = ? LIMIT 1
+    )",
+    "SELECT 1 FROM pages WHERE data_set = ? AND page_number = ? LIMIT 1",
+    "UPDATE pages SET scraped = 0 WHERE data_set = ? AND scraped = 1",
+    "SELECT COALESCE(SUM(count), 0) FROM file_counts WHERE data_set = ?",
+    "SELECT COALESCE(SUM(count), 0) FROM file_counts WHERE data_set = ? AND status = 2",
+    "UPDATE files SET status = 0, lease_owner = NULL, lease_expires = 0 WHERE status IN (0, 1, 3) AND data_set = ? AND status = 1",
+    "UPDATE files SET status = 0, retry_count = 0, error_message = NULL, next_attempt_at = NULL WHERE status IN (0, 1, 3) AND data_set = ? AND status = 3",
+    "UPDATE files SET status = 0, retry_count = 0, error_message = NULL, next_attempt_at = NULL, lease_owner = NULL, lease_expires = 0 WHERE data_set = ?",
+    "SELECT 1 FROM files WHERE status IN (0, 1, 3) AND data_set = ? LIMIT 1",
+    R"(
+        INSERT INTO progress (data_set, brute_force_current, updated_at)
+        VALUES (?, ?, datetime('now'))
+        ON CONFLICT(data_set) DO UPDATE SET
+            brute_force_current = excluded.brute_force_current,
+            updated_at = datetime('now')
+    )",
+    "SELECT brute_force_current FROM progress WHERE data_set = ?",
+    R"(
+        INSERT INTO progress (data_set, max_page, updated_at)
+        VALUES (?, ?, datetime('now'))
+        ON CONFLICT(data_set) DO UPDATE SET
+            max_page = excluded.max_page,
+            updated_at = datetime('now')
+    )",
+    "SELECT max_page FROM progress WHERE data_set = ?",
+    "SELECT total, scraped, pdf_total FROM page_counts WHERE data_set = ?",
+    "SELECT status, count FROM file_counts WHERE data_set = ?",
+    "DELETE FROM files WHERE data_set = ?",
+    "DELETE FROM pages WHERE data_set = ?",
+    "DELETE FROM progress WHERE data_set = ?",
+    R"(
+        INSERT INTO id_bitmaps (data_set, first_id, last_id, states, updated_at)
+        VALUES (?, ?, ?, ?, datetime('now'))
+        ON CONFLICT(data_set) DO UPDATE SET
+            first_id = excluded.first_id,
+            last_id = excluded.last_id,
+            states = excluded.states,
+            updated_at = datetime('now')
+    )",
+    "SELECT first_id, last_id, states FROM id_bitmaps WHERE data_set = ?",
+    "DELETE FROM id_bitmaps WHERE data_set = ?",
+    "SELECT file_id, status FROM files WHERE data_set = ?",
+    "SELECT data_set, file_id FROM files",
+    R"(
+        INSERT INTO files (data_set, file_id, url, local_path, status, file_size)
+        VALUES (?, ?, ?, ?, 2, ?)
+        ON CONFLICT(data_set, file_id) DO UPDATE SET
+            status = 2, file_size = excluded.file_size, error_message = NULL,
+            next_attempt_at = NULL, lease_owner = NULL, lease_expires = 0,
+            updated_at = datetime('now')
+        WHERE files.status NOT IN (2, 5)
+    )",
+    R"(
+        SELECT pack_id, MAX(pack_offset + (file_size + 511) / 512 * 512) FROM files
+        WHERE data_set = ?1 AND pack_id = (SELECT MAX(pack_id) FROM files WHERE data_set = ?1)
+    )",
+    R"(
+        SELECT id, file_id, local_path FROM files
+        WHERE data_set = ? AND status IN (2, 5) AND pack_id IS NULL AND id > ?
+        ORDER BY id LIMIT ?
+    )",
+    "UPDATE files SET pack_id = ?, pack_offset = ?, file_size = ? WHERE id = ?",
+    R"(
+        SELECT local_path FROM files
+        WHERE sha256 = ? AND id != ? AND status = 2 AND pack_id IS NULL LIMIT 1
+    )",
+    "DELETE FROM pages WHERE data_set = ? AND page_number > ?",
+};
+
+// Borrowed cached statement: resets it and clears its bindings on scope exit so
+// it is ready for the next caller (and releases any read snapshot it holds)
+class CachedStatement {
+public:
+    explicit CachedStatement(sqlite3_stmt* stmt) : stmt_(stmt) {}
+    ~CachedStatement() {
+        if (stmt_) {
+            sqlite3_reset(stmt_);
+            sqlite3_clear_bindings(stmt_);
+        }
+    }
+
+    CachedStatement(const CachedStatement&) = delete;
+    CachedStatement& operator=(const CachedStatement&) = delete;
+
+    operator sqlite3_stmt*() const { return stmt_; }
+    bool operator!() const { return stmt_ == nullptr; }
+
+private:
+    sqlite3_stmt* stmt_;
+};
+
+// Status columns hold DownloadStatus values (schema v2)
+DownloadStatus column_status(sqlite3_stmt* stmt, int column) {
+    int value = sqlite3_column_int(stmt, column);
+    if (value < static_cast<int>(DownloadStatus::PENDING) ||
+        value > static_cast<int>(DownloadStatus::SKIPPED)) {
+        return DownloadStatus::PENDING;
+    }
+    return static_cast<DownloadStatus>(value);
+}
+
+} // namespace
+
 Database::Database(const std::string& db_path) : db_path_(db_path) {
     int rc = sqlite3_open(db_path.c_str(), &db_);
     if (rc != SQLITE_OK) {
@@ -53,7 +310,8 @@ Database::~Database() {
 
 Database::Database(Database&& other) noexcept
     : db_(other.db_), db_path_(std::move(other.db_path_)),
-      last_error_(std::move(other.last_error_)), last_error_info_(std::move(other.last_error_info_)) {
+      last_error_(std::move(other.last_error_)), last_error_info_(std::move(other.last_error_info_)),
+      statements_(std::move(other.statements_)) {
     other.db_ = nullptr;
 }
 
@@ -64,12 +322,18 @@ Database& Database::operator=(Database&& other) noexcept {
         db_path_ = std::move(other.db_path_);
         last_error_ = std::move(other.last_error_);
         last_error_info_ = std::move(other.last_error_info_);
+        statements_ = std::move(other.statements_);
         other.db_ = nullptr;
     }
     return *this;
 }
 
 void Database::close() {
+    for (sqlite3_stmt* stmt : statements_) {
+        sqlite3_finalize(stmt);
+    }
+    statements_.clear();
+
     if (db_) {
         sqlite3_close(db_);
         db_ = nullptr;
@@ -89,9 +353,71 @@ bool Database::execute(const std::string& sql) {
     return true;
 }
 
+// Schema migrations, applied in order by initialize(). PRAGMA user_version holds
+// the number of migrations already applied; databases from before versioning
+// report 0 and run them all, which is safe because v1 only creates what is missing.
+const Database::Migration Database::MIGRATIONS[] = {
+    &Database::migrate_v1,
+    &Database::migrate_v2,
+    &Database::migrate_v3,
+    &Database::migrate_v4,
+    &Database::migrate_v5,
+    &Database::migrate_v6,
+    &Database::migrate_v7,
+    &Database::migrate_v8,
+};
+
 bool Database::initialize() {
     std::lock_guard<std::mutex> lock(mutex_);
 
+    const int latest = static_cast<int>(sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0]));
+    int version = user_version();
+    if (version < 0) return false;
+    if (version > latest) {
+        last_error_ = "Database schema version " + std::to_string(version) +
+                      " is newer than this build supports (" + std::to_string(latest) + ")";
+        last_error_info_ = ErrorInfo{ErrorCode::DB_OPERATION_FAILED, last_error_};
+        return false;
+    }
+
+    vacuum_after_migration_ = false;
+    for (int next = version + 1; next <= latest; ++next) {
+        // PRAGMA user_version is transactional, so each step applies fully or not at all
+        if (!execute("BEGIN TRANSACTION")) return false;
+        if (!(this->*MIGRATIONS[next - 1])() ||
+            !execute("PRAGMA user_version = " + std::to_string(next)) ||
+            !execute("COMMIT")) {
+            std::string error = last_error_;
+            execute("ROLLBACK");
+            last_error_ = "Schema migration to v" + std::to_string(next) + " failed: " + error;
+            last_error_info_ = ErrorInfo{ErrorCode::DB_OPERATION_FAILED, last_error_};
+            return false;
+        }
+    }
+
+    // Rebuilding a populated table leaves the old pages on the freelist
+    if (vacuum_after_migration_) {
+        execute("VACUUM");
+    }
+
+    // Prepare against the final schema
+    return prepare_statements();
+}
+
+int Database::user_version() {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "PRAGMA user_version", -1, &stmt, nullptr) != SQLITE_OK) {
+        last_error_ = sqlite3_errmsg(db_);
+        return -1;
+    }
+
+    int version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+// v1: the original schema, plus the work lease columns
+bool Database::migrate_v1() {
     const char* schema = R"(
         CREATE TABLE IF NOT EXISTS files (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -108,10 +434,6 @@ bool Database::initialize() {
             UNIQUE(data_set, file_id)
         );
 
-        CREATE INDEX IF NOT EXISTS idx_files_status ON files(status);
-        CREATE INDEX IF NOT EXISTS idx_files_data_set ON files(data_set);
-        CREATE INDEX IF NOT EXISTS idx_files_file_id ON files(file_id);
-
         CREATE TABLE IF NOT EXISTS pages (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             data_set INTEGER NOT NULL,
@@ -122,9 +444,6 @@ bool Database::initialize() {
             UNIQUE(data_set, page_number)
         );
 
-        CREATE INDEX IF NOT EXISTS idx_pages_data_set ON pages(data_set);
-        CREATE INDEX IF NOT EXISTS idx_pages_scraped ON pages(scraped);
-
         CREATE TABLE IF NOT EXISTS progress (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             data_set INTEGER NOT NULL UNIQUE,
@@ -133,20 +452,276 @@ bool Database::initialize() {
         );
     )";
 
-    return execute(schema);
+    return execute(schema) &&
+           ensure_column("files", "lease_owner", "TEXT") &&
+           ensure_column("files", "lease_expires", "INTEGER DEFAULT 0");
 }
 
-bool Database::add_file(const FileRecord& record) {
-    std::lock_guard<std::mutex> lock(mutex_);
+// v2: integer status codes (the DownloadStatus values), a partial index over the
+// rows the download loop still works on, and trigger-maintained counters
+bool Database::migrate_v2() {
+    const char* rebuild_files = R"(
+        CREATE TABLE files_v2 (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            data_set INTEGER NOT NULL,
+            file_id TEXT NOT NULL,
+            url TEXT NOT NULL,
+            local_path TEXT,
+            status INTEGER NOT NULL DEFAULT 0,
+            file_size INTEGER DEFAULT 0,
+            retry_count INTEGER DEFAULT 0,
+            error_message TEXT,
+            created_at TEXT DEFAULT (datetime('now')),
+            updated_at TEXT DEFAULT (datetime('now')),
+            lease_owner TEXT,
+            lease_expires INTEGER DEFAULT 0,
+            UNIQUE(data_set, file_id)
+        );
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        INSERT OR IGNORE INTO files (data_set, file_id, url, local_path, status)
-        VALUES (?, ?, ?, ?, ?)
+        INSERT INTO files_v2 (id, data_set, file_id, url, local_path, status, file_size,
+                              retry_count, error_message, created_at, updated_at,
+                              lease_owner, lease_expires)
+        SELECT id, data_set, file_id, url, local_path,
+               CASE status
+                   WHEN 'IN_PROGRESS' THEN 1
+                   WHEN 'COMPLETED' THEN 2
+                   WHEN 'FAILED' THEN 3
+                   WHEN 'NOT_FOUND' THEN 4
+                   WHEN 'SKIPPED' THEN 5
+                   ELSE 0
+               END,
+               file_size, retry_count, error_message, created_at, updated_at,
+               lease_owner, lease_expires
+        FROM files;
+    )";
+
+    if (!execute(rebuild_files)) return false;
+    if (sqlite3_changes(db_) > 0) vacuum_after_migration_ = true;
+
+    // Dropping the old table also drops its single-column indexes and any triggers.
+    // The UNIQUE(data_set, file_id) index serves file_exists and the by-file-id lookups.
+    const char* schema = R"(
+        DROP TABLE files;
+        ALTER TABLE files_v2 RENAME TO files;
+
+        -- Pending, in-progress and failed rows. Queries must repeat this exact
+        -- predicate for SQLite to consider the index.
+        CREATE INDEX idx_files_active ON files(data_set, status) WHERE status IN (0, 1, 3);
+
+        DROP INDEX IF EXISTS idx_pages_data_set;
+        DROP INDEX IF EXISTS idx_pages_scraped;
+        CREATE INDEX IF NOT EXISTS idx_pages_unscraped ON pages(data_set, page_number)
+            WHERE scraped = 0;
+
+        -- Per data set counters kept current by the triggers below, so
+        -- get_stats() reads a handful of rows instead of scanning files
+        DROP TABLE IF EXISTS file_counts;
+        CREATE TABLE file_counts (
+            data_set INTEGER NOT NULL,
+            status INTEGER NOT NULL,
+            count INTEGER NOT NULL DEFAULT 0,
+            PRIMARY KEY (data_set, status)
+        ) WITHOUT ROWID;
+
+        DROP TABLE IF EXISTS page_counts;
+        CREATE TABLE page_counts (
+            data_set INTEGER PRIMARY KEY,
+            total INTEGER NOT NULL DEFAULT 0,
+            scraped INTEGER NOT NULL DEFAULT 0,
+            pdf_total INTEGER NOT NULL DEFAULT 0
+        );
+
+        CREATE TRIGGER trg_files_count_insert AFTER INSERT ON files
+        BEGIN
+            INSERT INTO file_counts (data_set, status, count) VALUES (NEW.data_set, NEW.status, 1)
+            ON CONFLICT(data_set, status) DO UPDATE SET count = count + 1;
+        END;
+
+        CREATE TRIGGER trg_files_count_delete AFTER DELETE ON files
+        BEGIN
+            UPDATE file_counts SET count = count - 1
+            WHERE data_set = OLD.data_set AND status = OLD.status;
+        END;
+
+        CREATE TRIGGER trg_files_count_update AFTER UPDATE OF status, data_set ON files
+        WHEN OLD.status IS NOT NEW.status OR OLD.data_set IS NOT NEW.data_set
+        BEGIN
+            UPDATE file_counts SET count = count - 1
+            WHERE data_set = OLD.data_set AND status = OLD.status;
+            INSERT INTO file_counts (data_set, status, count) VALUES (NEW.data_set, NEW.status, 1)
+            ON CONFLICT(data_set, status) DO UPDATE SET count = count + 1;
+        END;
+
+        DROP TRIGGER IF EXISTS trg_pages_count_insert;
+        CREATE TRIGGER trg_pages_count_insert AFTER INSERT ON pages
+        BEGIN
+            INSERT INTO page_counts (data_set, total, scraped, pdf_total)
+            VALUES (NEW.data_set, 1, NEW.scraped IS 1, COALESCE(NEW.pdf_count, 0))
+            ON CONFLICT(data_set) DO UPDATE SET
+                total = total + 1,
+                scraped = scraped + excluded.scraped,
+                pdf_total = pdf_total + excluded.pdf_total;
+        END;
+
+        DROP TRIGGER IF EXISTS trg_pages_count_delete;
+        CREATE TRIGGER trg_pages_count_delete AFTER DELETE ON pages
+        BEGIN
+            UPDATE page_counts SET
+                total = total - 1,
+                scraped = scraped - (OLD.scraped IS 1),
+                pdf_total = pdf_total - COALESCE(OLD.pdf_count, 0)
+            WHERE data_set = OLD.data_set;
+        END;
+
+        DROP TRIGGER IF EXISTS trg_pages_count_update;
+        CREATE TRIGGER trg_pages_count_update AFTER UPDATE OF scraped, pdf_count ON pages
+        BEGIN
+            UPDATE page_counts SET
+                scraped = scraped + (NEW.scraped IS 1) - (OLD.scraped IS 1),
+                pdf_total = pdf_total + COALESCE(NEW.pdf_count, 0) - COALESCE(OLD.pdf_count, 0)
+            WHERE data_set = NEW.data_set;
+        END;
     )";
 
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
+    return execute(schema) && rebuild_counters("");
+}
+
+// v3: remember each data set's index page count so restarts can revalidate it
+// instead of searching for it again
+bool Database::migrate_v3() {
+    return ensure_column("progress", "max_page", "INTEGER DEFAULT -1");
+}
+
+// v4: per-page validators and a hash of the links found, so a refresh can
+// send conditional requests and skip pages whose links have not changed
+bool Database::migrate_v4() {
+    return ensure_column("pages", "etag", "TEXT") &&
+           ensure_column("pages", "last_modified", "TEXT") &&
+           ensure_column("pages", "content_hash", "INTEGER");
+}
+
+// v5: when each failed row is due for another attempt, so retries can be
+// scheduled by deadline. Rows that failed before this version are due now.
+bool Database::migrate_v5() {
+    return ensure_column("files", "next_attempt_at", "INTEGER") &&
+           execute(R"(
+               UPDATE files SET next_attempt_at = CAST(strftime('%s', updated_at) AS INTEGER)
+               WHERE status = 3 AND next_attempt_at IS NULL;
+               CREATE INDEX IF NOT EXISTS idx_files_retry ON files(data_set, next_attempt_at)
+                   WHERE status = 3;
+           )");
+}
+
+// v6: brute force keeps the probe state of its whole ID range in one bitmap
+// per data set instead of a PENDING files row per ID
+bool Database::migrate_v6() {
+    return execute(R"(
+        CREATE TABLE IF NOT EXISTS id_bitmaps (
+            data_set INTEGER PRIMARY KEY,
+            first_id INTEGER NOT NULL,
+            last_id INTEGER NOT NULL,
+            states BLOB NOT NULL,
+            updated_at TEXT DEFAULT (datetime('now'))
+        );
+    )");
+}
+
+// v7: completed downloads may live in a pack file (see PackStore) rather
+// than at local_path; NULL pack_id means the file is loose
+bool Database::migrate_v7() {
+    return ensure_column("files", "pack_id", "INTEGER") &&
+           ensure_column("files", "pack_offset", "INTEGER") &&
+           execute(R"(
+               CREATE INDEX IF NOT EXISTS idx_files_pack ON files(data_set, pack_id)
+                   WHERE pack_id IS NOT NULL;
+               CREATE INDEX IF NOT EXISTS idx_files_unpacked ON files(data_set, id)
+                   WHERE status IN (2, 5) AND pack_id IS NULL;
+           )");
+}
+
+// v8: digest and PDF signature check of each finished download, taken as
+// it streamed to disk; NULL for files from before the check existed
+bool Database::migrate_v8() {
+    return ensure_column("files", "sha256", "TEXT") &&
+           ensure_column("files", "is_pdf", "INTEGER") &&
+           execute(R"(
+               CREATE INDEX IF NOT EXISTS idx_files_sha256 ON files(sha256)
+                   WHERE sha256 IS NOT NULL;
+           )");
+}
+
+bool Database::rebuild_counters(const std::string& where) {
+    std::string sql =
+        "DELETE FROM file_counts" + where + ";"
+        "INSERT INTO file_counts (data_set, status, count) "
+        "SELECT data_set, status, COUNT(*) FROM files" + where + " GROUP BY data_set, status;"
+        "DELETE FROM page_counts" + where + ";"
+        "INSERT INTO page_counts (data_set, total, scraped, pdf_total) "
+        "SELECT data_set, COUNT(*), SUM(scraped IS 1), COALESCE(SUM(pdf_count), 0) FROM pages" +
+        where + " GROUP BY data_set;";
+
+    return execute(sql);
+}
+
+bool Database::prepare_statements() {
+    for (sqlite3_stmt* stmt : statements_) {
+        sqlite3_finalize(stmt);
+    }
+    statements_.assign(STMT_COUNT, nullptr);
+
+    for (size_t id = 0; id < STMT_COUNT; ++id) {
+        if (sqlite3_prepare_v3(db_, STATEMENT_SQL[id], -1, SQLITE_PREPARE_PERSISTENT,
+                               &statements_[id], nullptr) != SQLITE_OK) {
+            last_error_ = sqlite3_errmsg(db_);
+            last_error_info_ = ErrorInfo{ErrorCode::DB_OPERATION_FAILED, last_error_};
+            return false;
+        }
+    }
+    return true;
+}
+
+sqlite3_stmt* Database::statement(size_t id) {
+    // Methods may be called before initialize() on an existing database
+    if (statements_.size() != STMT_COUNT) {
+        statements_.assign(STMT_COUNT, nullptr);
+    }
+    if (!statements_[id]) {
+        sqlite3_prepare_v3(db_, STATEMENT_SQL[id], -1, SQLITE_PREPARE_PERSISTENT,
+                           &statements_[id], nullptr);
+    }
+    return statements_[id];
+}
+
+bool Database::ensure_column(const std::string& table, const std::string& column,
+                             const std::string& definition) {
+    sqlite3_stmt* stmt = nullptr;
+    std::string sql = "PRAGMA table_info(" + table + ")";
+
+    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
+        last_error_ = sqlite3_errmsg(db_);
+        return false;
+    }
+
+    bool found = false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (name && column == name) {
+            found = true;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    if (found) return true;
+    return execute("ALTER TABLE " + table + " ADD COLUMN " + column + " " + definition);
+}
+
+bool Database::add_file(const FileRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_ADD_FILE));
+    if (!stmt) {
         last_error_ = sqlite3_errmsg(db_);
         last_error_info_ = ErrorInfo{ErrorCode::DB_OPERATION_FAILED, last_error_};
         return false;
@@ -156,10 +731,9 @@ bool Database::add_file(const FileRecord& record) {
     sqlite3_bind_text(stmt, 2, record.file_id.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 3, record.url.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 4, record.local_path.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 5, status_to_string(record.status), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, static_cast<int>(record.status));
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     if (rc != SQLITE_DONE) {
         last_error_ = sqlite3_errmsg(db_);
@@ -176,14 +750,8 @@ bool Database::add_files_batch(const std::vector<FileRecord>& records) {
 
     if (!execute("BEGIN TRANSACTION")) return false;
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        INSERT OR IGNORE INTO files (data_set, file_id, url, local_path, status)
-        VALUES (?, ?, ?, ?, ?)
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_ADD_FILE));
+    if (!stmt) {
         last_error_ = sqlite3_errmsg(db_);
         execute("ROLLBACK");
         return false;
@@ -195,45 +763,75 @@ bool Database::add_files_batch(const std::vector<FileRecord>& records) {
         sqlite3_bind_text(stmt, 2, record.file_id.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, record.url.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, record.local_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 5, status_to_string(record.status), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 5, static_cast<int>(record.status));
 
-        rc = sqlite3_step(stmt);
+        int rc = sqlite3_step(stmt);
         if (rc != SQLITE_DONE) {
             last_error_ = sqlite3_errmsg(db_);
-            sqlite3_finalize(stmt);
             execute("ROLLBACK");
             return false;
         }
     }
 
-    sqlite3_finalize(stmt);
     return execute("COMMIT");
 }
 
-bool Database::update_file_status(int64_t id, DownloadStatus status,
-                                  const std::string& error_msg, int64_t file_size) {
+int Database::reconcile_local_files(const std::vector<FileRecord>& records) {
+    if (records.empty()) return 0;
+
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        UPDATE files SET status = ?, error_message = ?, file_size = ?,
-                        updated_at = datetime('now')
-        WHERE id = ?
-    )";
+    if (!execute("BEGIN TRANSACTION")) return -1;
 
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_RECONCILE_LOCAL_FILE));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
+        execute("ROLLBACK");
+        return -1;
+    }
+
+    int changed = 0;
+    for (const auto& record : records) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int(stmt, 1, record.data_set);
+        sqlite3_bind_text(stmt, 2, record.file_id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, record.url.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, record.local_path.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 5, record.file_size);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            last_error_ = sqlite3_errmsg(db_);
+            execute("ROLLBACK");
+            return -1;
+        }
+        changed += sqlite3_changes(db_);
+    }
+
+    return execute("COMMIT") ? changed : -1;
+}
+
+bool Database::update_file_status(int64_t id, DownloadStatus status,
+                                  const std::string& error_msg, int64_t file_size,
+                                  int64_t next_attempt_at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_UPDATE_STATUS));
+    if (!stmt) {
         last_error_ = sqlite3_errmsg(db_);
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, status_to_string(status), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 1, static_cast<int>(status));
     sqlite3_bind_text(stmt, 2, error_msg.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int64(stmt, 3, file_size);
-    sqlite3_bind_int64(stmt, 4, id);
+    if (next_attempt_at > 0) {
+        sqlite3_bind_int64(stmt, 4, next_attempt_at);
+    } else {
+        sqlite3_bind_null(stmt, 4);
+    }
+    sqlite3_bind_int64(stmt, 5, id);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_DONE;
 }
@@ -244,27 +842,19 @@ bool Database::update_file_status_by_file_id(const std::string& file_id, int dat
                                               int64_t file_size) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        UPDATE files SET status = ?, error_message = ?, file_size = ?,
-                        updated_at = datetime('now')
-        WHERE file_id = ? AND data_set = ?
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_UPDATE_STATUS_BY_FILE_ID));
+    if (!stmt) {
         last_error_ = sqlite3_errmsg(db_);
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, status_to_string(status), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 1, static_cast<int>(status));
     sqlite3_bind_text(stmt, 2, error_msg.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int64(stmt, 3, file_size);
     sqlite3_bind_text(stmt, 4, file_id.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 5, data_set);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_DONE;
 }
@@ -272,23 +862,15 @@ bool Database::update_file_status_by_file_id(const std::string& file_id, int dat
 std::optional<FileRecord> Database::get_file(int64_t id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        SELECT id, data_set, file_id, url, local_path, status, file_size,
-               retry_count, error_message
-        FROM files WHERE id = ?
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_GET_FILE));
+    if (!stmt) {
         return std::nullopt;
     }
 
     sqlite3_bind_int64(stmt, 1, id);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
 
     if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
         return std::nullopt;
     }
 
@@ -299,37 +881,28 @@ std::optional<FileRecord> Database::get_file(int64_t id) {
     record.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
     const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
     record.local_path = local_path ? local_path : "";
-    record.status = string_to_status(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
+    record.status = column_status(stmt, 5);
     record.file_size = sqlite3_column_int64(stmt, 6);
     record.retry_count = sqlite3_column_int(stmt, 7);
     const char* error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
     record.error_message = error ? error : "";
 
-    sqlite3_finalize(stmt);
     return record;
 }
 
 std::optional<FileRecord> Database::get_file_by_file_id(const std::string& file_id, int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        SELECT id, data_set, file_id, url, local_path, status, file_size,
-               retry_count, error_message
-        FROM files WHERE file_id = ? AND data_set = ?
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_GET_FILE_BY_FILE_ID));
+    if (!stmt) {
         return std::nullopt;
     }
 
     sqlite3_bind_text(stmt, 1, file_id.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 2, data_set);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
 
     if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
         return std::nullopt;
     }
 
@@ -340,13 +913,12 @@ std::optional<FileRecord> Database::get_file_by_file_id(const std::string& file_
     record.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
     const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
     record.local_path = local_path ? local_path : "";
-    record.status = string_to_status(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
+    record.status = column_status(stmt, 5);
     record.file_size = sqlite3_column_int64(stmt, 6);
     record.retry_count = sqlite3_column_int(stmt, 7);
     const char* error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
     record.error_message = error ? error : "";
 
-    sqlite3_finalize(stmt);
     return record;
 }
 
@@ -354,20 +926,14 @@ std::vector<FileRecord> Database::get_pending_files(int limit) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     std::vector<FileRecord> result;
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        SELECT id, data_set, file_id, url, local_path, status, file_size,
-               retry_count, error_message
-        FROM files WHERE status = 'PENDING' LIMIT ?
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_GET_PENDING));
+    if (!stmt) {
         return result;
     }
 
     sqlite3_bind_int(stmt, 1, limit);
 
+    int rc;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         FileRecord record;
         record.id = sqlite3_column_int64(stmt, 0);
@@ -376,7 +942,7 @@ std::vector<FileRecord> Database::get_pending_files(int limit) {
         record.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
         const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
         record.local_path = local_path ? local_path : "";
-        record.status = string_to_status(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
+        record.status = column_status(stmt, 5);
         record.file_size = sqlite3_column_int64(stmt, 6);
         record.retry_count = sqlite3_column_int(stmt, 7);
         const char* error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
@@ -384,30 +950,26 @@ std::vector<FileRecord> Database::get_pending_files(int limit) {
         result.push_back(std::move(record));
     }
 
-    sqlite3_finalize(stmt);
     return result;
 }
 
-std::vector<FileRecord> Database::get_failed_files(int max_retries, int limit) {
+std::vector<FileRecord> Database::claim_pending_files(int data_set, int limit, const std::string& owner,
+                                                      int lease_seconds) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     std::vector<FileRecord> result;
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        SELECT id, data_set, file_id, url, local_path, status, file_size,
-               retry_count, error_message, strftime('%s', updated_at)
-        FROM files WHERE status = 'FAILED' AND retry_count < ?
-        ORDER BY updated_at ASC LIMIT ?
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_CLAIM_PENDING));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
         return result;
     }
 
-    sqlite3_bind_int(stmt, 1, max_retries);
-    sqlite3_bind_int(stmt, 2, limit);
+    sqlite3_bind_text(stmt, 1, owner.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, lease_seconds);
+    sqlite3_bind_int(stmt, 3, data_set);
+    sqlite3_bind_int(stmt, 4, limit);
 
+    int rc;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         FileRecord record;
         record.id = sqlite3_column_int64(stmt, 0);
@@ -416,56 +978,231 @@ std::vector<FileRecord> Database::get_failed_files(int max_retries, int limit) {
         record.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
         const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
         record.local_path = local_path ? local_path : "";
-        record.status = string_to_status(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
+        record.status = column_status(stmt, 5);
         record.file_size = sqlite3_column_int64(stmt, 6);
         record.retry_count = sqlite3_column_int(stmt, 7);
         const char* error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
         record.error_message = error ? error : "";
-
-        // Convert unix timestamp to time_point
-        int64_t unix_time = sqlite3_column_int64(stmt, 9);
-        record.updated_at = std::chrono::system_clock::from_time_t(static_cast<time_t>(unix_time));
-
         result.push_back(std::move(record));
     }
 
-    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        last_error_ = sqlite3_errmsg(db_);
+    }
+
     return result;
 }
 
-bool Database::increment_retry_count(int64_t id) {
+bool Database::release_files(const std::vector<int64_t>& ids) {
+    if (ids.empty()) return true;
+
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "UPDATE files SET retry_count = retry_count + 1 WHERE id = ?";
+    if (!execute("BEGIN TRANSACTION")) return false;
 
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_RELEASE_FILE));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
+        execute("ROLLBACK");
         return false;
     }
 
-    sqlite3_bind_int64(stmt, 1, id);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-
-    return rc == SQLITE_DONE;
+    for (int64_t id : ids) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int64(stmt, 1, id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            last_error_ = sqlite3_errmsg(db_);
+            execute("ROLLBACK");
+            return false;
+        }
+    }
+
+    return execute("COMMIT");
 }
 
-bool Database::file_exists(const std::string& file_id, int data_set) {
+std::vector<FileRecord> Database::get_failed_files(int max_retries, int limit) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT 1 FROM files WHERE file_id = ? AND data_set = ? LIMIT 1";
+    std::vector<FileRecord> result;
+    CachedStatement stmt(statement(STMT_GET_FAILED));
+    if (!stmt) {
+        return result;
+    }
 
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    sqlite3_bind_int(stmt, 1, max_retries);
+    sqlite3_bind_int(stmt, 2, limit);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        FileRecord record;
+        record.id = sqlite3_column_int64(stmt, 0);
+        record.data_set = sqlite3_column_int(stmt, 1);
+        record.file_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        record.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+        record.local_path = local_path ? local_path : "";
+        record.status = column_status(stmt, 5);
+        record.file_size = sqlite3_column_int64(stmt, 6);
+        record.retry_count = sqlite3_column_int(stmt, 7);
+        const char* error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
+        record.error_message = error ? error : "";
+
+        // Convert unix timestamp to time_point
+        int64_t unix_time = sqlite3_column_int64(stmt, 9);
+        record.updated_at = std::chrono::system_clock::from_time_t(static_cast<time_t>(unix_time));
+
+        result.push_back(std::move(record));
+    }
+
+    return result;
+}
+
+std::vector<RetryDeadline> Database::get_retry_deadlines(int data_set, int max_retries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<RetryDeadline> result;
+    CachedStatement stmt(statement(STMT_GET_RETRY_DEADLINES));
+    if (!stmt) {
+        return result;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    sqlite3_bind_int(stmt, 2, max_retries);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        result.push_back(RetryDeadline{sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1)});
+    }
+
+    if (rc != SQLITE_DONE) {
+        last_error_ = sqlite3_errmsg(db_);
+    }
+
+    return result;
+}
+
+std::vector<FileRecord> Database::claim_retry_files(const std::vector<int64_t>& ids, int64_t now,
+                                                    const std::string& owner, int lease_seconds) {
+    std::vector<FileRecord> result;
+    if (ids.empty()) return result;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!execute("BEGIN TRANSACTION")) return result;
+
+    CachedStatement stmt(statement(STMT_CLAIM_RETRY));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
+        execute("ROLLBACK");
+        return result;
+    }
+
+    for (int64_t id : ids) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_text(stmt, 1, owner.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 2, lease_seconds);
+        sqlite3_bind_int64(stmt, 3, id);
+        sqlite3_bind_int64(stmt, 4, now);
+
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            FileRecord record;
+            record.id = sqlite3_column_int64(stmt, 0);
+            record.data_set = sqlite3_column_int(stmt, 1);
+            record.file_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+            record.url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+            const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+            record.local_path = local_path ? local_path : "";
+            record.status = column_status(stmt, 5);
+            record.file_size = sqlite3_column_int64(stmt, 6);
+            record.retry_count = sqlite3_column_int(stmt, 7);
+            const char* error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
+            record.error_message = error ? error : "";
+            result.push_back(std::move(record));
+        }
+        if (rc != SQLITE_DONE) {
+            last_error_ = sqlite3_errmsg(db_);
+            execute("ROLLBACK");
+            return {};
+        }
+    }
+
+    if (!execute("COMMIT")) return {};
+    return result;
+}
+
+bool Database::increment_retry_count(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_INCREMENT_RETRY));
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_int64(stmt, 1, id);
+    int rc = sqlite3_step(stmt);
+
+    return rc == SQLITE_DONE;
+}
+
+bool Database::apply_status_updates(const std::vector<StatusUpdate>& updates) {
+    if (updates.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!execute("BEGIN TRANSACTION")) return false;
+
+    CachedStatement stmt(statement(STMT_APPLY_STATUS_UPDATE));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
+        execute("ROLLBACK");
+        return false;
+    }
+
+    for (const auto& update : updates) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int(stmt, 1, static_cast<int>(update.status));
+        sqlite3_bind_text(stmt, 2, update.error_message.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 3, update.file_size);
+        sqlite3_bind_int(stmt, 4, update.increment_retry ? 1 : 0);
+        if (update.next_attempt_at > 0) {
+            sqlite3_bind_int64(stmt, 5, update.next_attempt_at);
+        } else {
+            sqlite3_bind_null(stmt, 5);
+        }
+        if (!update.sha256.empty()) {
+            sqlite3_bind_text(stmt, 6, update.sha256.c_str(), -1, SQLITE_TRANSIENT);
+        } else {
+            sqlite3_bind_null(stmt, 6);
+        }
+        if (update.is_pdf >= 0) {
+            sqlite3_bind_int(stmt, 7, update.is_pdf);
+        } else {
+            sqlite3_bind_null(stmt, 7);
+        }
+        sqlite3_bind_int64(stmt, 8, update.id);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            last_error_ = sqlite3_errmsg(db_);
+            execute("ROLLBACK");
+            return false;
+        }
+    }
+
+    return execute("COMMIT");
+}
+
+bool Database::file_exists(const std::string& file_id, int data_set) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_FILE_EXISTS));
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_text(stmt, 1, file_id.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 2, data_set);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_ROW;
 }
@@ -473,18 +1210,14 @@ bool Database::file_exists(const std::string& file_id, int data_set) {
 bool Database::add_page(int data_set, int page_number) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "INSERT OR IGNORE INTO pages (data_set, page_number) VALUES (?, ?)";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_ADD_PAGE));
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     sqlite3_bind_int(stmt, 2, page_number);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_DONE;
 }
@@ -494,11 +1227,8 @@ bool Database::add_pages_batch(int data_set, int start_page, int end_page) {
 
     if (!execute("BEGIN TRANSACTION")) return false;
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "INSERT OR IGNORE INTO pages (data_set, page_number) VALUES (?, ?)";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_ADD_PAGE));
+    if (!stmt) {
         execute("ROLLBACK");
         return false;
     }
@@ -508,89 +1238,107 @@ bool Database::add_pages_batch(int data_set, int start_page, int end_page) {
         sqlite3_bind_int(stmt, 1, data_set);
         sqlite3_bind_int(stmt, 2, page);
 
-        rc = sqlite3_step(stmt);
+        int rc = sqlite3_step(stmt);
         if (rc != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
             execute("ROLLBACK");
             return false;
         }
     }
 
-    sqlite3_finalize(stmt);
     return execute("COMMIT");
 }
 
-bool Database::mark_page_scraped(int data_set, int page_number, int pdf_count) {
+bool Database::mark_page_scraped(int data_set, int page_number, int pdf_count,
+                                 const std::string& etag, const std::string& last_modified,
+                                 uint64_t content_hash) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        UPDATE pages SET scraped = 1, pdf_count = ?, scraped_at = datetime('now')
-        WHERE data_set = ? AND page_number = ?
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_MARK_PAGE_SCRAPED));
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_int(stmt, 1, pdf_count);
-    sqlite3_bind_int(stmt, 2, data_set);
-    sqlite3_bind_int(stmt, 3, page_number);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    if (!etag.empty()) sqlite3_bind_text(stmt, 2, etag.c_str(), -1, SQLITE_TRANSIENT);
+    if (!last_modified.empty()) sqlite3_bind_text(stmt, 3, last_modified.c_str(), -1, SQLITE_TRANSIENT);
+    if (content_hash != 0) sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(content_hash));
+    sqlite3_bind_int(stmt, 5, data_set);
+    sqlite3_bind_int(stmt, 6, page_number);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_DONE;
 }
 
-std::vector<int> Database::get_unscraped_pages(int data_set, int limit) {
+int Database::reset_scraped_pages(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    std::vector<int> result;
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        SELECT page_number FROM pages
-        WHERE data_set = ? AND scraped = 0
-        ORDER BY page_number
-        LIMIT ?
-    )";
+    CachedStatement stmt(statement(STMT_RESET_SCRAPED_PAGES));
+    if (!stmt) {
+        return -1;
+    }
 
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    sqlite3_bind_int(stmt, 1, data_set);
+    int rc = sqlite3_step(stmt);
+
+    if (rc != SQLITE_DONE) {
+        return -1;
+    }
+    return sqlite3_changes(db_);
+}
+
+int Database::remove_pages_after(int data_set, int last_page) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_REMOVE_PAGES_AFTER));
+    if (!stmt) {
+        return -1;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    sqlite3_bind_int(stmt, 2, last_page);
+    int rc = sqlite3_step(stmt);
+
+    if (rc != SQLITE_DONE) {
+        return -1;
+    }
+    return sqlite3_changes(db_);
+}
+
+std::vector<int> Database::get_unscraped_pages(int data_set, int limit, int first_page, int last_page) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<int> result;
+    CachedStatement stmt(statement(STMT_GET_UNSCRAPED_PAGES));
+    if (!stmt) {
         return result;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
-    sqlite3_bind_int(stmt, 2, limit);
+    sqlite3_bind_int(stmt, 2, first_page);
+    sqlite3_bind_int(stmt, 3, last_page);
+    sqlite3_bind_int(stmt, 4, limit);
 
+    int rc;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         result.push_back(sqlite3_column_int(stmt, 0));
     }
 
-    sqlite3_finalize(stmt);
     return result;
 }
 
 std::optional<PageRecord> Database::get_page(int data_set, int page_number) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        SELECT id, data_set, page_number, scraped, pdf_count, scraped_at
-        FROM pages WHERE data_set = ? AND page_number = ? LIMIT 1
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_GET_PAGE));
+    if (!stmt) {
         return std::nullopt;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     sqlite3_bind_int(stmt, 2, page_number);
 
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
         return std::nullopt;
     }
 
@@ -601,26 +1349,28 @@ std::optional<PageRecord> Database::get_page(int data_set, int page_number) {
     record.scraped = sqlite3_column_int(stmt, 3) != 0;
     record.pdf_count = sqlite3_column_int(stmt, 4);
     // scraped_at handling - skip for now
+    if (auto* text = sqlite3_column_text(stmt, 6)) {
+        record.etag = reinterpret_cast<const char*>(text);
+    }
+    if (auto* text = sqlite3_column_text(stmt, 7)) {
+        record.last_modified = reinterpret_cast<const char*>(text);
+    }
+    record.content_hash = static_cast<uint64_t>(sqlite3_column_int64(stmt, 8));
 
-    sqlite3_finalize(stmt);
     return record;
 }
 
 bool Database::page_exists(int data_set, int page_number) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT 1 FROM pages WHERE data_set = ? AND page_number = ? LIMIT 1";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_PAGE_EXISTS));
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     sqlite3_bind_int(stmt, 2, page_number);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_ROW;
 }
@@ -629,56 +1379,40 @@ DownloadStats Database::get_stats(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     DownloadStats stats{};
-    sqlite3_stmt* stmt = nullptr;
 
     // Get page stats
-    const char* page_sql = R"(
-        SELECT
-            COUNT(*) as total,
-            SUM(CASE WHEN scraped = 1 THEN 1 ELSE 0 END) as scraped,
-            SUM(pdf_count) as pdf_total
-        FROM pages WHERE data_set = ?
-    )";
-
-    if (sqlite3_prepare_v2(db_, page_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (CachedStatement stmt(statement(STMT_PAGE_STATS)); stmt) {
         sqlite3_bind_int(stmt, 1, data_set);
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             stats.total_pages = sqlite3_column_int64(stmt, 0);
             stats.pages_scraped = sqlite3_column_int64(stmt, 1);
             stats.total_files_found = sqlite3_column_int64(stmt, 2);
         }
-        sqlite3_finalize(stmt);
     }
 
     // Get file stats
-    const char* file_sql = R"(
-        SELECT status, COUNT(*) FROM files WHERE data_set = ? GROUP BY status
-    )";
-
-    if (sqlite3_prepare_v2(db_, file_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (CachedStatement stmt(statement(STMT_FILE_STATUS_COUNTS)); stmt) {
         sqlite3_bind_int(stmt, 1, data_set);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            const char* status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
             int64_t count = sqlite3_column_int64(stmt, 1);
 
-            if (strcmp(status, "PENDING") == 0) stats.files_pending = count;
-            else if (strcmp(status, "IN_PROGRESS") == 0) stats.files_in_progress = count;
-            else if (strcmp(status, "COMPLETED") == 0) stats.files_completed = count;
-            else if (strcmp(status, "FAILED") == 0) stats.files_failed = count;
-            else if (strcmp(status, "NOT_FOUND") == 0) stats.files_not_found = count;
-            else if (strcmp(status, "SKIPPED") == 0) stats.files_skipped = count;
+            switch (column_status(stmt, 0)) {
+                case DownloadStatus::PENDING: stats.files_pending = count; break;
+                case DownloadStatus::IN_PROGRESS: stats.files_in_progress = count; break;
+                case DownloadStatus::COMPLETED: stats.files_completed = count; break;
+                case DownloadStatus::FAILED: stats.files_failed = count; break;
+                case DownloadStatus::NOT_FOUND: stats.files_not_found = count; break;
+                case DownloadStatus::SKIPPED: stats.files_skipped = count; break;
+            }
         }
-        sqlite3_finalize(stmt);
     }
 
     // Get brute force progress
-    const char* bf_sql = "SELECT brute_force_current FROM progress WHERE data_set = ?";
-    if (sqlite3_prepare_v2(db_, bf_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (CachedStatement stmt(statement(STMT_GET_BRUTE_FORCE)); stmt) {
         sqlite3_bind_int(stmt, 1, data_set);
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             stats.brute_force_current = sqlite3_column_int64(stmt, 0);
         }
-        sqlite3_finalize(stmt);
     }
 
     return stats;
@@ -687,10 +1421,8 @@ DownloadStats Database::get_stats(int data_set) {
 int64_t Database::get_total_files(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT COUNT(*) FROM files WHERE data_set = ?";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_COUNT_FILES));
+    if (!stmt) {
         return 0;
     }
 
@@ -699,17 +1431,14 @@ int64_t Database::get_total_files(int data_set) {
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         count = sqlite3_column_int64(stmt, 0);
     }
-    sqlite3_finalize(stmt);
     return count;
 }
 
 int64_t Database::get_completed_files(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT COUNT(*) FROM files WHERE data_set = ? AND status = 'COMPLETED'";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_COUNT_COMPLETED));
+    if (!stmt) {
         return 0;
     }
 
@@ -718,23 +1447,19 @@ int64_t Database::get_completed_files(int data_set) {
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         count = sqlite3_column_int64(stmt, 0);
     }
-    sqlite3_finalize(stmt);
     return count;
 }
 
 int Database::reset_in_progress_files(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "UPDATE files SET status = 'PENDING' WHERE data_set = ? AND status = 'IN_PROGRESS'";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_RESET_IN_PROGRESS));
+    if (!stmt) {
         return -1;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 
     if (rc != SQLITE_DONE) {
         return -1;
@@ -745,16 +1470,13 @@ int Database::reset_in_progress_files(int data_set) {
 int Database::reset_failed_files(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "UPDATE files SET status = 'PENDING', retry_count = 0, error_message = NULL WHERE data_set = ? AND status = 'FAILED'";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_RESET_FAILED));
+    if (!stmt) {
         return -1;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 
     if (rc != SQLITE_DONE) {
         return -1;
@@ -765,16 +1487,13 @@ int Database::reset_failed_files(int data_set) {
 int Database::reset_all_files(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "UPDATE files SET status = 'PENDING', retry_count = 0, error_message = NULL WHERE data_set = ?";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_RESET_ALL));
+    if (!stmt) {
         return -1;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 
     if (rc != SQLITE_DONE) {
         return -1;
@@ -786,57 +1505,62 @@ int Database::reset_all_files(int data_set) {
 bool Database::has_existing_work(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT 1 FROM files WHERE data_set = ? AND status IN ('PENDING', 'IN_PROGRESS', 'FAILED') LIMIT 1";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_HAS_WORK));
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 
     return rc == SQLITE_ROW;
 }
 
+bool Database::reconcile_counters(int data_set) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!execute("BEGIN TRANSACTION")) return false;
+    if (!rebuild_counters(" WHERE data_set = " + std::to_string(data_set))) {
+        execute("ROLLBACK");
+        return false;
+    }
+    return execute("COMMIT");
+}
+
 int Database::clear_data_set(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     std::cerr << "[DEBUG] clear_data_set: Clearing data_set=" << data_set << std::endl;
 
     // Delete files
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "DELETE FROM files WHERE data_set = ?";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return -1;
-    }
-
-    sqlite3_bind_int(stmt, 1, data_set);
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int deleted_files;
+    {
+        CachedStatement stmt(statement(STMT_DELETE_FILES));
+        if (!stmt) {
+            return -1;
+        }
 
-    if (rc != SQLITE_DONE) {
-        return -1;
+        sqlite3_bind_int(stmt, 1, data_set);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            return -1;
+        }
+        deleted_files = sqlite3_changes(db_);
     }
 
-    int deleted_files = sqlite3_changes(db_);
-
     // Delete pages
-    sql = "DELETE FROM pages WHERE data_set = ?";
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (CachedStatement stmt(statement(STMT_DELETE_PAGES)); stmt) {
         sqlite3_bind_int(stmt, 1, data_set);
         sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
     }
 
     // Delete progress
-    sql = "DELETE FROM progress WHERE data_set = ?";
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (CachedStatement stmt(statement(STMT_DELETE_PROGRESS)); stmt) {
+        sqlite3_bind_int(stmt, 1, data_set);
+        sqlite3_step(stmt);
+    }
+    if (CachedStatement stmt(statement(STMT_DELETE_ID_BITMAP)); stmt) {
         sqlite3_bind_int(stmt, 1, data_set);
         sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
     }
 
     return deleted_files;
@@ -845,24 +1569,14 @@ int Database::clear_data_set(int data_set) {
 bool Database::set_brute_force_progress(int data_set, uint64_t current_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = R"(
-        INSERT INTO progress (data_set, brute_force_current, updated_at)
-        VALUES (?, ?, datetime('now'))
-        ON CONFLICT(data_set) DO UPDATE SET
-            brute_force_current = excluded.brute_force_current,
-            updated_at = datetime('now')
-    )";
-
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_SET_BRUTE_FORCE));
+    if (!stmt) {
         return false;
     }
 
     sqlite3_bind_int(stmt, 1, data_set);
     sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(current_id));
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
 
     return rc == SQLITE_DONE;
 }
@@ -870,10 +1584,8 @@ bool Database::set_brute_force_progress(int data_set, uint64_t current_id) {
 uint64_t Database::get_brute_force_progress(int data_set) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT brute_force_current FROM progress WHERE data_set = ?";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    CachedStatement stmt(statement(STMT_GET_BRUTE_FORCE));
+    if (!stmt) {
         return 0;
     }
 
@@ -882,7 +1594,213 @@ uint64_t Database::get_brute_force_progress(int data_set) {
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         result = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
     }
-    sqlite3_finalize(stmt);
+    return result;
+}
+
+bool Database::save_id_bitmap(int data_set, const IdBitmap& bitmap) {
+    std::string states = bitmap.serialize();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_SAVE_ID_BITMAP));
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(bitmap.first()));
+    sqlite3_bind_int64(stmt, 3, static_cast<int64_t>(bitmap.last()));
+    sqlite3_bind_blob(stmt, 4, states.data(), static_cast<int>(states.size()), SQLITE_STATIC);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+bool Database::load_id_bitmap(int data_set, IdBitmap& bitmap) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_LOAD_ID_BITMAP));
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+
+    auto first = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+    auto last = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+    const void* blob = sqlite3_column_blob(stmt, 2);
+    std::string states(static_cast<const char*>(blob), blob ? sqlite3_column_bytes(stmt, 2) : 0);
+
+    auto loaded = IdBitmap::deserialize(first, last, states);
+    if (!loaded) {
+        return false;
+    }
+    bitmap = std::move(*loaded);
+    return true;
+}
+
+void Database::for_each_file_status(int data_set,
+                                    const std::function<void(const std::string&, DownloadStatus)>& visit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_FILE_STATUSES));
+    if (!stmt) {
+        return;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* file_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        visit(file_id ? file_id : "", static_cast<DownloadStatus>(sqlite3_column_int(stmt, 1)));
+    }
+}
+
+bool Database::for_each_file(const std::function<void(int, const std::string&)>& visit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_ALL_FILE_IDS));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
+        return false;
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* file_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        visit(sqlite3_column_int(stmt, 0), file_id ? file_id : "");
+    }
+    if (rc != SQLITE_DONE) {
+        last_error_ = sqlite3_errmsg(db_);
+        return false;
+    }
+    return true;
+}
+
+bool Database::get_pack_end(int data_set, int& pack_id, int64_t& end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_GET_PACK_END));
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    if (sqlite3_step(stmt) != SQLITE_ROW || sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+        return false;
+    }
+    pack_id = sqlite3_column_int(stmt, 0);
+    end = sqlite3_column_int64(stmt, 1);
+    return true;
+}
+
+std::vector<FileRecord> Database::get_unpacked_files(int data_set, int64_t after_id, int limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<FileRecord> result;
+    CachedStatement stmt(statement(STMT_GET_UNPACKED));
+    if (!stmt) {
+        return result;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    sqlite3_bind_int64(stmt, 2, after_id);
+    sqlite3_bind_int(stmt, 3, limit);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        FileRecord record{};
+        record.id = sqlite3_column_int64(stmt, 0);
+        record.data_set = data_set;
+        const char* file_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        const char* local_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        record.file_id = file_id ? file_id : "";
+        record.local_path = local_path ? local_path : "";
+        record.status = DownloadStatus::COMPLETED;
+        result.push_back(std::move(record));
+    }
+
+    if (rc != SQLITE_DONE) {
+        last_error_ = sqlite3_errmsg(db_);
+    }
+
+    return result;
+}
+
+bool Database::set_pack_locations(const std::vector<PackedFile>& files) {
+    if (files.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!execute("BEGIN TRANSACTION")) return false;
+
+    CachedStatement stmt(statement(STMT_SET_PACK_LOCATION));
+    if (!stmt) {
+        last_error_ = sqlite3_errmsg(db_);
+        execute("ROLLBACK");
+        return false;
+    }
+
+    for (const auto& file : files) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int(stmt, 1, file.pack_id);
+        sqlite3_bind_int64(stmt, 2, file.pack_offset);
+        sqlite3_bind_int64(stmt, 3, file.file_size);
+        sqlite3_bind_int64(stmt, 4, file.id);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            last_error_ = sqlite3_errmsg(db_);
+            execute("ROLLBACK");
+            return false;
+        }
+    }
+
+    return execute("COMMIT");
+}
+
+std::string Database::find_file_by_sha256(const std::string& sha256, int64_t exclude_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_FIND_BY_SHA256));
+    if (!stmt) {
+        return "";
+    }
+
+    sqlite3_bind_text(stmt, 1, sha256.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, exclude_id);
+    std::string local_path;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        local_path = path ? path : "";
+    }
+    return local_path;
+}
+
+bool Database::set_max_page(int data_set, int max_page) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_SET_MAX_PAGE));
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    sqlite3_bind_int(stmt, 2, max_page);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+int Database::get_max_page(int data_set) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CachedStatement stmt(statement(STMT_GET_MAX_PAGE));
+    if (!stmt) {
+        return -1;
+    }
+
+    sqlite3_bind_int(stmt, 1, data_set);
+    int result = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        result = sqlite3_column_int(stmt, 0);
+    }
     return result;
 }
 
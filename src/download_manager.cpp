@@ -29,27 +29,30 @@
 #include <iomanip>
 
 #include <cmath>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
 
 namespace fs = std::filesystem;
 
 namespace efgrabber {
 
-// S-curve (sigmoid) backoff calculation
-// Delay increases slowly at first, then rapidly, then plateaus
-static int64_t calculate_s_curve_backoff(int retry_count) {
-    if (retry_count <= 0) return 0;
-
-    const double max_delay = 600.0; // 10 minutes max
-    const double min_delay = 5.0;   // 5 seconds min
-    const double k = 1.0;           // Steepness
-    const double mid = 5.0;         // Halfway point at 5 retries
-
-    double delay = min_delay + (max_delay - min_delay) / (1.0 + std::exp(-k * (retry_count - mid)));
-    return static_cast<int64_t>(delay);
+// Unix seconds, the unit of files.next_attempt_at
+static int64_t unix_now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
 DownloadManager::DownloadManager(const std::string& db_path, const std::string& download_dir)
     : db_path_(db_path), download_dir_(download_dir) {
+    // Identifies this process's leases on claimed rows
+    lease_owner_ = "efgrabber-" + std::to_string(getpid()) + "-" +
+        std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+
+    // One share for every handle this manager creates, so DNS results and TLS
+    // sessions survive across files; pooled handles keep their connections
+    curl_share_ = std::make_unique<CurlShare>();
+    downloader_pool_ = std::make_unique<DownloaderPool>(curl_share_.get(), &open_connections_);
 }
 
 DownloadManager::~DownloadManager() {
@@ -59,12 +62,7 @@ DownloadManager::~DownloadManager() {
     pause_cv_.notify_all();
 
     // Join all threads if joinable
-    if (scraper_thread_.joinable()) {
-        scraper_thread_.join();
-    }
-    if (brute_force_thread_.joinable()) {
-        brute_force_thread_.join();
-    }
+    join_producers();
     if (download_thread_.joinable()) {
         download_thread_.join();
     }
@@ -72,13 +70,31 @@ DownloadManager::~DownloadManager() {
         stats_thread_.join();
     }
 
-    // Shutdown thread pools
+    // Hand back work that was claimed but never dispatched
+    stop_work_queue();
+
+    // Shutdown thread pools and the multi engine
     if (download_pool_) {
         download_pool_->shutdown();
     }
+    if (multi_downloader_) {
+        // Aborted transfers stay IN_PROGRESS and are picked up by reset_in_progress()
+        multi_downloader_->shutdown();
+        // Results already handed over are still recorded
+        completion_pool_->shutdown();
+        active_downloads_ = 0;
+    }
     if (scrape_pool_) {
         scrape_pool_->shutdown();
     }
+    for (auto& run : runs_) {
+        if (run->pack_store) {
+            run->pack_store->stop();
+        }
+    }
+    if (status_journal_) {
+        status_journal_->flush();
+    }
 
     running_ = false;
 }
@@ -95,6 +111,15 @@ bool DownloadManager::initialize() {
             return false;
         }
 
+        // Enqueueing dedups against this instead of querying per file
+        if (!known_ids_.load(*db_)) {
+            log("Failed to load known file IDs: " + db_->get_last_error());
+            return false;
+        }
+
+        // Completion statuses are written behind in batched transactions
+        status_journal_ = std::make_unique<StatusJournal>(*db_);
+
         // Initialize cookie jar
         cookie_jar_ = std::make_unique<CookieJar>();
         // Start reaper thread (every 60 seconds)
@@ -109,13 +134,43 @@ bool DownloadManager::initialize() {
 }
 
 void DownloadManager::start(const DataSetConfig& config, OperationMode mode) {
+    start_runs({DataSetJob{config, mode, 1}}, false);
+}
+
+void DownloadManager::start(const std::vector<DataSetJob>& jobs) {
+    start_runs(jobs, false);
+}
+
+void DownloadManager::start_download_only(const DataSetConfig& config) {
+    // Only the download worker; files arrive through add_files_to_queue()
+    start_runs({DataSetJob{config, OperationMode::SCRAPER, 1}}, true);
+}
+
+void DownloadManager::start_runs(const std::vector<DataSetJob>& jobs, bool download_only) {
     if (running_) {
         log("Already running");
         return;
     }
+    if (jobs.empty()) {
+        log("No data sets to run");
+        return;
+    }
+
+    join_producers();  // A finished run's threads may not have been joined
+    runs_.clear();
+    scheduler_.clear();
+    for (const auto& job : jobs) {
+        if (find_run(job.config.id)) continue;  // Each data set runs once
+        auto run = std::make_unique<DataSetRun>();
+        run->job = job;
+        // Also needed for file URLs when only downloading
+        run->scraper = std::make_unique<Scraper>(job.config);
+        run->stats.brute_force_start = job.config.first_file_id;
+        run->stats.brute_force_end = job.config.last_file_id;
+        scheduler_.add(job.config.id, job.weight);
+        runs_.push_back(std::move(run));
+    }
 
-    current_config_ = config;
-    current_mode_ = mode;
     running_ = true;
     paused_ = false;
     stop_requested_ = false;
@@ -124,80 +179,104 @@ void DownloadManager::start(const DataSetConfig& config, OperationMode mode) {
     {
         std::lock_guard<std::mutex> lock(stats_mutex_);
         stats_ = DownloadStats{};
-        stats_.brute_force_start = config.first_file_id;
-        stats_.brute_force_end = config.last_file_id;
+        // Data set ID ranges follow one another, so together they span one range
+        for (const auto& run : runs_) {
+            if (download_only || run->stats.brute_force_start == 0) continue;
+            if (stats_.brute_force_start == 0 || run->stats.brute_force_start < stats_.brute_force_start) {
+                stats_.brute_force_start = run->stats.brute_force_start;
+            }
+            stats_.brute_force_end = std::max(stats_.brute_force_end, run->stats.brute_force_end);
+        }
         stats_.start_time = std::chrono::system_clock::now();
+        for (auto& run : runs_) {
+            run->stats.start_time = stats_.start_time;
+        }
     }
 
     start_time_ = std::chrono::steady_clock::now();
     bytes_this_session_ = 0;
+    bytes_resumed_ = 0;
+    brute_force_current_ = 0;
+    scrape_blocked_ = false;
+    {
+        std::lock_guard<std::mutex> lock(digests_mutex_);
+        digests_.clear();
+        digest_order_.clear();
+    }
     wire_time_ms_ = 0;
     active_transfer_wall_ms_ = 0;
     any_download_active_ = false;
 
-    // Create scraper
-    scraper_ = std::make_unique<Scraper>(config);
-
-    // Create thread pools
-    download_pool_ = std::make_unique<ThreadPool>(max_concurrent_downloads_);
-    scrape_pool_ = std::make_unique<ThreadPool>(max_concurrent_scrapes_);
-
-    log("Starting download for " + config.name);
+    // What is already on disk is settled before any work is claimed
+    directories_.clear();
+    for (auto& run : runs_) {
+        if (disk_check_ == DiskCheck::SCAN && !overwrite_existing_) {
+            reconcile_download_dir(*run);
+        }
+        start_pack_store(*run);
+    }
 
-    // Start worker threads based on mode
-    if (mode == OperationMode::SCRAPER || mode == OperationMode::HYBRID) {
-        scraper_thread_ = std::thread(&DownloadManager::scraper_worker, this);
+    // Create thread pools; every data set shares them
+    create_download_engine();
+    start_work_queue();
+    if (!download_only) {
+        scrape_pool_ = std::make_unique<ThreadPool>(max_concurrent_scrapes_);
     }
 
-    if (mode == OperationMode::BRUTE_FORCE || mode == OperationMode::HYBRID) {
-        brute_force_thread_ = std::thread(&DownloadManager::brute_force_worker, this);
+    // Start worker threads based on each data set's mode
+    active_producers_ = 0;
+    for (auto& entry : runs_) {
+        DataSetRun& run = *entry;
+        log("Starting download for " + run.job.config.name);
+        if (download_only) continue;
+
+        OperationMode mode = run.job.mode;
+        if (mode == OperationMode::SCRAPER || mode == OperationMode::HYBRID ||
+            mode == OperationMode::REFRESH) {
+            active_producers_++;
+            run.scraper_thread = std::thread([this, &run] {
+                scraper_worker(run);
+                active_producers_--;
+                notify_new_work();
+            });
+        }
+        if (mode == OperationMode::BRUTE_FORCE || mode == OperationMode::HYBRID) {
+            active_producers_++;
+            run.brute_force_thread = std::thread([this, &run] {
+                brute_force_worker(run);
+                active_producers_--;
+                notify_new_work();
+            });
+        }
     }
 
     // Start stats update thread
     stats_thread_ = std::thread(&DownloadManager::stats_worker, this);
 
-    // Start download worker
+    // Start download worker; in download-only mode it waits for queued files
     download_thread_ = std::thread(&DownloadManager::download_worker, this);
 }
 
-void DownloadManager::start_download_only(const DataSetConfig& config) {
-    if (running_) {
-        log("Already running");
-        return;
+DownloadManager::DataSetRun* DownloadManager::find_run(int data_set) const {
+    for (const auto& run : runs_) {
+        if (run->job.config.id == data_set) return run.get();
     }
+    return nullptr;
+}
 
-    current_config_ = config;
-    current_mode_ = OperationMode::SCRAPER;  // Pretend scraper mode but don't start scraper
-    running_ = true;
-    paused_ = false;
-    stop_requested_ = false;
+int DownloadManager::primary_data_set() const {
+    return runs_.empty() ? 0 : runs_.front()->job.config.id;
+}
 
-    // Reset stats
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_ = DownloadStats{};
-        stats_.start_time = std::chrono::system_clock::now();
+void DownloadManager::join_producers() {
+    for (auto& run : runs_) {
+        if (run->scraper_thread.joinable()) {
+            run->scraper_thread.join();
+        }
+        if (run->brute_force_thread.joinable()) {
+            run->brute_force_thread.join();
+        }
     }
-
-    start_time_ = std::chrono::steady_clock::now();
-    bytes_this_session_ = 0;
-    wire_time_ms_ = 0;
-    active_transfer_wall_ms_ = 0;
-    any_download_active_ = false;
-
-    // Create scraper (needed for file URL building)
-    scraper_ = std::make_unique<Scraper>(config);
-
-    // Create download pool only
-    download_pool_ = std::make_unique<ThreadPool>(max_concurrent_downloads_);
-
-    log("Starting download-only mode for " + config.name);
-
-    // Start stats update thread
-    stats_thread_ = std::thread(&DownloadManager::stats_worker, this);
-
-    // Start download worker - it will wait for files to be added to the queue
-    download_thread_ = std::thread(&DownloadManager::download_worker, this);
 }
 
 void DownloadManager::stop() {
@@ -208,12 +287,7 @@ void DownloadManager::stop() {
     pause_cv_.notify_all();
 
     // Wait for threads to finish
-    if (scraper_thread_.joinable()) {
-        scraper_thread_.join();
-    }
-    if (brute_force_thread_.joinable()) {
-        brute_force_thread_.join();
-    }
+    join_producers();
     if (download_thread_.joinable()) {
         download_thread_.join();
     }
@@ -221,13 +295,40 @@ void DownloadManager::stop() {
         stats_thread_.join();
     }
 
-    // Shutdown thread pools
+    // Hand back work that was claimed but never dispatched
+    stop_work_queue();
+
+    // Shutdown thread pools and the multi engine
     if (download_pool_) {
         download_pool_->shutdown();
     }
+    if (multi_downloader_) {
+        // Aborted transfers stay IN_PROGRESS and are picked up by reset_in_progress()
+        multi_downloader_->shutdown();
+        // Results already handed over are still recorded
+        completion_pool_->shutdown();
+        active_downloads_ = 0;
+    }
     if (scrape_pool_) {
         scrape_pool_->shutdown();
     }
+    for (auto& run : runs_) {
+        if (!run->pack_store) continue;
+        // Packs what finished this run; older loose files wait for the next
+        run->pack_store->stop();
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        run->stats.files_packed = run->pack_store->files_packed();
+        stats_.files_packed = 0;
+        for (const auto& other : runs_) {
+            stats_.files_packed += other->stats.files_packed;
+        }
+    }
+    if (status_journal_) {
+        status_journal_->flush();
+    }
+    if (db_) {
+        update_stats();  // Final figures, with every journaled status counted
+    }
 
     running_ = false;
     log("Download stopped");
@@ -256,11 +357,51 @@ DownloadStats DownloadManager::get_stats() const {
     return stats_;
 }
 
+DownloadStats DownloadManager::get_stats(int data_set) const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    DataSetRun* run = find_run(data_set);
+    return run ? run->stats : DownloadStats{};
+}
+
+std::vector<int> DownloadManager::get_data_sets() const {
+    std::vector<int> data_sets;
+    for (const auto& run : runs_) {
+        data_sets.push_back(run->job.config.id);
+    }
+    return data_sets;
+}
+
 void DownloadManager::set_callbacks(const DownloadCallbacks& callbacks) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
     callbacks_ = callbacks;
 }
 
+void DownloadManager::set_event_channel(EventChannel* channel) {
+    events_.store(channel, std::memory_order_release);
+}
+
+void DownloadManager::notify_file_status(const std::string& file_id, DownloadStatus status) {
+    if (EventChannel* events = events_.load(std::memory_order_acquire)) {
+        events->push(ManagerEvent::file_status(file_id, status));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    if (callbacks_.on_file_status_change) {
+        callbacks_.on_file_status_change(file_id, status);
+    }
+}
+
+void DownloadManager::notify_page_scraped(int page_number, int pdf_count) {
+    if (EventChannel* events = events_.load(std::memory_order_acquire)) {
+        events->push(ManagerEvent::page_scraped(page_number, pdf_count));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    if (callbacks_.on_page_scraped) {
+        callbacks_.on_page_scraped(page_number, pdf_count);
+    }
+}
+
 void DownloadManager::set_max_concurrent_downloads(int max) {
     max_concurrent_downloads_.store(max);
 }
@@ -285,10 +426,112 @@ void DownloadManager::set_cookie_string(const std::string& cookies) {
     }
 }
 
+void DownloadManager::import_cookies(const std::vector<Cookie>& cookies) {
+    if (!cookie_jar_) return;
+    for (const auto& cookie : cookies) {
+        cookie_jar_->add_cookie(cookie);
+    }
+}
+
 void DownloadManager::set_overwrite_existing(bool overwrite) {
     overwrite_existing_ = overwrite;
 }
 
+void DownloadManager::set_download_engine(DownloadEngine engine) {
+    download_engine_ = engine;
+}
+
+void DownloadManager::set_http2(bool enabled) {
+    http2_ = enabled;
+}
+
+void DownloadManager::set_max_streams_per_connection(int streams) {
+    max_streams_per_connection_ = std::max(1, streams);
+}
+
+void DownloadManager::set_segmented_downloads(int segments, int64_t threshold_bytes) {
+    segments_per_file_ = std::clamp(segments, 1, MAX_SEGMENTS_PER_FILE);
+    segment_threshold_ = std::max<int64_t>(threshold_bytes, MIN_SEGMENT_BYTES);
+}
+
+void DownloadManager::set_write_mode(WriteMode mode) {
+    write_mode_ = mode;
+}
+
+void DownloadManager::set_disk_check(DiskCheck mode) {
+    disk_check_ = mode;
+}
+
+void DownloadManager::set_storage(StorageMode mode, int64_t pack_bytes) {
+    storage_ = mode;
+    pack_bytes_ = pack_bytes > 0 ? pack_bytes : PACK_FILE_BYTES;
+}
+
+void DownloadManager::set_require_pdf(bool require) {
+    require_pdf_ = require;
+}
+
+void DownloadManager::set_dedup(bool enabled) {
+    dedup_ = enabled;
+}
+
+void DownloadManager::set_adaptive_concurrency(bool enabled, int min_limit) {
+    adaptive_concurrency_ = enabled;
+    adaptive_min_ = std::max(1, min_limit);
+}
+
+int DownloadManager::concurrency_limit() const {
+    return concurrency_ ? concurrency_->limit() : max_concurrent_downloads_.load();
+}
+
+void DownloadManager::adjust_concurrency(double window_seconds) {
+    if (!concurrency_) return;
+
+    // The max bound follows the thread count, which the GUI can change at runtime
+    concurrency_->set_bounds(adaptive_min_, max_concurrent_downloads_);
+    int before = concurrency_->limit();
+    if (concurrency_->update(window_seconds, active_downloads_.load()) ||
+        concurrency_->limit() != before) {
+        log("Concurrency " + std::to_string(before) + " -> " + std::to_string(concurrency_->limit()) +
+            ": " + concurrency_->reason());
+        slot_cv_.notify_all();
+    }
+}
+
+void DownloadManager::create_download_engine() {
+    if (adaptive_concurrency_) {
+        concurrency_ = std::make_unique<ConcurrencyController>(adaptive_min_, max_concurrent_downloads_);
+    } else {
+        concurrency_.reset();
+    }
+
+    // Page fetches and blocking downloads negotiate HTTP/2 too, but only the
+    // multi engine can multiplex several transfers over one connection
+    downloader_pool_->set_http2(http2_);
+
+    if (download_engine_ == DownloadEngine::CURL_MULTI) {
+        // Enough loops that each drives about MULTI_TRANSFERS_PER_LOOP transfers
+        size_t wanted = (static_cast<size_t>(max_concurrent_downloads_.load()) +
+                         MULTI_TRANSFERS_PER_LOOP - 1) / MULTI_TRANSFERS_PER_LOOP;
+        size_t hw = std::max(1u, std::thread::hardware_concurrency());
+
+        MultiDownloaderConfig config;
+        config.loop_threads = std::clamp<size_t>(wanted, 1, hw);
+        config.share = curl_share_.get();
+        config.http2 = http2_;
+        config.max_streams = max_streams_per_connection_;
+        config.socket_counter = &open_connections_;
+        config.write_mode = write_mode_;
+        completion_pool_ = std::make_unique<ThreadPool>(MULTI_COMPLETION_THREADS);
+        multi_downloader_ = std::make_unique<MultiDownloader>(config);
+        download_pool_.reset();
+    } else {
+        download_pool_ = std::make_unique<ThreadPool>(max_concurrent_downloads_);
+        multi_downloader_.reset();
+        completion_pool_.reset();
+    }
+}
+
 void DownloadManager::set_external_scraping_active(bool active) {
     external_scraping_active_.store(active);
 }
@@ -296,19 +539,15 @@ void DownloadManager::set_external_scraping_active(bool active) {
 void DownloadManager::add_file_to_queue(const std::string& file_id, const std::string& url, const std::string& local_path) {
     if (!db_) return;
 
-    // Check if file already exists in database
-    if (db_->file_exists(file_id, current_config_.id)) {
-        return;  // Already queued or downloaded
-    }
-
     FileRecord record;
-    record.data_set = current_config_.id;
+    record.data_set = primary_data_set();
     record.file_id = file_id;
     record.url = url;
     record.local_path = local_path;
     record.status = DownloadStatus::PENDING;
 
-    db_->add_file(record);
+    std::vector<FileRecord> records{std::move(record)};
+    enqueue_files(records);
 }
 
 void DownloadManager::add_files_to_queue(const std::vector<std::tuple<std::string, std::string, std::string>>& files) {
@@ -317,21 +556,14 @@ void DownloadManager::add_files_to_queue(const std::vector<std::tuple<std::strin
         return;
     }
 
-    std::cerr << "[DEBUG] add_files_to_queue: Adding " << files.size() << " files to queue for data_set=" << current_config_.id << std::endl;
+    std::cerr << "[DEBUG] add_files_to_queue: Adding " << files.size() << " files to queue for data_set=" << primary_data_set() << std::endl;
 
     std::vector<FileRecord> records;
     records.reserve(files.size());
-    int skipped_duplicates = 0;
 
     for (const auto& [file_id, url, local_path] : files) {
-        // Skip if already exists
-        if (db_->file_exists(file_id, current_config_.id)) {
-            skipped_duplicates++;
-            continue;
-        }
-
         FileRecord record;
-        record.data_set = current_config_.id;
+        record.data_set = primary_data_set();
         record.file_id = file_id;
         record.url = url;
         record.local_path = local_path;
@@ -339,12 +571,24 @@ void DownloadManager::add_files_to_queue(const std::vector<std::tuple<std::strin
         records.push_back(std::move(record));
     }
 
-    std::cerr << "[DEBUG] add_files_to_queue: " << records.size() << " new records, " << skipped_duplicates << " skipped (already in db)" << std::endl;
+    int added = enqueue_files(records);
+    std::cerr << "[DEBUG] add_files_to_queue: " << added << " new records, "
+              << files.size() - records.size() << " skipped (already in db)" << std::endl;
+}
 
-    if (!records.empty()) {
-        db_->add_files_batch(records);
-        std::cerr << "[DEBUG] add_files_to_queue: Added to database" << std::endl;
+int DownloadManager::enqueue_files(std::vector<FileRecord>& records) {
+    known_ids_.insert_new(records);
+    if (records.empty()) return 0;
+
+    // INSERT OR IGNORE: a row another process added since the index was
+    // loaded is left alone, not duplicated
+    if (!db_->add_files_batch(records)) {
+        log("Failed to queue files: " + db_->get_last_error());
+        known_ids_.erase(records);
+        return -1;
     }
+    notify_new_work();
+    return static_cast<int>(records.size());
 }
 
 int DownloadManager::reset_interrupted_downloads(int data_set) {
@@ -369,7 +613,14 @@ bool DownloadManager::has_pending_work(int data_set) {
 
 int DownloadManager::clear_data_set(int data_set) {
     if (!db_) return -1;
-    return db_->clear_data_set(data_set);
+    int deleted = db_->clear_data_set(data_set);
+    if (deleted >= 0) known_ids_.clear(data_set);
+    return deleted;
+}
+
+bool DownloadManager::reconcile_stats(int data_set) {
+    if (!db_) return false;
+    return db_->reconcile_counters(data_set);
 }
 
 void DownloadManager::mark_page_scraped(int data_set, int page_number, int pdf_count) {
@@ -393,103 +644,206 @@ std::vector<int> DownloadManager::get_unscraped_pages(int data_set, int max_page
     return db_->get_unscraped_pages(data_set, max_page + 1);
 }
 
-void DownloadManager::scraper_worker() {
-    log("Scraper worker started");
-
-    // First, detect the actual number of pages by probing
-    int detected_max_page = -1;
-
-    // Binary search to find max page
-    int low = 0;
-    int high = 100000;  // Start with a high upper bound
-
-    // Removed single probe_downloader instance to allow fresh cookies per request if needed
-    // Downloader probe_downloader;
-    // if (!cookie_string_.empty()) {
-    //     probe_downloader.set_cookie(cookie_string_);
-    // } else if (!cookie_file_.empty()) {
-    //     probe_downloader.set_cookie_file(cookie_file_);
-    // }
-
-    while (low <= high && !stop_requested_) {
-        int mid = low + (high - low) / 2;
-        std::string url = scraper_->build_page_url(mid);
-
-        Downloader probe_downloader;
-        // Prefer cookies from jar
-        if (cookie_jar_) {
-            std::string cookies = cookie_jar_->get_cookies_for_url(url);
-            if (!cookies.empty()) {
-                 probe_downloader.set_cookie(cookies);
-            } else if (!cookie_string_.empty()) {
-                 probe_downloader.set_cookie(cookie_string_);
-            } else if (!cookie_file_.empty()) {
-                 probe_downloader.set_cookie_file(cookie_file_);
-            }
-        } else {
-            if (!cookie_string_.empty()) {
-                probe_downloader.set_cookie(cookie_string_);
-            } else if (!cookie_file_.empty()) {
-                probe_downloader.set_cookie_file(cookie_file_);
-            }
+void DownloadManager::keep_page_head(std::string& head, const char* data, size_t size) {
+    if (head.size() < BLOCK_SCAN_BYTES) {
+        head.append(data, std::min(size, BLOCK_SCAN_BYTES - head.size()));
+    }
+}
+
+void DownloadManager::report_scrape_block(int page_number, const std::string& reason) {
+    if (scrape_blocked_.exchange(true)) return;  // Reported once per run
+
+    log("Scraping blocked at page " + std::to_string(page_number) + ": " + reason);
+
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    if (callbacks_.on_scrape_blocked) {
+        callbacks_.on_scrape_blocked(page_number, reason);
+    } else if (callbacks_.on_error) {
+        callbacks_.on_error("Scraping blocked at page " + std::to_string(page_number) + ": " + reason);
+    }
+}
+
+DownloadManager::PageProbe DownloadManager::probe_page(DataSetRun& run, int page_number) {
+    std::string url = run.scraper->build_page_url(page_number);
+
+    DownloaderPool::Lease downloader(*downloader_pool_);
+    configure_cookies(*downloader, url);
+
+    DownloadResult result;
+    size_t links = 0;
+    int retries = 0;
+    const int max_retries = 3;
+
+    while (retries < max_retries && !scrape_blocked_) {
+        LinkScanner scanner(*run.scraper, [](PdfLink&&) {});
+        std::string head;
+        result = downloader->download_page(url, [&scanner, &head](const char* data, size_t size) {
+            scanner.feed(data, size);
+            keep_page_head(head, data, size);
+            return true;
+        });
+        scanner.finish();
+        links = scanner.links_found();
+
+        std::string blocked = links == 0 ? block_reason(result.http_code, head) : "";
+        if (!blocked.empty()) {
+            report_scrape_block(page_number, blocked);
+            break;
+        }
+        if (result.http_code == 200 || result.http_code == 404 || stop_requested_) {
+            break;
         }
 
-        DownloadResult result;
-        int retries = 0;
-        const int max_retries = 3;
+        retries++;
+        if (retries < max_retries) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
 
-        while (retries < max_retries) {
-            result = probe_downloader.download_page(url);
+    if (cookie_jar_ && !result.set_cookie_headers.empty()) {
+        for (const auto& header : result.set_cookie_headers) {
+             cookie_jar_->add_from_header(header, TARGET_DOMAIN);
+        }
+    }
 
-            if (result.http_code == 200 || result.http_code == 404 || stop_requested_) {
-                break;
-            }
+    if (scrape_blocked_) {
+        return PageProbe::ERROR;
+    }
+    if (result.success && result.http_code == 200) {
+        return links > 0 ? PageProbe::LINKS : PageProbe::EMPTY;
+    }
+    return result.http_code == 404 ? PageProbe::EMPTY : PageProbe::ERROR;
+}
 
-            retries++;
-            if (retries < max_retries) {
-                std::this_thread::sleep_for(std::chrono::seconds(1));
-            }
+std::vector<DownloadManager::PageProbe> DownloadManager::probe_pages(DataSetRun& run,
+                                                                      const std::vector<int>& pages) {
+    std::vector<std::future<PageProbe>> futures;
+    futures.reserve(pages.size());
+    for (int page : pages) {
+        futures.push_back(scrape_pool_->submit([this, &run, page] { return probe_page(run, page); }));
+    }
+
+    std::vector<PageProbe> results;
+    results.reserve(pages.size());
+    for (auto& f : futures) {
+        try {
+            results.push_back(f.get());
+        } catch (const std::exception& e) {
+            log("Page probe error: " + std::string(e.what()));
+            results.push_back(PageProbe::ERROR);
         }
+    }
+    return results;
+}
 
-        if (cookie_jar_ && !result.set_cookie_headers.empty()) {
-            for (const auto& header : result.set_cookie_headers) {
-                 cookie_jar_->add_from_header(header, TARGET_DOMAIN);
+int DownloadManager::search_max_page(DataSetRun& run, int with_links, int without_links) {
+    const int width = std::max(1, max_concurrent_scrapes_);
+    int low = with_links;
+    int high = without_links < 0 ? MAX_INDEX_PAGES + 1 : without_links;
+    bool bounded = without_links >= 0;
+
+    // Each round probes a whole scrape pool's worth of pages at once: while
+    // unbounded it gallops (low+1, low+2, low+4, ...), then it splits the gap
+    // into width+1 parts, so Data Set 9's ~9300 pages take about 4 rounds
+    while (!stop_requested_ && high - low > 1) {
+        std::vector<int> pages;
+        if (!bounded) {
+            for (int64_t step = 1; static_cast<int>(pages.size()) < width && low + step < high; step *= 2) {
+                pages.push_back(static_cast<int>(low + step));
+            }
+        } else {
+            int64_t span = high - low;
+            int count = static_cast<int>(std::min<int64_t>(width, span - 1));
+            for (int i = 1; i <= count; ++i) {
+                pages.push_back(static_cast<int>(low + span * i / (count + 1)));
             }
         }
 
-        if (result.http_code == 200 && !result.data.empty()) {
-            // Check if it's a valid page with content
-            std::string content(result.data.begin(), result.data.end());
-            if (content.find("EFTA") != std::string::npos ||
-                content.find(".pdf") != std::string::npos) {
-                detected_max_page = mid;
-                low = mid + 1;
-            } else {
-                high = mid - 1;
+        auto results = probe_pages(run, pages);
+
+        // Errors count as "no links", as a single failed probe always did
+        int new_low = low;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            if (results[i] == PageProbe::LINKS) new_low = std::max(new_low, pages[i]);
+        }
+        int new_high = high;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            if (results[i] != PageProbe::LINKS && pages[i] > new_low) {
+                new_high = std::min(new_high, pages[i]);
+                bounded = true;
             }
-        } else if (result.http_code == 404) {
-            high = mid - 1;
-        } else {
-            // Error, try again or skip
-            high = mid - 1;
         }
+        low = new_low;
+        high = new_high;
+    }
+    return low;
+}
+
+int DownloadManager::detect_max_page(DataSetRun& run) {
+    // A count from an earlier run only needs its last page and the one after it
+    int known = db_->get_max_page(run.job.config.id);
+    if (known >= 0) {
+        auto results = probe_pages(run, {known, known + 1});
+        if (results[0] == PageProbe::LINKS && results[1] == PageProbe::EMPTY) {
+            return known;
+        }
+        if (results[0] == PageProbe::ERROR || results[1] == PageProbe::ERROR) {
+            log("Could not revalidate page count, keeping " + std::to_string(known + 1) + " pages");
+            return known;
+        }
+        if (results[0] == PageProbe::LINKS) {
+            log("Data set grew past " + std::to_string(known + 1) + " pages");
+            return search_max_page(run, known + 1, -1);
+        }
+        log("Data set shrank below " + std::to_string(known + 1) + " pages");
+        return search_max_page(run, -1, known);
     }
+    return search_max_page(run, -1, -1);
+}
+
+void DownloadManager::scraper_worker(DataSetRun& run) {
+    const DataSetConfig& config = run.job.config;
+    log("Scraper worker started for " + config.name);
 
-    if (detected_max_page < 0) {
-        log("Failed to detect page count, using config default");
-        detected_max_page = current_config_.max_page_index;
+    int first_page = 0;
+    int last_page = run.job.last_page;
+    if (last_page >= 0) {
+        // A fixed range, such as a shard lease: no page count detection
+        first_page = std::clamp(run.job.first_page, 0, last_page);
     } else {
-        log("Detected " + std::to_string(detected_max_page + 1) + " pages");
+        auto detect_start = std::chrono::steady_clock::now();
+        last_page = detect_max_page(run);
+        auto detect_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - detect_start).count();
+
+        if (scrape_blocked_) {
+            log("Scraper worker stopped: blocked during page count detection");
+            return;
+        }
+        if (last_page < 0) {
+            log("Failed to detect page count, using config default");
+            last_page = config.max_page_index;
+        } else {
+            log("Detected " + std::to_string(last_page + 1) + " pages in " +
+                std::to_string(detect_ms) + " ms");
+            if (!stop_requested_) {
+                db_->set_max_page(config.id, last_page);
+            }
+        }
     }
 
     // Add all pages to database
-    db_->add_pages_batch(current_config_.id, 0, detected_max_page);
+    db_->add_pages_batch(config.id, first_page, last_page);
 
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.total_pages = detected_max_page + 1;
+    if (run.job.mode == OperationMode::REFRESH) {
+        int reset = db_->reset_scraped_pages(config.id);
+        if (reset > 0) {
+            log("Revalidating " + std::to_string(reset) + " scraped pages");
+        }
     }
 
+    run.total_pages = last_page - first_page + 1;
+
     // Scrape pages
     while (!stop_requested_) {
         // Check for pause
@@ -498,21 +852,24 @@ void DownloadManager::scraper_worker() {
             pause_cv_.wait(lock, [this] { return !paused_ || stop_requested_; });
         }
 
-        if (stop_requested_) break;
+        if (stop_requested_ || scrape_blocked_) break;
 
         // Get batch of unscraped pages
-        auto pages = db_->get_unscraped_pages(current_config_.id, max_concurrent_scrapes_);
+        auto pages = db_->get_unscraped_pages(config.id, max_concurrent_scrapes_, first_page, last_page);
 
         if (pages.empty()) {
-            log("All pages scraped");
+            log("All pages of " + config.name + " scraped");
+            if (run.pages_unchanged > 0) {
+                log(std::to_string(run.pages_unchanged.load()) + " pages unchanged since the last scrape");
+            }
             break;
         }
 
-        // Submit scraping tasks
+        // Submit scraping tasks; other data sets' batches interleave on the pool
         std::vector<std::future<void>> futures;
         for (int page : pages) {
-            futures.push_back(scrape_pool_->submit([this, page] {
-                scrape_page(page);
+            futures.push_back(scrape_pool_->submit([this, &run, page] {
+                scrape_page(run, page);
             }));
         }
 
@@ -529,29 +886,52 @@ void DownloadManager::scraper_worker() {
     log("Scraper worker finished");
 }
 
-void DownloadManager::brute_force_worker() {
-    log("Brute force worker started");
+void DownloadManager::brute_force_worker(DataSetRun& run) {
+    log("Brute force worker started for " + run.job.config.name);
 
-    // Resume from last position
-    uint64_t start_id = db_->get_brute_force_progress(current_config_.id);
-    if (start_id == 0 || start_id < current_config_.first_file_id) {
-        start_id = current_config_.first_file_id;
+    const int data_set = run.job.config.id;
+    const uint64_t first = run.job.config.first_file_id;
+    const uint64_t last = run.job.config.last_file_id;
+    if (first == 0 || last < first) {
+        log("No brute force range for " + run.job.config.name);
+        return;
     }
 
-    brute_force_current_ = start_id;
-
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.brute_force_current = start_id;
+    // Resume from the stored bitmap, carried over if the range was changed
+    IdBitmap bitmap;
+    if (db_->load_id_bitmap(data_set, bitmap)) {
+        if (bitmap.first() != first || bitmap.last() != last) {
+            bitmap = bitmap.rebased(first, last);
+        }
+    } else {
+        bitmap = IdBitmap(first, last);
     }
 
-    log("Brute force starting from " + scraper_->format_file_id(start_id));
+    // IDs that already have a row (scraped, or queued by a run from before
+    // the bitmap) need no probe
+    db_->for_each_file_status(data_set, [&](const std::string& file_id, DownloadStatus status) {
+        uint64_t id = run.scraper->parse_file_id_number(file_id);
+        bitmap.set(id, status == DownloadStatus::NOT_FOUND ? IdState::MISSING : IdState::PRESENT);
+    });
+
+    ProbePlanner planner(bitmap, std::max(1, max_concurrent_scrapes_), max_retry_attempts_);
 
-    const size_t batch_size = 1000;  // Process in batches
-    std::vector<FileRecord> batch;
-    batch.reserve(batch_size);
+    auto publish = [&](uint64_t current) {
+        run.brute_force_current = current;
+        run.brute_force_probed = bitmap.size() - bitmap.count(IdState::UNKNOWN);
+        run.brute_force_found = bitmap.count(IdState::PRESENT);
+        run.brute_force_pass = planner.pass();
+        brute_force_current_ = current;
+    };
+    publish(first);
 
-    for (uint64_t id = start_id; id <= current_config_.last_file_id && !stop_requested_; ++id) {
+    log("Brute force: " + std::to_string(run.brute_force_probed.load()) + " of " +
+        std::to_string(bitmap.size()) + " IDs already known");
+
+    int since_checkpoint = 0;
+    int failed_rounds = 0;
+
+    while (!stop_requested_) {
         // Check for pause
         {
             std::unique_lock<std::mutex> lock(pause_mutex_);
@@ -560,47 +940,190 @@ void DownloadManager::brute_force_worker() {
 
         if (stop_requested_) break;
 
-        std::string file_id = scraper_->format_file_id(id);
+        std::vector<uint64_t> ids = planner.next_batch();
+        if (ids.empty()) break;
 
-        // Skip if already in database
-        if (!db_->file_exists(file_id, current_config_.id)) {
-            FileRecord record;
-            record.data_set = current_config_.id;
-            record.file_id = file_id;
-            record.url = scraper_->build_file_url(file_id);
-            record.local_path = get_local_path(file_id);
-            record.status = DownloadStatus::PENDING;
+        std::vector<std::future<int>> futures;
+        futures.reserve(ids.size());
+        for (uint64_t id : ids) {
+            futures.push_back(scrape_pool_->submit([this, &run, id] { return probe_file_id(run, id); }));
+        }
 
-            batch.push_back(std::move(record));
+        std::vector<FileRecord> found;
+        size_t failures = 0;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            int code = 0;
+            try {
+                code = futures[i].get();
+            } catch (const std::exception& e) {
+                log("Probe error: " + std::string(e.what()));
+            }
+
+            // 403/429, 5xx and network errors leave the ID for a later pass
+            IdState state = code == 200 ? IdState::PRESENT
+                          : (code == 404 || code == 410) ? IdState::MISSING
+                          : IdState::UNKNOWN;
+            bitmap.set(ids[i], state);
+            planner.report(ids[i], state);
+
+            if (state == IdState::PRESENT) {
+                FileRecord record;
+                record.data_set = data_set;
+                record.file_id = run.scraper->format_file_id(ids[i]);
+                record.url = run.scraper->build_file_url(record.file_id);
+                record.local_path = get_local_path(data_set, record.file_id);
+                record.status = DownloadStatus::PENDING;
+                found.push_back(std::move(record));
+            } else if (state == IdState::UNKNOWN) {
+                failures++;
+            }
         }
 
-        brute_force_current_ = id;
+        if (!found.empty()) {
+            enqueue_files(found);
+        }
 
-        // Commit batch
-        if (batch.size() >= batch_size) {
-            db_->add_files_batch(batch);
-            db_->set_brute_force_progress(current_config_.id, id);
-            batch.clear();
+        since_checkpoint += static_cast<int>(ids.size());
+        if (since_checkpoint >= BRUTE_FORCE_CHECKPOINT_PROBES) {
+            db_->save_id_bitmap(data_set, bitmap);
+            since_checkpoint = 0;
+        }
+        publish(ids.back());
 
-            {
-                std::lock_guard<std::mutex> lock(stats_mutex_);
-                stats_.brute_force_current = id;
-            }
+        // A round where every probe failed is usually the anti-bot layer; back off
+        if (failures == ids.size()) {
+            int64_t wait = RetryScheduler::backoff_seconds(failed_rounds++);
+            log("Every probe failed, waiting " + std::to_string(wait) + " s");
+            std::unique_lock<std::mutex> lock(pause_mutex_);
+            pause_cv_.wait_for(lock, std::chrono::seconds(wait), [this] { return stop_requested_.load(); });
+        } else {
+            failed_rounds = 0;
         }
     }
 
-    // Commit remaining
-    if (!batch.empty()) {
-        db_->add_files_batch(batch);
-        db_->set_brute_force_progress(current_config_.id, brute_force_current_.load());
+    db_->save_id_bitmap(data_set, bitmap);
+    publish(run.brute_force_current.load());
+    log("Brute force worker finished: " + std::to_string(run.brute_force_found.load()) + " found, " +
+        std::to_string(bitmap.count(IdState::UNKNOWN)) + " IDs still unknown");
+}
+
+int DownloadManager::probe_file_id(DataSetRun& run, uint64_t id) {
+    std::string url = run.scraper->build_file_url(run.scraper->format_file_id(id));
+
+    DownloaderPool::Lease downloader(*downloader_pool_);
+    configure_cookies(*downloader, url);
+    return downloader->probe_url(url);
+}
+
+void DownloadManager::start_work_queue() {
+    // Failures from earlier runs keep their deadlines
+    retry_scheduler_.clear();
+    for (const auto& run : runs_) {
+        retry_scheduler_.schedule(db_->get_retry_deadlines(run->job.config.id, max_retry_attempts_));
     }
 
-    log("Brute force worker finished");
+    size_t batch = static_cast<size_t>(std::max(1, max_concurrent_downloads_.load()));
+    work_queue_ = std::make_unique<WorkQueue>(
+        [this](size_t want) { return refill_work(want); }, batch, batch / 2);
+    work_queue_->start();
+    arm_retry_wakeup();
+}
+
+void DownloadManager::stop_work_queue() {
+    if (!work_queue_) return;
+
+    auto unclaimed = work_queue_->stop();
+    if (!unclaimed.empty() && db_) {
+        std::vector<int64_t> ids;
+        ids.reserve(unclaimed.size());
+        for (const auto& file : unclaimed) {
+            ids.push_back(file.id);
+        }
+        db_->release_files(ids);
+    }
+}
+
+void DownloadManager::notify_new_work() {
+    if (work_queue_) {
+        work_queue_->notify();
+    }
+}
+
+std::vector<FileRecord> DownloadManager::refill_work(size_t want) {
+    // Retries whose deadline has passed go first, so they run alongside new work
+    int64_t now = unix_now();
+    auto due = retry_scheduler_.take_due(now, want);
+    std::vector<FileRecord> files;
+    if (!due.empty()) {
+        // The failure that scheduled a retry may still be on the journal
+        status_journal_->flush();
+        files = db_->claim_retry_files(due, now, lease_owner_);
+        arm_retry_wakeup();
+    }
+
+    // Lease pending rows, one statement per data set; they come back already
+    // IN_PROGRESS. With several data sets each gets slots by weight, and what
+    // a set has no rows for goes to the others.
+    if (files.size() < want) {
+        scheduler_.distribute(want - files.size(), [&](int data_set, size_t count) {
+            auto pending = db_->claim_pending_files(data_set, static_cast<int>(count), lease_owner_);
+            files.insert(files.end(), std::make_move_iterator(pending.begin()),
+                         std::make_move_iterator(pending.end()));
+            return pending.size();
+        });
+    }
+    return files;
+}
+
+void DownloadManager::arm_retry_wakeup() {
+    auto next = retry_scheduler_.next_due();
+    if (!next || !work_queue_) return;
+
+    int64_t wait = std::max<int64_t>(0, *next - unix_now());
+    work_queue_->notify_at(std::chrono::steady_clock::now() + std::chrono::seconds(wait));
+}
+
+void DownloadManager::record_status(int64_t id, DownloadStatus status, const std::string& error_msg,
+                                    int64_t file_size, bool increment_retry, int64_t next_attempt_at,
+                                    const std::string& sha256, int is_pdf) {
+    StatusUpdate update{id, status, error_msg, file_size, increment_retry, next_attempt_at,
+                        sha256, is_pdf};
+    if (status_journal_) {
+        status_journal_->push(std::move(update));
+        return;
+    }
+    db_->apply_status_updates({update});
+}
+
+void DownloadManager::record_failure(const FileRecord& file, const std::string& error_msg) {
+    // Every failure counts as an attempt; the last one leaves no deadline
+    int attempts = file.retry_count + 1;
+    int64_t due = 0;
+    if (attempts < max_retry_attempts_) {
+        due = unix_now() + RetryScheduler::backoff_seconds(attempts);
+    }
+
+    record_status(file.id, DownloadStatus::FAILED, error_msg, 0, true, due);
+
+    if (due > 0) {
+        retry_scheduler_.schedule(file.id, due);
+        arm_retry_wakeup();
+    }
+}
+
+void DownloadManager::release_slot() {
+    {
+        std::lock_guard<std::mutex> lock(slot_mutex_);
+        active_downloads_--;
+    }
+    slot_cv_.notify_one();
 }
 
 void DownloadManager::download_worker() {
     std::cerr << "[DEBUG] download_worker: Started" << std::endl;
 
+    int batch_limit = concurrency_limit();
+
     while (!stop_requested_) {
         // Check for pause
         {
@@ -610,73 +1133,71 @@ void DownloadManager::download_worker() {
 
         if (stop_requested_) break;
 
-        int max_downloads = max_concurrent_downloads_.load();
-
-        // Check if we have capacity
-        while (active_downloads_.load() >= max_downloads && !stop_requested_) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            max_downloads = max_concurrent_downloads_.load();  // Re-check in case it changed
+        // Wait for a free slot; finished downloads wake us through release_slot()
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+            slot_cv_.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                return stop_requested_ ||
+                       active_downloads_.load() < concurrency_limit();
+            });
         }
 
         if (stop_requested_) break;
 
-        // Get pending files
-        int want = max_downloads - active_downloads_.load();
-        auto files = db_->get_pending_files(want);
-        std::cerr << "[DEBUG] download_worker: Requested " << want << " pending files, got " << files.size() << std::endl;
+        int max_downloads = concurrency_limit();
+        if (active_downloads_.load() >= max_downloads) continue;
 
-        if (files.empty()) {
-            // Check for failed files to retry with S-curve backoff
-            auto failed = db_->get_failed_files(max_retry_attempts_, 100);
-            auto now = std::chrono::system_clock::now();
-
-            for (const auto& f : failed) {
-                int64_t wait_sec = calculate_s_curve_backoff(f.retry_count);
-                auto ready_time = f.updated_at + std::chrono::seconds(wait_sec);
-
-                if (now >= ready_time) {
-                    files.push_back(f);
-                    if (static_cast<int>(files.size()) >= want) break;
-                }
-            }
+        // Keep the claim window in step with the concurrency limit
+        if (max_downloads != batch_limit) {
+            batch_limit = max_downloads;
+            work_queue_->set_batch_size(static_cast<size_t>(std::max(1, batch_limit)),
+                                        static_cast<size_t>(std::max(1, batch_limit)) / 2);
         }
 
-        if (files.empty()) {
+        auto file = work_queue_->pop(std::chrono::milliseconds(200));
+
+        if (!file) {
             // No work to do, check if we should wait or exit
             int64_t active = active_downloads_.load();
 
-            // If downloads are still in progress, wait for them
-            if (active > 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // If downloads are still in progress, or a refill may still bring work, wait
+            if (active > 0 || !work_queue_->drained()) {
                 continue;
             }
 
             // If external scraping is active, wait for more files
             if (external_scraping_active_.load()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
                 continue;
             }
 
-            // Check if scraper/brute force workers are still running
-            bool scraper_done = !scraper_thread_.joinable() ||
-                               current_mode_ == OperationMode::BRUTE_FORCE;
-            bool bf_done = !brute_force_thread_.joinable() ||
-                          current_mode_ == OperationMode::SCRAPER;
+            // Check if any data set's scraper/brute force worker is still running
+            if (active_producers_.load() > 0) {
+                // Workers still running; they notify the queue when they add files
+                continue;
+            }
 
-            if (!scraper_done || !bf_done) {
-                // Workers still running, wait for them to add more files
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            // Failed files with attempts left; the queue refills when each is due
+            if (!retry_scheduler_.empty()) {
                 continue;
             }
 
-            // Double-check: query database one more time before exiting
-            auto db_stats = db_->get_stats(current_config_.id);
+            // Double-check: query database one more time before exiting,
+            // after making sure every journaled status has reached it
+            status_journal_->flush();
+            DownloadStats db_stats{};
+            for (const auto& run : runs_) {
+                auto set_stats = db_->get_stats(run->job.config.id);
+                db_stats.files_pending += set_stats.files_pending;
+                db_stats.files_in_progress += set_stats.files_in_progress;
+                db_stats.files_completed += set_stats.files_completed;
+                db_stats.files_failed += set_stats.files_failed;
+            }
             std::cerr << "[DEBUG] download_worker exit check: pending=" << db_stats.files_pending
                       << " in_progress=" << db_stats.files_in_progress
                       << " completed=" << db_stats.files_completed
                       << " failed=" << db_stats.files_failed << std::endl;
             if (db_stats.files_pending > 0 || db_stats.files_in_progress > 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                notify_new_work();
                 continue;
             }
 
@@ -684,25 +1205,21 @@ void DownloadManager::download_worker() {
             break;
         }
 
-        // Submit download tasks
-        for (const auto& file : files) {
-            if (stop_requested_) break;
-
-            // Mark as in progress
-            db_->update_file_status(file.id, DownloadStatus::IN_PROGRESS);
-            active_downloads_++;
-
-            download_pool_->submit_detached([this, file]() {
-                download_file(file);
-                active_downloads_--;
-            });
+        if (stop_requested_) {
+            db_->release_files({file->id});
+            break;
         }
+
+        active_downloads_++;
+        submit_download(*file);
     }
 
     log("Download worker finished");
 
     // Signal completion if we exited normally (not stopped)
     if (!stop_requested_) {
+        stop_work_queue();
+        update_stats();
         running_ = false;
         std::lock_guard<std::mutex> lock(callback_mutex_);
         if (callbacks_.on_complete) {
@@ -712,39 +1229,69 @@ void DownloadManager::download_worker() {
 }
 
 void DownloadManager::stats_worker() {
+    auto window_start = std::chrono::steady_clock::now();
+
     while (!stop_requested_) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
 
         if (stop_requested_) break;
 
+        auto now = std::chrono::steady_clock::now();
+        if (now - window_start >= std::chrono::milliseconds(ADAPTIVE_WINDOW_MS)) {
+            adjust_concurrency(std::chrono::duration<double>(now - window_start).count());
+            window_start = now;
+        }
+
         update_stats();
     }
 }
 
-void DownloadManager::scrape_page(int page_number) {
-    Downloader downloader;
-    std::string url = scraper_->build_page_url(page_number);
+void DownloadManager::scrape_page(DataSetRun& run, int page_number) {
+    const int data_set = run.job.config.id;
+    DownloaderPool::Lease downloader(*downloader_pool_);
+    std::string url = run.scraper->build_page_url(page_number);
+
+    configure_cookies(*downloader, url);
+
+    // A page scraped before carries its validators and links hash: the request
+    // is conditional, and its links are only queued once they are known to differ
+    auto previous = db_->get_page(data_set, page_number);
+    PageValidators validators;
+    uint64_t previous_hash = 0;
+    if (previous) {
+        validators.etag = previous->etag;
+        validators.last_modified = previous->last_modified;
+        previous_hash = previous->content_hash;
+    }
 
-    // Prefer cookies from jar (which includes initial string + updates),
-    // fallback to static string only if jar is empty/failed
-    if (cookie_jar_) {
-        std::string cookies = cookie_jar_->get_cookies_for_url(url);
-        if (!cookies.empty()) {
-             downloader.set_cookie(cookies);
-        } else if (!cookie_string_.empty()) {
-             downloader.set_cookie(cookie_string_);
-        } else if (!cookie_file_.empty()) {
-             downloader.set_cookie_file(cookie_file_);
-        }
-    } else {
-        if (!cookie_string_.empty()) {
-            downloader.set_cookie(cookie_string_);
-        } else if (!cookie_file_.empty()) {
-            downloader.set_cookie_file(cookie_file_);
+    // Links are scanned out of the body as it arrives and queued in batches,
+    // so downloads can start before the page has finished loading
+    std::vector<FileRecord> records;
+    auto queue_records = [&]() {
+        if (records.empty()) return;
+        enqueue_files(records);
+        records.clear();
+    };
+
+    LinkScanner scanner(*run.scraper, [&](PdfLink&& pdf) {
+        FileRecord record;
+        record.data_set = data_set;
+        record.file_id = std::move(pdf.file_id);
+        record.url = std::move(pdf.url);
+        record.local_path = get_local_path(data_set, record.file_id);
+        record.status = DownloadStatus::PENDING;
+        records.push_back(std::move(record));
+        if (records.size() >= SCRAPE_LINK_BATCH && previous_hash == 0) {
+            queue_records();
         }
-    }
+    });
 
-    auto result = downloader.download_page(url);
+    std::string head;
+    auto result = downloader->download_page(url, [&scanner, &head](const char* data, size_t size) {
+        scanner.feed(data, size);
+        keep_page_head(head, data, size);
+        return true;
+    }, validators);
 
     if (cookie_jar_ && !result.set_cookie_headers.empty()) {
         for (const auto& header : result.set_cookie_headers) {
@@ -753,86 +1300,233 @@ void DownloadManager::scrape_page(int page_number) {
         }
     }
 
+    std::string blocked = scanner.links_found() == 0 ? block_reason(result.http_code, head) : "";
+    if (!blocked.empty()) {
+        // Left unscraped for whoever takes over (see on_scrape_blocked)
+        report_scrape_block(page_number, blocked);
+        return;
+    }
+
     if (!result.success) {
+        // Links seen before the failure are real; the page itself is retried later
+        queue_records();
         log("Failed to scrape page " + std::to_string(page_number) + ": " + result.error_message);
         return;
     }
 
-    std::string html(result.data.begin(), result.data.end());
-    auto pdf_links = scraper_->extract_pdf_links(html);
-
-    // Add PDFs to database
-    std::vector<FileRecord> records;
-    for (const auto& pdf : pdf_links) {
-        FileRecord record;
-        record.data_set = current_config_.id;
-        record.file_id = pdf.file_id;
-        record.url = pdf.url;
-        record.local_path = get_local_path(pdf.file_id);
-        record.status = DownloadStatus::PENDING;
-        records.push_back(std::move(record));
+    int links_found;
+    if (result.not_modified) {
+        // A 304 may refresh the validators; keep whichever the server did not resend
+        links_found = previous->pdf_count;
+        db_->mark_page_scraped(data_set, page_number, links_found,
+                               result.etag.empty() ? previous->etag : result.etag,
+                               result.last_modified.empty() ? previous->last_modified : result.last_modified,
+                               previous_hash);
+        run.pages_unchanged++;
+    } else {
+        scanner.finish();
+        links_found = static_cast<int>(scanner.links_found());
+        if (previous_hash != 0 && scanner.links_hash() == previous_hash) {
+            // Same links as last time: every one of them is already in the files table
+            records.clear();
+            run.pages_unchanged++;
+        }
+        queue_records();
+        db_->mark_page_scraped(data_set, page_number, links_found,
+                               result.etag, result.last_modified, scanner.links_hash());
     }
 
-    db_->add_files_batch(records);
-    db_->mark_page_scraped(current_config_.id, page_number, static_cast<int>(pdf_links.size()));
-
     {
         std::lock_guard<std::mutex> lock(stats_mutex_);
         stats_.pages_scraped++;
-        stats_.total_files_found += pdf_links.size();
+        stats_.total_files_found += links_found;
+        run.stats.pages_scraped++;
+        run.stats.total_files_found += links_found;
+    }
+
+    notify_page_scraped(page_number, links_found);
+}
+
+void DownloadManager::submit_download(const FileRecord& file) {
+    if (multi_downloader_) {
+        bool needed = false;
+        try {
+            needed = prepare_download(file);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] prepare_download exception for " << file.file_id << ": " << e.what() << std::endl;
+            record_failure(file, std::string("Exception: ") + e.what());
+        }
+        if (!needed) {
+            release_slot();
+            return;
+        }
+
+        MultiTransferRequest request;
+        request.url = file.url;
+        request.filepath = file.local_path;
+        request.cookie = cookie_header_for(file.url);
+        request.cookie_file = cookie_file_;
+        // Runs on a loop thread; the PDF check, dedup lookup and pack hand-off
+        // would hold up every other transfer on that loop, so they run elsewhere
+        request.on_complete = [this, file](const DownloadResult& result) {
+            bool posted = completion_pool_->try_submit_detached([this, file, result]() {
+                handle_download_result(file, result);
+                release_slot();
+            });
+            if (!posted) {
+                // Shutting down: record it here rather than lose it
+                handle_download_result(file, result);
+                release_slot();
+            }
+        };
+        if (!multi_downloader_->submit(std::move(request))) {
+            release_slot();
+        }
+        return;
     }
 
+    download_pool_->submit_detached([this, file]() {
+        download_file(file);
+        release_slot();
+    });
+}
+
+bool DownloadManager::prepare_download(const FileRecord& file) {
+    // Check if file already exists locally and has content. After a start-up
+    // scan, or when trusting the database, a row still to do has no file.
+    if (!overwrite_existing_ && disk_check_ == DiskCheck::STAT &&
+        fs::exists(file.local_path) && fs::file_size(file.local_path) > 0) {
+        record_status(file.id, DownloadStatus::SKIPPED);
+        return false;
+    }
+
+    // Create directory structure, once per shard directory
+    fs::path filepath(file.local_path);
+    if (!directories_.ensure(filepath.parent_path().string())) {
+        record_failure(file, "Failed to create directory " + filepath.parent_path().string());
+        return false;
+    }
+
+    // Track when this download starts for active transfer time
+    auto download_start = std::chrono::steady_clock::now();
     {
-        std::lock_guard<std::mutex> lock(callback_mutex_);
-        if (callbacks_.on_page_scraped) {
-            callbacks_.on_page_scraped(page_number, static_cast<int>(pdf_links.size()));
+        std::lock_guard<std::mutex> lock(transfer_time_mutex_);
+        if (!any_download_active_.load()) {
+            first_active_time_ = download_start;
+            any_download_active_.store(true);
         }
     }
+    return true;
+}
+
+void DownloadManager::start_pack_store(DataSetRun& run) {
+    run.pack_store.reset();
+    if (storage_ != StorageMode::PACK) return;
+
+    run.pack_store = std::make_unique<PackStore>(*db_, run.job.config.id, download_dir_, pack_bytes_);
+    if (!run.pack_store->start()) {
+        // Downloads still land as loose files, which a later run can pack
+        log("Failed to open pack files for " + run.job.config.name + ", keeping downloads as files");
+        run.pack_store.reset();
+    }
+}
+
+void DownloadManager::reconcile_download_dir(DataSetRun& run) {
+    const int data_set = run.job.config.id;
+    fs::path root = fs::path(download_dir_) / ("DataSet" + std::to_string(data_set));
+    auto found = scan_download_tree(root.string(), DISK_SCAN_THREADS);
+
+    std::vector<FileRecord> records;
+    records.reserve(found.size());
+    for (auto& local : found) {
+        // Only files where get_local_path() puts them; downloads never look anywhere else
+        if (run.scraper->extract_file_id(local.file_id) != local.file_id ||
+            get_local_path(data_set, local.file_id) != local.path) {
+            continue;
+        }
+        FileRecord record;
+        record.data_set = data_set;
+        record.file_id = std::move(local.file_id);
+        record.url = run.scraper->build_file_url(record.file_id);
+        record.local_path = std::move(local.path);
+        record.status = DownloadStatus::COMPLETED;
+        record.file_size = local.size;
+        records.push_back(std::move(record));
+    }
+
+    int reconciled = db_->reconcile_local_files(records);
+    if (reconciled < 0) {
+        log("Failed to reconcile files on disk: " + db_->get_last_error());
+        reconciled = 0;
+    } else {
+        for (const auto& record : records) {
+            known_ids_.insert(record.data_set, record.file_id);
+        }
+    }
+    log("Found " + std::to_string(records.size()) + " files on disk, " +
+        std::to_string(reconciled) + " new to the database");
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    run.stats.files_on_disk = static_cast<int64_t>(records.size());
+    run.stats.files_reconciled = reconciled;
+    stats_.files_on_disk += run.stats.files_on_disk;
+    stats_.files_reconciled += reconciled;
+}
+
+std::string DownloadManager::cookie_header_for(const std::string& url) const {
+    // Prefer cookies from jar (which includes initial string + updates),
+    // fallback to static string only if jar is empty/failed
+    if (cookie_jar_) {
+        std::string cookies = cookie_jar_->get_cookies_for_url(url);
+        if (!cookies.empty()) {
+            return cookies;
+        }
+    }
+    return cookie_string_;
+}
+
+void DownloadManager::configure_cookies(Downloader& downloader, const std::string& url) const {
+    std::string cookies = cookie_header_for(url);
+    if (!cookies.empty()) {
+        downloader.set_cookie(cookies);
+    } else if (!cookie_file_.empty()) {
+        downloader.set_cookie_file(cookie_file_);
+    }
 }
 
 void DownloadManager::download_file(const FileRecord& file) {
     try {
-        // Check if file already exists locally and has content
-        if (!overwrite_existing_ && fs::exists(file.local_path) && fs::file_size(file.local_path) > 0) {
-            db_->update_file_status(file.id, DownloadStatus::SKIPPED);
+        if (!prepare_download(file)) {
             return;
         }
 
-        // Create directory structure
-        fs::path filepath(file.local_path);
-        fs::create_directories(filepath.parent_path());
+        DownloaderPool::Lease downloader(*downloader_pool_);
+        configure_cookies(*downloader, file.url);
+        downloader->set_segmentation(segments_per_file_, segment_threshold_, downloader_pool_.get());
+        downloader->set_write_mode(write_mode_);
 
-        // Track when this download starts for active transfer time
-        auto download_start = std::chrono::steady_clock::now();
-        {
-            std::lock_guard<std::mutex> lock(transfer_time_mutex_);
-            if (!any_download_active_.load()) {
-                first_active_time_ = download_start;
-                any_download_active_.store(true);
-            }
+        auto result = downloader->download_to_file(file.url, file.local_path);
+        handle_download_result(file, result);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] download_file exception for " << file.file_id << ": " << e.what() << std::endl;
+        try {
+            record_failure(file, std::string("Exception: ") + e.what());
+        } catch (...) {
+            // Ignore nested exceptions
         }
-
-        Downloader downloader;
-        // Prefer cookies from jar
-        if (cookie_jar_) {
-            std::string cookies = cookie_jar_->get_cookies_for_url(file.url);
-            if (!cookies.empty()) {
-                 downloader.set_cookie(cookies);
-            } else if (!cookie_string_.empty()) {
-                 downloader.set_cookie(cookie_string_);
-            } else if (!cookie_file_.empty()) {
-                 downloader.set_cookie_file(cookie_file_);
-            }
-        } else {
-            if (!cookie_string_.empty()) {
-                downloader.set_cookie(cookie_string_);
-            } else if (!cookie_file_.empty()) {
-                downloader.set_cookie_file(cookie_file_);
-            }
+    } catch (...) {
+        std::cerr << "[ERROR] download_file unknown exception for " << file.file_id << std::endl;
+        try {
+            record_failure(file, "Unknown exception");
+        } catch (...) {
+            // Ignore nested exceptions
         }
+    }
+}
 
-        auto result = downloader.download_to_file(file.url, file.local_path);
-
+void DownloadManager::handle_download_result(const FileRecord& file, const DownloadResult& result) {
+    DataSetRun* run = find_run(file.data_set);
+    try {
         if (cookie_jar_ && !result.set_cookie_headers.empty()) {
             for (const auto& header : result.set_cookie_headers) {
                  cookie_jar_->add_from_header(header, TARGET_DOMAIN);
@@ -849,84 +1543,124 @@ void DownloadManager::download_file(const FileRecord& file) {
                 last_active_time_ - first_active_time_).count();
         }
 
+        // Partial data lives in <local_path>.part, which the Downloader keeps or
+        // removes depending on whether the transfer can be resumed
+        if (result.resumed_bytes > 0) {
+            bytes_resumed_ += result.resumed_bytes;
+        }
+
+        int64_t file_size = result.resumed_bytes + result.content_length;
+        transfer_metrics_.record(result);
+
+        if (concurrency_) {
+            bool blocked = result.http_code == 403 || result.http_code == 429;
+            bool answered = result.success || result.http_code == 404;
+            concurrency_->record(blocked ? TransferOutcome::BLOCKED
+                                         : answered ? TransferOutcome::OK : TransferOutcome::FAILED,
+                                 result.content_length, result.download_time_ms);
+        }
+
         if (result.http_code == 404) {
-            // Delete empty file if created
-            if (fs::exists(file.local_path)) {
-                fs::remove(file.local_path);
-            }
-            db_->update_file_status(file.id, DownloadStatus::NOT_FOUND, "404 Not Found");
+            record_status(file.id, DownloadStatus::NOT_FOUND, "404 Not Found");
         } else if (result.http_code == 403 || result.http_code == 429) {
             // Forbidden or rate limited - anti-bot triggered
-            if (fs::exists(file.local_path)) {
-                fs::remove(file.local_path);
-            }
-            db_->increment_retry_count(file.id);
-            db_->update_file_status(file.id, DownloadStatus::FAILED,
-                "Blocked: HTTP " + std::to_string(result.http_code));
-
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            if (callbacks_.on_file_status_change) {
-                callbacks_.on_file_status_change(file.file_id, DownloadStatus::FAILED);
-            }
-        } else if (result.success && result.content_length > 0) {
-            // Success - file downloaded (content type not validated per user request)
+            record_failure(file, "Blocked: HTTP " + std::to_string(result.http_code));
+
+            notify_file_status(file.file_id, DownloadStatus::FAILED);
+        } else if (result.success && file_size > 0 && require_pdf_ &&
+                   !result.sha256.empty() && !result.pdf_signature) {
+            // A block or error page served with a 200; the content type is not
+            // trusted, only the body's own header
+            std::error_code ec;
+            fs::remove(file.local_path, ec);
+            if (run) run->files_rejected++;
+            record_failure(file, "Not a PDF (" +
+                           (result.content_type.empty() ? std::string("no content type")
+                                                        : result.content_type) + ")");
+
+            notify_file_status(file.file_id, DownloadStatus::FAILED);
+        } else if (result.success && file_size > 0) {
+            // Success - file downloaded; the digest and signature check were
+            // taken by the Downloader as the body was written
             bytes_this_session_ += result.content_length;
             wire_time_ms_ += result.download_time_ms;
-            db_->update_file_status(file.id, DownloadStatus::COMPLETED, "", result.content_length);
-
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            if (callbacks_.on_file_status_change) {
-                callbacks_.on_file_status_change(file.file_id, DownloadStatus::COMPLETED);
+            if (run) run->bytes_downloaded += result.content_length;
+            record_status(file.id, DownloadStatus::COMPLETED, "", file_size, false, 0, result.sha256,
+                          result.sha256.empty() ? -1 : (result.pdf_signature ? 1 : 0));
+            if (run && run->pack_store) {
+                run->pack_store->submit(file.id, file.local_path);
+            } else if (dedup_ && !result.sha256.empty() && link_duplicate(file, result.sha256)) {
+                if (run) run->files_deduplicated++;
             }
-        } else if (result.success && result.content_length == 0) {
+
+            notify_file_status(file.file_id, DownloadStatus::COMPLETED);
+        } else if (result.success && file_size == 0) {
             // Empty response - delete and mark not found
             if (fs::exists(file.local_path)) {
                 fs::remove(file.local_path);
             }
-            db_->update_file_status(file.id, DownloadStatus::NOT_FOUND, "Empty response");
+            record_status(file.id, DownloadStatus::NOT_FOUND, "Empty response");
         } else {
-            // Download failed - delete empty file
-            if (fs::exists(file.local_path)) {
-                fs::remove(file.local_path);
-            }
-            db_->increment_retry_count(file.id);
-            db_->update_file_status(file.id, DownloadStatus::FAILED, result.error_message);
+            // Download failed
+            record_failure(file, result.error_message);
 
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            if (callbacks_.on_file_status_change) {
-                callbacks_.on_file_status_change(file.file_id, DownloadStatus::FAILED);
-            }
+            notify_file_status(file.file_id, DownloadStatus::FAILED);
         }
     } catch (const std::exception& e) {
-        std::cerr << "[ERROR] download_file exception for " << file.file_id << ": " << e.what() << std::endl;
+        std::cerr << "[ERROR] handle_download_result exception for " << file.file_id << ": " << e.what() << std::endl;
         try {
-            db_->update_file_status(file.id, DownloadStatus::FAILED, std::string("Exception: ") + e.what());
-        } catch (...) {
-            // Ignore nested exceptions
-        }
-    } catch (...) {
-        std::cerr << "[ERROR] download_file unknown exception for " << file.file_id << std::endl;
-        try {
-            db_->update_file_status(file.id, DownloadStatus::FAILED, "Unknown exception");
+            record_failure(file, std::string("Exception: ") + e.what());
         } catch (...) {
             // Ignore nested exceptions
         }
     }
 }
 
-std::string DownloadManager::get_local_path(const std::string& file_id) const {
-    // Organize into subdirectories based on ID to avoid too many files in one folder
-    // e.g., EFTA02205655 -> downloads/DataSet11/022/EFTA02205655.pdf
-    std::string subdir;
-    if (file_id.length() >= 7) {
-        subdir = file_id.substr(4, 3);  // Extract first 3 digits of number
-    } else {
-        subdir = "misc";
+bool DownloadManager::link_duplicate(const FileRecord& file, const std::string& sha256) {
+    std::string original;
+    {
+        // Held across the lookup so two downloads with one digest can't both
+        // become the original
+        std::lock_guard<std::mutex> lock(digests_mutex_);
+        auto it = digests_.find(sha256);
+        if (it != digests_.end()) {
+            digest_order_.splice(digest_order_.begin(), digest_order_, it->second);
+            original = it->second->second;
+        } else {
+            original = db_->find_file_by_sha256(sha256, file.id);
+            digest_order_.emplace_front(sha256, original.empty() ? file.local_path : original);
+            digests_.emplace(sha256, digest_order_.begin());
+            if (digest_order_.size() > DEDUP_DIGEST_CACHE) {
+                digests_.erase(digest_order_.back().first);
+                digest_order_.pop_back();
+            }
+        }
     }
+    if (original.empty() || original == file.local_path) return false;
 
-    fs::path path = fs::path(download_dir_) / ("DataSet" + std::to_string(current_config_.id)) /
-                    subdir / (file_id + ".pdf");
-    return path.string();
+    // The earlier file must still be there and unchanged in size
+    struct stat first{}, second{};
+    if (::stat(original.c_str(), &first) != 0 || ::stat(file.local_path.c_str(), &second) != 0 ||
+        first.st_size != second.st_size) {
+        return false;
+    }
+    if (first.st_dev == second.st_dev && first.st_ino == second.st_ino) return false;
+
+    // Link beside the copy and rename over it, so the path is never missing
+    std::string temp = file.local_path + PARTIAL_FILE_SUFFIX;
+    std::remove(temp.c_str());
+    if (::link(original.c_str(), temp.c_str()) != 0) {
+        return false;  // Other filesystem, or no hard links there; keep the copy
+    }
+    if (std::rename(temp.c_str(), file.local_path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string DownloadManager::get_local_path(int data_set, const std::string& file_id) const {
+    return download_path(download_dir_, data_set, file_id);
 }
 
 void DownloadManager::log(const std::string& message) {
@@ -936,22 +1670,73 @@ void DownloadManager::log(const std::string& message) {
 }
 
 void DownloadManager::update_stats() {
-    auto db_stats = db_->get_stats(current_config_.id);
-
     auto now = std::chrono::steady_clock::now();
     double elapsed = std::chrono::duration<double>(now - start_time_).count();
 
+    // Database counters per data set, read before taking the stats lock
+    std::vector<DownloadStats> db_stats;
+    db_stats.reserve(runs_.size());
+    for (const auto& run : runs_) {
+        db_stats.push_back(db_->get_stats(run->job.config.id));
+    }
+
     {
         std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.files_pending = db_stats.files_pending;
+        DownloadStats total = stats_;
+        total.files_pending = total.files_completed = total.files_failed = total.files_not_found = 0;
+        total.pages_scraped = total.total_files_found = total.total_pages = total.pages_unchanged = 0;
+        total.brute_force_probed = total.brute_force_found = 0;
+        total.brute_force_pass = 0;
+        total.files_packed = total.files_rejected = total.files_deduplicated = 0;
+
+        for (size_t i = 0; i < runs_.size(); ++i) {
+            DataSetRun& run = *runs_[i];
+            DownloadStats& set = run.stats;
+            set.files_pending = db_stats[i].files_pending;
+            set.files_completed = db_stats[i].files_completed;
+            set.files_failed = db_stats[i].files_failed;
+            set.files_not_found = db_stats[i].files_not_found;
+            set.pages_scraped = db_stats[i].pages_scraped;
+            set.total_files_found = db_stats[i].total_files_found;
+            set.total_pages = run.total_pages.load();
+            set.pages_unchanged = run.pages_unchanged.load();
+            set.bytes_downloaded = run.bytes_downloaded.load();
+            set.brute_force_current = run.brute_force_current.load();
+            set.brute_force_probed = run.brute_force_probed.load();
+            set.brute_force_found = run.brute_force_found.load();
+            set.brute_force_pass = run.brute_force_pass.load();
+            set.files_packed = run.pack_store ? run.pack_store->files_packed() : set.files_packed;
+            set.files_rejected = run.files_rejected.load();
+            set.files_deduplicated = run.files_deduplicated.load();
+            set.current_speed_bps = elapsed > 0 ? set.bytes_downloaded / elapsed : 0;
+
+            total.files_pending += set.files_pending;
+            total.files_completed += set.files_completed;
+            total.files_failed += set.files_failed;
+            total.files_not_found += set.files_not_found;
+            total.pages_scraped += set.pages_scraped;
+            total.total_files_found += set.total_files_found;
+            total.total_pages += set.total_pages;
+            total.pages_unchanged += set.pages_unchanged;
+            total.brute_force_probed += set.brute_force_probed;
+            total.brute_force_found += set.brute_force_found;
+            total.brute_force_pass = std::max(total.brute_force_pass, set.brute_force_pass);
+            total.files_packed += set.files_packed;
+            total.files_rejected += set.files_rejected;
+            total.files_deduplicated += set.files_deduplicated;
+        }
+        stats_ = std::move(total);
+
         stats_.files_in_progress = active_downloads_.load();
-        stats_.files_completed = db_stats.files_completed;
-        stats_.files_failed = db_stats.files_failed;
-        stats_.files_not_found = db_stats.files_not_found;
-        stats_.pages_scraped = db_stats.pages_scraped;
-        stats_.total_files_found = db_stats.total_files_found;
         stats_.bytes_downloaded = bytes_this_session_.load();
+        stats_.bytes_resumed = bytes_resumed_.load();
         stats_.brute_force_current = brute_force_current_.load();
+        stats_.connections_open = open_connections_.load();
+        // Only the multi engine shares connections between transfers
+        stats_.streams_active = multi_downloader_ && http2_
+                                    ? static_cast<int64_t>(multi_downloader_->active_transfers()) : 0;
+        stats_.concurrency_limit = concurrency_limit();
+        stats_.concurrency_reason = concurrency_ ? concurrency_->reason() : "fixed";
 
         if (elapsed > 0) {
             stats_.current_speed_bps = bytes_this_session_.load() / elapsed;
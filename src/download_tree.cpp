@@ -0,0 +1,158 @@
+/*
+ * download_tree.cpp - What is already on disk under the download directory
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/download_tree.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace efgrabber {
+
+namespace {
+
+constexpr char PDF_SUFFIX[] = ".pdf";
+constexpr size_t PDF_SUFFIX_LENGTH = sizeof(PDF_SUFFIX) - 1;
+
+bool is_directory(int parent_fd, const dirent* entry) {
+    if (entry->d_type == DT_DIR) return true;
+    if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK) return false;
+    struct stat st;
+    return fstatat(parent_fd, entry->d_name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Subdirectory names of root, skipping . and ..
+std::vector<std::string> list_subdirectories(const std::string& root) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(root.c_str());
+    if (!dir) return names;
+
+    while (const dirent* entry = readdir(dir)) {
+        if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) continue;
+        if (is_directory(dirfd(dir), entry)) names.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+    return names;
+}
+
+void scan_subdirectory(const std::string& path, std::vector<LocalFile>& files) {
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return;
+
+    while (const dirent* entry = readdir(dir)) {
+        size_t length = std::strlen(entry->d_name);
+        if (length <= PDF_SUFFIX_LENGTH ||
+            std::strcmp(entry->d_name + length - PDF_SUFFIX_LENGTH, PDF_SUFFIX) != 0) {
+            continue;
+        }
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+            continue;
+        }
+        files.push_back({std::string(entry->d_name, length - PDF_SUFFIX_LENGTH),
+                         path + "/" + entry->d_name, static_cast<int64_t>(st.st_size)});
+    }
+    closedir(dir);
+}
+
+} // namespace
+
+bool parse_disk_check(const std::string& name, DiskCheck& mode) {
+    if (name == "stat") mode = DiskCheck::STAT;
+    else if (name == "scan") mode = DiskCheck::SCAN;
+    else if (name == "trust") mode = DiskCheck::TRUST_DB;
+    else return false;
+    return true;
+}
+
+const char* disk_check_name(DiskCheck mode) {
+    switch (mode) {
+        case DiskCheck::SCAN: return "scan";
+        case DiskCheck::TRUST_DB: return "trust";
+        case DiskCheck::STAT:
+        default: return "stat";
+    }
+}
+
+std::string download_path(const std::string& download_dir, int data_set, const std::string& file_id) {
+    // Subdirectories keep any one folder from holding too many files
+    std::string subdir = file_id.length() >= 7 ? file_id.substr(4, 3) : "misc";
+    std::filesystem::path path = std::filesystem::path(download_dir) /
+                                 ("DataSet" + std::to_string(data_set)) / subdir / (file_id + ".pdf");
+    return path.string();
+}
+
+std::vector<LocalFile> scan_download_tree(const std::string& root, int threads) {
+    std::vector<std::string> subdirectories = list_subdirectories(root);
+    std::vector<LocalFile> files;
+    if (subdirectories.empty()) return files;
+
+    size_t workers = std::min(subdirectories.size(), static_cast<size_t>(std::max(1, threads)));
+    std::vector<std::vector<LocalFile>> found(workers);
+    std::atomic<size_t> next{0};
+
+    auto work = [&](size_t worker) {
+        for (size_t i = next++; i < subdirectories.size(); i = next++) {
+            scan_subdirectory(root + "/" + subdirectories[i], found[worker]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        pool.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    for (auto& part : found) {
+        files.insert(files.end(), std::make_move_iterator(part.begin()),
+                     std::make_move_iterator(part.end()));
+    }
+    return files;
+}
+
+bool DirectoryCache::ensure(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (created_.count(path)) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) return false;
+    created_.insert(path);
+    return true;
+}
+
+void DirectoryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    created_.clear();
+}
+
+} // namespace efgrabber
@@ -22,11 +22,24 @@
  */
 
 #include "efgrabber/downloader.h"
+#include "efgrabber/file_writer.h"
+#include "efgrabber/content_digest.h"
 #include <curl/curl.h>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <strings.h>
+#include <filesystem>
 #include <fstream>
 #include <stdexcept>
 #include <chrono>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <thread>
+#include <algorithm>
+#include <climits>
 
 namespace efgrabber {
 
@@ -49,23 +62,200 @@ CurlGlobalInit& CurlGlobalInit::instance() {
     return *instance_;
 }
 
-// Write callback for memory downloads
+// Lock callbacks for the share; one mutex per shared data type
+struct CurlShareCallbacks {
+    static void lock(CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* userptr) {
+        static_cast<CurlShare*>(userptr)->locks_[data % CurlShare::LOCK_SLOTS].lock();
+    }
+    static void unlock(CURL* /*handle*/, curl_lock_data data, void* userptr) {
+        static_cast<CurlShare*>(userptr)->locks_[data % CurlShare::LOCK_SLOTS].unlock();
+    }
+};
+
+static_assert(CURL_LOCK_DATA_LAST <= 8, "CurlShare::LOCK_SLOTS too small");
+
+CurlShare::CurlShare() {
+    CurlGlobalInit::instance();  // Ensure global init
+
+    share_ = curl_share_init();
+    if (!share_) {
+        throw std::runtime_error("Failed to initialize CURLSH handle");
+    }
+
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, CurlShareCallbacks::lock);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, CurlShareCallbacks::unlock);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+
+    // The connection cache is deliberately not shared: libcurl does not support
+    // sharing connections between concurrently running threads. Connections are
+    // instead kept alive by each long-lived easy handle (and by each CURLM).
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+CurlShare::~CurlShare() {
+    if (share_) {
+        curl_share_cleanup(share_);
+        share_ = nullptr;
+    }
+}
+
+std::unique_ptr<Downloader> DownloaderPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            auto downloader = std::move(idle_.back());
+            idle_.pop_back();
+            downloader->set_http2(http2_);
+            return downloader;
+        }
+    }
+    auto downloader = std::make_unique<Downloader>();
+    downloader->set_share(share_);
+    downloader->set_socket_counter(socket_counter_);
+    downloader->set_http2(http2_);
+    return downloader;
+}
+
+void DownloaderPool::release(std::unique_ptr<Downloader> downloader) {
+    if (!downloader) return;
+    downloader->reset_defaults();
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(std::move(downloader));
+}
+
+size_t DownloaderPool::idle_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+// Socket callbacks used to count open connections
+static curl_socket_t open_socket_callback(void* clientp, curlsocktype /*purpose*/,
+                                          struct curl_sockaddr* address) {
+    curl_socket_t fd = socket(address->family, address->socktype, address->protocol);
+    if (fd != CURL_SOCKET_BAD) {
+        (*static_cast<std::atomic<int64_t>*>(clientp))++;
+    }
+    return fd;
+}
+
+static TransferTiming read_timing(CURL* curl) {
+    TransferTiming timing;
+    curl_off_t value = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &value) == CURLE_OK) timing.namelookup_us = value;
+    if (curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &value) == CURLE_OK) timing.connect_us = value;
+    if (curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &value) == CURLE_OK) timing.appconnect_us = value;
+    if (curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &value) == CURLE_OK) timing.starttransfer_us = value;
+    if (curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &value) == CURLE_OK) timing.total_us = value;
+
+    long connects = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK) timing.new_connections = connects;
+
+    char* ip = nullptr;
+    if (curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &ip) == CURLE_OK && ip) timing.primary_ip = ip;
+    return timing;
+}
+
+static int close_socket_callback(void* clientp, curl_socket_t fd) {
+    (*static_cast<std::atomic<int64_t>*>(clientp))--;
+    return close(fd);
+}
+
+
+// Header callback to extract content info. Fields describe the final response:
+// they are reset at each status line so redirects and 100 Continue don't leak in.
+struct HeaderData {
+    long status = 0;
+    int64_t content_length = -1;
+    std::string content_type;
+    std::vector<std::string> set_cookies;
+    bool accept_ranges = false;     // Accept-Ranges: bytes
+    int64_t range_start = -1;       // First byte of a 206 Content-Range
+    int64_t range_total = -1;       // Complete size from a 206 Content-Range
+    std::string etag;
+    std::string last_modified;
+};
+
+// Write callback for memory downloads, or streamed ones when sink is set
+struct MemoryWriteData {
+    std::vector<char>* buffer = nullptr;
+    const HeaderData* headers = nullptr;
+    const DataCallback* sink = nullptr;
+    int64_t received = 0;
+};
+
+// Reserve at most this much up front; a bogus Content-Length shouldn't cost more
+static constexpr int64_t MAX_MEMORY_RESERVE = 64LL << 20;
+
 static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t real_size = size * nmemb;
-    auto* buffer = static_cast<std::vector<char>*>(userp);
+    auto* data = static_cast<MemoryWriteData*>(userp);
+    data->received += static_cast<int64_t>(real_size);
+
+    if (data->sink) {
+        // Error pages are not what the caller is parsing for
+        long status = data->headers->status;
+        if (status < 200 || status >= 300) return real_size;
+        return (*data->sink)(static_cast<const char*>(contents), real_size) ? real_size : 0;
+    }
+
+    std::vector<char>* buffer = data->buffer;
+    if (buffer->empty() && data->headers->content_length > 0) {
+        buffer->reserve(static_cast<size_t>(std::min(data->headers->content_length, MAX_MEMORY_RESERVE)));
+    }
     buffer->insert(buffer->end(),
                    static_cast<char*>(contents),
                    static_cast<char*>(contents) + real_size);
     return real_size;
 }
 
+// Resume validator kept beside a .part file (see PARTIAL_META_SUFFIX)
+struct ResumeValidator {
+    std::string etag;
+    std::string last_modified;
+
+    bool empty() const { return etag.empty() && last_modified.empty(); }
+    // If-Range only accepts strong ETags, so weak ones are never stored
+    const std::string& if_range() const { return !etag.empty() ? etag : last_modified; }
+};
+
+static ResumeValidator read_validator(const std::string& path) {
+    ResumeValidator validator;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("etag ", 0) == 0) validator.etag = line.substr(5);
+        else if (line.rfind("last-modified ", 0) == 0) validator.last_modified = line.substr(14);
+    }
+    return validator;
+}
+
+static bool write_validator(const std::string& path, const ResumeValidator& validator) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!validator.etag.empty()) out << "etag " << validator.etag << "\n";
+    if (!validator.last_modified.empty()) out << "last-modified " << validator.last_modified << "\n";
+    return out.good();
+}
+
 // Write callback for file downloads
 struct FileWriteData {
-    std::ofstream* file;
-    Downloader* downloader;
+    FileWriter* file = nullptr;
+    Downloader* downloader = nullptr;
     ProgressCallback progress_cb;
-    int64_t downloaded;
-    int64_t total;
+    int64_t downloaded = 0;
+    int64_t total = 0;
+
+    // Resume state, settled when the first body byte arrives (see start_body)
+    const HeaderData* headers = nullptr;
+    std::string part_path;
+    std::string meta_path;
+    int64_t resume_from = 0;        // Bytes already in the .part file
+    bool started = false;
+    bool discard = false;           // Error body: don't write it into the .part file
+    bool resumable = false;         // .part plus validator can be resumed later
+    int64_t split_above = 0;        // Stop a fresh transfer larger than this (0: never)
+    bool split = false;             // Stopped for download_segmented()
+    ContentInspector inspector;     // Digest and signature of the whole file, resumed prefix included
 };
 
 // Internal struct to pass to progress callback
@@ -74,6 +264,59 @@ struct ProgressData {
     FileWriteData* file_data; // Pointer to file data to update total
 };
 
+// Decide what the response body means for the .part file: a 206 from the offset
+// we asked for appends, any other 2xx starts the file over, and error bodies are
+// dropped so an earlier partial survives for the next attempt
+static bool start_body(FileWriteData* data) {
+    data->started = true;
+    const HeaderData& headers = *data->headers;
+
+    if (headers.status < 200 || headers.status >= 300) {
+        data->discard = true;
+        return true;
+    }
+
+    if (data->resume_from > 0 && headers.status == 206 && headers.range_start == data->resume_from) {
+        if (headers.content_length > 0) {
+            data->file->preallocate(data->resume_from + headers.content_length);
+        }
+        // Picks up where the .part file ends; the digest covers the whole file,
+        // so the kept prefix is read back once
+        return inspect_file(data->part_path, 0, data->resume_from, data->inspector);
+    }
+    if (headers.status == 206) {
+        return false;  // A range we didn't ask for
+    }
+
+    // Full body (the validator changed, or this is a fresh download)
+    ResumeValidator validator;
+    if (headers.etag.rfind("W/", 0) != 0) validator.etag = headers.etag;
+    validator.last_modified = headers.last_modified;
+
+    // Large enough to be worth several ranges: stop before writing anything
+    if (data->split_above > 0 && headers.content_length > data->split_above &&
+        headers.accept_ranges && !validator.empty()) {
+        data->split = true;
+        return false;
+    }
+
+    if (headers.content_length > 0) {
+        data->file->preallocate(headers.content_length);
+    }
+    if (data->resume_from > 0) {
+        data->resume_from = 0;
+        if (!data->file->truncate()) return false;
+    }
+
+    // Written before any body bytes so a crash mid-transfer still leaves a resumable file
+    data->resumable = headers.accept_ranges && !validator.empty() &&
+                      write_validator(data->meta_path, validator);
+    if (!data->resumable) {
+        std::remove(data->meta_path.c_str());
+    }
+    return true;
+}
+
 static size_t file_write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t real_size = size * nmemb;
     auto* data = static_cast<FileWriteData*>(userp);
@@ -82,10 +325,17 @@ static size_t file_write_callback(void* contents, size_t size, size_t nmemb, voi
         return 0;  // Abort transfer
     }
 
-    data->file->write(static_cast<char*>(contents), real_size);
-    if (!data->file->good()) {
+    if (!data->started && !start_body(data)) {
+        return 0;
+    }
+    if (data->discard) {
+        return real_size;
+    }
+
+    if (!data->file->write(static_cast<const char*>(contents), real_size)) {
         return 0;  // Write error
     }
+    data->inspector.update(static_cast<const char*>(contents), real_size);
 
     data->downloaded += real_size;
 
@@ -127,52 +377,64 @@ static int progress_callback(void* clientp, curl_off_t dltotal, curl_off_t dlnow
     return 0;
 }
 
-// Header callback to extract content info
-struct HeaderData {
-    int64_t content_length = -1;
-    std::string content_type;
-    std::vector<std::string> set_cookies;
-};
+// Value of header "Name: value" if it matches name (case-insensitive), trimmed
+static bool header_value(const std::string& header, const char* name, std::string& value) {
+    size_t name_length = std::strlen(name);
+    if (header.size() <= name_length || header[name_length] != ':' ||
+        strncasecmp(header.c_str(), name, name_length) != 0) {
+        return false;
+    }
+
+    size_t start = header.find_first_not_of(" \t", name_length + 1);
+    size_t end = header.find_last_not_of(" \t\r\n");
+    value = (start == std::string::npos || end < start) ? "" : header.substr(start, end - start + 1);
+    return true;
+}
 
 static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userdata) {
     size_t real_size = size * nitems;
     auto* header_data = static_cast<HeaderData*>(userdata);
 
     std::string header(buffer, real_size);
+    std::string value;
 
-    // Parse Content-Length
-    if (header.find("Content-Length:") == 0 || header.find("content-length:") == 0) {
-        size_t pos = header.find(':');
-        if (pos != std::string::npos) {
-            std::string value = header.substr(pos + 1);
-            // Trim whitespace
-            size_t start = value.find_first_not_of(" \t\r\n");
-            size_t end = value.find_last_not_of(" \t\r\n");
-            if (start != std::string::npos && end != std::string::npos) {
-                try {
-                    header_data->content_length = std::stoll(value.substr(start, end - start + 1));
-                } catch (...) {
-                    header_data->content_length = -1;
-                }
-            }
-        }
-    }
+    // New response (redirect hop, 100 Continue or the final one): start over
+    if (header.rfind("HTTP/", 0) == 0) {
+        std::vector<std::string> cookies = std::move(header_data->set_cookies);
+        *header_data = HeaderData{};
+        header_data->set_cookies = std::move(cookies);
 
-    // Parse Content-Type
-    if (header.find("Content-Type:") == 0 || header.find("content-type:") == 0) {
-        size_t pos = header.find(':');
-        if (pos != std::string::npos) {
-            std::string value = header.substr(pos + 1);
-            size_t start = value.find_first_not_of(" \t\r\n");
-            size_t end = value.find_last_not_of(" \t\r\n");
-            if (start != std::string::npos && end != std::string::npos) {
-                header_data->content_type = value.substr(start, end - start + 1);
-            }
+        size_t space = header.find(' ');
+        if (space != std::string::npos) {
+            header_data->status = std::strtol(header.c_str() + space + 1, nullptr, 10);
         }
+        return real_size;
     }
 
-    // Capture Set-Cookie headers
-    if (header.find("Set-Cookie:") == 0 || header.find("set-cookie:") == 0) {
+    if (header_value(header, "Content-Length", value)) {
+        try {
+            header_data->content_length = std::stoll(value);
+        } catch (...) {
+            header_data->content_length = -1;
+        }
+    } else if (header_value(header, "Content-Type", value)) {
+        header_data->content_type = value;
+    } else if (header_value(header, "Accept-Ranges", value)) {
+        header_data->accept_ranges = strcasecmp(value.c_str(), "bytes") == 0;
+    } else if (header_value(header, "Content-Range", value)) {
+        // "bytes <start>-<end>/<total>"
+        if (strncasecmp(value.c_str(), "bytes ", 6) == 0) {
+            char* end = nullptr;
+            long long start = std::strtoll(value.c_str() + 6, &end, 10);
+            if (end && *end == '-') header_data->range_start = start;
+            const char* slash = std::strchr(value.c_str(), '/');
+            if (slash && slash[1] != '*') header_data->range_total = std::strtoll(slash + 1, nullptr, 10);
+        }
+    } else if (header_value(header, "ETag", value)) {
+        header_data->etag = value;
+    } else if (header_value(header, "Last-Modified", value)) {
+        header_data->last_modified = value;
+    } else if (header_value(header, "Set-Cookie", value)) {
         // Strip CRLF
         size_t end = header.find_last_not_of("\r\n");
         if (end != std::string::npos) {
@@ -194,8 +456,12 @@ Downloader::~Downloader() {
 
 Downloader::Downloader(Downloader&& other) noexcept
     : curl_(other.curl_), cookie_(std::move(other.cookie_)),
-      user_agent_(std::move(other.user_agent_)),
-      cancelled_(other.cancelled_.load()),
+      cookie_file_(std::move(other.cookie_file_)),
+      user_agent_(std::move(other.user_agent_)), share_(other.share_),
+      http2_(other.http2_), socket_counter_(other.socket_counter_),
+      segments_(other.segments_), segment_threshold_(other.segment_threshold_),
+      segment_pool_(other.segment_pool_),
+      write_mode_(other.write_mode_), cancelled_(other.cancelled_.load()),
       bytes_downloaded_(other.bytes_downloaded_.load()) {
     other.curl_ = nullptr;
 }
@@ -205,7 +471,15 @@ Downloader& Downloader::operator=(Downloader&& other) noexcept {
         cleanup_curl();
         curl_ = other.curl_;
         cookie_ = std::move(other.cookie_);
+        cookie_file_ = std::move(other.cookie_file_);
         user_agent_ = std::move(other.user_agent_);
+        share_ = other.share_;
+        http2_ = other.http2_;
+        socket_counter_ = other.socket_counter_;
+        segments_ = other.segments_;
+        segment_threshold_ = other.segment_threshold_;
+        segment_pool_ = other.segment_pool_;
+        write_mode_ = other.write_mode_;
         cancelled_ = other.cancelled_.load();
         bytes_downloaded_ = other.bytes_downloaded_.load();
         other.curl_ = nullptr;
@@ -234,9 +508,26 @@ void Downloader::cleanup_curl() {
 void Downloader::setup_common_options(CURL* curl, const std::string& url) {
     curl_easy_reset(curl);
 
+    // curl_easy_reset() detaches the share, so re-attach it on every request
+    if (share_) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share_->handle());
+    }
+
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_USERAGENT, user_agent_.c_str());
 
+    if (http2_) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    if (socket_counter_) {
+        curl_easy_setopt(curl, CURLOPT_OPENSOCKETFUNCTION, open_socket_callback);
+        curl_easy_setopt(curl, CURLOPT_OPENSOCKETDATA, socket_counter_);
+        curl_easy_setopt(curl, CURLOPT_CLOSESOCKETFUNCTION, close_socket_callback);
+        curl_easy_setopt(curl, CURLOPT_CLOSESOCKETDATA, socket_counter_);
+    }
+
     // Use cookie file if specified, otherwise use cookie string
     if (!cookie_file_.empty()) {
         curl_easy_setopt(curl, CURLOPT_COOKIEFILE, cookie_file_.c_str());
@@ -265,6 +556,11 @@ void Downloader::setup_common_options(CURL* curl, const std::string& url) {
 }
 
 DownloadResult Downloader::download(const std::string& url, int timeout_seconds) {
+    return perform_get(url, nullptr, nullptr, timeout_seconds);
+}
+
+DownloadResult Downloader::perform_get(const std::string& url, const DataCallback* sink,
+                                       const PageValidators* validators, int timeout_seconds) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     DownloadResult result{};
@@ -288,21 +584,40 @@ DownloadResult Downloader::download(const std::string& url, int timeout_seconds)
     curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);  // 5 second connect timeout
     curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1000L);  // Abort if below 1KB/s
     curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 10L);     // for more than 10 seconds
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result.data);
-
     HeaderData header_data;
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
     curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_data);
 
+    MemoryWriteData write_data;
+    write_data.buffer = &result.data;
+    write_data.headers = &header_data;
+    write_data.sink = sink;
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write_data);
+
+    struct curl_slist* headers = nullptr;
+    if (validators) {
+        if (!validators->etag.empty()) {
+            headers = curl_slist_append(headers, ("If-None-Match: " + validators->etag).c_str());
+        }
+        if (!validators->last_modified.empty()) {
+            headers = curl_slist_append(headers, ("If-Modified-Since: " + validators->last_modified).c_str());
+        }
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+
     CURLcode res = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
 
     long http_code = 0;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
     result.http_code = static_cast<int>(http_code);
+    result.timing = read_timing(curl);
     result.content_length = header_data.content_length;
     result.content_type = header_data.content_type;
     result.set_cookie_headers = std::move(header_data.set_cookies);
+    result.etag = std::move(header_data.etag);
+    result.last_modified = std::move(header_data.last_modified);
 
     if (res != CURLE_OK) {
         result.error_message = curl_easy_strerror(res);
@@ -310,34 +625,67 @@ DownloadResult Downloader::download(const std::string& url, int timeout_seconds)
             result.error_message = "Download cancelled";
         }
     } else {
-        result.success = (http_code >= 200 && http_code < 300);
+        result.not_modified = validators && !validators->empty() && http_code == 304;
+        result.success = (http_code >= 200 && http_code < 300) || result.not_modified;
         if (!result.success) {
             result.error_message = "HTTP error: " + std::to_string(http_code);
         }
-        bytes_downloaded_ += result.data.size();
+        bytes_downloaded_ += write_data.received;
     }
 
     return result;
 }
 
-DownloadResult Downloader::download_to_file(const std::string& url, const std::string& filepath,
-                                            ProgressCallback progress_cb, int timeout_seconds) {
-    std::lock_guard<std::mutex> lock(mutex_);
+// State for one file transfer, kept alive between begin and finish
+struct FileTransfer {
+    std::string filepath;
+    std::unique_ptr<FileWriter> file;
+    FileWriteData write_data{};
+    ProgressData progress_data{};
+    HeaderData header_data;
+    std::string range;
+    struct curl_slist* headers = nullptr;
+    std::chrono::steady_clock::time_point start_time;
 
-    DownloadResult result{};
-    result.success = false;
+    ~FileTransfer() {
+        curl_slist_free_all(headers);
+    }
+};
+
+void FileTransferDeleter::operator()(FileTransfer* transfer) const {
+    delete transfer;
+}
 
+FileTransferPtr Downloader::begin_file_transfer(const std::string& url, const std::string& filepath,
+                                                std::string& error,
+                                                ProgressCallback progress_cb, int timeout_seconds) {
     if (!curl_) {
-        result.error_message = "CURL not initialized";
-        return result;
+        error = "CURL not initialized";
+        return nullptr;
     }
 
     cancelled_ = false;
 
-    std::ofstream file(filepath, std::ios::binary);
-    if (!file) {
-        result.error_message = "Failed to open file for writing: " + filepath;
-        return result;
+    FileTransferPtr transfer(new FileTransfer());
+    transfer->filepath = filepath;
+
+    // Bytes land in <path>.part and are renamed into place once complete. A .part
+    // left by an earlier attempt is resumed if its validator was recorded.
+    std::string part_path = filepath + PARTIAL_FILE_SUFFIX;
+    std::string meta_path = filepath + PARTIAL_META_SUFFIX;
+    std::error_code ec;
+    auto part_size = std::filesystem::file_size(part_path, ec);
+    int64_t resume_from = ec ? 0 : static_cast<int64_t>(part_size);
+    ResumeValidator validator = resume_from > 0 ? read_validator(meta_path) : ResumeValidator{};
+    if (validator.empty()) {
+        resume_from = 0;
+        std::remove(meta_path.c_str());
+    }
+
+    transfer->file = make_file_writer(write_mode_);
+    if (!transfer->file->open(part_path, resume_from > 0)) {
+        error = "Failed to open file for writing: " + part_path;
+        return nullptr;
     }
 
     CURL* curl = static_cast<CURL*>(curl_);
@@ -348,41 +696,80 @@ DownloadResult Downloader::download_to_file(const std::string& url, const std::s
     curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1000L);  // Abort if below 1KB/s
     curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 10L);     // for more than 10 seconds
 
-    FileWriteData write_data{&file, this, progress_cb, 0, 0};
-    ProgressData progress_data{this, &write_data};
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress_data);
+    // CURLOPT_RANGE rather than CURLOPT_RESUME_FROM: libcurl fails a resume that
+    // gets a 200, but with If-Range a 200 is the server's "file changed" answer
+    if (resume_from > 0) {
+        transfer->range = std::to_string(resume_from) + "-";
+        curl_easy_setopt(curl, CURLOPT_RANGE, transfer->range.c_str());
+        transfer->headers = curl_slist_append(nullptr, ("If-Range: " + validator.if_range()).c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+    }
 
-    HeaderData header_data;
+    FileWriteData& data = transfer->write_data;
+    data.file = transfer->file.get();
+    data.downloader = this;
+    data.progress_cb = progress_cb;
+    data.headers = &transfer->header_data;
+    data.part_path = part_path;
+    data.meta_path = meta_path;
+    data.resume_from = resume_from;
+    data.resumable = resume_from > 0;
+    transfer->progress_data = ProgressData{this, &transfer->write_data};
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer->progress_data);
 
-    // Do the actual download
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, file_write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write_data);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->write_data);
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_data);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->header_data);
+
+    transfer->start_time = std::chrono::steady_clock::now();
+    return transfer;
+}
+
+// Keep the .part file only if a later attempt can resume it
+static void drop_or_keep_partial(const FileWriteData& data, bool keep) {
+    if (keep && data.resumable && data.resume_from + data.downloaded > 0) return;
+    std::remove(data.part_path.c_str());
+    std::remove(data.meta_path.c_str());
+}
+
+DownloadResult Downloader::finish_file_transfer(FileTransferPtr transfer, int curl_code) {
+    DownloadResult result{};
+    result.success = false;
+
+    CURLcode res = static_cast<CURLcode>(curl_code);
+    FileWriteData& data = transfer->write_data;
 
-    auto transfer_start = std::chrono::steady_clock::now();
-    CURLcode res = curl_easy_perform(curl);
     auto transfer_end = std::chrono::steady_clock::now();
     result.download_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        transfer_end - transfer_start).count();
+        transfer_end - transfer->start_time).count();
 
-    file.close();
+    // Empty bodies never reach the write callback
+    if (res == CURLE_OK && !data.started && !start_body(&data)) {
+        res = CURLE_WRITE_ERROR;
+    }
+    // Pooled writers flush their last buffer here, so close() can still fail
+    if (!transfer->file->close() && res == CURLE_OK) {
+        res = CURLE_WRITE_ERROR;
+    }
 
     long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_getinfo(static_cast<CURL*>(curl_), CURLINFO_RESPONSE_CODE, &http_code);
     result.http_code = static_cast<int>(http_code);
-    result.content_length = write_data.downloaded;
-    result.expected_length = header_data.content_length;  // From response headers
-    result.content_type = header_data.content_type;
-    result.set_cookie_headers = std::move(header_data.set_cookies);
+    result.timing = read_timing(static_cast<CURL*>(curl_));
+    result.content_length = data.downloaded;
+    result.resumed_bytes = data.resume_from;
+    result.expected_length = transfer->header_data.content_length;  // From response headers
+    result.content_type = transfer->header_data.content_type;
+    result.set_cookie_headers = std::move(transfer->header_data.set_cookies);
 
     if (res != CURLE_OK) {
         result.error_message = curl_easy_strerror(res);
         if (cancelled_) {
             result.error_message = "Download cancelled";
         }
-        // Remove partial file
-        std::remove(filepath.c_str());
+        // Timeouts, stalls and resets can pick up where they stopped
+        drop_or_keep_partial(data, true);
     } else {
         result.success = (http_code >= 200 && http_code < 300);
 
@@ -393,46 +780,408 @@ DownloadResult Downloader::download_to_file(const std::string& url, const std::s
             result.error_message = "Size mismatch: expected " +
                 std::to_string(result.expected_length) + " bytes, got " +
                 std::to_string(result.content_length);
-            std::remove(filepath.c_str());
+            drop_or_keep_partial(data, false);
         } else if (!result.success) {
             result.error_message = "HTTP error: " + std::to_string(http_code);
-            std::remove(filepath.c_str());
+            // The error body was not written, so the earlier partial is intact unless
+            // the file is gone or the requested range no longer makes sense
+            drop_or_keep_partial(data, http_code != 404 && http_code != 410 && http_code != 416);
+        } else if (std::rename(data.part_path.c_str(), transfer->filepath.c_str()) != 0) {
+            result.success = false;
+            result.error_message = "Failed to move " + data.part_path + " into place: " +
+                                   std::strerror(errno);
+            drop_or_keep_partial(data, false);
+        } else {
+            std::remove(data.meta_path.c_str());
+            result.sha256 = data.inspector.hex_digest();
+            result.pdf_signature = data.inspector.looks_like_pdf();
         }
-        bytes_downloaded_ += write_data.downloaded;
+        bytes_downloaded_ += data.downloaded;
     }
 
+    if (!result.success) {
+        result.resumed_bytes = 0;
+    }
     return result;
 }
 
-DownloadResult Downloader::download_page(const std::string& url, int timeout_seconds) {
-    return download(url, timeout_seconds);
+void Downloader::abandon_file_transfer(FileTransferPtr transfer) {
+    transfer->file->close();
+    drop_or_keep_partial(transfer->write_data, true);
 }
 
-bool Downloader::url_exists(const std::string& url) {
+DownloadResult Downloader::download_to_file(const std::string& url, const std::string& filepath,
+                                            ProgressCallback progress_cb, int timeout_seconds) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    if (!curl_) return false;
+    std::string error;
+    auto transfer = begin_file_transfer(url, filepath, error, progress_cb, timeout_seconds);
+    if (!transfer) {
+        DownloadResult result{};
+        result.success = false;
+        result.error_message = error;
+        return result;
+    }
+
+    // Only a fresh transfer can be split; a resumed .part finishes as one stream
+    if (segments_ > 1) {
+        transfer->write_data.split_above = segment_threshold_;
+    }
 
-    cancelled_ = false;
+    CURLcode res = curl_easy_perform(static_cast<CURL*>(curl_));
+    if (!transfer->write_data.split) {
+        return finish_file_transfer(std::move(transfer), res);
+    }
+
+    // Stopped at the first body byte: the size is known, nothing was written
+    HeaderData first = std::move(transfer->header_data);
+    TransferTiming timing = read_timing(static_cast<CURL*>(curl_));
+    transfer->file->close();
+    drop_or_keep_partial(transfer->write_data, false);
+    transfer.reset();
+    return download_segmented(url, filepath, first, timing, progress_cb, timeout_seconds);
+}
+
+// Progress shared by the segments of one file; callbacks are serialised
+struct SegmentProgress {
+    ProgressCallback callback;
+    std::mutex mutex;
+    int64_t downloaded = 0;
+    int64_t total = 0;
+
+    void add(int64_t bytes) {
+        if (!callback) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        downloaded += bytes;
+        callback(downloaded, total);
+    }
+};
+
+// One ranged GET, written in place into the shared .part file
+struct RangeRequest {
+    Downloader* owner = nullptr;       // Whose cancel() aborts this request
+    FileWriter* file = nullptr;        // Positioned at start
+    int64_t start = 0;                 // First byte requested
+    int64_t end = 0;                   // One past the last byte requested
+    int64_t written = 0;
+    bool started = false;
+    bool discard = false;
+    HeaderData headers;
+    SegmentProgress* progress = nullptr;
+    ContentInspector* inspector = nullptr;  // Fed as bytes arrive; first segment only
+    int curl_code = 0;
+    long http_code = 0;
+    TransferTiming timing;
+};
+
+static size_t range_write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+    size_t real_size = size * nmemb;
+    auto* request = static_cast<RangeRequest*>(userp);
+
+    if (request->owner->is_cancelled()) {
+        return 0;
+    }
+
+    if (!request->started) {
+        request->started = true;
+        long status = request->headers.status;
+        if (status < 200 || status >= 300) {
+            request->discard = true;
+        } else if (status != 206 || request->headers.range_start != request->start) {
+            return 0;  // The file changed under If-Range, or a range we didn't ask for
+        }
+    }
+    if (request->discard) {
+        return real_size;
+    }
 
+    int64_t offset = request->start + request->written;
+    if (offset + static_cast<int64_t>(real_size) > request->end) {
+        return 0;  // More than we asked for
+    }
+
+    if (!request->file->write(static_cast<const char*>(contents), real_size)) {
+        return 0;  // Write error
+    }
+    if (request->inspector) {
+        request->inspector->update(static_cast<const char*>(contents), real_size);
+    }
+
+    request->written += static_cast<int64_t>(real_size);
+    if (request->progress) {
+        request->progress->add(static_cast<int64_t>(real_size));
+    }
+    return real_size;
+}
+
+void Downloader::perform_range(const std::string& url, const std::string& if_range,
+                               RangeRequest& request, int timeout_seconds) {
     CURL* curl = static_cast<CURL*>(curl_);
     setup_common_options(curl, url);
-    // Use dummy progress data for cancellation
-    ProgressData progress_data{this, nullptr};
+
+    ProgressData progress_data{request.owner, nullptr};
     curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress_data);
 
-    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);  // HEAD request
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(timeout_seconds));
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);  // 5 second connect timeout
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1000L);  // Abort if below 1KB/s
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 10L);     // for more than 10 seconds
 
-    CURLcode res = curl_easy_perform(curl);
+    std::string range = std::to_string(request.start) + "-" + std::to_string(request.end - 1);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+
+    struct curl_slist* headers = nullptr;
+    if (!if_range.empty()) {
+        headers = curl_slist_append(headers, ("If-Range: " + if_range).c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, range_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &request);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &request.headers);
+
+    request.curl_code = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &request.http_code);
+    request.timing = read_timing(curl);
+
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+}
+
+// Size the file so segments can be written in place: real extents where the
+// filesystem can allocate them, a sparse file otherwise
+static bool presize_file(int fd, int64_t size) {
+#ifdef __linux__
+    if (fallocate(fd, 0, 0, size) == 0) return true;
+#endif
+    return ftruncate(fd, size) == 0;
+}
+
+DownloadResult Downloader::download_segmented(const std::string& url, const std::string& filepath,
+                                              const HeaderData& first, const TransferTiming& timing,
+                                              ProgressCallback progress_cb, int timeout_seconds) {
+    DownloadResult result{};
+    result.success = false;
+    result.http_code = static_cast<int>(first.status);
+    result.timing = timing;
+    result.content_type = first.content_type;
+    result.set_cookie_headers = first.set_cookies;
+
+    std::string part_path = filepath + PARTIAL_FILE_SUFFIX;
+    std::string meta_path = filepath + PARTIAL_META_SUFFIX;
+
+    int fd = ::open(part_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        result.error_message = "Failed to open file for writing: " + part_path;
+        return result;
+    }
 
-    if (res != CURLE_OK) return false;
+    auto start_time = std::chrono::steady_clock::now();
+    int64_t total = first.content_length;
+    SegmentProgress progress;
+    progress.callback = progress_cb;
+    progress.total = total;
+
+    ResumeValidator validator;
+    if (first.etag.rfind("W/", 0) != 0) validator.etag = first.etag;
+    validator.last_modified = first.last_modified;
+
+    // No range shorter than MIN_SEGMENT_BYTES, so a low threshold doesn't
+    // turn into many tiny requests. Boundaries stay block aligned for O_DIRECT.
+    int count = static_cast<int>(std::min<int64_t>(segments_, (total + MIN_SEGMENT_BYTES - 1) /
+                                                               MIN_SEGMENT_BYTES));
+    std::vector<RangeRequest> segments(static_cast<size_t>(count));
+    std::vector<std::unique_ptr<FileWriter>> writers;
+    ContentInspector inspector;
+    int64_t step = total / count / static_cast<int64_t>(WRITE_BUFFER_ALIGNMENT) *
+                   static_cast<int64_t>(WRITE_BUFFER_ALIGNMENT);
+
+    int64_t received = 0;
+    int64_t contiguous = 0;  // Valid bytes from offset 0, kept for resume on failure
+    std::string error;
+
+    if (!presize_file(fd, total)) {
+        error = std::string("Failed to allocate ") + part_path + ": " + std::strerror(errno);
+    }
+    ::close(fd);
+
+    for (int i = 0; i < count && error.empty(); ++i) {
+        RangeRequest& segment = segments[static_cast<size_t>(i)];
+        segment.owner = this;
+        segment.start = step * i;
+        segment.end = (i == count - 1) ? total : segment.start + step;
+        segment.progress = &progress;
+        if (i == 0) segment.inspector = &inspector;
+
+        writers.push_back(make_file_writer(write_mode_));
+        segment.file = writers.back().get();
+        if (!segment.file->open(part_path, true) || !segment.file->seek(segment.start)) {
+            error = "Failed to open file for writing: " + part_path;
+        }
+    }
+
+    if (error.empty()) {
+        const std::string& if_range = validator.if_range();
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < segments.size(); ++i) {
+            threads.emplace_back([this, &url, &if_range, &segments, i, timeout_seconds]() {
+                // A pooled handle keeps its warm connection for the next file
+                std::unique_ptr<Downloader> segment_downloader =
+                    segment_pool_ ? segment_pool_->acquire() : std::make_unique<Downloader>();
+                segment_downloader->copy_settings_from(*this);
+                segment_downloader->perform_range(url, if_range, segments[i], timeout_seconds);
+                if (segment_pool_) segment_pool_->release(std::move(segment_downloader));
+            });
+        }
+        perform_range(url, if_range, segments[0], timeout_seconds);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // Only the first segment continues the contiguous prefix
+        contiguous = segments[0].written;
+        for (auto& segment : segments) {
+            received += segment.written;
+            result.set_cookie_headers.insert(result.set_cookie_headers.end(),
+                                             segment.headers.set_cookies.begin(),
+                                             segment.headers.set_cookies.end());
+            // Pooled writers flush their last buffer here, so close() can still fail
+            bool closed = segment.file->close();
+            if (!closed && &segment == &segments[0]) contiguous = 0;
+            if (!error.empty()) continue;
+            if (!closed) {
+                error = "Failed to write " + part_path + ": " + std::strerror(errno);
+            } else if (segment.curl_code != CURLE_OK) {
+                error = cancelled_ ? "Download cancelled"
+                                   : curl_easy_strerror(static_cast<CURLcode>(segment.curl_code));
+            } else if (segment.http_code != 206 || segment.written != segment.end - segment.start) {
+                error = "Segment " + std::to_string(segment.start) + "-" +
+                        std::to_string(segment.end - 1) + " failed: HTTP " +
+                        std::to_string(segment.http_code);
+            }
+            // The failing range's status, not the first response's 200, says how
+            // the failure is handled (a 403 or 429 is a block)
+            if (!error.empty() && segment.http_code != 0) {
+                result.http_code = static_cast<int>(segment.http_code);
+            }
+        }
+    }
+
+    result.content_length = received;
+    result.expected_length = total;
+
+    auto transfer_end = std::chrono::steady_clock::now();
+    result.download_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        transfer_end - start_time).count();
+    // Connection phases are the first response's; the total covers the ranges after it
+    result.timing.total_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        transfer_end - start_time).count();
+    bytes_downloaded_ += result.content_length;
+
+    if (error.empty() && result.content_length != total) {
+        error = "Size mismatch: expected " + std::to_string(total) + " bytes, got " +
+                std::to_string(result.content_length);
+        contiguous = 0;
+    }
 
+    writers.clear();
+
+    // The first segment was inspected as it arrived; the others landed out of
+    // order, so they are read back while still in the page cache
+    for (size_t i = 1; i < segments.size() && error.empty(); ++i) {
+        const RangeRequest& segment = segments[i];
+        if (!inspect_file(part_path, segment.start, segment.end - segment.start, inspector)) {
+            error = "Failed to read back " + part_path + ": " + std::strerror(errno);
+            contiguous = 0;
+        }
+    }
+
+    if (error.empty()) {
+        if (std::rename(part_path.c_str(), filepath.c_str()) == 0) {
+            result.success = true;
+            result.sha256 = inspector.hex_digest();
+            result.pdf_signature = inspector.looks_like_pdf();
+            return result;
+        }
+        error = "Failed to move " + part_path + " into place: " + std::strerror(errno);
+        contiguous = 0;
+    }
+
+    result.error_message = error;
+
+    // Keep the contiguous prefix for a later single-stream resume, as download_to_file would
+    if (contiguous > 0 &&
+        truncate(part_path.c_str(), contiguous) == 0 && write_validator(meta_path, validator)) {
+        return result;
+    }
+    std::remove(part_path.c_str());
+    std::remove(meta_path.c_str());
+    return result;
+}
+
+void Downloader::copy_settings_from(const Downloader& other) {
+    cookie_ = other.cookie_;
+    cookie_file_ = other.cookie_file_;
+    user_agent_ = other.user_agent_;
+    share_ = other.share_;
+    http2_ = other.http2_;
+    socket_counter_ = other.socket_counter_;
+    write_mode_ = other.write_mode_;
+}
+
+DownloadResult Downloader::download_page(const std::string& url, int timeout_seconds) {
+    return download(url, timeout_seconds);
+}
+
+DownloadResult Downloader::download_page(const std::string& url, const DataCallback& on_data,
+                                         int timeout_seconds) {
+    return perform_get(url, &on_data, nullptr, timeout_seconds);
+}
+
+DownloadResult Downloader::download_page(const std::string& url, const DataCallback& on_data,
+                                         const PageValidators& validators, int timeout_seconds) {
+    return perform_get(url, &on_data, &validators, timeout_seconds);
+}
+
+bool Downloader::url_exists(const std::string& url) {
+    return probe_url(url) == 200;
+}
+
+static size_t discard_callback(void*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+int Downloader::probe_url(const std::string& url, int timeout_seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!curl_) return 0;
+
+    cancelled_ = false;
+
+    CURL* curl = static_cast<CURL*>(curl_);
     long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    for (bool head : {true, false}) {
+        setup_common_options(curl, url);
+        // Use dummy progress data for cancellation
+        ProgressData progress_data{this, nullptr};
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress_data);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(timeout_seconds));
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+        if (head) {
+            curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+        } else {
+            curl_easy_setopt(curl, CURLOPT_RANGE, "0-0");
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_callback);
+        }
 
-    return http_code == 200;
+        if (curl_easy_perform(curl) != CURLE_OK) return 0;
+
+        http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code != 405 && http_code != 501) break;
+    }
+    return http_code == 206 ? 200 : static_cast<int>(http_code);
 }
 
 void Downloader::set_cookie(const std::string& cookie) {
@@ -447,6 +1196,36 @@ void Downloader::set_user_agent(const std::string& user_agent) {
     user_agent_ = user_agent;
 }
 
+void Downloader::set_share(CurlShare* share) {
+    share_ = share;
+}
+
+void Downloader::set_http2(bool enabled) {
+    http2_ = enabled;
+}
+
+void Downloader::set_socket_counter(std::atomic<int64_t>* counter) {
+    socket_counter_ = counter;
+}
+
+void Downloader::set_write_mode(WriteMode mode) {
+    write_mode_ = mode;
+}
+
+void Downloader::reset_defaults() {
+    cookie_ = REQUIRED_COOKIE;
+    cookie_file_.clear();
+    user_agent_ = USER_AGENT;
+    segments_ = 1;
+    segment_pool_ = nullptr;
+}
+
+void Downloader::set_segmentation(int segments, int64_t threshold_bytes, DownloaderPool* pool) {
+    segments_ = std::clamp(segments, 1, MAX_SEGMENTS_PER_FILE);
+    segment_threshold_ = threshold_bytes;
+    segment_pool_ = pool;
+}
+
 void Downloader::cancel() {
     cancelled_ = true;
 }
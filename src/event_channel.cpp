@@ -0,0 +1,95 @@
+/*
+ * event_channel.cpp - Lock-free queue of download events for a UI thread
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/event_channel.h"
+#include <algorithm>
+#include <cstring>
+
+namespace efgrabber {
+
+ManagerEvent ManagerEvent::file_status(std::string_view file_id, DownloadStatus status) {
+    ManagerEvent event;
+    event.kind = Kind::FILE_STATUS;
+    event.status = status;
+    size_t length = std::min(file_id.size(), sizeof(event.file_id) - 1);
+    std::memcpy(event.file_id, file_id.data(), length);
+    return event;
+}
+
+ManagerEvent ManagerEvent::page_scraped(int page, int count) {
+    ManagerEvent event;
+    event.kind = Kind::PAGE_SCRAPED;
+    event.page = page;
+    event.count = count;
+    return event;
+}
+
+EventChannel::EventChannel(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    slots_ = std::make_unique<Slot[]>(size);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool EventChannel::push(const ManagerEvent& event) {
+    size_t position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = slots_[position & mask_];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+        if (lag == 0) {
+            // Free for this lap; claim it unless another producer got there first
+            if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.event = event;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (lag < 0) {
+            // Still holds last lap's event: the consumer is a full ring behind
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t EventChannel::drain(std::vector<ManagerEvent>& out, size_t max) {
+    size_t taken = 0;
+    while (taken < max) {
+        Slot& slot = slots_[head_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            break;  // Empty, or the producer holding this slot hasn't finished writing
+        }
+        out.push_back(slot.event);
+        slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        ++taken;
+    }
+    return taken;
+}
+
+} // namespace efgrabber
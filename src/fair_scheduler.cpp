@@ -0,0 +1,83 @@
+/*
+ * fair_scheduler.cpp - Weighted sharing of download slots between data sets
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/fair_scheduler.h"
+#include <algorithm>
+
+namespace efgrabber {
+
+void FairScheduler::add(int data_set, int weight) {
+    flows_.push_back(Flow{data_set, std::max(1, weight)});
+}
+
+void FairScheduler::clear() {
+    flows_.clear();
+    next_ = 0;
+}
+
+size_t FairScheduler::distribute(size_t want, const Claim& claim) {
+    size_t remaining = want;
+    std::vector<bool> open(flows_.size(), true);
+    size_t open_count = flows_.size();
+
+    while (remaining > 0 && open_count > 0) {
+        int total_weight = 0;
+        for (size_t i = 0; i < flows_.size(); ++i) {
+            if (open[i]) total_weight += flows_[i].weight;
+        }
+
+        // One round hands out about what is still wanted
+        const double round = static_cast<double>(remaining) / total_weight;
+        for (size_t n = 0; n < flows_.size() && remaining > 0; ++n) {
+            size_t i = (next_ + n) % flows_.size();
+            if (!open[i]) continue;
+
+            Flow& flow = flows_[i];
+            flow.deficit += round * flow.weight;
+            size_t ask = std::min(remaining, static_cast<size_t>(flow.deficit));
+            if (ask == 0) continue;
+
+            size_t got = std::min(claim(flow.data_set, ask), ask);
+            flow.deficit -= static_cast<double>(got);
+            flow.served += got;
+            remaining -= got;
+            if (got < ask) {
+                // Nothing more pending; an idle set banks no credit
+                open[i] = false;
+                open_count--;
+                flow.deficit = 0;
+            }
+        }
+        next_ = (next_ + 1) % flows_.size();
+    }
+    return want - remaining;
+}
+
+uint64_t FairScheduler::served(int data_set) const {
+    for (const auto& flow : flows_) {
+        if (flow.data_set == data_set) return flow.served;
+    }
+    return 0;
+}
+
+} // namespace efgrabber
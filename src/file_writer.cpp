@@ -0,0 +1,348 @@
+/*
+ * file_writer.cpp - Disk write path for downloaded files
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/file_writer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+namespace efgrabber {
+
+WriteBufferPool::WriteBufferPool(size_t max_idle) : max_idle_(max_idle) {}
+
+WriteBufferPool::~WriteBufferPool() {
+    for (char* buffer : idle_) {
+        std::free(buffer);
+    }
+}
+
+char* WriteBufferPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            char* buffer = idle_.back();
+            idle_.pop_back();
+            return buffer;
+        }
+    }
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, WRITE_BUFFER_ALIGNMENT, WRITE_BUFFER_BYTES) != 0) {
+        return nullptr;
+    }
+    return static_cast<char*>(buffer);
+}
+
+void WriteBufferPool::release(char* buffer) {
+    if (!buffer) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < max_idle_) {
+            idle_.push_back(buffer);
+            return;
+        }
+    }
+    std::free(buffer);
+}
+
+size_t WriteBufferPool::idle_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+WriteBufferPool& WriteBufferPool::shared() {
+    static WriteBufferPool pool;
+    return pool;
+}
+
+namespace {
+
+// The original write path, kept as a fallback and a benchmark baseline
+class StreamFileWriter : public FileWriter {
+public:
+    bool open(const std::string& path, bool append) override {
+        path_ = path;
+        file_.open(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+        return file_.good();
+    }
+
+    bool truncate() override {
+        file_.close();
+        file_.open(path_, std::ios::binary | std::ios::trunc);
+        return file_.good();
+    }
+
+    bool write(const char* data, size_t size) override {
+        file_.write(data, static_cast<std::streamsize>(size));
+        return file_.good();
+    }
+
+    bool seek(int64_t offset) override {
+        // An append stream ignores the put position, so reopen for in-place writes
+        file_.close();
+        file_.open(path_, std::ios::binary | std::ios::in | std::ios::out);
+        file_.seekp(offset);
+        return file_.good();
+    }
+
+    bool close() override {
+        if (!file_.is_open()) return true;
+        file_.close();
+        return !file_.fail();
+    }
+
+    bool is_open() const override { return file_.is_open(); }
+
+private:
+    std::string path_;
+    std::ofstream file_;
+};
+
+// Writes through one pooled buffer at explicit offsets. Chunks that fit are
+// copied into the buffer; a chunk that would overflow it goes out together with
+// the buffered bytes in a single pwritev(), straight from curl's memory. In
+// direct mode every write is a whole aligned buffer, and O_DIRECT is dropped
+// for the unaligned tail on close.
+class PooledFileWriter : public FileWriter {
+public:
+    explicit PooledFileWriter(bool direct) : direct_(direct) {}
+
+    ~PooledFileWriter() override {
+        close();
+    }
+
+    bool open(const std::string& path, bool append) override {
+        close();
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC), 0644);
+        if (fd_ < 0) return false;
+
+        offset_ = append ? lseek(fd_, 0, SEEK_END) : 0;
+        if (offset_ < 0) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        failed_ = false;
+        preallocated_ = 0;
+        update_direct();
+        return true;
+    }
+
+    bool truncate() override {
+        if (fd_ < 0) return false;
+        fill_ = 0;
+        offset_ = 0;
+        preallocated_ = 0;
+        if (ftruncate(fd_, 0) != 0) {
+            failed_ = true;
+            return false;
+        }
+        update_direct();
+        return true;
+    }
+
+    void preallocate(int64_t final_size) override {
+#ifdef __linux__
+        // KEEP_SIZE reserves the extents without moving EOF, so a crash still
+        // leaves a .part file whose size is exactly the bytes received
+        int64_t end = offset_ + static_cast<int64_t>(fill_);
+        if (fd_ < 0 || final_size <= end) return;
+        if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, end, final_size - end) == 0) {
+            preallocated_ = final_size;
+        }
+#else
+        (void)final_size;
+#endif
+    }
+
+    bool write(const char* data, size_t size) override {
+        if (fd_ < 0 || failed_) return false;
+        if (!buffer_) {
+            buffer_ = WriteBufferPool::shared().acquire();
+            if (!buffer_) {
+                failed_ = true;
+                return false;
+            }
+        }
+
+        if (direct_active_) {
+            // O_DIRECT needs whole aligned blocks, so everything goes through the buffer
+            while (size > 0) {
+                size_t n = std::min(size, WRITE_BUFFER_BYTES - fill_);
+                std::memcpy(buffer_ + fill_, data, n);
+                fill_ += n;
+                data += n;
+                size -= n;
+                if (fill_ == WRITE_BUFFER_BYTES && !flush()) return false;
+            }
+            return true;
+        }
+
+        if (fill_ + size < WRITE_BUFFER_BYTES) {
+            std::memcpy(buffer_ + fill_, data, size);
+            fill_ += size;
+            return true;
+        }
+
+        struct iovec iov[2];
+        iov[0].iov_base = buffer_;
+        iov[0].iov_len = fill_;
+        iov[1].iov_base = const_cast<char*>(data);
+        iov[1].iov_len = size;
+        if (!write_all(iov, 2)) return false;
+        fill_ = 0;
+        return true;
+    }
+
+    bool seek(int64_t offset) override {
+        if (fd_ < 0 || failed_) return false;
+        if (fill_ > 0 && !flush_tail()) return false;
+        offset_ = offset;
+        update_direct();
+        return true;
+    }
+
+    bool close() override {
+        if (fd_ < 0) return true;
+
+        if (fill_ > 0 && !failed_) flush_tail();
+
+        // A short transfer would otherwise leave the reservation allocated past EOF
+        if (preallocated_ > offset_ && ftruncate(fd_, offset_) != 0) {
+            failed_ = true;
+        }
+
+        if (::close(fd_) != 0) failed_ = true;
+        fd_ = -1;
+        fill_ = 0;
+        WriteBufferPool::shared().release(buffer_);
+        buffer_ = nullptr;
+        return !failed_;
+    }
+
+    bool is_open() const override { return fd_ >= 0; }
+
+private:
+    // A partial buffer; O_DIRECT is dropped first if it isn't whole blocks
+    bool flush_tail() {
+        if (direct_active_ && fill_ % WRITE_BUFFER_ALIGNMENT != 0) {
+            int flags = fcntl(fd_, F_GETFL);
+            if (flags < 0 || fcntl(fd_, F_SETFL, flags & ~O_DIRECT) != 0) {
+                failed_ = true;
+                return false;
+            }
+            direct_active_ = false;
+        }
+        return flush();
+    }
+
+    bool flush() {
+        struct iovec iov;
+        iov.iov_base = buffer_;
+        iov.iov_len = fill_;
+        if (!write_all(&iov, 1)) return false;
+        fill_ = 0;
+        return true;
+    }
+
+    // pwritev() at offset_ until every iovec is consumed
+    bool write_all(struct iovec* iov, int count) {
+        while (count > 0) {
+            ssize_t n = pwritev(fd_, iov, count, offset_);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                failed_ = true;
+                return false;
+            }
+            offset_ += n;
+            size_t done = static_cast<size_t>(n);
+            while (count > 0 && done >= iov->iov_len) {
+                done -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+                iov->iov_len -= done;
+            }
+        }
+        return true;
+    }
+
+    // O_DIRECT only while the file offset stays block aligned; filesystems
+    // without support (tmpfs) reject the flag and we stay buffered
+    void update_direct() {
+        direct_active_ = false;
+        if (!direct_ || offset_ % static_cast<int64_t>(WRITE_BUFFER_ALIGNMENT) != 0) return;
+        int flags = fcntl(fd_, F_GETFL);
+        if (flags >= 0 && fcntl(fd_, F_SETFL, flags | O_DIRECT) == 0) {
+            direct_active_ = true;
+        }
+    }
+
+    bool direct_;
+    bool direct_active_ = false;
+    bool failed_ = false;
+    int fd_ = -1;
+    int64_t offset_ = 0;        // File offset of buffer_[0]
+    int64_t preallocated_ = 0;  // End of the fallocate() reservation
+    char* buffer_ = nullptr;
+    size_t fill_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<FileWriter> make_file_writer(WriteMode mode) {
+    switch (mode) {
+        case WriteMode::STREAM:
+            return std::make_unique<StreamFileWriter>();
+        case WriteMode::DIRECT:
+            return std::make_unique<PooledFileWriter>(true);
+        case WriteMode::POOLED:
+        default:
+            return std::make_unique<PooledFileWriter>(false);
+    }
+}
+
+bool parse_write_mode(const std::string& name, WriteMode& mode) {
+    if (name == "stream") mode = WriteMode::STREAM;
+    else if (name == "pooled") mode = WriteMode::POOLED;
+    else if (name == "direct") mode = WriteMode::DIRECT;
+    else return false;
+    return true;
+}
+
+const char* write_mode_name(WriteMode mode) {
+    switch (mode) {
+        case WriteMode::STREAM: return "stream";
+        case WriteMode::DIRECT: return "direct";
+        case WriteMode::POOLED:
+        default: return "pooled";
+    }
+}
+
+} // namespace efgrabber
@@ -23,6 +23,7 @@
 
 #include "browser_widget.h"
 #include <QRegularExpression>
+#include <ctime>
 
 namespace efgrabber {
 
@@ -179,6 +180,28 @@ bool BrowserWidget::hasCookiesFor(const QString& domain) const {
 #endif
 }
 
+std::vector<Cookie> BrowserWidget::exportCookies(const QString& domain) const {
+    std::vector<Cookie> exported;
+#ifdef HAVE_WEBENGINE
+    for (const auto& cookie : cookies_) {
+        QString cookieDomain = cookie.domain();
+        if (!(domain.endsWith(cookieDomain) || cookieDomain.endsWith(domain) ||
+              cookieDomain == "." + domain || domain == cookieDomain.mid(1))) {
+            continue;
+        }
+        // Session cookies get a day, as CookieJar gives a Set-Cookie without expiry
+        time_t expiry = cookie.expirationDate().isValid()
+                      ? static_cast<time_t>(cookie.expirationDate().toSecsSinceEpoch())
+                      : std::time(nullptr) + 86400;
+        exported.emplace_back(cookie.name().toStdString(), cookie.value().toStdString(),
+                              cookieDomain.toStdString(), cookie.isSecure(), expiry);
+    }
+#else
+    Q_UNUSED(domain);
+#endif
+    return exported;
+}
+
 #ifdef HAVE_WEBENGINE
 QWebEngineProfile* BrowserWidget::profile() const {
     return webView_->page()->profile();
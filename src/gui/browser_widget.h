@@ -33,7 +33,9 @@
 #include <QString>
 #include <QMap>
 #include <functional>
+#include <vector>
 #include "efgrabber/common.h"
+#include "efgrabber/cookie.h"
 
 #ifdef HAVE_WEBENGINE
 #include <QWebEngineView>
@@ -66,6 +68,9 @@ public:
     // Check if we have cookies for a domain
     bool hasCookiesFor(const QString& domain) const;
 
+    // Cookies for a domain as CookieJar entries, for handing the session to libcurl
+    std::vector<Cookie> exportCookies(const QString& domain = QString::fromStdString(TARGET_DOMAIN)) const;
+
 #ifdef HAVE_WEBENGINE
     QWebEngineProfile* profile() const;
 #endif
@@ -78,6 +78,16 @@ void MainWindow::loadSettings() {
     cookieFileEdit_->setText(cookiePath);
 
     // Restore thread count
+    int engineIndex = settings.value("download/engineIndex", 0).toInt();
+    if (engineIndex >= 0 && engineIndex < engineCombo_->count()) {
+        engineCombo_->setCurrentIndex(engineIndex);
+    }
+
+    http2Check_->setChecked(settings.value("download/http2", false).toBool());
+    maxStreamsSpin_->setValue(settings.value("download/maxStreams", DEFAULT_MAX_STREAMS_PER_CONNECTION).toInt());
+    adaptiveCheck_->setChecked(settings.value("download/adaptive", false).toBool());
+    adaptiveMinSpin_->setValue(settings.value("download/adaptiveMin", ADAPTIVE_MIN_CONCURRENCY).toInt());
+
     int threadCount = settings.value("download/threadCount", 50).toInt();
     threadCountSpin_->setValue(threadCount);
 
@@ -99,6 +109,7 @@ void MainWindow::loadSettings() {
     // Restore force parallel settings
     forceParallelCheck_->setChecked(settings.value("scraper/forceParallel", false).toBool());
     forceMaxPageSpin_->setValue(settings.value("scraper/forceMaxPage", 500).toInt());
+    curlScrapeCheck_->setChecked(settings.value("scraper/curlHandoff", true).toBool());
 }
 
 void MainWindow::saveSettings() {
@@ -121,6 +132,11 @@ void MainWindow::saveSettings() {
 
     // Save thread count
     settings.setValue("download/threadCount", threadCountSpin_->value());
+    settings.setValue("download/engineIndex", engineCombo_->currentIndex());
+    settings.setValue("download/http2", http2Check_->isChecked());
+    settings.setValue("download/maxStreams", maxStreamsSpin_->value());
+    settings.setValue("download/adaptive", adaptiveCheck_->isChecked());
+    settings.setValue("download/adaptiveMin", adaptiveMinSpin_->value());
 
     // Save overwrite existing setting
     settings.setValue("download/overwriteExisting", overwriteExistingCheck_->isChecked());
@@ -137,6 +153,7 @@ void MainWindow::saveSettings() {
     // Save force parallel settings
     settings.setValue("scraper/forceParallel", forceParallelCheck_->isChecked());
     settings.setValue("scraper/forceMaxPage", forceMaxPageSpin_->value());
+    settings.setValue("scraper/curlHandoff", curlScrapeCheck_->isChecked());
 
     settings.sync();
 }
@@ -168,9 +185,9 @@ MainWindow::MainWindow(QWidget* parent)
     // Connect signals with queued connections for thread safety
     connect(this, &MainWindow::logMessageReceived, this, &MainWindow::appendLog, Qt::QueuedConnection);
     connect(this, &MainWindow::statsReceived, this, &MainWindow::updateStats, Qt::QueuedConnection);
-    connect(this, &MainWindow::pageScraped, this, &MainWindow::handlePageScraped, Qt::QueuedConnection);
     connect(this, &MainWindow::downloadComplete, this, &MainWindow::handleDownloadComplete, Qt::QueuedConnection);
     connect(this, &MainWindow::errorOccurred, this, &MainWindow::handleError, Qt::QueuedConnection);
+    connect(this, &MainWindow::scrapeBlocked, this, &MainWindow::onScrapeBlocked, Qt::QueuedConnection);
 
     // Stats timer - update every 2 seconds to reduce CPU usage
     statsTimer_ = new QTimer(this);
@@ -307,6 +324,12 @@ void MainWindow::setupUi() {
     forceMaxPageSpin_->setValue(500);
     threadLayout->addWidget(forceMaxPageSpin_);
 
+    threadLayout->addSpacing(20);
+    curlScrapeCheck_ = new QCheckBox("Scrape with libcurl");
+    curlScrapeCheck_->setToolTip("Use the browser only to pass the age check and bot challenge, then fetch "
+                                 "index pages with libcurl using its cookies; browser tabs take over if blocked");
+    threadLayout->addWidget(curlScrapeCheck_);
+
     threadLayout->addStretch();
     downloaderLayout->addLayout(threadLayout);
 
@@ -315,6 +338,39 @@ void MainWindow::setupUi() {
     overwriteExistingCheck_ = new QCheckBox("Overwrite existing files");
     overwriteExistingCheck_->setToolTip("Re-download files that already exist on disk");
     optionsLayout->addWidget(overwriteExistingCheck_);
+
+    optionsLayout->addSpacing(20);
+    optionsLayout->addWidget(new QLabel("Engine:"));
+    engineCombo_ = new QComboBox();
+    engineCombo_->addItem("Threads (one per download)", static_cast<int>(DownloadEngine::THREAD_POOL));
+    engineCombo_->addItem("Event loop (curl_multi)", static_cast<int>(DownloadEngine::CURL_MULTI));
+    engineCombo_->setToolTip("Event loop engine drives thousands of downloads from a few threads");
+    connect(engineCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        // The event loop engine is not bound by thread count, so allow far more transfers
+        auto engine = static_cast<DownloadEngine>(engineCombo_->itemData(index).toInt());
+        threadCountSpin_->setMaximum(engine == DownloadEngine::CURL_MULTI ? 10000 : 500);
+    });
+    optionsLayout->addWidget(engineCombo_);
+
+    http2Check_ = new QCheckBox("HTTP/2");
+    http2Check_->setToolTip("Negotiate HTTP/2; the event loop engine multiplexes downloads over few connections");
+    optionsLayout->addWidget(http2Check_);
+    optionsLayout->addWidget(new QLabel("Streams/conn:"));
+    maxStreamsSpin_ = new QSpinBox();
+    maxStreamsSpin_->setRange(1, 1000);
+    maxStreamsSpin_->setValue(DEFAULT_MAX_STREAMS_PER_CONNECTION);
+    maxStreamsSpin_->setToolTip("Maximum HTTP/2 streams multiplexed on one connection");
+    optionsLayout->addWidget(maxStreamsSpin_);
+
+    optionsLayout->addSpacing(20);
+    adaptiveCheck_ = new QCheckBox("Adaptive, min:");
+    adaptiveCheck_->setToolTip("Adjust concurrency between the minimum and Download Threads from "
+                               "goodput, latency and 403/429 responses");
+    optionsLayout->addWidget(adaptiveCheck_);
+    adaptiveMinSpin_ = new QSpinBox();
+    adaptiveMinSpin_->setRange(1, 10000);
+    adaptiveMinSpin_->setValue(ADAPTIVE_MIN_CONCURRENCY);
+    optionsLayout->addWidget(adaptiveMinSpin_);
     optionsLayout->addStretch();
     downloaderLayout->addLayout(optionsLayout);
 
@@ -561,7 +617,7 @@ void MainWindow::onResumeClicked() {
         return;
     }
 
-    downloadManager_->set_max_concurrent_downloads(threadCountSpin_->value());
+    applyManagerOptions();
     downloadManager_->set_overwrite_existing(overwriteExistingCheck_->isChecked());
 
     // Set cookies if available
@@ -597,6 +653,11 @@ void MainWindow::onResumeClicked() {
     stopButton_->setEnabled(true);
     dataSetCombo_->setEnabled(false);
     modeCombo_->setEnabled(false);
+    engineCombo_->setEnabled(false);
+    http2Check_->setEnabled(false);
+    maxStreamsSpin_->setEnabled(false);
+    adaptiveCheck_->setEnabled(false);
+    adaptiveMinSpin_->setEnabled(false);
 
     statsTimer_->start(2000);
 
@@ -624,7 +685,7 @@ void MainWindow::onRetryFailedClicked() {
         return;
     }
 
-    downloadManager_->set_max_concurrent_downloads(threadCountSpin_->value());
+    applyManagerOptions();
 
     // Set cookies if available
     if (browserWidget_->hasCookiesFor(QString::fromStdString(TARGET_DOMAIN))) {
@@ -666,6 +727,11 @@ void MainWindow::onRetryFailedClicked() {
     stopButton_->setEnabled(true);
     dataSetCombo_->setEnabled(false);
     modeCombo_->setEnabled(false);
+    engineCombo_->setEnabled(false);
+    http2Check_->setEnabled(false);
+    maxStreamsSpin_->setEnabled(false);
+    adaptiveCheck_->setEnabled(false);
+    adaptiveMinSpin_->setEnabled(false);
 
     statsTimer_->start(2000);
 
@@ -691,7 +757,7 @@ void MainWindow::onRedownloadAllClicked() {
         return;
     }
 
-    downloadManager_->set_max_concurrent_downloads(threadCountSpin_->value());
+    applyManagerOptions();
     downloadManager_->set_overwrite_existing(overwriteExistingCheck_->isChecked());
 
     // Set cookies if available
@@ -727,6 +793,11 @@ void MainWindow::onRedownloadAllClicked() {
     stopButton_->setEnabled(true);
     dataSetCombo_->setEnabled(false);
     modeCombo_->setEnabled(false);
+    engineCombo_->setEnabled(false);
+    http2Check_->setEnabled(false);
+    maxStreamsSpin_->setEnabled(false);
+    adaptiveCheck_->setEnabled(false);
+    adaptiveMinSpin_->setEnabled(false);
 
     statsTimer_->start(2000);
 
@@ -808,13 +879,32 @@ void MainWindow::onStatsTimer() {
         // Show actual active downloads
         int activeCount = stats.files_in_progress;
         if (activeCount > 0) {
-            activeDownloadsLabel_->setText(QString("(%1 downloading)").arg(activeCount));
+            activeDownloadsLabel_->setText(QString("(%1 of %2 downloading over %3 connections)")
+                .arg(activeCount).arg(stats.concurrency_limit).arg(stats.connections_open));
         } else {
             activeDownloadsLabel_->setText("(idle)");
         }
+        // Why the adaptive limit last moved
+        activeDownloadsLabel_->setToolTip(QString("Concurrency limit %1: %2")
+            .arg(stats.concurrency_limit).arg(QString::fromStdString(stats.concurrency_reason)));
+        if (downloadManager_->get_adaptive_concurrency() &&
+            stats.concurrency_reason != lastConcurrencyReason_) {
+            lastConcurrencyReason_ = stats.concurrency_reason;
+            logNormal(LogChannel::DOWNLOAD, QString("Concurrency limit %1: %2")
+                .arg(stats.concurrency_limit).arg(QString::fromStdString(stats.concurrency_reason)));
+        }
     }
 }
 
+void MainWindow::applyManagerOptions() {
+    downloadManager_->set_max_concurrent_downloads(threadCountSpin_->value());
+    downloadManager_->set_download_engine(
+        static_cast<DownloadEngine>(engineCombo_->currentData().toInt()));
+    downloadManager_->set_http2(http2Check_->isChecked());
+    downloadManager_->set_max_streams_per_connection(maxStreamsSpin_->value());
+    downloadManager_->set_adaptive_concurrency(adaptiveCheck_->isChecked(), adaptiveMinSpin_->value());
+}
+
 void MainWindow::onThreadCountChanged(int value) {
     if (downloadManager_) {
         downloadManager_->set_max_concurrent_downloads(value);
@@ -867,35 +957,27 @@ void MainWindow::startDownload(int dataSet, OperationMode mode) {
     callbacks.on_stats_update = [this](const DownloadStats& stats) {
         emit statsReceived(stats);
     };
-    callbacks.on_page_scraped = [this](int page, int count) {
-        emit pageScraped(page, count);
-    };
     callbacks.on_complete = [this]() {
         emit downloadComplete();
     };
     callbacks.on_error = [this](const std::string& error) {
         emit errorOccurred(QString::fromStdString(error));
     };
-    callbacks.on_file_status_change = [this](const std::string& file_id, DownloadStatus status) {
-        // Only log at verbose level - this could be millions of messages
-        if (logLevel_ != LogLevel::VERBOSE && logLevel_ != LogLevel::DEBUG) return;
-        if (!logDownloadCheck_->isChecked()) return;
-
-        QString statusStr;
-        switch (status) {
-            case DownloadStatus::COMPLETED: statusStr = "completed"; break;
-            case DownloadStatus::FAILED: statusStr = "FAILED"; break;
-            case DownloadStatus::NOT_FOUND: statusStr = "404"; break;
-            default: return;  // Don't log other status changes
-        }
-        appendLog(QString("[DL]  %1: %2").arg(QString::fromStdString(file_id)).arg(statusStr));
-    };
     callbacks.on_worker_state = [this](const std::string& worker_name, bool started) {
         logNormal(LogChannel::SYSTEM, QString("%1 %2")
             .arg(QString::fromStdString(worker_name))
             .arg(started ? "started" : "finished"));
     };
+    callbacks.on_scrape_blocked = [this](int page, const std::string& reason) {
+        // Set here, on the scraper's thread, so the download worker can't finish
+        // the run before onScrapeBlocked hands the pages to the browser
+        downloadManager_->set_external_scraping_active(true);
+        emit scrapeBlocked(page, QString::fromStdString(reason));
+    };
     downloadManager_->set_callbacks(callbacks);
+    // File status changes and scraped pages arrive through the event channel,
+    // drained with the log flush instead of one queued signal per event
+    downloadManager_->set_event_channel(&events_);
 
     DataSetConfig config = get_data_set_config(dataSet);
     config.first_file_id = static_cast<uint64_t>(startIdSpin_->value());
@@ -912,11 +994,24 @@ void MainWindow::startDownload(int dataSet, OperationMode mode) {
     pauseButton_->setEnabled(true);
     dataSetCombo_->setEnabled(false);
     modeCombo_->setEnabled(false);
+    engineCombo_->setEnabled(false);
+    http2Check_->setEnabled(false);
+    maxStreamsSpin_->setEnabled(false);
+    adaptiveCheck_->setEnabled(false);
+    adaptiveMinSpin_->setEnabled(false);
 
     statsTimer_->start(2000);  // Update stats every 2 seconds
 
+    // With the browser past the challenge, libcurl fetches the index pages
+    bool scraping = mode == OperationMode::SCRAPER || mode == OperationMode::HYBRID;
+    if (scraping && curlScrapeCheck_->isChecked() &&
+        browserWidget_->hasCookiesFor(QString::fromStdString(TARGET_DOMAIN))) {
+        startCurlScraping(config, mode);
+        return;
+    }
+
     // Use browser-based scraping for scraper mode
-    if (mode == OperationMode::SCRAPER || mode == OperationMode::HYBRID) {
+    if (scraping) {
         logNormal(LogChannel::SYSTEM, "Using browser-based scraping to bypass Akamai");
         startBrowserScraping(dataSet);
         scraperPauseButton_->setEnabled(true);
@@ -930,25 +1025,59 @@ void MainWindow::startDownload(int dataSet, OperationMode mode) {
 }
 
 void MainWindow::startBrowserScraping(int dataSet) {
-    browserScrapingActive_.store(true);
-    pdfFoundCount_.store(0);
-    seenFileIds_.clear();
-    detectedLastPage_ = -1;
-    detectingMaxPage_ = true;
-    verifyingFirstPage_ = false;
-
     logNormal(LogChannel::SCRAPER, QString("Starting browser-based scraping for Data Set %1").arg(dataSet));
 
     auto config = get_data_set_config(dataSet);
 
     // Set initial thread count and options from UI
-    downloadManager_->set_max_concurrent_downloads(threadCountSpin_->value());
+    applyManagerOptions();
     downloadManager_->set_overwrite_existing(overwriteExistingCheck_->isChecked());
 
     // Tell download manager that external scraping is active
     downloadManager_->set_external_scraping_active(true);
 
     downloadManager_->start_download_only(config);
+    scrapePagesInBrowser(dataSet);
+}
+
+void MainWindow::startCurlScraping(const DataSetConfig& config, OperationMode mode) {
+    applyManagerOptions();
+    downloadManager_->set_overwrite_existing(overwriteExistingCheck_->isChecked());
+
+    // The jar keeps each cookie's domain and expiry, and takes Set-Cookie
+    // updates from the pages libcurl fetches
+    std::vector<Cookie> cookies = browserWidget_->exportCookies();
+    downloadManager_->import_cookies(cookies);
+    logNormal(LogChannel::SCRAPER, QString("Scraping index pages with libcurl using %1 browser cookies")
+        .arg(cookies.size()));
+
+    downloadManager_->start(config, mode);
+    logNormal(LogChannel::SYSTEM, QString("Started downloading %1").arg(QString::fromStdString(config.name)));
+}
+
+void MainWindow::onScrapeBlocked(int page, const QString& reason) {
+    if (!isRunning_.load() || !downloadManager_ || browserScrapingActive_.load()) return;
+
+    logQuiet(LogChannel::SCRAPER, QString("libcurl scraping blocked at page %1 (%2), continuing in the browser")
+        .arg(page).arg(reason));
+
+    // The manager's scraper has stopped; downloads keep running and wait
+    // for the pages the browser tabs scrape
+    downloadManager_->set_external_scraping_active(true);
+    scrapePagesInBrowser(selectedDataSet_);
+    scraperPauseButton_->setEnabled(true);
+    scraperPauseButton_->setText("Pause Scraping");
+}
+
+void MainWindow::scrapePagesInBrowser(int dataSet) {
+    browserScrapingActive_.store(true);
+    pdfFoundCount_.store(0);
+    seenFileIds_.clear();
+    detectedLastPage_ = -1;
+    detectingMaxPage_ = true;
+    verifyingFirstPage_ = false;
+
+    auto config = get_data_set_config(dataSet);
 
     // Check if we already have detected total pages in the database
     auto stats = downloadManager_->get_stats();
@@ -1029,6 +1158,11 @@ void MainWindow::stopDownload() {
     pauseButton_->setText("Pause");
     dataSetCombo_->setEnabled(true);
     modeCombo_->setEnabled(true);
+    engineCombo_->setEnabled(true);
+    http2Check_->setEnabled(true);
+    maxStreamsSpin_->setEnabled(true);
+    adaptiveCheck_->setEnabled(true);
+    adaptiveMinSpin_->setEnabled(true);
     activeDownloadsLabel_->setText("");
     scraperPauseButton_->setEnabled(false);
     scraperPauseButton_->setText("Pause Scraping");
@@ -1130,7 +1264,59 @@ void MainWindow::logDebug(LogChannel channel, const QString& message) {
     log(LogLevel::DEBUG, channel, message);
 }
 
+void MainWindow::drainManagerEvents() {
+    eventBatch_.clear();
+    if (events_.drain(eventBatch_) == 0 && events_.dropped() == reportedEventDrops_) return;
+
+    // File status lines are verbose-only and could be millions of messages
+    bool logFiles = (logLevel_ == LogLevel::VERBOSE || logLevel_ == LogLevel::DEBUG) &&
+                    logDownloadCheck_->isChecked();
+    int pages = 0, pagePdfs = 0, fileLines = 0, filesUnlogged = 0;
+    for (const ManagerEvent& event : eventBatch_) {
+        if (event.kind == ManagerEvent::Kind::PAGE_SCRAPED) {
+            if (++pages <= MAX_EVENT_LINES) {
+                logNormal(LogChannel::SCRAPER, QString("Scraped page %1 (%2 PDFs)")
+                    .arg(event.page).arg(event.count));
+            } else {
+                pagePdfs += event.count;
+            }
+            continue;
+        }
+
+        if (!logFiles) continue;
+        const char* statusStr;
+        switch (event.status) {
+            case DownloadStatus::COMPLETED: statusStr = "completed"; break;
+            case DownloadStatus::FAILED: statusStr = "FAILED"; break;
+            case DownloadStatus::NOT_FOUND: statusStr = "404"; break;
+            default: continue;  // Don't log other status changes
+        }
+        if (++fileLines <= MAX_EVENT_LINES) {
+            appendLog(QString("[DL]  %1: %2").arg(QString::fromLatin1(event.file_id)).arg(statusStr));
+        } else {
+            filesUnlogged++;
+        }
+    }
+
+    if (pages > MAX_EVENT_LINES) {
+        logNormal(LogChannel::SCRAPER, QString("... and %1 more pages (%2 PDFs)")
+            .arg(pages - MAX_EVENT_LINES).arg(pagePdfs));
+    }
+    if (filesUnlogged > 0) {
+        appendLog(QString("[DL]  ... and %1 more files").arg(filesUnlogged));
+    }
+
+    uint64_t dropped = events_.dropped();
+    if (dropped != reportedEventDrops_) {
+        logDebug(LogChannel::DEBUG, QString("Event channel full, %1 events dropped")
+            .arg(dropped - reportedEventDrops_));
+        reportedEventDrops_ = dropped;
+    }
+}
+
 void MainWindow::flushPendingLogs() {
+    drainManagerEvents();
+
     QStringList logs;
     {
         QMutexLocker locker(&logMutex_);
@@ -1195,18 +1381,19 @@ void MainWindow::updateStats(const DownloadStats& stats) {
             .arg(stats.pages_scraped).arg(stats.total_pages).arg(stats.total_files_found));
     }
 
-    // Brute force progress
+    // Brute force progress: IDs probed so far, over several passes
     if (stats.brute_force_end > stats.brute_force_start) {
-        uint64_t range = stats.brute_force_end - stats.brute_force_start;
-        uint64_t done = stats.brute_force_current - stats.brute_force_start;
-        int bfPct = static_cast<int>(100.0 * done / range);
+        uint64_t range = stats.brute_force_end - stats.brute_force_start + 1;
+        int bfPct = static_cast<int>(100.0 * stats.brute_force_probed / range);
         updateProgressBar(bruteForceProgress_, bfPct);
 
-        QString bfText = QString("EFTA%1 - %2% (%3 / %4)")
+        QString bfText = QString("EFTA%1 - %2% (%3 / %4 probed, %5 found, pass %6)")
             .arg(stats.brute_force_current, 8, 10, QChar('0'))
             .arg(bfPct)
-            .arg(done)
-            .arg(range);
+            .arg(stats.brute_force_probed)
+            .arg(range)
+            .arg(stats.brute_force_found)
+            .arg(stats.brute_force_pass + 1);
         updateLabel(bruteForceLabel_, bfText);
     }
 }
@@ -1491,10 +1678,6 @@ void MainWindow::onScrapingComplete() {
     }
 }
 
-void MainWindow::handlePageScraped(int page, int count) {
-    logNormal(LogChannel::SCRAPER, QString("Scraped page %1 (%2 PDFs)").arg(page).arg(count));
-}
-
 void MainWindow::handleDownloadComplete() {
     logQuiet(LogChannel::SYSTEM, "Download complete!");
     stopDownload();
@@ -49,6 +49,7 @@
 #include <atomic>
 
 #include "efgrabber/download_manager.h"
+#include "efgrabber/event_channel.h"
 #include "browser_widget.h"
 #include "scraper_pool.h"
 
@@ -99,19 +100,19 @@ public slots:
 signals:
     void logMessageReceived(const QString& message);
     void statsReceived(const DownloadStats& stats);
-    void pageScraped(int page, int count);
     void downloadComplete();
     void errorOccurred(const QString& error);
+    void scrapeBlocked(int page, const QString& reason);
 
 private slots:
     void appendLog(const QString& message);
     void updateStats(const DownloadStats& stats);
-    void handlePageScraped(int page, int count);
     void handleDownloadComplete();
     void handleError(const QString& error);
     void onBrowserPageReady(const QString& url, const QString& html);
     void onScraperPageReady(int pageNumber, const QString& html);
     void onScrapingComplete();
+    void onScrapeBlocked(int page, const QString& reason);
     void scrapeNextPage();
     void flushPendingLogs();
 
@@ -119,8 +120,13 @@ private:
     void setupUi();
     void startDownload(int dataSet, OperationMode mode);
     void startBrowserScraping(int dataSet);
+    void scrapePagesInBrowser(int dataSet);  // Hand the manager's unscraped pages to browser tabs
+    void drainManagerEvents();  // Log the manager's queued events, coalesced per flush
+    // libcurl scraping with the browser session's cookies (browser tabs only after a block)
+    void startCurlScraping(const DataSetConfig& config, OperationMode mode);
     void stopDownload();
     void pauseDownload();
+    void applyManagerOptions();  // Push UI download options into downloadManager_
     void processBrowserHtml(const QString& html);
     QString formatBytes(int64_t bytes) const;
     QString formatSpeed(double bps) const;
@@ -173,10 +179,18 @@ private:
     QCheckBox* forceParallelCheck_;
     QSpinBox* forceMaxPageSpin_;
 
+    // Fetch index pages with libcurl once the browser holds the session cookies
+    QCheckBox* curlScrapeCheck_;
+
     QLabel* activeDownloadsLabel_;
 
     // Download options
     QCheckBox* overwriteExistingCheck_;
+    QComboBox* engineCombo_;
+    QCheckBox* http2Check_;
+    QSpinBox* maxStreamsSpin_;
+    QCheckBox* adaptiveCheck_;
+    QSpinBox* adaptiveMinSpin_;
 
     // Log verbosity control
     QComboBox* logVerbosityCombo_;
@@ -228,7 +242,10 @@ private:
     QPushButton* pauseButton_;
     QPushButton* stopButton_;
 
-    // Download manager
+    // Download manager. Its workers push file and page events into events_,
+    // which is declared first so it outlives them.
+    EventChannel events_;
+    std::vector<ManagerEvent> eventBatch_;
     std::unique_ptr<DownloadManager> downloadManager_;
 
     // Timers
@@ -257,6 +274,7 @@ private:
     QString lastOverallLabel_;
     QString lastScraperLabel_;
     QString lastBruteForceLabel_;
+    std::string lastConcurrencyReason_;
     int lastOverallProgress_ = -1;
     int lastScraperProgress_ = -1;
     int lastBruteForceProgress_ = -1;
@@ -266,6 +284,8 @@ private:
     QStringList pendingLogs_;
     static constexpr int MAX_LOG_LINES = 500;
     static constexpr int LOG_FLUSH_INTERVAL_MS = 100;
+    static constexpr int MAX_EVENT_LINES = 5;  // Per-flush event lines before a summary
+    uint64_t reportedEventDrops_ = 0;
 };
 
 } // namespace efgrabber
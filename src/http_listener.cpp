@@ -0,0 +1,157 @@
+/*
+ * http_listener.cpp - Minimal HTTP server for the local control endpoints
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/http_listener.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace efgrabber {
+
+namespace {
+
+constexpr size_t MAX_HEADER_BYTES = 65536;
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+HttpListener::HttpListener(Handler handler, int timeout_seconds, size_t max_body)
+    : handler_(std::move(handler)), timeout_seconds_(timeout_seconds), max_body_(max_body) {}
+
+HttpListener::~HttpListener() {
+    stop();
+}
+
+bool HttpListener::start(int port, const std::string& bind_address, int backlog) {
+    if (running_) return true;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1) return false;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, backlog) != 0) {
+        close(fd);
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+    listen_fd_ = fd;
+    running_ = true;
+    thread_ = std::thread(&HttpListener::serve, this);
+    return true;
+}
+
+void HttpListener::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void HttpListener::serve() {
+    while (running_) {
+        // Poll with a timeout so stop() is noticed without closing the socket under us
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        handle_client(client);
+        close(client);
+    }
+}
+
+void HttpListener::handle_client(int fd) {
+    timeval timeout{timeout_seconds_, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string data;
+    char buf[16384];
+    size_t header_end;
+    while ((header_end = data.find("\r\n\r\n")) == std::string::npos) {
+        if (data.size() > MAX_HEADER_BYTES) return;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        data.append(buf, static_cast<size_t>(n));
+    }
+
+    // "METHOD /path?query HTTP/1.1"
+    HttpRequest request;
+    size_t method_end = data.find(' ');
+    size_t target_end = method_end == std::string::npos ? std::string::npos : data.find(' ', method_end + 1);
+    if (target_end == std::string::npos || target_end > header_end) return;
+    request.method = data.substr(0, method_end);
+    request.path = data.substr(method_end + 1, target_end - method_end - 1);
+    request.path = request.path.substr(0, request.path.find('?'));
+
+    // The body, by Content-Length
+    size_t content_length = 0;
+    std::string headers = data.substr(0, header_end);
+    std::transform(headers.begin(), headers.end(), headers.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    size_t field = headers.find("\r\ncontent-length:");
+    if (field != std::string::npos) {
+        content_length = std::strtoull(headers.c_str() + field + 17, nullptr, 10);
+    }
+    if (content_length > max_body_) return;
+    while (data.size() < header_end + 4 + content_length) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        data.append(buf, static_cast<size_t>(n));
+    }
+    request.body = data.substr(header_end + 4, content_length);
+
+    HttpResponse response = handler_(request);
+    send_all(fd, "HTTP/1.1 " + response.status + "\r\nContent-Type: " + response.content_type +
+                 "\r\nContent-Length: " + std::to_string(response.body.size()) +
+                 "\r\nConnection: close\r\n\r\n" + response.body);
+}
+
+} // namespace efgrabber
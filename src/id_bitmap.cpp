@@ -0,0 +1,122 @@
+/*
+ * id_bitmap.cpp - Two-bit probe state for every ID of a brute force range
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/id_bitmap.h"
+#include <algorithm>
+
+namespace efgrabber {
+
+IdBitmap::IdBitmap(uint64_t first, uint64_t last) : first_(first), last_(last) {
+    if (empty()) return;
+    words_.assign(static_cast<size_t>((size() + IDS_PER_WORD - 1) / IDS_PER_WORD), 0);
+    counts_[static_cast<int>(IdState::UNKNOWN)] = size();
+}
+
+IdState IdBitmap::get(uint64_t id) const {
+    if (!contains(id)) return IdState::UNKNOWN;
+    uint64_t index = id - first_;
+    uint64_t word = words_[index / IDS_PER_WORD];
+    return static_cast<IdState>((word >> ((index % IDS_PER_WORD) * 2)) & 3);
+}
+
+void IdBitmap::set(uint64_t id, IdState state) {
+    if (!contains(id)) return;
+    uint64_t index = id - first_;
+    uint64_t& word = words_[index / IDS_PER_WORD];
+    int shift = static_cast<int>((index % IDS_PER_WORD) * 2);
+    auto old_state = static_cast<IdState>((word >> shift) & 3);
+    if (old_state == state) return;
+
+    word = (word & ~(uint64_t{3} << shift)) | (static_cast<uint64_t>(state) << shift);
+    counts_[static_cast<int>(old_state)]--;
+    counts_[static_cast<int>(state)]++;
+}
+
+uint64_t IdBitmap::count(IdState state) const {
+    return counts_[static_cast<int>(state)];
+}
+
+uint64_t IdBitmap::next_unknown(uint64_t from) const {
+    if (from < first_) from = first_;
+    uint64_t index = from - first_;
+    while (index < size()) {
+        uint64_t word = words_[index / IDS_PER_WORD] >> ((index % IDS_PER_WORD) * 2);
+        // Skip words that hold no UNKNOWN slot (both bits clear) from here on
+        uint64_t in_word = IDS_PER_WORD - index % IDS_PER_WORD;
+        uint64_t unknown = ~(word | (word >> 1)) & 0x5555555555555555ULL;
+        if (in_word < IDS_PER_WORD) unknown &= (uint64_t{1} << (in_word * 2)) - 1;
+        if (unknown) {
+            uint64_t found = index + static_cast<uint64_t>(__builtin_ctzll(unknown) / 2);
+            return found < size() ? first_ + found : last_ + 1;
+        }
+        index += in_word;
+    }
+    return last_ + 1;
+}
+
+std::string IdBitmap::serialize() const {
+    std::string bytes;
+    bytes.reserve(words_.size() * 8);
+    for (uint64_t word : words_) {
+        for (int i = 0; i < 8; ++i) {
+            bytes.push_back(static_cast<char>((word >> (i * 8)) & 0xff));
+        }
+    }
+    return bytes;
+}
+
+std::optional<IdBitmap> IdBitmap::deserialize(uint64_t first, uint64_t last, const std::string& bytes) {
+    IdBitmap bitmap(first, last);
+    if (bytes.size() != bitmap.words_.size() * 8) return std::nullopt;
+
+    for (size_t w = 0; w < bitmap.words_.size(); ++w) {
+        uint64_t word = 0;
+        for (int i = 0; i < 8; ++i) {
+            word |= static_cast<uint64_t>(static_cast<unsigned char>(bytes[w * 8 + i])) << (i * 8);
+        }
+        bitmap.words_[w] = word;
+    }
+
+    // Recount, treating the unused slots of the last word as padding
+    std::fill(std::begin(bitmap.counts_), std::end(bitmap.counts_), 0);
+    for (uint64_t index = 0; index < bitmap.size(); ++index) {
+        auto state = static_cast<IdState>((bitmap.words_[index / IDS_PER_WORD] >>
+                                           ((index % IDS_PER_WORD) * 2)) & 3);
+        if (state > IdState::PRESENT) return std::nullopt;
+        bitmap.counts_[static_cast<int>(state)]++;
+    }
+    return bitmap;
+}
+
+IdBitmap IdBitmap::rebased(uint64_t first, uint64_t last) const {
+    IdBitmap bitmap(first, last);
+    uint64_t from = std::max(first, first_);
+    uint64_t to = std::min(last, last_);
+    for (uint64_t id = from; id <= to && from <= to; ++id) {
+        IdState state = get(id);
+        if (state != IdState::UNKNOWN) bitmap.set(id, state);
+    }
+    return bitmap;
+}
+
+} // namespace efgrabber
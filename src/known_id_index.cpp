@@ -0,0 +1,157 @@
+/*
+ * known_id_index.cpp - In-memory set of the file IDs already in the database
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/known_id_index.h"
+#include "efgrabber/database.h"
+
+namespace efgrabber {
+
+namespace {
+
+constexpr char CANONICAL_PREFIX[] = "EFTA";
+constexpr size_t CANONICAL_PREFIX_LENGTH = sizeof(CANONICAL_PREFIX) - 1;
+constexpr size_t CANONICAL_DIGITS = 8;
+
+// The number of a canonical ID, or false for anything else
+bool canonical_number(const std::string& file_id, uint64_t& number) {
+    if (file_id.size() != CANONICAL_PREFIX_LENGTH + CANONICAL_DIGITS ||
+        file_id.compare(0, CANONICAL_PREFIX_LENGTH, CANONICAL_PREFIX) != 0) {
+        return false;
+    }
+    number = 0;
+    for (size_t i = CANONICAL_PREFIX_LENGTH; i < file_id.size(); ++i) {
+        char c = file_id[i];
+        if (c < '0' || c > '9') return false;
+        number = number * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+bool KnownIdIndex::load(Database& db) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_sets_.clear();
+    return db.for_each_file([this](int data_set, const std::string& file_id) {
+        insert_locked(data_set, file_id);
+    });
+}
+
+bool KnownIdIndex::insert(int data_set, const std::string& file_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return insert_locked(data_set, file_id);
+}
+
+bool KnownIdIndex::contains(int data_set, const std::string& file_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto ds = data_sets_.find(data_set);
+    if (ds == data_sets_.end()) return false;
+
+    uint64_t number;
+    if (!canonical_number(file_id, number)) {
+        return ds->second.others.count(file_id) != 0;
+    }
+    auto chunk = ds->second.chunks.find(number / CHUNK_IDS);
+    if (chunk == ds->second.chunks.end()) return false;
+    uint64_t bit = number % CHUNK_IDS;
+    return ((*chunk->second)[bit / 64] >> (bit % 64)) & 1;
+}
+
+void KnownIdIndex::erase(int data_set, const std::string& file_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    erase_locked(data_set, file_id);
+}
+
+size_t KnownIdIndex::insert_new(std::vector<FileRecord>& records) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t kept = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!insert_locked(records[i].data_set, records[i].file_id)) continue;
+        if (kept != i) records[kept] = std::move(records[i]);
+        kept++;
+    }
+    size_t dropped = records.size() - kept;
+    records.resize(kept);
+    return dropped;
+}
+
+void KnownIdIndex::erase(const std::vector<FileRecord>& records) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& record : records) {
+        erase_locked(record.data_set, record.file_id);
+    }
+}
+
+void KnownIdIndex::clear(int data_set) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_sets_.erase(data_set);
+}
+
+size_t KnownIdIndex::size(int data_set) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto ds = data_sets_.find(data_set);
+    return ds == data_sets_.end() ? 0 : ds->second.count;
+}
+
+bool KnownIdIndex::insert_locked(int data_set, const std::string& file_id) {
+    DataSetIds& ds = data_sets_[data_set];
+
+    uint64_t number;
+    if (!canonical_number(file_id, number)) {
+        if (!ds.others.insert(file_id).second) return false;
+        ds.count++;
+        return true;
+    }
+
+    auto& chunk = ds.chunks[number / CHUNK_IDS];
+    if (!chunk) chunk = std::make_unique<Chunk>(Chunk{});
+    uint64_t bit = number % CHUNK_IDS;
+    uint64_t& word = (*chunk)[bit / 64];
+    uint64_t mask = uint64_t{1} << (bit % 64);
+    if (word & mask) return false;
+    word |= mask;
+    ds.count++;
+    return true;
+}
+
+void KnownIdIndex::erase_locked(int data_set, const std::string& file_id) {
+    auto ds = data_sets_.find(data_set);
+    if (ds == data_sets_.end()) return;
+
+    uint64_t number;
+    if (!canonical_number(file_id, number)) {
+        if (ds->second.others.erase(file_id)) ds->second.count--;
+        return;
+    }
+    auto chunk = ds->second.chunks.find(number / CHUNK_IDS);
+    if (chunk == ds->second.chunks.end()) return;
+    uint64_t bit = number % CHUNK_IDS;
+    uint64_t& word = (*chunk->second)[bit / 64];
+    uint64_t mask = uint64_t{1} << (bit % 64);
+    if (word & mask) {
+        word &= ~mask;
+        ds->second.count--;
+    }
+}
+
+} // namespace efgrabber
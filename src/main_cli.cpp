@@ -29,15 +29,44 @@
 #include <chrono>
 #include <iomanip>
 #include <mutex>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <vector>
 #include <getopt.h>
+#include <unistd.h>
 
 #include "efgrabber/common.h"
 #include "efgrabber/download_manager.h"
+#include "efgrabber/metrics.h"
+#include "efgrabber/pack_store.h"
+#include "efgrabber/shard.h"
 
 using namespace efgrabber;
 
 static std::atomic<bool> g_interrupted{false};
 
+// Long-only option codes (outside the range of short option characters)
+enum LongOnlyOption {
+    OPT_ENGINE = 256,
+    OPT_HTTP2,
+    OPT_MAX_STREAMS,
+    OPT_RECONCILE,
+    OPT_SEGMENTS,
+    OPT_SEGMENT_THRESHOLD,
+    OPT_WRITE_MODE,
+    OPT_ADAPTIVE,
+    OPT_METRICS_PORT,
+    OPT_JSON_STATS,
+    OPT_DISK_CHECK,
+    OPT_STORAGE,
+    OPT_PACK_SIZE,
+    OPT_NO_PDF_CHECK,
+    OPT_DEDUP,
+    OPT_COORDINATOR,
+    OPT_WORKER,
+};
+
 void signal_handler(int signal) {
     if (signal == SIGINT || signal == SIGTERM) {
         std::cout << "\n[!] Interrupt received, stopping gracefully...\n";
@@ -46,21 +75,137 @@ void signal_handler(int signal) {
 }
 
 void print_usage(const char* program) {
-    std::cout << "Usage: " << program << " [OPTIONS]\n\n";
+    std::cout << "Usage: " << program << " [OPTIONS]\n";
+    std::cout << "       " << program << " pack list PACK...\n";
+    std::cout << "       " << program << " pack extract PACK [DIR]\n\n";
     std::cout << "Options:\n";
-    std::cout << "  -d, --data-set N     Data set number to download (1-12, default: 11)\n";
-    std::cout << "  -m, --mode MODE      Download mode: scraper, brute, hybrid (default: scraper)\n";
+    std::cout << "  -d, --data-set LIST  Data set(s) to download (1-12, default: 11). Several, as in\n"
+              << "                       1,2,9:3, run at once; N:W gives set N weight W (default 1)\n"
+              << "                       in the share of download slots\n";
+    std::cout << "  -m, --mode MODE      Download mode: scraper, brute, hybrid, refresh (default: scraper)\n";
     std::cout << "  -o, --output DIR     Output directory (default: downloads)\n";
     std::cout << "  -k, --cookies FILE   Netscape cookie file for authentication\n";
     std::cout << "  -c, --concurrent N   Max concurrent downloads (default: 1000)\n";
     std::cout << "  -r, --retries N      Max retry attempts (default: 3)\n";
     std::cout << "  -s, --start ID       Brute force start ID (overrides default)\n";
     std::cout << "  -e, --end ID         Brute force end ID (overrides default)\n";
+    std::cout << "      --engine ENGINE  Download engine: threads, multi (default: threads)\n";
+    std::cout << "      --http2          Use HTTP/2; multiplexes transfers with --engine multi\n";
+    std::cout << "      --max-streams N  HTTP/2 streams per connection (default: "
+              << DEFAULT_MAX_STREAMS_PER_CONNECTION << ")\n";
+    std::cout << "      --segments N     Parallel ranges per large file, threads engine (default: "
+              << DEFAULT_SEGMENTS_PER_FILE << ", 1 disables)\n";
+    std::cout << "      --segment-threshold MB  Split files larger than this (default: "
+              << (DEFAULT_SEGMENT_THRESHOLD >> 20) << ")\n";
+    std::cout << "      --write-mode MODE  Disk writes: pooled, direct (O_DIRECT), stream (default: pooled)\n";
+    std::cout << "      --disk-check MODE  Find files already on disk: stat (each file), scan (walk the\n"
+              << "                       output directory once at start), trust (database only;\n"
+              << "                       default: stat)\n";
+    std::cout << "      --storage MODE   Keep downloads as files, or append them to pack files (default: files)\n";
+    std::cout << "      --pack-size GB   Start a new pack file past this size (default: "
+              << (PACK_FILE_BYTES >> 30) << ")\n";
+    std::cout << "      --no-pdf-check   Keep downloads that don't start with a %PDF- header\n";
+    std::cout << "      --dedup          Hard-link downloads identical to an earlier file (by SHA-256)\n";
+    std::cout << "      --adaptive MIN:MAX  Adjust concurrency between MIN and MAX from goodput,\n"
+              << "                       latency and 403/429 rate (replaces -c)\n";
+    std::cout << "      --metrics-port [ADDR:]PORT  Serve Prometheus metrics on /metrics\n"
+              << "                       (default address: 127.0.0.1)\n";
+    std::cout << "      --json-stats FILE  Append a JSON stats line every 5 seconds (- for stdout)\n";
+    std::cout << "      --coordinator [ADDR:]PORT  Hand out this run's pages and IDs to --worker\n"
+              << "                       nodes instead of downloading (default address: 127.0.0.1)\n";
+    std::cout << "      --worker HOST:PORT  Work leases from a coordinator; -d, -m, -s and -e\n"
+              << "                       come from the coordinator\n";
+    std::cout << "      --reconcile      Recount the data set's statistics from the database and exit\n";
     std::cout << "  -h, --help           Show this help message\n";
     std::cout << "\nExamples:\n";
     std::cout << "  " << program << " -d 11 -m scraper -k cookies.txt\n";
     std::cout << "  " << program << " -d 9 -m hybrid -c 500\n";
+    std::cout << "  " << program << " -d 1,2,3,4,5,6,7,8,9:4,10,11:4,12 -c 1000\n";
     std::cout << "  " << program << " -d 11 -m brute -s 2205655 -e 2730262\n";
+    std::cout << "  " << program << " -d 10 -c 2000 --engine multi\n";
+    std::cout << "  " << program << " -d 10 -c 2000 --engine multi --http2 --max-streams 64\n";
+    std::cout << "  " << program << " -d 9 --storage pack\n";
+    std::cout << "  " << program << " -d 9 -m hybrid --coordinator 0.0.0.0:8790\n";
+    std::cout << "  " << program << " --worker coordinator.example:8790 -c 200\n";
+    std::cout << "  " << program << " pack extract downloads/packs/DataSet9-00000.tar downloads\n";
+}
+
+// A member name that stays inside the extraction directory
+bool safe_member_name(const std::string& name) {
+    if (name.empty() || name[0] == '/') return false;
+    for (const auto& part : std::filesystem::path(name)) {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
+// efgrabber-cli pack list|extract: read pack files written by --storage pack.
+// They are plain tar archives, so tar(1) works on them too.
+int run_pack_command(int argc, char** argv, const char* program) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "list" && argc > 2) {
+        bool ok = true;
+        for (int i = 2; i < argc; ++i) {
+            std::vector<PackMember> members;
+            if (!read_pack_index(argv[i], members)) {
+                std::cerr << "Error: " << argv[i] << " is unreadable or corrupt past "
+                          << members.size() << " members\n";
+                ok = false;
+            }
+            for (const auto& member : members) {
+                std::cout << std::setw(14) << member.offset << " " << std::setw(12) << member.size
+                          << " " << member.name << "\n";
+            }
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (command == "extract" && (argc == 3 || argc == 4)) {
+        std::string pack = argv[2];
+        std::string dir = argc == 4 ? argv[3] : ".";
+        std::vector<PackMember> members;
+        bool ok = read_pack_index(pack, members);
+        if (!ok) {
+            std::cerr << "Error: " << pack << " is unreadable or corrupt past "
+                      << members.size() << " members\n";
+        }
+        size_t extracted = 0;
+        for (const auto& member : members) {
+            if (!safe_member_name(member.name)) {
+                std::cerr << "Skipping unsafe member name " << member.name << "\n";
+                continue;
+            }
+            if (!extract_pack_member(pack, member, dir + "/" + member.name)) {
+                std::cerr << "Error: failed to extract " << member.name << "\n";
+                ok = false;
+                continue;
+            }
+            extracted++;
+        }
+        std::cout << "[+] Extracted " << extracted << " files to " << dir << "\n";
+        return ok ? 0 : 1;
+    }
+
+    print_usage(program);
+    return 1;
+}
+
+// -d argument: comma-separated data set numbers, each optionally :WEIGHT
+bool parse_data_sets(const std::string& arg, std::vector<std::pair<int, int>>& data_sets) {
+    data_sets.clear();
+    std::stringstream list(arg);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t colon = item.find(':');
+        int id = std::stoi(item.substr(0, colon));
+        int weight = colon == std::string::npos ? 1 : std::stoi(item.substr(colon + 1));
+        if (id < MIN_DATA_SET || id > MAX_DATA_SET || weight < 1) return false;
+        for (const auto& [existing, w] : data_sets) {
+            if (existing == id) return false;
+        }
+        data_sets.emplace_back(id, weight);
+    }
+    return !data_sets.empty();
 }
 
 std::string format_bytes(int64_t bytes) {
@@ -78,9 +223,100 @@ std::string format_bytes(int64_t bytes) {
     return oss.str();
 }
 
+// --coordinator: lease out the jobs until every page and ID is done
+int run_shard_coordinator(const std::vector<DataSetJob>& jobs, const std::string& db_path,
+                          const std::string& output_dir, const std::string& address, int port) {
+    Database db(db_path);
+    if (!db.initialize()) {
+        std::cerr << "Failed to open " << db_path << "\n";
+        return 1;
+    }
+
+    ShardCoordinator coordinator(db, jobs, output_dir);
+    coordinator.load();
+    if (!coordinator.start(port, address)) {
+        std::cerr << "Failed to listen for workers on " << address << ":" << port << "\n";
+        return 1;
+    }
+    std::cout << "Coordinating on " << address << ":" << coordinator.port()
+              << "; start workers with --worker HOST:" << coordinator.port() << "\n";
+
+    auto print_stats = [&]() {
+        int64_t completed = 0, not_found = 0, pending = 0, pages = 0, total_pages = 0;
+        for (const auto& job : jobs) {
+            DownloadStats stats = db.get_stats(job.config.id);
+            completed += stats.files_completed;
+            not_found += stats.files_not_found;
+            pending += stats.files_pending + stats.files_failed;
+            pages += stats.pages_scraped;
+            total_pages += stats.total_pages;
+        }
+        std::cout << "\r[Shard] Workers: " << coordinator.workers_seen() << " | "
+                  << "Leases: " << coordinator.active_leases() << " | "
+                  << "Reassigned: " << coordinator.leases_reassigned() << " | "
+                  << "Pages: " << pages << "/" << total_pages << " | "
+                  << "Completed: " << completed << " | "
+                  << "404: " << not_found << " | "
+                  << "Not fetched: " << pending << "          " << std::flush;
+    };
+
+    auto last_print = std::chrono::steady_clock::now();
+    while (!coordinator.finished() && !g_interrupted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_print >= std::chrono::seconds(5)) {
+            print_stats();
+            last_print = now;
+        }
+    }
+    coordinator.stop();
+    print_stats();
+
+    std::cout << "\n\n" << (g_interrupted ? "[!] Interrupted" : "[+] Every lease is done") << "\n";
+    for (const auto& job : jobs) {
+        DownloadStats stats = db.get_stats(job.config.id);
+        std::cout << "  " << job.config.name << ": " << stats.files_completed << " completed, "
+                  << stats.files_not_found << " not found, "
+                  << stats.files_pending + stats.files_failed << " found but not fetched\n";
+    }
+    return 0;
+}
+
+// --worker: run leases from the coordinator at coordinator (HOST:PORT)
+int run_shard_worker(const std::string& coordinator, const std::string& output_dir,
+                     const ShardWorker::Configure& configure) {
+    char host[256] = "worker";
+    gethostname(host, sizeof(host) - 1);
+    std::string name = std::string(host) + ":" + std::to_string(getpid());
+
+    std::cout << "=== Epstein Files Grabber ===\n";
+    std::cout << "Worker " << name << " of " << coordinator << "\n";
+    std::cout << "Output: " << output_dir << "\n\n";
+
+    ShardWorker worker(coordinator, output_dir, name, configure);
+    worker.set_on_lease_done([](const ShardLease& lease, const DownloadStats& stats, bool completed) {
+        std::cout << "[Lease " << lease.id << "] Data Set " << lease.data_set << " "
+                  << (lease.kind == ShardLease::Kind::PAGES ? "pages " : "IDs ")
+                  << lease.first << "-" << lease.last << ": " << stats.files_completed << " completed, "
+                  << stats.files_not_found << " not found, " << stats.files_failed << " failed"
+                  << (completed ? "" : " (not reported)") << "\n";
+    });
+    int leases = worker.run(g_interrupted);
+
+    if (worker.blocked()) {
+        std::cout << "[!] Scraping was blocked from this address; stopping so other workers take over\n";
+    }
+    std::cout << "[+] " << leases << " leases done\n";
+    return 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "pack") {
+        return run_pack_command(argc - 1, argv + 1, argv[0]);
+    }
+
     // Default options
-    int data_set = 11;
+    std::vector<std::pair<int, int>> data_sets{{11, 1}};  // Data set, weight
     std::string mode_str = "scraper";
     std::string output_dir = "downloads";
     std::string cookie_file;
@@ -88,6 +324,26 @@ int main(int argc, char** argv) {
     int max_retries = 3;
     uint64_t brute_start = 0;
     uint64_t brute_end = 0;
+    std::string engine_str = "threads";
+    bool http2 = false;
+    int max_streams = DEFAULT_MAX_STREAMS_PER_CONNECTION;
+    bool reconcile = false;
+    int segments = DEFAULT_SEGMENTS_PER_FILE;
+    int64_t segment_threshold_mb = DEFAULT_SEGMENT_THRESHOLD >> 20;
+    WriteMode write_mode = WriteMode::POOLED;
+    DiskCheck disk_check = DiskCheck::STAT;
+    StorageMode storage = StorageMode::FILES;
+    int64_t pack_size_gb = PACK_FILE_BYTES >> 30;
+    bool require_pdf = true;
+    bool dedup = false;
+    bool adaptive = false;
+    int adaptive_min = ADAPTIVE_MIN_CONCURRENCY;
+    std::string metrics_address = "127.0.0.1";
+    int metrics_port = 0;
+    std::string json_stats_path;
+    std::string coordinator_address = "127.0.0.1";
+    int coordinator_port = 0;
+    std::string worker_of;
 
     // Parse command line options
     static struct option long_options[] = {
@@ -99,6 +355,23 @@ int main(int argc, char** argv) {
         {"retries", required_argument, nullptr, 'r'},
         {"start", required_argument, nullptr, 's'},
         {"end", required_argument, nullptr, 'e'},
+        {"engine", required_argument, nullptr, OPT_ENGINE},
+        {"http2", no_argument, nullptr, OPT_HTTP2},
+        {"max-streams", required_argument, nullptr, OPT_MAX_STREAMS},
+        {"reconcile", no_argument, nullptr, OPT_RECONCILE},
+        {"segments", required_argument, nullptr, OPT_SEGMENTS},
+        {"segment-threshold", required_argument, nullptr, OPT_SEGMENT_THRESHOLD},
+        {"write-mode", required_argument, nullptr, OPT_WRITE_MODE},
+        {"adaptive", required_argument, nullptr, OPT_ADAPTIVE},
+        {"metrics-port", required_argument, nullptr, OPT_METRICS_PORT},
+        {"json-stats", required_argument, nullptr, OPT_JSON_STATS},
+        {"disk-check", required_argument, nullptr, OPT_DISK_CHECK},
+        {"storage", required_argument, nullptr, OPT_STORAGE},
+        {"pack-size", required_argument, nullptr, OPT_PACK_SIZE},
+        {"no-pdf-check", no_argument, nullptr, OPT_NO_PDF_CHECK},
+        {"dedup", no_argument, nullptr, OPT_DEDUP},
+        {"coordinator", required_argument, nullptr, OPT_COORDINATOR},
+        {"worker", required_argument, nullptr, OPT_WORKER},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0}
     };
@@ -108,10 +381,9 @@ int main(int argc, char** argv) {
         try {
             switch (opt) {
                 case 'd':
-                    data_set = std::stoi(optarg);
-                    if (data_set < MIN_DATA_SET || data_set > MAX_DATA_SET) {
-                        std::cerr << "Error: Data set must be between " << MIN_DATA_SET
-                                  << " and " << MAX_DATA_SET << "\n";
+                    if (!parse_data_sets(optarg, data_sets)) {
+                        std::cerr << "Error: Data sets must be between " << MIN_DATA_SET
+                                  << " and " << MAX_DATA_SET << ", each listed once, weights 1 or more\n";
                         return 1;
                     }
                     break;
@@ -140,6 +412,121 @@ int main(int argc, char** argv) {
                 case 'e':
                     brute_end = std::stoull(optarg);
                     break;
+                case OPT_ENGINE:
+                    engine_str = optarg;
+                    break;
+                case OPT_HTTP2:
+                    http2 = true;
+                    break;
+                case OPT_MAX_STREAMS:
+                    max_streams = std::stoi(optarg);
+                    if (max_streams < 1 || max_streams > 1000) {
+                        std::cerr << "Error: Max streams must be between 1 and 1000\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_RECONCILE:
+                    reconcile = true;
+                    break;
+                case OPT_SEGMENTS:
+                    segments = std::stoi(optarg);
+                    if (segments < 1 || segments > MAX_SEGMENTS_PER_FILE) {
+                        std::cerr << "Error: Segments must be between 1 and " << MAX_SEGMENTS_PER_FILE << "\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_SEGMENT_THRESHOLD:
+                    segment_threshold_mb = std::stoll(optarg);
+                    if (segment_threshold_mb < (MIN_SEGMENT_BYTES >> 20)) {
+                        std::cerr << "Error: Segment threshold must be at least "
+                                  << (MIN_SEGMENT_BYTES >> 20) << " MB\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_WRITE_MODE:
+                    if (!parse_write_mode(optarg, write_mode)) {
+                        std::cerr << "Error: Write mode must be 'pooled', 'direct' or 'stream'\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_DISK_CHECK:
+                    if (!parse_disk_check(optarg, disk_check)) {
+                        std::cerr << "Error: Disk check must be 'stat', 'scan' or 'trust'\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_STORAGE:
+                    if (!parse_storage_mode(optarg, storage)) {
+                        std::cerr << "Error: Storage must be 'files' or 'pack'\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_PACK_SIZE:
+                    pack_size_gb = std::stoll(optarg);
+                    if (pack_size_gb < 1 || pack_size_gb > 1024) {
+                        std::cerr << "Error: Pack size must be between 1 and 1024 GB\n";
+                        return 1;
+                    }
+                    break;
+                case OPT_NO_PDF_CHECK:
+                    require_pdf = false;
+                    break;
+                case OPT_DEDUP:
+                    dedup = true;
+                    break;
+                case OPT_ADAPTIVE: {
+                    std::string bounds = optarg;
+                    size_t colon = bounds.find(':');
+                    if (colon == std::string::npos) {
+                        std::cerr << "Error: --adaptive takes MIN:MAX\n";
+                        return 1;
+                    }
+                    adaptive_min = std::stoi(bounds.substr(0, colon));
+                    max_concurrent = std::stoi(bounds.substr(colon + 1));
+                    if (adaptive_min < 1 || max_concurrent < adaptive_min || max_concurrent > 10000) {
+                        std::cerr << "Error: --adaptive needs 1 <= MIN <= MAX <= 10000\n";
+                        return 1;
+                    }
+                    adaptive = true;
+                    break;
+                }
+                case OPT_METRICS_PORT: {
+                    std::string endpoint = optarg;
+                    size_t colon = endpoint.rfind(':');
+                    if (colon != std::string::npos) {
+                        metrics_address = endpoint.substr(0, colon);
+                        endpoint = endpoint.substr(colon + 1);
+                    }
+                    metrics_port = std::stoi(endpoint);
+                    if (metrics_port < 1 || metrics_port > 65535) {
+                        std::cerr << "Error: Metrics port must be between 1 and 65535\n";
+                        return 1;
+                    }
+                    break;
+                }
+                case OPT_JSON_STATS:
+                    json_stats_path = optarg;
+                    break;
+                case OPT_COORDINATOR: {
+                    std::string endpoint = optarg;
+                    size_t colon = endpoint.rfind(':');
+                    if (colon != std::string::npos) {
+                        coordinator_address = endpoint.substr(0, colon);
+                        endpoint = endpoint.substr(colon + 1);
+                    }
+                    coordinator_port = std::stoi(endpoint);
+                    if (coordinator_port < 1 || coordinator_port > 65535) {
+                        std::cerr << "Error: Coordinator port must be between 1 and 65535\n";
+                        return 1;
+                    }
+                    break;
+                }
+                case OPT_WORKER:
+                    worker_of = optarg;
+                    if (worker_of.find(':') == std::string::npos) {
+                        worker_of += ":" + std::to_string(SHARD_DEFAULT_PORT);
+                    }
+                    break;
                 case 'h':
                     print_usage(argv[0]);
                     return 0;
@@ -161,8 +548,21 @@ int main(int argc, char** argv) {
         mode = OperationMode::BRUTE_FORCE;
     } else if (mode_str == "hybrid" || mode_str == "h") {
         mode = OperationMode::HYBRID;
+    } else if (mode_str == "refresh" || mode_str == "r") {
+        mode = OperationMode::REFRESH;
+    } else {
+        std::cerr << "Error: Invalid mode '" << mode_str << "'. Use: scraper, brute, hybrid, or refresh\n";
+        return 1;
+    }
+
+    // Parse download engine
+    DownloadEngine engine;
+    if (engine_str == "threads" || engine_str == "t") {
+        engine = DownloadEngine::THREAD_POOL;
+    } else if (engine_str == "multi" || engine_str == "m") {
+        engine = DownloadEngine::CURL_MULTI;
     } else {
-        std::cerr << "Error: Invalid mode '" << mode_str << "'. Use: scraper, brute, or hybrid\n";
+        std::cerr << "Error: Invalid engine '" << engine_str << "'. Use: threads or multi\n";
         return 1;
     }
 
@@ -170,8 +570,40 @@ int main(int argc, char** argv) {
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
-    // Get data set config with known ID ranges
-    DataSetConfig config = get_data_set_config(data_set);
+    // Settings of every download manager this process runs, a worker's included
+    auto configure = [&](DownloadManager& manager) {
+        manager.set_max_concurrent_downloads(max_concurrent);
+        manager.set_retry_attempts(max_retries);
+        manager.set_download_engine(engine);
+        manager.set_http2(http2);
+        manager.set_max_streams_per_connection(max_streams);
+        manager.set_segmented_downloads(segments, segment_threshold_mb << 20);
+        manager.set_write_mode(write_mode);
+        manager.set_disk_check(disk_check);
+        manager.set_storage(storage, pack_size_gb << 30);
+        manager.set_require_pdf(require_pdf);
+        manager.set_dedup(dedup);
+        manager.set_adaptive_concurrency(adaptive, adaptive_min);
+        if (!cookie_file.empty()) {
+            manager.set_cookie_file(cookie_file);
+        }
+    };
+
+    if (!worker_of.empty()) {
+        return run_shard_worker(worker_of, output_dir, configure);
+    }
+
+    if ((brute_start > 0 || brute_end > 0) && data_sets.size() > 1) {
+        std::cerr << "Error: --start and --end apply to a single data set\n";
+        return 1;
+    }
+
+    // Get data set configs with known ID ranges
+    std::vector<DataSetJob> jobs;
+    for (const auto& [id, weight] : data_sets) {
+        jobs.push_back(DataSetJob{get_data_set_config(id), mode, weight});
+    }
+    DataSetConfig& config = jobs.front().config;
 
     // Override brute force range if specified on command line
     if (brute_start > 0) {
@@ -182,19 +614,47 @@ int main(int argc, char** argv) {
     }
 
     std::cout << "=== Epstein Files Grabber ===\n";
-    std::cout << "Data Set: " << config.name << "\n";
+    if (jobs.size() == 1) {
+        std::cout << "Data Set: " << config.name << "\n";
+    } else {
+        std::cout << "Data Sets:";
+        for (const auto& job : jobs) {
+            std::cout << " " << job.config.id;
+            if (job.weight != 1) std::cout << " (weight " << job.weight << ")";
+        }
+        std::cout << "\n";
+    }
     std::cout << "Mode: " << mode_str << "\n";
     std::cout << "Output: " << output_dir << "\n";
-    std::cout << "Max Concurrent: " << max_concurrent << "\n";
-    if (mode != OperationMode::SCRAPER && config.first_file_id > 0 && config.last_file_id > 0) {
+    if (adaptive) {
+        std::cout << "Concurrency: adaptive, " << adaptive_min << " to " << max_concurrent << "\n";
+    } else {
+        std::cout << "Max Concurrent: " << max_concurrent << "\n";
+    }
+    std::cout << "Engine: " << engine_str << "\n";
+    if (storage == StorageMode::PACK) {
+        std::cout << "Storage: pack files of up to " << pack_size_gb << " GB in " << output_dir << "/packs\n";
+    }
+    if (http2) {
+        std::cout << "HTTP/2: on (" << max_streams << " streams per connection)\n";
+        if (engine != DownloadEngine::CURL_MULTI) {
+            std::cout << "Note: transfers are only multiplexed with --engine multi\n";
+        }
+    }
+    if ((mode == OperationMode::BRUTE_FORCE || mode == OperationMode::HYBRID) && jobs.size() == 1 &&
+        config.first_file_id > 0 && config.last_file_id > 0) {
         std::cout << "Brute Force Range: EFTA" << std::setw(8) << std::setfill('0')
                   << config.first_file_id << " - EFTA" << std::setw(8)
                   << std::setfill('0') << config.last_file_id << "\n";
     }
     std::cout << "\n";
 
-    // Create download manager
     std::string db_path = "efgrabber.db";
+    if (coordinator_port > 0) {
+        return run_shard_coordinator(jobs, db_path, output_dir, coordinator_address, coordinator_port);
+    }
+
+    // Create download manager
     DownloadManager manager(db_path, output_dir);
 
     if (!manager.initialize()) {
@@ -202,10 +662,19 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    manager.set_max_concurrent_downloads(max_concurrent);
-    manager.set_retry_attempts(max_retries);
+    if (reconcile) {
+        for (const auto& job : jobs) {
+            if (!manager.reconcile_stats(job.config.id)) {
+                std::cerr << "Failed to reconcile statistics\n";
+                return 1;
+            }
+            std::cout << "[+] Statistics recounted for " << job.config.name << "\n";
+        }
+        return 0;
+    }
+
+    configure(manager);
     if (!cookie_file.empty()) {
-        manager.set_cookie_file(cookie_file);
         std::cout << "Using cookies from: " << cookie_file << "\n";
     }
 
@@ -231,11 +700,50 @@ int main(int argc, char** argv) {
 
     manager.set_callbacks(callbacks);
 
+    MetricsServer metrics_server([&manager]() {
+        return format_prometheus(manager.get_stats(), manager.get_transfer_metrics());
+    });
+    if (metrics_port > 0) {
+        if (!metrics_server.start(metrics_port, metrics_address)) {
+            std::cerr << "Failed to listen for metrics on " << metrics_address << ":" << metrics_port << "\n";
+            return 1;
+        }
+        std::cout << "Metrics: http://" << metrics_address << ":" << metrics_server.port() << "/metrics\n";
+    }
+
+    // JSON stats go to stdout in place of the progress line, or to a file
+    bool json_to_stdout = json_stats_path == "-";
+    std::ofstream json_file;
+    if (!json_stats_path.empty() && !json_to_stdout) {
+        json_file.open(json_stats_path, std::ios::app);
+        if (!json_file) {
+            std::cerr << "Failed to open " << json_stats_path << " for JSON stats\n";
+            return 1;
+        }
+    }
+    auto write_json_stats = [&](const DownloadStats& stats) {
+        std::string line = format_json(stats, manager.get_transfer_metrics());
+        if (json_to_stdout) {
+            std::cout << line << std::endl;
+        } else if (json_file.is_open()) {
+            json_file << line << std::endl;
+        }
+    };
+
     // Start download
-    manager.start(config, mode);
+    if (disk_check == DiskCheck::SCAN) {
+        std::cout << "Scanning " << output_dir << " for finished downloads...\n";
+    }
+    manager.start(jobs);
+    if (disk_check == DiskCheck::SCAN) {
+        DownloadStats scanned = manager.get_stats();
+        std::cout << "[+] " << scanned.files_on_disk << " files on disk, "
+                  << scanned.files_reconciled << " newly marked completed\n";
+    }
 
     // Main loop - print stats periodically
     auto last_print = std::chrono::steady_clock::now();
+    std::string last_reason;
 
     while (manager.is_running() && !g_interrupted) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -249,14 +757,31 @@ int main(int argc, char** argv) {
                            stats.files_not_found;
             double progress = total > 0 ? 100.0 * stats.files_completed / total : 0;
 
+            write_json_stats(stats);
+            if (json_to_stdout) {
+                last_print = now;
+                continue;
+            }
+
+            if (adaptive && stats.concurrency_reason != last_reason) {
+                last_reason = stats.concurrency_reason;
+                std::cout << "\n[Concurrency] limit " << stats.concurrency_limit << ": " << last_reason << "\n";
+            }
+
             std::cout << "\r[Stats] "
                       << "Progress: " << std::fixed << std::setprecision(1) << progress << "% | "
                       << "Completed: " << stats.files_completed << " | "
                       << "Failed: " << stats.files_failed << " | "
                       << "404: " << stats.files_not_found << " | "
                       << "Pending: " << stats.files_pending << " | "
-                      << "Active: " << stats.files_in_progress << " | "
-                      << "Speed: " << format_bytes(static_cast<int64_t>(stats.current_speed_bps)) << "/s"
+                      << "Active: " << stats.files_in_progress << "/" << stats.concurrency_limit << " | "
+                      << "Conns: " << stats.connections_open << " | ";
+            if (mode == OperationMode::BRUTE_FORCE || mode == OperationMode::HYBRID) {
+                std::cout << "Probed: " << stats.brute_force_probed << "/"
+                          << (stats.brute_force_end - stats.brute_force_start + 1)
+                          << " (" << stats.brute_force_found << " found) | ";
+            }
+            std::cout << "Speed: " << format_bytes(static_cast<int64_t>(stats.current_speed_bps)) << "/s"
                       << "          " << std::flush;
 
             last_print = now;
@@ -269,12 +794,49 @@ int main(int argc, char** argv) {
 
     // Final stats
     DownloadStats final_stats = manager.get_stats();
+    write_json_stats(final_stats);
+    metrics_server.stop();
     std::cout << "\n\n=== Final Statistics ===\n";
     std::cout << "Files completed: " << final_stats.files_completed << "\n";
     std::cout << "Files failed: " << final_stats.files_failed << "\n";
     std::cout << "Files not found (404): " << final_stats.files_not_found << "\n";
     std::cout << "Pages scraped: " << final_stats.pages_scraped << "/" << final_stats.total_pages << "\n";
+    if (final_stats.pages_unchanged > 0) {
+        std::cout << "Pages unchanged: " << final_stats.pages_unchanged << "\n";
+    }
     std::cout << "Total downloaded: " << format_bytes(final_stats.bytes_downloaded) << "\n";
+    if (final_stats.files_packed > 0) {
+        std::cout << "Files packed: " << final_stats.files_packed << "\n";
+    }
+    if (final_stats.files_rejected > 0) {
+        std::cout << "Rejected (not a PDF): " << final_stats.files_rejected << "\n";
+    }
+    if (final_stats.files_deduplicated > 0) {
+        std::cout << "Deduplicated (hard-linked): " << final_stats.files_deduplicated << "\n";
+    }
+    if (final_stats.bytes_resumed > 0) {
+        std::cout << "Resumed from partial files: " << format_bytes(final_stats.bytes_resumed) << "\n";
+    }
+    if (jobs.size() > 1) {
+        for (int id : manager.get_data_sets()) {
+            DownloadStats set = manager.get_stats(id);
+            std::cout << "  Data Set " << id << ": " << set.files_completed << " completed, "
+                      << set.files_failed << " failed, " << set.files_not_found << " not found, "
+                      << set.files_pending << " pending, " << format_bytes(set.bytes_downloaded) << "\n";
+        }
+    }
+    const TransferMetrics& metrics = manager.get_transfer_metrics();
+    auto total_time = metrics.phase(TransferPhase::TOTAL);
+    if (total_time.count > 0) {
+        std::cout << "Transfer time p50/p90/p99 (ms):";
+        for (TransferPhase phase : {TransferPhase::TTFB, TransferPhase::BODY, TransferPhase::TOTAL}) {
+            auto snap = metrics.phase(phase);
+            std::cout << " " << transfer_phase_name(phase) << " " << std::fixed << std::setprecision(0)
+                      << snap.quantile(0.5) / 1000 << "/" << snap.quantile(0.9) / 1000 << "/"
+                      << snap.quantile(0.99) / 1000;
+        }
+        std::cout << "\n";
+    }
 
     return 0;
 }
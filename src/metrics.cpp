@@ -0,0 +1,368 @@
+/*
+ * metrics.cpp - Transfer timing histograms and metrics endpoint
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace efgrabber {
+
+Histogram::Histogram(std::vector<int64_t> bounds)
+    : bounds_(std::move(bounds)),
+      counts_(std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1)) {
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(int64_t value) {
+    if (value < 0) value = 0;
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snap;
+    snap.bounds = bounds_;
+    snap.counts.resize(bounds_.size() + 1);
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        snap.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        snap.count += snap.counts[i];
+    }
+    snap.sum = sum_.load(std::memory_order_relaxed);
+    return snap;
+}
+
+double Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] == 0 || static_cast<double>(seen + counts[i]) < rank) {
+            seen += counts[i];
+            continue;
+        }
+        // The overflow bucket has no upper bound; report its lower one
+        if (i == bounds.size()) return bounds.empty() ? 0 : static_cast<double>(bounds.back());
+        double lower = i == 0 ? 0 : static_cast<double>(bounds[i - 1]);
+        double upper = static_cast<double>(bounds[i]);
+        return lower + (upper - lower) * (rank - static_cast<double>(seen)) / counts[i];
+    }
+    return bounds.empty() ? 0 : static_cast<double>(bounds.back());
+}
+
+std::vector<int64_t> Histogram::decades(int64_t first, int64_t last) {
+    std::vector<int64_t> bounds;
+    for (int64_t decade = std::max<int64_t>(first, 1); decade <= last; decade *= 10) {
+        for (int64_t step : {1, 2, 5}) {
+            if (decade * step <= last) bounds.push_back(decade * step);
+        }
+    }
+    return bounds;
+}
+
+const char* transfer_phase_name(TransferPhase phase) {
+    switch (phase) {
+        case TransferPhase::DNS:     return "dns";
+        case TransferPhase::CONNECT: return "connect";
+        case TransferPhase::TLS:     return "tls";
+        case TransferPhase::TTFB:    return "ttfb";
+        case TransferPhase::BODY:    return "body";
+        case TransferPhase::TOTAL:   return "total";
+        default:                     return "unknown";
+    }
+}
+
+TransferMetrics::TransferMetrics()
+    // 1 KB to 1 GB: index pages and small PDFs up to the large video files
+    : sizes_(Histogram::decades(1000, 1000000000)) {
+    for (auto& phase : phases_) {
+        // 100 us to 100 s
+        phase = std::make_unique<Histogram>(Histogram::decades(100, 100000000));
+    }
+}
+
+void TransferMetrics::record(const DownloadResult& result) {
+    int code = result.http_code;
+    if (code < 0 || code >= MAX_HTTP_CODE) code = 0;
+    status_codes_[code].fetch_add(1, std::memory_order_relaxed);
+
+    const TransferTiming& t = result.timing;
+    if (t.new_connections > 0) {
+        connections_opened_.fetch_add(t.new_connections, std::memory_order_relaxed);
+    }
+    if (t.total_us < 0) return;
+
+    auto observe = [this](TransferPhase which, int64_t value) {
+        phases_[static_cast<size_t>(which)]->observe(value);
+    };
+
+    if (t.new_connections > 0) {
+        if (t.namelookup_us >= 0) observe(TransferPhase::DNS, t.namelookup_us);
+        if (t.connect_us > 0) observe(TransferPhase::CONNECT, t.connect_us - std::max<int64_t>(t.namelookup_us, 0));
+        if (t.appconnect_us > 0) observe(TransferPhase::TLS, t.appconnect_us - t.connect_us);
+    }
+    if (t.starttransfer_us > 0) {
+        int64_t request_sent = std::max<int64_t>({t.appconnect_us, t.connect_us, 0});
+        observe(TransferPhase::TTFB, t.starttransfer_us - request_sent);
+        observe(TransferPhase::BODY, t.total_us - t.starttransfer_us);
+    }
+    observe(TransferPhase::TOTAL, t.total_us);
+
+    if (result.success) {
+        sizes_.observe(result.resumed_bytes + result.content_length);
+    }
+
+    if (t.primary_ip.empty()) return;
+    bool error = code == 0 || code == 403 || code == 429 || code >= 500;
+
+    std::lock_guard<std::mutex> lock(edges_mutex_);
+    auto it = edges_.find(t.primary_ip);
+    if (it == edges_.end()) {
+        if (edges_.size() >= MAX_EDGES) return;
+        it = edges_.emplace(t.primary_ip, EdgeStats{}).first;
+    }
+    it->second.transfers++;
+    if (error) it->second.errors++;
+    if (t.starttransfer_us > 0) it->second.ttfb_us_sum += t.starttransfer_us;
+    it->second.total_us_sum += t.total_us;
+}
+
+Histogram::Snapshot TransferMetrics::phase(TransferPhase which) const {
+    return phases_[static_cast<size_t>(which)]->snapshot();
+}
+
+std::map<int, uint64_t> TransferMetrics::status_codes() const {
+    std::map<int, uint64_t> codes;
+    for (int code = 0; code < MAX_HTTP_CODE; ++code) {
+        uint64_t n = status_codes_[code].load(std::memory_order_relaxed);
+        if (n > 0) codes[code] = n;
+    }
+    return codes;
+}
+
+std::map<std::string, TransferMetrics::EdgeStats> TransferMetrics::edges() const {
+    std::lock_guard<std::mutex> lock(edges_mutex_);
+    return edges_;
+}
+
+namespace {
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void prometheus_histogram(std::ostringstream& out, const std::string& name, const std::string& labels,
+                          const Histogram::Snapshot& snap, double scale) {
+    std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < snap.bounds.size(); ++i) {
+        cumulative += snap.counts[i];
+        out << name << "_bucket" << prefix << "le=\"" << snap.bounds[i] * scale << "\"} " << cumulative << "\n";
+    }
+    out << name << "_bucket" << prefix << "le=\"+Inf\"} " << snap.count << "\n";
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    out << name << "_sum" << suffix << " " << snap.sum * scale << "\n";
+    out << name << "_count" << suffix << " " << snap.count << "\n";
+}
+
+} // namespace
+
+std::string format_prometheus(const DownloadStats& stats, const TransferMetrics& metrics) {
+    std::ostringstream out;
+
+    out << "# TYPE efgrabber_files gauge\n";
+    const std::pair<const char*, int64_t> files[] = {
+        {"pending", stats.files_pending}, {"in_progress", stats.files_in_progress},
+        {"completed", stats.files_completed}, {"failed", stats.files_failed},
+        {"not_found", stats.files_not_found}, {"skipped", stats.files_skipped},
+    };
+    for (const auto& [state, n] : files) {
+        out << "efgrabber_files{state=\"" << state << "\"} " << n << "\n";
+    }
+    out << "# TYPE efgrabber_pages_scraped_total counter\n"
+        << "efgrabber_pages_scraped_total " << stats.pages_scraped << "\n"
+        << "# TYPE efgrabber_bytes_downloaded_total counter\n"
+        << "efgrabber_bytes_downloaded_total " << stats.bytes_downloaded << "\n"
+        << "# TYPE efgrabber_bytes_resumed_total counter\n"
+        << "efgrabber_bytes_resumed_total " << stats.bytes_resumed << "\n"
+        << "# TYPE efgrabber_speed_bytes_per_second gauge\n"
+        << "efgrabber_speed_bytes_per_second{clock=\"wall\"} " << stats.current_speed_bps << "\n"
+        << "efgrabber_speed_bytes_per_second{clock=\"wire\"} " << stats.wire_speed_bps << "\n"
+        << "# TYPE efgrabber_connections_open gauge\n"
+        << "efgrabber_connections_open " << stats.connections_open << "\n"
+        << "# TYPE efgrabber_streams_active gauge\n"
+        << "efgrabber_streams_active " << stats.streams_active << "\n"
+        << "# TYPE efgrabber_concurrency_limit gauge\n"
+        << "efgrabber_concurrency_limit " << stats.concurrency_limit << "\n"
+        << "# TYPE efgrabber_connections_opened_total counter\n"
+        << "efgrabber_connections_opened_total " << metrics.connections_opened() << "\n";
+
+    out << "# TYPE efgrabber_http_responses_total counter\n";
+    for (const auto& [code, n] : metrics.status_codes()) {
+        out << "efgrabber_http_responses_total{code=\"" << code << "\"} " << n << "\n";
+    }
+
+    out << "# TYPE efgrabber_transfer_phase_seconds histogram\n";
+    for (size_t i = 0; i < static_cast<size_t>(TransferPhase::COUNT); ++i) {
+        auto which = static_cast<TransferPhase>(i);
+        prometheus_histogram(out, "efgrabber_transfer_phase_seconds",
+                             std::string("phase=\"") + transfer_phase_name(which) + "\"",
+                             metrics.phase(which), 1e-6);
+    }
+    out << "# TYPE efgrabber_transfer_size_bytes histogram\n";
+    prometheus_histogram(out, "efgrabber_transfer_size_bytes", "", metrics.sizes(), 1);
+
+    auto edges = metrics.edges();
+    if (!edges.empty()) {
+        out << "# TYPE efgrabber_edge_transfers_total counter\n";
+        for (const auto& [ip, edge] : edges) {
+            out << "efgrabber_edge_transfers_total{ip=\"" << ip << "\"} " << edge.transfers << "\n";
+        }
+        out << "# TYPE efgrabber_edge_errors_total counter\n";
+        for (const auto& [ip, edge] : edges) {
+            out << "efgrabber_edge_errors_total{ip=\"" << ip << "\"} " << edge.errors << "\n";
+        }
+        out << "# TYPE efgrabber_edge_ttfb_seconds_sum counter\n";
+        for (const auto& [ip, edge] : edges) {
+            out << "efgrabber_edge_ttfb_seconds_sum{ip=\"" << ip << "\"} " << edge.ttfb_us_sum * 1e-6 << "\n";
+        }
+    }
+    return out.str();
+}
+
+std::string format_json(const DownloadStats& stats, const TransferMetrics& metrics) {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now() - stats.start_time).count();
+    out << "{\"time\":" << std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count()
+        << ",\"elapsed_s\":" << elapsed
+        << ",\"pages_scraped\":" << stats.pages_scraped
+        << ",\"files\":{\"pending\":" << stats.files_pending
+        << ",\"in_progress\":" << stats.files_in_progress
+        << ",\"completed\":" << stats.files_completed
+        << ",\"failed\":" << stats.files_failed
+        << ",\"not_found\":" << stats.files_not_found
+        << ",\"skipped\":" << stats.files_skipped << "}"
+        << ",\"bytes\":" << stats.bytes_downloaded
+        << ",\"speed_bps\":" << stats.current_speed_bps
+        << ",\"wire_speed_bps\":" << stats.wire_speed_bps
+        << ",\"connections_open\":" << stats.connections_open
+        << ",\"connections_opened\":" << metrics.connections_opened()
+        << ",\"concurrency\":" << stats.concurrency_limit;
+
+    // Milliseconds with microsecond resolution
+    out.precision(3);
+    out << ",\"phases_ms\":{";
+    for (size_t i = 0; i < static_cast<size_t>(TransferPhase::COUNT); ++i) {
+        auto which = static_cast<TransferPhase>(i);
+        auto snap = metrics.phase(which);
+        out << (i ? "," : "") << "\"" << transfer_phase_name(which) << "\":{\"count\":" << snap.count
+            << ",\"mean\":" << snap.mean() / 1000
+            << ",\"p50\":" << snap.quantile(0.5) / 1000
+            << ",\"p90\":" << snap.quantile(0.9) / 1000
+            << ",\"p99\":" << snap.quantile(0.99) / 1000 << "}";
+    }
+    out << "}";
+
+    out << ",\"http\":{";
+    bool first = true;
+    for (const auto& [code, n] : metrics.status_codes()) {
+        out << (first ? "" : ",") << "\"" << code << "\":" << n;
+        first = false;
+    }
+    out << "}";
+
+    out << ",\"edges\":{";
+    first = true;
+    for (const auto& [ip, edge] : metrics.edges()) {
+        double n = edge.transfers ? static_cast<double>(edge.transfers) : 1;
+        out << (first ? "" : ",") << "\"" << json_escape(ip) << "\":{\"transfers\":" << edge.transfers
+            << ",\"errors\":" << edge.errors
+            << ",\"ttfb_ms\":" << edge.ttfb_us_sum / n / 1000
+            << ",\"total_ms\":" << edge.total_us_sum / n / 1000 << "}";
+        first = false;
+    }
+    out << "}";
+
+    if (!stats.concurrency_reason.empty()) {
+        out << ",\"concurrency_reason\":\"" << json_escape(stats.concurrency_reason) << "\"";
+    }
+    out << "}";
+    return out.str();
+}
+
+MetricsServer::MetricsServer(Handler handler)
+    : handler_(std::move(handler)),
+      listener_([this](const HttpRequest& request) { return respond(request); }, 2, 0) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(int port, const std::string& bind_address) {
+    return listener_.start(port, bind_address);
+}
+
+void MetricsServer::stop() {
+    listener_.stop();
+}
+
+HttpResponse MetricsServer::respond(const HttpRequest& request) {
+    HttpResponse response;
+    if (request.method != "GET") {
+        response.status = "405 Method Not Allowed";
+        response.body = "method not allowed\n";
+    } else if (request.path == "/metrics") {
+        response.content_type = "text/plain; version=0.0.4; charset=utf-8";
+        response.body = handler_();
+    } else {
+        response.status = "404 Not Found";
+        response.body = "not found\n";
+    }
+    return response;
+}
+
+} // namespace efgrabber
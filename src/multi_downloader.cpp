@@ -0,0 +1,255 @@
+/*
+ * multi_downloader.cpp - Implementation of the curl_multi download engine
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/multi_downloader.h"
+#include <curl/curl.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+namespace efgrabber {
+
+// One event loop: a CURLM handle plus the transfers it is driving
+struct MultiDownloader::Loop {
+    CURLM* multi = nullptr;
+    std::thread thread;
+
+    // Requests waiting to be picked up by the loop thread
+    std::mutex pending_mutex;
+    std::deque<MultiTransferRequest> pending;
+
+    // Transfers currently attached to the multi handle (loop thread only)
+    struct Active {
+        std::unique_ptr<Downloader> downloader;
+        FileTransferPtr transfer;
+        MultiTransferRequest request;
+    };
+    std::unordered_map<CURL*, Active> active;
+
+    // Recycled easy handles (loop thread only)
+    std::vector<std::unique_ptr<Downloader>> idle;
+
+    std::atomic<size_t> active_count{0};
+    std::atomic<size_t> pending_count{0};
+};
+
+MultiDownloader::MultiDownloader(const MultiDownloaderConfig& config) : config_(config) {
+    CurlGlobalInit::instance();  // Ensure global init
+
+    size_t loop_threads = config_.loop_threads > 0 ? config_.loop_threads : 1;
+
+    for (size_t i = 0; i < loop_threads; ++i) {
+        auto loop = std::make_unique<Loop>();
+        loop->multi = curl_multi_init();
+        if (!loop->multi) {
+            throw std::runtime_error("Failed to initialize CURLM handle");
+        }
+        if (config_.http2) {
+            curl_multi_setopt(loop->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+            curl_multi_setopt(loop->multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                              std::max(1L, config_.max_streams));
+        }
+        loops_.push_back(std::move(loop));
+    }
+
+    for (auto& loop : loops_) {
+        loop->thread = std::thread(&MultiDownloader::loop_thread, this, loop.get());
+    }
+}
+
+MultiDownloader::~MultiDownloader() {
+    shutdown();
+}
+
+bool MultiDownloader::submit(MultiTransferRequest request) {
+    if (stop_) return false;
+
+    // Pick the least loaded loop, starting from a rotating offset so ties spread out
+    size_t start = next_loop_++ % loops_.size();
+    Loop* target = loops_[start].get();
+    size_t best = target->active_count.load() + target->pending_count.load();
+    for (size_t i = 1; i < loops_.size(); ++i) {
+        Loop* candidate = loops_[(start + i) % loops_.size()].get();
+        size_t load = candidate->active_count.load() + candidate->pending_count.load();
+        if (load < best) {
+            best = load;
+            target = candidate;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(target->pending_mutex);
+        target->pending.push_back(std::move(request));
+        target->pending_count++;
+    }
+    curl_multi_wakeup(target->multi);
+    return true;
+}
+
+void MultiDownloader::shutdown() {
+    if (stop_.exchange(true)) return;
+
+    for (auto& loop : loops_) {
+        curl_multi_wakeup(loop->multi);
+    }
+    for (auto& loop : loops_) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+        curl_multi_cleanup(loop->multi);
+        loop->multi = nullptr;
+    }
+}
+
+size_t MultiDownloader::active_transfers() const {
+    size_t total = 0;
+    for (const auto& loop : loops_) {
+        total += loop->active_count.load();
+    }
+    return total;
+}
+
+size_t MultiDownloader::queued_transfers() const {
+    size_t total = 0;
+    for (const auto& loop : loops_) {
+        total += loop->pending_count.load();
+    }
+    return total;
+}
+
+void MultiDownloader::loop_thread(Loop* loop) {
+    auto complete = [](const MultiTransferRequest& request, const DownloadResult& result) {
+        if (!request.on_complete) return;
+        try {
+            request.on_complete(result);
+        } catch (const std::exception& e) {
+            std::cerr << "[MultiDownloader] Completion callback exception: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "[MultiDownloader] Completion callback unknown exception" << std::endl;
+        }
+    };
+
+    while (!stop_) {
+        // Attach newly queued transfers
+        std::deque<MultiTransferRequest> incoming;
+        {
+            std::lock_guard<std::mutex> lock(loop->pending_mutex);
+            incoming.swap(loop->pending);
+        }
+
+        for (auto& request : incoming) {
+            loop->pending_count--;
+
+            std::unique_ptr<Downloader> downloader;
+            if (!loop->idle.empty()) {
+                downloader = std::move(loop->idle.back());
+                loop->idle.pop_back();
+            } else {
+                downloader = std::make_unique<Downloader>();
+                downloader->set_share(config_.share);
+                downloader->set_socket_counter(config_.socket_counter);
+                downloader->set_http2(config_.http2);
+                downloader->set_write_mode(config_.write_mode);
+            }
+
+            downloader->reset_defaults();
+            if (!request.cookie.empty()) {
+                downloader->set_cookie(request.cookie);
+            } else if (!request.cookie_file.empty()) {
+                downloader->set_cookie_file(request.cookie_file);
+            }
+
+            std::string error;
+            auto transfer = downloader->begin_file_transfer(request.url, request.filepath, error,
+                                                            nullptr, request.timeout_seconds);
+            if (!transfer) {
+                DownloadResult result{};
+                result.success = false;
+                result.error_message = error;
+                loop->idle.push_back(std::move(downloader));
+                complete(request, result);
+                continue;
+            }
+
+            CURL* easy = downloader->handle();
+            if (curl_multi_add_handle(loop->multi, easy) != CURLM_OK) {
+                DownloadResult result = downloader->finish_file_transfer(std::move(transfer),
+                                                                         CURLE_FAILED_INIT);
+                loop->idle.push_back(std::move(downloader));
+                complete(request, result);
+                continue;
+            }
+
+            loop->active.emplace(easy, Loop::Active{std::move(downloader), std::move(transfer),
+                                                    std::move(request)});
+            loop->active_count++;
+        }
+
+        int running = 0;
+        curl_multi_perform(loop->multi, &running);
+
+        // Harvest finished transfers
+        int queued_msgs = 0;
+        while (CURLMsg* msg = curl_multi_info_read(loop->multi, &queued_msgs)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            CURL* easy = msg->easy_handle;
+            CURLcode code = msg->data.result;
+            curl_multi_remove_handle(loop->multi, easy);
+
+            auto it = loop->active.find(easy);
+            if (it == loop->active.end()) continue;
+
+            Loop::Active entry = std::move(it->second);
+            loop->active.erase(it);
+            loop->active_count--;
+
+            DownloadResult result = entry.downloader->finish_file_transfer(std::move(entry.transfer), code);
+            loop->idle.push_back(std::move(entry.downloader));
+            complete(entry.request, result);
+        }
+
+        curl_multi_poll(loop->multi, nullptr, 0, 1000, nullptr);
+    }
+
+    // Abort whatever is still attached; resumable .part files are kept for next time
+    for (auto& [easy, entry] : loop->active) {
+        curl_multi_remove_handle(loop->multi, easy);
+        entry.downloader->abandon_file_transfer(std::move(entry.transfer));
+    }
+    loop->active.clear();
+    loop->active_count = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(loop->pending_mutex);
+        loop->pending.clear();
+        loop->pending_count = 0;
+    }
+    loop->idle.clear();
+}
+
+} // namespace efgrabber
@@ -0,0 +1,525 @@
+/*
+ * pack_store.cpp - Append-only tar pack files for completed downloads
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/pack_store.h"
+#include "efgrabber/database.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace efgrabber {
+
+namespace {
+
+// ustar layout: 512-byte header, then the data padded to a whole block
+constexpr int64_t BLOCK = 512;
+constexpr size_t NAME_LENGTH = 100;
+constexpr size_t PREFIX_LENGTH = 155;
+constexpr size_t SIZE_OFFSET = 124;
+constexpr size_t SIZE_LENGTH = 12;
+constexpr size_t CHECKSUM_OFFSET = 148;
+constexpr size_t CHECKSUM_LENGTH = 8;
+constexpr size_t TYPE_OFFSET = 156;
+constexpr size_t MAGIC_OFFSET = 257;
+constexpr size_t PREFIX_OFFSET = 345;
+constexpr int64_t MAX_OCTAL_SIZE = (int64_t{1} << 33) - 1;  // 11 octal digits
+constexpr size_t COPY_BUFFER_BYTES = 1 << 20;
+
+int64_t padded(int64_t size) {
+    return (size + BLOCK - 1) / BLOCK * BLOCK;
+}
+
+void put_octal(char* field, size_t width, uint64_t value) {
+    std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1),
+                  static_cast<unsigned long long>(value));
+}
+
+unsigned header_checksum(const char* header) {
+    unsigned sum = 0;
+    for (int64_t i = 0; i < BLOCK; ++i) {
+        bool in_field = i >= static_cast<int64_t>(CHECKSUM_OFFSET) &&
+                        i < static_cast<int64_t>(CHECKSUM_OFFSET + CHECKSUM_LENGTH);
+        sum += in_field ? ' ' : static_cast<unsigned char>(header[i]);
+    }
+    return sum;
+}
+
+// Header for a regular file; false if name cannot be split into ustar's
+// prefix and name fields
+bool build_header(char* header, const std::string& name, int64_t size) {
+    std::memset(header, 0, BLOCK);
+
+    size_t split = 0;
+    if (name.size() > NAME_LENGTH) {
+        split = name.rfind('/', PREFIX_LENGTH);
+        if (split == std::string::npos || split == 0 || name.size() - split - 1 > NAME_LENGTH) {
+            return false;
+        }
+        std::memcpy(header + PREFIX_OFFSET, name.data(), split);
+        split++;
+    }
+    std::memcpy(header, name.data() + split, name.size() - split);
+
+    put_octal(header + 100, 8, 0644);
+    put_octal(header + 108, 8, 0);
+    put_octal(header + 116, 8, 0);
+    if (size <= MAX_OCTAL_SIZE) {
+        put_octal(header + SIZE_OFFSET, SIZE_LENGTH, static_cast<uint64_t>(size));
+    } else {
+        // GNU base-256: high bit set, then the size big-endian
+        header[SIZE_OFFSET] = static_cast<char>(0x80);
+        for (size_t i = 0; i < SIZE_LENGTH - 1; ++i) {
+            header[SIZE_OFFSET + SIZE_LENGTH - 1 - i] = static_cast<char>((size >> (8 * i)) & 0xff);
+        }
+    }
+    put_octal(header + 136, 12, static_cast<uint64_t>(std::time(nullptr)));
+    header[TYPE_OFFSET] = '0';
+    std::memcpy(header + MAGIC_OFFSET, "ustar", 6);
+    std::memcpy(header + MAGIC_OFFSET + 6, "00", 2);
+
+    std::snprintf(header + CHECKSUM_OFFSET, 7, "%06o", header_checksum(header));
+    header[CHECKSUM_OFFSET + 7] = ' ';
+    return true;
+}
+
+int64_t parse_size(const char* field) {
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        int64_t size = 0;
+        for (size_t i = 1; i < SIZE_LENGTH; ++i) {
+            size = (size << 8) | static_cast<unsigned char>(field[i]);
+        }
+        return size;
+    }
+    return static_cast<int64_t>(std::strtoull(std::string(field, SIZE_LENGTH).c_str(), nullptr, 8));
+}
+
+bool write_all(int fd, const char* data, size_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+// size bytes of in (from its start) to out at offset; on Linux, copy_file_range()
+// lets the kernel (or a server-side copy on network filesystems) move the data
+bool copy_range(int in, int out, int64_t size, int64_t offset) {
+    int64_t in_offset = 0;
+    int64_t out_offset = offset;
+#ifdef __linux__
+    while (in_offset < size) {
+        loff_t from = in_offset;
+        loff_t to = out_offset;
+        ssize_t n = copy_file_range(in, &from, out, &to, static_cast<size_t>(size - in_offset), 0);
+        if (n > 0) {
+            in_offset = from;
+            out_offset = to;
+            continue;
+        }
+        if (n == 0) return false;  // Source shrank under us
+        if (errno == EINTR) continue;
+        if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP) return false;
+        break;  // Not supported between these files
+    }
+#endif
+
+    // Plain reads and writes elsewhere, and for what the kernel could not copy
+    std::vector<char> buffer;
+    while (in_offset < size) {
+        if (buffer.empty()) buffer.resize(COPY_BUFFER_BYTES);
+        ssize_t got = pread(in, buffer.data(),
+                            static_cast<size_t>(std::min<int64_t>(size - in_offset, COPY_BUFFER_BYTES)),
+                            in_offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0 || !write_all(out, buffer.data(), static_cast<size_t>(got), out_offset)) {
+            return false;
+        }
+        in_offset += got;
+        out_offset += got;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parse_storage_mode(const std::string& name, StorageMode& mode) {
+    if (name == "files") mode = StorageMode::FILES;
+    else if (name == "pack") mode = StorageMode::PACK;
+    else return false;
+    return true;
+}
+
+const char* storage_mode_name(StorageMode mode) {
+    switch (mode) {
+        case StorageMode::PACK: return "pack";
+        case StorageMode::FILES:
+        default: return "files";
+    }
+}
+
+PackWriter::PackWriter(std::string directory, std::string prefix, int64_t max_bytes)
+    : directory_(std::move(directory)), prefix_(std::move(prefix)),
+      max_bytes_(max_bytes > 0 ? max_bytes : PACK_FILE_BYTES) {}
+
+PackWriter::~PackWriter() {
+    close();
+}
+
+std::string PackWriter::pack_path(int pack_id) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "-%05d.tar", pack_id);
+    return directory_ + "/" + prefix_ + name;
+}
+
+bool PackWriter::open(int pack_id, int64_t end) {
+    close();
+
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (ec) return false;
+
+    if (pack_id < 0 || end < 0) {
+        return open_new(std::max(0, pack_id));
+    }
+
+    int fd = ::open(pack_path(pack_id).c_str(), O_RDWR | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && end < max_bytes_ && fstat(fd, &st) == 0 && st.st_size >= end &&
+        ftruncate(fd, end) == 0) {
+        fd_ = fd;
+        pack_id_ = pack_id;
+        end_ = end;
+        return true;
+    }
+    if (fd >= 0) ::close(fd);
+    return open_new(pack_id + 1);
+}
+
+bool PackWriter::open_new(int first_id) {
+    for (int id = first_id; id >= 0; ++id) {
+        int fd = ::open(pack_path(id).c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            fd_ = fd;
+            pack_id_ = id;
+            end_ = 0;
+            return true;
+        }
+        if (errno != EEXIST) return false;
+    }
+    return false;
+}
+
+std::optional<PackMember> PackWriter::append(const std::string& name, const std::string& source_path) {
+    if (fd_ < 0) return std::nullopt;
+
+    int in = ::open(source_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return std::nullopt;
+
+    struct stat st;
+    if (fstat(in, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        ::close(in);
+        return std::nullopt;
+    }
+    int64_t size = st.st_size;
+
+    char header[BLOCK];
+    if (!build_header(header, name, size)) {
+        ::close(in);
+        return std::nullopt;
+    }
+
+    if (end_ > 0 && end_ + BLOCK + padded(size) > max_bytes_) {
+        int next = pack_id_ + 1;
+        close();
+        if (!open_new(next)) {
+            ::close(in);
+            return std::nullopt;
+        }
+    }
+
+    static const char zeros[BLOCK] = {};
+    bool ok = write_all(fd_, header, BLOCK, end_) &&
+              copy_range(in, fd_, size, end_ + BLOCK) &&
+              write_all(fd_, zeros, static_cast<size_t>(padded(size) - size), end_ + BLOCK + size);
+    ::close(in);
+
+    if (!ok) {
+        // Nothing indexed points past end_, so the partial member just goes
+        if (ftruncate(fd_, end_) != 0) {
+            close();
+        }
+        return std::nullopt;
+    }
+
+    PackMember member{name, end_ + BLOCK, size};
+    end_ += BLOCK + padded(size);
+    return member;
+}
+
+bool PackWriter::sync() {
+    return fd_ >= 0 && fdatasync(fd_) == 0;
+}
+
+void PackWriter::close() {
+    if (fd_ < 0) return;
+
+    // End-of-archive: two zero blocks, past end_ so the next open() drops them
+    static const char trailer[2 * BLOCK] = {};
+    write_all(fd_, trailer, sizeof(trailer), end_);
+    fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+}
+
+bool read_pack_index(const std::string& path, std::vector<PackMember>& members) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    char header[BLOCK];
+    int64_t offset = 0;
+    bool ok = true;
+    while (true) {
+        ssize_t n = pread(fd, header, BLOCK, offset);
+        if (n == 0) break;  // A pack still being written has no end-of-archive blocks
+        if (n != BLOCK) {
+            ok = false;
+            break;
+        }
+        if (std::all_of(header, header + BLOCK, [](char c) { return c == 0; })) break;
+
+        unsigned stored = static_cast<unsigned>(
+            std::strtoul(std::string(header + CHECKSUM_OFFSET, CHECKSUM_LENGTH).c_str(), nullptr, 8));
+        if (std::memcmp(header + MAGIC_OFFSET, "ustar", 5) != 0 || stored != header_checksum(header)) {
+            ok = false;
+            break;
+        }
+
+        PackMember member;
+        member.name.assign(header, strnlen(header, NAME_LENGTH));
+        size_t prefix = strnlen(header + PREFIX_OFFSET, PREFIX_LENGTH);
+        if (prefix > 0) {
+            member.name = std::string(header + PREFIX_OFFSET, prefix) + "/" + member.name;
+        }
+        member.offset = offset + BLOCK;
+        member.size = parse_size(header + SIZE_OFFSET);
+
+        char type = header[TYPE_OFFSET];
+        if (type == '0' || type == '\0') {
+            members.push_back(member);
+        }
+        offset = member.offset + padded(member.size);
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+bool extract_pack_member(const std::string& pack_path, const PackMember& member,
+                         const std::string& out_path) {
+    int in = ::open(pack_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+
+    std::error_code ec;
+    fs::path target(out_path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+    }
+    int out = ::open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    // The member's data at its offset, copied through a buffer like copy_range()'s fallback
+    std::vector<char> buffer(COPY_BUFFER_BYTES);
+    int64_t done = 0;
+    bool ok = true;
+    while (ok && done < member.size) {
+        ssize_t got = pread(in, buffer.data(),
+                            static_cast<size_t>(std::min<int64_t>(member.size - done, COPY_BUFFER_BYTES)),
+                            member.offset + done);
+        if (got < 0 && errno == EINTR) continue;
+        ok = got > 0 && write_all(out, buffer.data(), static_cast<size_t>(got), done);
+        done += got > 0 ? got : 0;
+    }
+
+    ok = ::close(out) == 0 && ok;
+    ::close(in);
+    return ok;
+}
+
+PackStore::PackStore(Database& db, int data_set, const std::string& download_dir,
+                     int64_t max_pack_bytes)
+    : db_(db), data_set_(data_set), download_dir_(download_dir),
+      writer_((fs::path(download_dir) / "packs").string(), "DataSet" + std::to_string(data_set),
+              max_pack_bytes) {}
+
+PackStore::~PackStore() {
+    stop();
+}
+
+bool PackStore::start() {
+    int pack_id = -1;
+    int64_t end = -1;
+    if (!db_.get_pack_end(data_set_, pack_id, end)) {
+        pack_id = -1;
+        end = -1;
+    }
+    if (!writer_.open(pack_id, end)) {
+        std::cerr << "[PackStore] Cannot open a pack file in " << download_dir_ << "/packs" << std::endl;
+        return false;
+    }
+    thread_ = std::thread(&PackStore::packer_thread, this);
+    return true;
+}
+
+void PackStore::submit(int64_t file_row_id, const std::string& local_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(Entry{file_row_id, local_path});
+    }
+    cv_.notify_one();
+}
+
+void PackStore::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    writer_.close();
+}
+
+std::vector<PackStore::Entry> PackStore::next_batch() {
+    std::vector<Entry> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (!queue_.empty()) {
+            while (!queue_.empty() && batch.size() < static_cast<size_t>(PACK_BATCH_FILES)) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            return batch;
+        }
+        if (stop_) return batch;
+
+        if (!backlog_done_) {
+            lock.unlock();
+            auto rows = db_.get_unpacked_files(data_set_, backlog_after_, PACK_BATCH_FILES);
+            lock.lock();
+            if (rows.empty()) {
+                backlog_done_ = true;
+                continue;
+            }
+            backlog_after_ = rows.back().id;
+            for (auto& row : rows) {
+                batch.push_back(Entry{row.id, std::move(row.local_path)});
+            }
+            return batch;
+        }
+        cv_.wait(lock);
+    }
+}
+
+void PackStore::packer_thread() {
+    while (true) {
+        auto batch = next_batch();
+        if (batch.empty()) break;
+        pack_batch(batch);
+    }
+}
+
+void PackStore::pack_batch(const std::vector<Entry>& batch) {
+    std::vector<PackedFile> packed;
+    std::vector<const std::string*> sources;
+    for (const auto& entry : batch) {
+        // The backlog scan can return a row that was also submitted live
+        if (packed_.count(entry.id)) continue;
+
+        auto member = writer_.append(member_name(entry.path), entry.path);
+        if (!member) {
+            std::error_code ec;
+            if (fs::exists(entry.path, ec)) {
+                std::cerr << "[PackStore] Failed to pack " << entry.path << std::endl;
+            }
+            continue;
+        }
+        packed.push_back(PackedFile{entry.id, writer_.pack_id(), member->offset, member->size});
+        sources.push_back(&entry.path);
+    }
+    if (packed.empty()) return;
+
+    // Until the index commits, the loose files are the only copies on record
+    if (!writer_.sync() || !db_.set_pack_locations(packed)) {
+        std::cerr << "[PackStore] Failed to index " << packed.size() << " packed files: "
+                  << db_.get_last_error() << std::endl;
+        return;
+    }
+
+    for (size_t i = 0; i < packed.size(); ++i) {
+        packed_.insert(packed[i].id);
+        std::error_code ec;
+        fs::remove(*sources[i], ec);
+        files_packed_++;
+        bytes_packed_ += packed[i].file_size;
+    }
+
+    // The scan never returns rows at or below its cursor again, and none at
+    // all once it is done, so only rows it may still reach need remembering
+    int64_t cursor;
+    bool scan_done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cursor = backlog_after_;
+        scan_done = backlog_done_;
+    }
+    std::erase_if(packed_, [&](int64_t id) { return scan_done || id <= cursor; });
+}
+
+std::string PackStore::member_name(const std::string& path) const {
+    fs::path relative = fs::path(path).lexically_relative(download_dir_);
+    if (relative.empty() || *relative.begin() == "..") {
+        return fs::path(path).filename().string();
+    }
+    return relative.generic_string();
+}
+
+} // namespace efgrabber
@@ -0,0 +1,201 @@
+/*
+ * probe_planner.cpp - Order of brute force existence probes
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/probe_planner.h"
+#include <algorithm>
+
+namespace efgrabber {
+
+namespace {
+
+// Pseudo-counts spread over the first PRIOR_SPAN lengths, so the hazard is a
+// flat 1/PRIOR_SPAN until real documents outweigh it
+constexpr double PRIOR_WEIGHT = 4.0;
+constexpr uint64_t PRIOR_SPAN = 32;
+
+} // namespace
+
+ProbePlanner::ProbePlanner(const IdBitmap& bitmap, int width, int retry_passes)
+    : bitmap_(bitmap), width_(static_cast<size_t>(std::max(1, width))),
+      retry_passes_(std::max(0, retry_passes)), lengths_(MAX_TRACKED_LENGTH + 1, 0) {
+    uint64_t size = bitmap_.size();
+    uint64_t count = std::clamp<uint64_t>((size + REGION_IDS - 1) / REGION_IDS, 1, MAX_REGIONS);
+    for (uint64_t i = 0; i < count && size > 0; ++i) {
+        Walk walk{};
+        walk.first = bitmap_.first() + size * i / count;
+        walk.last = bitmap_.first() + size * (i + 1) / count - 1;
+        walks_.push_back(walk);
+    }
+    learn_lengths();
+    done_ = walks_.empty();
+    start_pass();
+}
+
+void ProbePlanner::learn_lengths() {
+    // Consecutive hits with nothing unknown between them bound a document
+    uint64_t previous = 0;
+    bool have_previous = false;
+    for (uint64_t id = bitmap_.first(); id <= bitmap_.last() && !bitmap_.empty(); ++id) {
+        IdState state = bitmap_.get(id);
+        if (state == IdState::UNKNOWN) {
+            have_previous = false;
+        } else if (state == IdState::PRESENT) {
+            if (have_previous) record_length(id - previous);
+            previous = id;
+            have_previous = true;
+        }
+    }
+}
+
+void ProbePlanner::record_length(uint64_t length) {
+    lengths_[std::min<uint64_t>(length, MAX_TRACKED_LENGTH)]++;
+    measured_++;
+    hazard_stale_ = true;
+}
+
+double ProbePlanner::hazard(uint64_t age) {
+    if (hazard_stale_) {
+        // hazard[k] = (n(k) + prior(k)) / (n(>= k) + prior(>= k))
+        hazard_.assign(MAX_TRACKED_LENGTH + 1, 0);
+        double at_least = 0;
+        double prior_at_least = 0;
+        for (uint64_t k = MAX_TRACKED_LENGTH; k >= 1; --k) {
+            double prior = k <= PRIOR_SPAN ? PRIOR_WEIGHT / PRIOR_SPAN : 0;
+            at_least += static_cast<double>(lengths_[k]);
+            prior_at_least += prior;
+            double n = static_cast<double>(lengths_[k]) + prior;
+            double d = at_least + prior_at_least;
+            hazard_[k] = d > 0 ? n / d : 0;
+        }
+        // Past the prior and every document seen, keep a small chance
+        for (uint64_t k = 1; k <= MAX_TRACKED_LENGTH; ++k) {
+            hazard_[k] = std::max(hazard_[k], 1.0 / (MAX_TRACKED_LENGTH * 4));
+        }
+        hazard_stale_ = false;
+    }
+    return hazard_[std::clamp<uint64_t>(age, 1, MAX_TRACKED_LENGTH)];
+}
+
+void ProbePlanner::start_pass() {
+    for (;;) {
+        if (done_) return;
+        if (bitmap_.count(IdState::UNKNOWN) == 0 || pass_ > retry_passes_) {
+            done_ = true;
+            return;
+        }
+        bool any = false;
+        for (auto& walk : walks_) {
+            walk.next = walk.first;
+            walk.last_hit = walk.first - 1;
+            walk.outstanding = 0;
+            skip_known(walk);
+            any = any || walk.next <= walk.last;
+        }
+        if (any) return;
+        pass_++;
+    }
+}
+
+void ProbePlanner::skip_known(Walk& walk) {
+    while (walk.next <= walk.last) {
+        IdState state = bitmap_.get(walk.next);
+        if (state == IdState::UNKNOWN) break;
+        if (state == IdState::PRESENT) walk.last_hit = walk.next;
+        walk.next++;
+    }
+}
+
+void ProbePlanner::hand_out(Walk& walk, std::vector<uint64_t>& batch) {
+    batch.push_back(walk.next++);
+    walk.outstanding++;
+    skip_known(walk);
+}
+
+ProbePlanner::Walk* ProbePlanner::walk_for(uint64_t id) {
+    auto it = std::upper_bound(walks_.begin(), walks_.end(), id,
+                               [](uint64_t value, const Walk& walk) { return value < walk.first; });
+    if (it == walks_.begin()) return nullptr;
+    --it;
+    return id <= it->last ? &*it : nullptr;
+}
+
+std::vector<uint64_t> ProbePlanner::next_batch() {
+    std::vector<uint64_t> batch;
+    while (!done_ && batch.empty()) {
+        // Candidates: each walk's next ID, ranked by hazard at its age
+        std::vector<std::pair<double, Walk*>> ranked;
+        bool active = false;
+        for (auto& walk : walks_) {
+            if (walk.outstanding > 0) active = true;
+            if (walk.next > walk.last) continue;
+            ranked.emplace_back(hazard(walk.next - walk.last_hit), &walk);
+        }
+
+        if (ranked.empty()) {
+            if (active) break;      // Wait for outstanding reports
+            pass_++;
+            start_pass();
+            continue;
+        }
+
+        size_t take = std::min(width_, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + static_cast<long>(take), ranked.end(),
+                          [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = 0; i < take; ++i) {
+            hand_out(*ranked[i].second, batch);
+        }
+
+        // Fewer walks than width: let the best ones run ahead several IDs
+        for (size_t i = 0; batch.size() < width_ && take > 0; i = (i + 1) % take) {
+            Walk& walk = *ranked[i].second;
+            if (walk.next <= walk.last) {
+                hand_out(walk, batch);
+            } else if (std::none_of(ranked.begin(), ranked.begin() + static_cast<long>(take),
+                                    [](const auto& r) { return r.second->next <= r.second->last; })) {
+                break;
+            }
+        }
+    }
+    return batch;
+}
+
+void ProbePlanner::report(uint64_t id, IdState state) {
+    Walk* walk = walk_for(id);
+    if (!walk || walk->outstanding == 0) return;
+    walk->outstanding--;
+
+    if (state == IdState::PRESENT) {
+        // A closed gap measures the document before this one
+        uint64_t previous = id - 1;
+        while (previous >= bitmap_.first() && previous > 0 && bitmap_.get(previous) == IdState::MISSING) {
+            previous--;
+        }
+        if (previous >= bitmap_.first() && previous > 0 && bitmap_.get(previous) == IdState::PRESENT) {
+            record_length(id - previous);
+        }
+        if (id > walk->last_hit) walk->last_hit = id;
+    }
+    skip_known(*walk);
+}
+
+} // namespace efgrabber
@@ -0,0 +1,85 @@
+/*
+ * retry_scheduler.cpp - Implementation of the retry deadline queue
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/retry_scheduler.h"
+#include <cmath>
+
+namespace efgrabber {
+
+int64_t RetryScheduler::backoff_seconds(int retry_count) {
+    if (retry_count <= 0) return 0;
+
+    const double max_delay = 600.0; // 10 minutes max
+    const double min_delay = 5.0;   // 5 seconds min
+    const double k = 1.0;           // Steepness
+    const double mid = 5.0;         // Halfway point at 5 retries
+
+    double delay = min_delay + (max_delay - min_delay) / (1.0 + std::exp(-k * (retry_count - mid)));
+    return static_cast<int64_t>(delay);
+}
+
+void RetryScheduler::schedule(int64_t id, int64_t due) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_.push(Entry{id, due});
+}
+
+void RetryScheduler::schedule(const std::vector<RetryDeadline>& deadlines) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& deadline : deadlines) {
+        heap_.push(deadline);
+    }
+}
+
+std::vector<int64_t> RetryScheduler::take_due(int64_t now, size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<int64_t> due;
+    while (due.size() < limit && !heap_.empty() && heap_.top().next_attempt_at <= now) {
+        due.push_back(heap_.top().id);
+        heap_.pop();
+    }
+    return due;
+}
+
+std::optional<int64_t> RetryScheduler::next_due() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heap_.empty()) return std::nullopt;
+    return heap_.top().next_attempt_at;
+}
+
+size_t RetryScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return heap_.size();
+}
+
+bool RetryScheduler::empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return heap_.empty();
+}
+
+void RetryScheduler::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_ = {};
+}
+
+} // namespace efgrabber
@@ -25,62 +25,184 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
-#include <cctype>
+#include <cstring>
 
 namespace efgrabber {
 
-Scraper::Scraper(const DataSetConfig& config)
-    : config_(config),
-      // Match PDF links like href="/epstein/files/DataSet%2011/EFTA02205655.pdf"
-      // or href="https://www.justice.gov/epstein/files/DataSet%2011/EFTA02205655.pdf"
-      // Dynamic pattern based on current data set ID
-      pdf_link_regex_(build_pdf_regex(config.id), std::regex::icase | std::regex::optimize),
-      // Match EFTA followed by digits
-      file_id_regex_(R"(EFTA(\d{8}))", std::regex::optimize) {
+namespace {
+
+constexpr size_t FILE_ID_DIGITS = 8;
+constexpr const char FILE_ID_MARKER[] = "EFTA";
+constexpr size_t FILE_ID_MARKER_LEN = sizeof(FILE_ID_MARKER) - 1;
+
+// Markup only Akamai's denial and bot challenge pages carry
+constexpr const char* CHALLENGE_MARKERS[] = {
+    "errors.edgesuite.net",   // "Access Denied" reference page
+    "/_sec/cp_challenge/",    // Interactive challenge script
+    "sec-if-cpt",             // Challenge container
+    "bm-verify",              // Bot Manager proof-of-work form
+};
+
+// The characters std::regex treats as \s in the classic locale
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
 }
 
-std::string Scraper::build_pdf_regex(int data_set_id) {
-    // Build a regex that matches this specific data set's PDF links
-    // Handles both "DataSet%20X" and "DataSet X" formats
-    std::string id_str = std::to_string(data_set_id);
-    // Match href="...DataSet%20X/EFTA....pdf" or href="...DataSet X/EFTA....pdf"
-    // Include trailing slash to ensure exact match of data set ID (e.g., "1/" vs "11/")
-    return R"(href\s*=\s*["']([^"']*(?:DataSet(?:%20|\s))" + id_str + R"(/)[^"']*\.pdf)["'])";
+inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
 }
 
-std::vector<PdfLink> Scraper::extract_pdf_links(const std::string& html_content) {
-    std::vector<PdfLink> links;
+inline char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
 
-    std::sregex_iterator it(html_content.begin(), html_content.end(), pdf_link_regex_);
-    std::sregex_iterator end;
+// Case-insensitive compare of text at p against a lowercase literal
+inline bool iequals(const char* p, const char* lower_literal, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (to_lower(p[i]) != lower_literal[i]) return false;
+    }
+    return true;
+}
 
-    while (it != end) {
-        std::smatch match = *it;
-        std::string href = match[1].str();
+// Offset of the digits of the first "EFTA" + 8 digits in text, or npos
+size_t find_file_id_digits(std::string_view text) {
+    size_t pos = 0;
+    while ((pos = text.find(FILE_ID_MARKER, pos)) != std::string_view::npos) {
+        size_t digits = pos + FILE_ID_MARKER_LEN;
+        if (text.size() - digits >= FILE_ID_DIGITS &&
+            std::all_of(text.begin() + digits, text.begin() + digits + FILE_ID_DIGITS, is_digit)) {
+            return digits;
+        }
+        ++pos;
+    }
+    return std::string_view::npos;
+}
+
+// href contains "DataSet%20<id>/" or "DataSet <id>/" (any case) with room
+// for at least ".pdf" after the slash. The earliest marker leaves the most
+// room, so it is the only one that needs checking.
+bool has_data_set_marker(std::string_view href, std::string_view id) {
+    static constexpr char NAME[] = "dataset";
+    static constexpr size_t NAME_LEN = sizeof(NAME) - 1;
 
-        // Extract file ID from the URL
-        std::string file_id = extract_file_id(href);
+    for (size_t i = 0; i + NAME_LEN <= href.size(); ++i) {
+        if (to_lower(href[i]) != 'd' || !iequals(href.data() + i, NAME, NAME_LEN)) continue;
 
-        if (!file_id.empty()) {
-            PdfLink link;
-            link.file_id = file_id;
+        size_t pos = i + NAME_LEN;
+        if (href.compare(pos, 3, "%20") == 0) {
+            pos += 3;
+        } else if (pos < href.size() && is_space(href[pos])) {
+            pos += 1;
+        } else {
+            continue;
+        }
+        if (href.compare(pos, id.size(), id) != 0) continue;
+        pos += id.size();
+        if (pos >= href.size() || href[pos] != '/') continue;
+        return pos + 1 + 4 <= href.size();
+    }
+    return false;
+}
 
-            // Build full URL if it's a relative path
-            if (href.find("http") != 0) {
-                if (href[0] == '/') {
-                    link.url = "https://www." + std::string(TARGET_DOMAIN) + href;
-                } else {
-                    link.url = "https://www." + std::string(TARGET_DOMAIN) + "/" + href;
-                }
-            } else {
-                link.url = href;
-            }
+} // namespace
 
-            links.push_back(std::move(link));
+Scraper::Scraper(const DataSetConfig& config)
+    : config_(config), data_set_id_(std::to_string(config.id)) {
+}
+
+// Equivalent to the case-insensitive regex
+//   href\s*=\s*["']([^"']*DataSet(?:%20|\s)<id>/[^"']*\.pdf)["']
+// applied left to right without overlap. Candidates are found by jumping
+// between '=' signs with memchr(), which glibc vectorises, so the bulk of a
+// page is never looked at byte by byte.
+//
+// Without final, html is a prefix of the page: scanning stops at the first
+// href whose value is still open and the return value is where the next call
+// has to start so nothing is decided twice or missed (a trailing "href" and
+// whitespace waiting for its '=' is kept too). With final the whole of html
+// is consumed.
+template <typename Callback>
+size_t Scraper::scan_pdf_hrefs(std::string_view html, bool final, Callback&& on_href) const {
+    const char* begin = html.data();
+    const char* end = begin + html.size();
+    const char* p = begin;
+
+    while (p < end) {
+        const char* eq = static_cast<const char*>(std::memchr(p, '=', static_cast<size_t>(end - p)));
+        if (!eq) break;
+        const char* resume = p;
+        p = eq + 1;
+
+        // Attribute name: "href" in any case, optionally followed by whitespace
+        const char* name_end = eq;
+        while (name_end > begin && is_space(name_end[-1])) --name_end;
+        if (name_end - begin < 4 || !iequals(name_end - 4, "href", 4)) continue;
+        const char* name = std::max(name_end - 4, resume);
+
+        // Quoted value; it ends at the first quote of either kind
+        const char* value = eq + 1;
+        while (value < end && is_space(*value)) ++value;
+        if (value == end) {
+            if (!final) return static_cast<size_t>(name - begin);
+            continue;
+        }
+        if (*value != '"' && *value != '\'') continue;
+        const char* value_begin = value + 1;
+        const char* value_end = std::find_if(value_begin, end,
+                                             [](char c) { return c == '"' || c == '\''; });
+        if (value_end == end) {
+            if (!final) return static_cast<size_t>(name - begin);
+            continue;
+        }
+
+        std::string_view href(value_begin, static_cast<size_t>(value_end - value_begin));
+        if (href.size() < 4 || !iequals(href.data() + href.size() - 4, ".pdf", 4) ||
+            !has_data_set_marker(href, data_set_id_)) {
+            continue;
         }
 
-        ++it;
+        on_href(href);
+        p = value_end + 1;
+    }
+
+    if (final) return html.size();
+
+    // Keep a trailing "href" plus whitespace whose '=' may be in the next chunk
+    const char* tail = end;
+    while (tail > p && is_space(tail[-1])) --tail;
+    return static_cast<size_t>(std::max(p, std::max(begin, tail - 4)) - begin);
+}
+
+bool Scraper::make_link(std::string_view href, PdfLink& link) const {
+    // Extract file ID from the URL
+    size_t digits = find_file_id_digits(href);
+    if (digits == std::string_view::npos) return false;
+
+    link.file_id = config_.file_prefix;
+    link.file_id.append(href.substr(digits, FILE_ID_DIGITS));
+
+    // Build full URL if it's a relative path
+    if (href.rfind("http", 0) != 0) {
+        link.url = "https://www." + std::string(TARGET_DOMAIN);
+        if (href[0] != '/') {
+            link.url += '/';
+        }
+        link.url.append(href);
+    } else {
+        link.url = std::string(href);
     }
+    return true;
+}
+
+std::vector<PdfLink> Scraper::extract_pdf_links(const std::string& html_content) {
+    std::vector<PdfLink> links;
+
+    scan_pdf_hrefs(html_content, true, [&](std::string_view href) {
+        PdfLink link;
+        if (make_link(href, link)) {
+            links.push_back(std::move(link));
+        }
+    });
 
     // Remove duplicates
     std::sort(links.begin(), links.end(),
@@ -92,6 +214,63 @@ std::vector<PdfLink> Scraper::extract_pdf_links(const std::string& html_content)
     return links;
 }
 
+LinkScanner::LinkScanner(const Scraper& scraper, LinkCallback on_link)
+    : scraper_(scraper), on_link_(std::move(on_link)) {
+}
+
+void LinkScanner::feed(const char* data, size_t size) {
+    if (finished_ || size == 0) return;
+    bytes_scanned_ += size;
+
+    // Scan the chunk in place unless an earlier chunk left something open
+    std::string_view text(data, size);
+    if (!carry_.empty()) {
+        carry_.append(data, size);
+        text = carry_;
+    }
+
+    size_t consumed = scan(text, false);
+
+    if (text.size() - consumed > MAX_LINK_CARRY) {
+        // An attribute value this long is not a file link; treat it as a
+        // mismatch and carry on after its '=' rather than buffering the page
+        size_t eq = text.find('=', consumed);
+        consumed = eq == std::string_view::npos ? text.size() : eq + 1;
+    }
+
+    if (consumed == text.size()) {
+        carry_.clear();
+    } else if (carry_.empty()) {
+        carry_.assign(text.substr(consumed));
+    } else {
+        carry_.erase(0, consumed);
+    }
+}
+
+void LinkScanner::finish() {
+    if (finished_) return;
+    finished_ = true;
+    if (!carry_.empty()) {
+        scan(carry_, true);
+        carry_.clear();
+    }
+}
+
+size_t LinkScanner::scan(std::string_view text, bool final) {
+    return scraper_.scan_pdf_hrefs(text, final, [this](std::string_view href) {
+        PdfLink link;
+        if (!scraper_.make_link(href, link)) return;
+        // First occurrence wins, like a std::unique over the page
+        if (!seen_.insert(link.file_id).second) return;
+        ++links_found_;
+        for (unsigned char c : link.url) {
+            links_hash_ = (links_hash_ ^ c) * FNV_PRIME;
+        }
+        links_hash_ = (links_hash_ ^ '\n') * FNV_PRIME;
+        on_link_(std::move(link));
+    });
+}
+
 std::string Scraper::build_page_url(int page_number) const {
     if (page_number == 0) {
         return config_.base_url;
@@ -108,23 +287,23 @@ std::string Scraper::build_file_url(const std::string& file_id) const {
 }
 
 std::string Scraper::extract_file_id(const std::string& url_or_filename) const {
-    std::smatch match;
-    if (std::regex_search(url_or_filename, match, file_id_regex_)) {
-        return config_.file_prefix + match[1].str();
+    size_t digits = find_file_id_digits(url_or_filename);
+    if (digits != std::string::npos) {
+        return config_.file_prefix + url_or_filename.substr(digits, FILE_ID_DIGITS);
     }
     return "";
 }
 
 uint64_t Scraper::parse_file_id_number(const std::string& file_id) const {
-    std::smatch match;
-    if (std::regex_search(file_id, match, file_id_regex_)) {
-        try {
-            return std::stoull(match[1].str());
-        } catch (...) {
-            return 0; // Return 0 on conversion error
-        }
+    size_t digits = find_file_id_digits(file_id);
+    if (digits == std::string::npos) {
+        return 0;
+    }
+    uint64_t number = 0;
+    for (size_t i = digits; i < digits + FILE_ID_DIGITS; ++i) {
+        number = number * 10 + static_cast<uint64_t>(file_id[i] - '0');
     }
-    return 0;
+    return number;
 }
 
 std::string Scraper::format_file_id(uint64_t number) const {
@@ -134,7 +313,20 @@ std::string Scraper::format_file_id(uint64_t number) const {
 }
 
 bool Scraper::is_valid_file_id(const std::string& file_id) const {
-    return std::regex_match(file_id, file_id_regex_);
+    return file_id.size() == FILE_ID_MARKER_LEN + FILE_ID_DIGITS &&
+           find_file_id_digits(file_id) == FILE_ID_MARKER_LEN;
+}
+
+std::string block_reason(int http_code, std::string_view head) {
+    if (http_code == 403 || http_code == 429) {
+        return "HTTP " + std::to_string(http_code);
+    }
+    for (const char* marker : CHALLENGE_MARKERS) {
+        if (head.find(marker) != std::string_view::npos) {
+            return std::string("challenge page (") + marker + ")";
+        }
+    }
+    return "";
 }
 
 } // namespace efgrabber
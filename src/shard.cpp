@@ -0,0 +1,728 @@
+/*
+ * shard.cpp - Coordinator and workers of a run spread over several nodes
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/shard.h"
+#include "efgrabber/download_tree.h"
+#include "efgrabber/downloader.h"
+#include "efgrabber/scraper.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <curl/curl.h>
+
+namespace efgrabber {
+
+namespace {
+
+constexpr size_t MAX_REQUEST_BYTES = 16 << 20;
+constexpr size_t STATES_PER_LINE = 4096;  // IDs per "ids" line
+
+std::vector<std::string> split_lines(const std::string& body) {
+    std::vector<std::string> lines;
+    std::istringstream in(body);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+// "lease ID" -> ID, or 0
+int64_t parse_lease_line(const std::string& line) {
+    std::istringstream in(line);
+    std::string word;
+    int64_t id = 0;
+    if (!(in >> word >> id) || word != "lease") return 0;
+    return id;
+}
+
+// "ids FIRST STATES" lines for the known IDs of bitmap in [first, last]
+void append_states(std::string& out, const IdBitmap& bitmap, uint64_t first, uint64_t last) {
+    for (uint64_t start = first; start <= last; start += STATES_PER_LINE) {
+        uint64_t end = std::min<uint64_t>(last, start + STATES_PER_LINE - 1);
+        std::string states;
+        states.reserve(end - start + 1);
+        bool known = false;
+        for (uint64_t id = start; id <= end; ++id) {
+            IdState state = bitmap.get(id);
+            known |= state != IdState::UNKNOWN;
+            states += static_cast<char>('0' + static_cast<int>(state));
+        }
+        if (known) out += "ids " + std::to_string(start) + " " + states + "\n";
+    }
+}
+
+// Apply an "ids FIRST STATES" line; UNKNOWN digits leave the ID as it is
+bool read_states(const std::string& line, IdBitmap& bitmap) {
+    std::istringstream in(line);
+    std::string word, states;
+    uint64_t first = 0;
+    if (!(in >> word >> first >> states)) return false;
+    for (size_t i = 0; i < states.size(); ++i) {
+        int state = states[i] - '0';
+        if (state == static_cast<int>(IdState::MISSING) || state == static_cast<int>(IdState::PRESENT)) {
+            bitmap.set(first + i, static_cast<IdState>(state));
+        }
+    }
+    return true;
+}
+
+const char* kind_name(ShardLease::Kind kind) {
+    return kind == ShardLease::Kind::PAGES ? "pages" : "ids";
+}
+
+size_t append_response(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    static_cast<std::string*>(userdata)->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+} // namespace
+
+// ShardCoordinator
+
+ShardCoordinator::ShardCoordinator(Database& db, const std::vector<DataSetJob>& jobs,
+                                   const std::string& download_dir)
+    : db_(db), download_dir_(download_dir),
+      listener_([this](const HttpRequest& request) { return respond(request); }, 10, MAX_REQUEST_BYTES) {
+    for (const auto& job : jobs) {
+        DataSetWork work;
+        work.job = job;
+        work.pages = job.mode != OperationMode::BRUTE_FORCE;
+        work.ids = job.mode == OperationMode::BRUTE_FORCE || job.mode == OperationMode::HYBRID;
+        sets_.push_back(std::move(work));
+    }
+}
+
+ShardCoordinator::~ShardCoordinator() {
+    stop();
+}
+
+void ShardCoordinator::load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto& work : sets_) {
+        const DataSetConfig& config = work.job.config;
+
+        if (work.pages) {
+            int max_page = db_.get_max_page(config.id);
+            if (max_page < 0) max_page = work.job.last_page >= 0 ? work.job.last_page : config.max_page_index;
+            if (max_page >= 0) {
+                // Known page count: queue the whole range, leases skip what is scraped
+                work.end_known = true;
+                work.last_page = max_page;
+                db_.add_pages_batch(config.id, 0, max_page);
+                for (int64_t first = 0; first <= max_page; first += SHARD_PAGES_PER_LEASE) {
+                    work.page_ranges.emplace_back(first, std::min<int64_t>(max_page, first + SHARD_PAGES_PER_LEASE - 1));
+                }
+                work.next_page = max_page + 1;
+            }
+            if (work.job.mode == OperationMode::REFRESH) {
+                db_.reset_scraped_pages(config.id);
+            }
+        }
+
+        if (work.ids) {
+            if (config.first_file_id == 0 || config.last_file_id < config.first_file_id) {
+                work.ids = false;
+                continue;
+            }
+            // As the brute force worker resumes: stored bitmap, then files rows
+            IdBitmap bitmap;
+            if (db_.load_id_bitmap(config.id, bitmap)) {
+                if (bitmap.first() != config.first_file_id || bitmap.last() != config.last_file_id) {
+                    bitmap = bitmap.rebased(config.first_file_id, config.last_file_id);
+                }
+            } else {
+                bitmap = IdBitmap(config.first_file_id, config.last_file_id);
+            }
+            Scraper scraper(config);
+            db_.for_each_file_status(config.id, [&](const std::string& file_id, DownloadStatus status) {
+                bitmap.set(scraper.parse_file_id_number(file_id),
+                           status == DownloadStatus::NOT_FOUND ? IdState::MISSING : IdState::PRESENT);
+            });
+            work.bitmap = std::move(bitmap);
+            work.next_id = work.bitmap.first();
+        }
+    }
+}
+
+bool ShardCoordinator::start(int port, const std::string& bind_address) {
+    return listener_.start(port, bind_address, 64);
+}
+
+void ShardCoordinator::stop() {
+    listener_.stop();
+}
+
+bool ShardCoordinator::finished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return all_done();
+}
+
+size_t ShardCoordinator::active_leases() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return leases_.size();
+}
+
+size_t ShardCoordinator::workers_seen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return workers_.size();
+}
+
+std::string ShardCoordinator::handle(const std::string& path, const std::string& body) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reclaim_expired();
+
+    std::vector<std::string> lines = split_lines(body);
+    if (path == "/lease") {
+        std::string worker = "unnamed";
+        if (!lines.empty() && lines[0].compare(0, 7, "worker ") == 0) worker = lines[0].substr(7);
+        return acquire(worker);
+    }
+
+    int64_t id = lines.empty() ? 0 : parse_lease_line(lines[0]);
+    auto active = leases_.find(id);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(SHARD_LEASE_SECONDS);
+
+    if (path == "/renew") {
+        if (active == leases_.end()) return "lost\n";
+        active->second.expires = deadline;
+        return "ok\n";
+    }
+
+    if (path == "/report") {
+        // Results are good even from a lease that was given away since
+        auto issued = issued_.find(id);
+        if (issued == issued_.end()) return "error unknown lease\n";
+        if (DataSetWork* work = find_work(issued->second.data_set)) {
+            apply_report(*work, lines);
+        }
+        if (active == leases_.end()) return "lost\n";
+        active->second.expires = deadline;
+        return "ok\n";
+    }
+
+    if (path == "/done") {
+        if (active == leases_.end()) return "lost\n";
+        ShardLease lease = active->second.lease;
+        leases_.erase(active);
+        // Pages the worker did not get to (it was blocked or stopped) go back
+        // in the queue; IDs it could not probe wait for the next pass
+        if (lease.kind == ShardLease::Kind::PAGES) requeue(lease);
+        return "ok\n";
+    }
+
+    return "";
+}
+
+std::string ShardCoordinator::acquire(const std::string& worker) {
+    workers_.insert(worker);
+
+    std::optional<ShardLease> lease = next_lease();
+    if (!lease) {
+        return all_done() ? "done\n" : "wait " + std::to_string(SHARD_WAIT_SECONDS) + "\n";
+    }
+
+    lease->id = next_lease_id_++;
+    leases_[lease->id] = ActiveLease{*lease, worker,
+                                     std::chrono::steady_clock::now() + std::chrono::seconds(SHARD_LEASE_SECONDS)};
+    issued_[lease->id] = *lease;
+
+    const DataSetWork* work = find_work(lease->data_set);
+    std::string reply = "lease " + std::to_string(lease->id) + " " + kind_name(lease->kind) + " " +
+                        std::to_string(lease->data_set) + " " + std::to_string(lease->first) + " " +
+                        std::to_string(lease->last) + "\n" +
+                        "base_url " + work->job.config.base_url + "\n" +
+                        "file_url_base " + work->job.config.file_url_base + "\n";
+    if (lease->kind == ShardLease::Kind::IDS) {
+        // The worker skips what is known already (a later pass or a reclaimed range)
+        append_states(reply, work->bitmap, lease->first, lease->last);
+    }
+    return reply;
+}
+
+std::optional<ShardLease> ShardCoordinator::next_lease() {
+    // Data sets take turns, so every set makes progress with few workers
+    for (size_t i = 0; i < sets_.size(); ++i) {
+        DataSetWork& work = sets_[(next_set_ + i) % sets_.size()];
+        std::optional<ShardLease> lease = next_page_lease(work);
+        if (!lease) lease = next_id_lease(work);
+        if (lease) {
+            next_set_ = (next_set_ + i + 1) % sets_.size();
+            return lease;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<ShardLease> ShardCoordinator::next_page_lease(DataSetWork& work) {
+    if (!work.pages || work.pages_done) return std::nullopt;
+    const int data_set = work.job.config.id;
+
+    for (;;) {
+        while (!work.page_ranges.empty()) {
+            auto [first, last] = work.page_ranges.front();
+            work.page_ranges.pop_front();
+            if (work.end_known) last = std::min(last, work.last_page);
+            if (first > last) continue;
+
+            // Lease the first run of pages in the range that is still unscraped
+            std::vector<int> pages = db_.get_unscraped_pages(data_set, static_cast<int>(last - first + 1),
+                                                             static_cast<int>(first), static_cast<int>(last));
+            if (pages.empty()) continue;
+            size_t run = 1;
+            while (run < pages.size() && pages[run] == pages[run - 1] + 1) ++run;
+            if (run < pages.size()) work.page_ranges.emplace_front(pages[run], last);
+
+            ShardLease lease;
+            lease.kind = ShardLease::Kind::PAGES;
+            lease.data_set = data_set;
+            lease.first = static_cast<uint64_t>(pages.front());
+            lease.last = static_cast<uint64_t>(pages[run - 1]);
+            return lease;
+        }
+
+        if (work.end_known && work.next_page > work.last_page) {
+            work.pages_done = !leases_outstanding(data_set, ShardLease::Kind::PAGES);
+            return std::nullopt;
+        }
+
+        // Unknown page count: extend the frontier one lease at a time until
+        // a worker reports a page without links
+        int64_t first = work.next_page;
+        int64_t last = first + SHARD_PAGES_PER_LEASE - 1;
+        if (work.end_known) last = std::min(last, work.last_page);
+        db_.add_pages_batch(data_set, static_cast<int>(first), static_cast<int>(last));
+        work.page_ranges.emplace_back(first, last);
+        work.next_page = last + 1;
+    }
+}
+
+std::optional<ShardLease> ShardCoordinator::next_id_lease(DataSetWork& work) {
+    if (!work.ids || work.ids_done) return std::nullopt;
+    const IdBitmap& bitmap = work.bitmap;
+
+    ShardLease lease;
+    lease.kind = ShardLease::Kind::IDS;
+    lease.data_set = work.job.config.id;
+
+    while (!work.id_ranges.empty()) {
+        auto [first, last] = work.id_ranges.front();
+        work.id_ranges.pop_front();
+        first = bitmap.next_unknown(first);
+        if (first > last) continue;
+        lease.first = first;
+        lease.last = last;
+        return lease;
+    }
+
+    for (;;) {
+        uint64_t first = bitmap.next_unknown(work.next_id);
+        if (first <= bitmap.last()) {
+            lease.first = first;
+            lease.last = std::min(bitmap.last(), first + SHARD_IDS_PER_LEASE - 1);
+            work.next_id = lease.last + 1;
+            return lease;
+        }
+
+        // End of a pass: IDs whose probes failed everywhere get another one
+        // once every range of this pass is back
+        if (leases_outstanding(lease.data_set, ShardLease::Kind::IDS)) return std::nullopt;
+        if (bitmap.count(IdState::UNKNOWN) == 0 || work.pass + 1 >= MAX_RETRY_ATTEMPTS) {
+            work.ids_done = true;
+            return std::nullopt;
+        }
+        ++work.pass;
+        work.next_id = bitmap.first();
+    }
+}
+
+bool ShardCoordinator::leases_outstanding(int data_set, ShardLease::Kind kind) const {
+    for (const auto& [id, active] : leases_) {
+        if (active.lease.data_set == data_set && active.lease.kind == kind) return true;
+    }
+    return false;
+}
+
+bool ShardCoordinator::all_done() const {
+    if (!leases_.empty()) return false;
+    for (const auto& work : sets_) {
+        if ((work.pages && !work.pages_done) || (work.ids && !work.ids_done)) return false;
+    }
+    return true;
+}
+
+void ShardCoordinator::reclaim_expired() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = leases_.begin(); it != leases_.end();) {
+        if (it->second.expires > now) {
+            ++it;
+            continue;
+        }
+        std::cerr << "Lease " << it->first << " of " << it->second.worker << " expired, reassigning "
+                  << kind_name(it->second.lease.kind) << " " << it->second.lease.first << "-"
+                  << it->second.lease.last << "\n";
+        ShardLease lease = it->second.lease;
+        it = leases_.erase(it);
+        requeue(lease);
+        ++reassigned_;
+    }
+}
+
+void ShardCoordinator::requeue(const ShardLease& lease) {
+    DataSetWork* work = find_work(lease.data_set);
+    if (!work) return;
+    if (lease.kind == ShardLease::Kind::PAGES) {
+        work->page_ranges.emplace_front(static_cast<int64_t>(lease.first), static_cast<int64_t>(lease.last));
+        work->pages_done = false;
+    } else {
+        work->id_ranges.emplace_front(lease.first, lease.last);
+        work->ids_done = false;
+    }
+}
+
+void ShardCoordinator::apply_report(DataSetWork& work, const std::vector<std::string>& lines) {
+    const DataSetConfig& config = work.job.config;
+    Scraper scraper(config);
+    std::vector<FileRecord> completed;
+    std::vector<FileRecord> queued;
+    bool bitmap_changed = false;
+
+    for (size_t i = 1; i < lines.size(); ++i) {
+        std::istringstream in(lines[i]);
+        std::string kind;
+        in >> kind;
+
+        if (kind == "page") {
+            int page = 0, pdf_count = 0;
+            if (!(in >> page >> pdf_count) || page < 0 || pdf_count < 0) continue;
+            db_.mark_page_scraped(config.id, page, pdf_count);
+            if (pdf_count == 0) end_of_pages(work, page);
+        } else if (kind == "file") {
+            std::string file_id;
+            int status = 0;
+            int64_t size = 0;
+            if (!(in >> file_id >> status >> size)) continue;
+            // The ID ends up in a local path, a URL and the database, so only
+            // well-formed IDs and known states are taken from the wire
+            if (!scraper.is_valid_file_id(file_id) ||
+                status < static_cast<int>(DownloadStatus::PENDING) ||
+                status > static_cast<int>(DownloadStatus::SKIPPED)) {
+                std::cerr << "Ignoring malformed shard report line: " << lines[i] << "\n";
+                continue;
+            }
+
+            FileRecord record{};
+            record.data_set = config.id;
+            record.file_id = file_id;
+            record.url = scraper.build_file_url(file_id);
+            record.local_path = download_path(download_dir_, config.id, file_id);
+            record.file_size = size;
+            auto state = static_cast<DownloadStatus>(status);
+            if (state == DownloadStatus::COMPLETED || state == DownloadStatus::SKIPPED) {
+                completed.push_back(std::move(record));
+            } else {
+                // Found but not fetched by the worker: queued here, for a
+                // download-only run or another pass
+                record.status = state == DownloadStatus::NOT_FOUND ? DownloadStatus::NOT_FOUND
+                                                                   : DownloadStatus::PENDING;
+                queued.push_back(std::move(record));
+            }
+            if (work.ids) {
+                work.bitmap.set(scraper.parse_file_id_number(file_id),
+                                state == DownloadStatus::NOT_FOUND ? IdState::MISSING : IdState::PRESENT);
+                bitmap_changed = true;
+            }
+        } else if (kind == "ids" && work.ids) {
+            bitmap_changed |= read_states(lines[i], work.bitmap);
+        }
+    }
+
+    if (!db_.add_files_batch(queued) || db_.reconcile_local_files(completed) < 0) {
+        std::cerr << "Failed to merge a shard report: " << db_.get_last_error() << "\n";
+    }
+    if (bitmap_changed) {
+        db_.save_id_bitmap(config.id, work.bitmap);
+    }
+}
+
+void ShardCoordinator::end_of_pages(DataSetWork& work, int64_t empty_page) {
+    // The first page without links is one past the end, as for detect_max_page()
+    if (work.end_known && empty_page > work.last_page) return;
+    work.end_known = true;
+    work.last_page = empty_page - 1;
+    db_.remove_pages_after(work.job.config.id, static_cast<int>(work.last_page));
+    if (work.last_page >= 0) {
+        db_.set_max_page(work.job.config.id, static_cast<int>(work.last_page));
+    }
+}
+
+ShardCoordinator::DataSetWork* ShardCoordinator::find_work(int data_set) {
+    for (auto& work : sets_) {
+        if (work.job.config.id == data_set) return &work;
+    }
+    return nullptr;
+}
+
+HttpResponse ShardCoordinator::respond(const HttpRequest& request) {
+    HttpResponse response;
+    if (request.method != "POST") {
+        response.status = "405 Method Not Allowed";
+        response.body = "method not allowed\n";
+        return response;
+    }
+    response.body = handle(request.path, request.body);
+    if (response.body.empty()) {
+        response.status = "404 Not Found";
+        response.body = "not found\n";
+    }
+    return response;
+}
+
+// ShardWorker
+
+ShardWorker::ShardWorker(const std::string& coordinator, const std::string& download_dir,
+                         const std::string& name, Configure configure)
+    : base_url_("http://" + coordinator), download_dir_(download_dir), name_(name),
+      configure_(std::move(configure)) {
+    CurlGlobalInit::instance();
+}
+
+int ShardWorker::run(const std::atomic<bool>& interrupted) {
+    int completed = 0;
+    int failures = 0;
+
+    while (!interrupted && !blocked_) {
+        std::optional<std::string> reply = post("/lease", "worker " + name_ + "\n");
+        if (!reply) {
+            // The coordinator may be restarting; give up after a minute
+            if (++failures > 60 / SHARD_WAIT_SECONDS) return completed;
+            std::this_thread::sleep_for(std::chrono::seconds(SHARD_WAIT_SECONDS));
+            continue;
+        }
+        failures = 0;
+
+        std::vector<std::string> lines = split_lines(*reply);
+        std::istringstream head(lines.empty() ? "" : lines[0]);
+        std::string word;
+        head >> word;
+        if (word == "done") break;
+        if (word == "wait") {
+            int seconds = SHARD_WAIT_SECONDS;
+            head >> seconds;
+            for (int i = 0; i < seconds * 10 && !interrupted; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+
+        ShardLease lease;
+        std::string kind;
+        if (word != "lease" || !(head >> lease.id >> kind >> lease.data_set >> lease.first >> lease.last) ||
+            lease.data_set < MIN_DATA_SET || lease.data_set > MAX_DATA_SET || lease.last < lease.first) {
+            std::cerr << "Unexpected reply from the coordinator: " << (lines.empty() ? "" : lines[0]) << "\n";
+            return completed;
+        }
+        lease.kind = kind == "ids" ? ShardLease::Kind::IDS : ShardLease::Kind::PAGES;
+
+        DataSetConfig config = get_data_set_config(lease.data_set);
+        IdBitmap known;
+        if (lease.kind == ShardLease::Kind::IDS) {
+            config.first_file_id = lease.first;
+            config.last_file_id = lease.last;
+            known = IdBitmap(lease.first, lease.last);
+        }
+        for (size_t i = 1; i < lines.size(); ++i) {
+            if (lines[i].compare(0, 9, "base_url ") == 0) {
+                config.base_url = lines[i].substr(9);
+            } else if (lines[i].compare(0, 14, "file_url_base ") == 0) {
+                config.file_url_base = lines[i].substr(14);
+            } else if (lines[i].compare(0, 4, "ids ") == 0) {
+                read_states(lines[i], known);
+            }
+        }
+
+        if (work(lease, config, known, interrupted)) ++completed;
+    }
+    return completed;
+}
+
+bool ShardWorker::work(const ShardLease& lease, const DataSetConfig& config, const IdBitmap& known,
+                       const std::atomic<bool>& interrupted) {
+    std::filesystem::path scratch = std::filesystem::path(download_dir_) / ".shard";
+    std::error_code ec;
+    std::filesystem::create_directories(scratch, ec);
+    std::string db_path = (scratch / ("lease-" + std::to_string(lease.id) + ".db")).string();
+    auto remove_db = [&db_path] {
+        std::error_code ignored;
+        for (const char* suffix : {"", "-wal", "-shm"}) {
+            std::filesystem::remove(db_path + suffix, ignored);
+        }
+    };
+    remove_db();
+
+    if (known.count(IdState::UNKNOWN) < known.size()) {
+        // IDs another worker already probed: brute force resumes past them
+        Database db(db_path);
+        if (!db.initialize() || !db.save_id_bitmap(lease.data_set, known)) {
+            std::cerr << "Failed to set up " << db_path << "\n";
+            return false;
+        }
+    }
+
+    DataSetJob job;
+    job.config = config;
+    if (lease.kind == ShardLease::Kind::PAGES) {
+        job.mode = OperationMode::SCRAPER;
+        job.first_page = static_cast<int>(lease.first);
+        job.last_page = static_cast<int>(lease.last);
+    } else {
+        job.mode = OperationMode::BRUTE_FORCE;
+    }
+
+    bool lost = false;
+    DownloadStats stats{};
+    {
+        DownloadManager manager(db_path, download_dir_);
+        if (!manager.initialize()) {
+            std::cerr << "Failed to set up " << db_path << "\n";
+            remove_db();
+            return false;
+        }
+        if (configure_) configure_(manager);
+        manager.start({job});
+
+        auto last_renew = std::chrono::steady_clock::now();
+        while (manager.is_running() && !interrupted) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_renew < std::chrono::seconds(SHARD_RENEW_SECONDS)) continue;
+            last_renew = now;
+            std::optional<std::string> reply = post("/renew", "lease " + std::to_string(lease.id) + "\n");
+            if (reply && reply->compare(0, 4, "lost") == 0) {
+                // Reassigned: someone else is doing this range now
+                lost = true;
+                break;
+            }
+        }
+        manager.stop();
+        stats = manager.get_stats();
+        blocked_ = manager.scrape_blocked();
+    }
+
+    // The coordinator takes results even from a lease it has given away since,
+    // so what got done before the loss is sent too; only /done is ours alone
+    bool completed = send_results(lease, db_path) && !lost;
+    if (completed) {
+        std::optional<std::string> reply = post("/done", "lease " + std::to_string(lease.id) + "\n");
+        completed = reply && reply->compare(0, 2, "ok") == 0;
+    }
+    remove_db();
+
+    if (on_lease_done_) on_lease_done_(lease, stats, completed);
+    return completed && !interrupted;
+}
+
+bool ShardWorker::send_results(const ShardLease& lease, const std::string& db_path) {
+    Database db(db_path);
+    if (!db.initialize()) return false;
+
+    const std::string header = "lease " + std::to_string(lease.id) + "\n";
+    std::string body = header;
+    size_t lines = 0;
+    bool ok = true;
+    auto add = [&](const std::string& line) {
+        body += line;
+        if (++lines < SHARD_REPORT_LINES) return;
+        std::optional<std::string> reply = post("/report", body);
+        ok &= reply && reply->compare(0, 5, "error") != 0;
+        body = header;
+        lines = 0;
+    };
+
+    if (lease.kind == ShardLease::Kind::PAGES) {
+        for (uint64_t page = lease.first; page <= lease.last; ++page) {
+            auto record = db.get_page(lease.data_set, static_cast<int>(page));
+            if (record && record->scraped) {
+                add("page " + std::to_string(page) + " " + std::to_string(record->pdf_count) + "\n");
+            }
+        }
+    }
+
+    db.for_each_file_status(lease.data_set, [&](const std::string& file_id, DownloadStatus status) {
+        int64_t size = 0;
+        if (status == DownloadStatus::COMPLETED || status == DownloadStatus::SKIPPED) {
+            std::error_code ec;
+            auto bytes = std::filesystem::file_size(download_path(download_dir_, lease.data_set, file_id), ec);
+            if (!ec) size = static_cast<int64_t>(bytes);
+        }
+        add("file " + file_id + " " + std::to_string(static_cast<int>(status)) + " " + std::to_string(size) + "\n");
+    });
+
+    IdBitmap bitmap;
+    if (lease.kind == ShardLease::Kind::IDS && db.load_id_bitmap(lease.data_set, bitmap)) {
+        std::string states;
+        append_states(states, bitmap, bitmap.first(), bitmap.last());
+        std::istringstream in(states);
+        std::string line;
+        while (std::getline(in, line)) add(line + "\n");
+    }
+
+    if (lines > 0) {
+        std::optional<std::string> reply = post("/report", body);
+        ok &= reply && reply->compare(0, 5, "error") != 0;
+    }
+    return ok;
+}
+
+std::optional<std::string> ShardWorker::post(const std::string& path, const std::string& body) {
+    CURL* curl = curl_easy_init();
+    if (!curl) return std::nullopt;
+
+    std::string response;
+    std::string url = base_url_ + path;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, append_response);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+    CURLcode res = curl_easy_perform(curl);
+    long code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK || code != 200) {
+        std::cerr << "Coordinator " << url << ": "
+                  << (res != CURLE_OK ? std::string(curl_easy_strerror(res)) : "HTTP " + std::to_string(code)) << "\n";
+        return std::nullopt;
+    }
+    return response;
+}
+
+} // namespace efgrabber
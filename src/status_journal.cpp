@@ -0,0 +1,129 @@
+/*
+ * status_journal.cpp - Implementation of the file status write-behind journal
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/status_journal.h"
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+namespace efgrabber {
+
+StatusJournal::StatusJournal(Database& db, std::chrono::milliseconds flush_interval, size_t batch_size)
+    : db_(db), flush_interval_(flush_interval), batch_size_(batch_size > 0 ? batch_size : 1) {
+    thread_ = std::thread(&StatusJournal::flusher_thread, this);
+}
+
+StatusJournal::~StatusJournal() {
+    stop();
+}
+
+void StatusJournal::push(StatusUpdate update) {
+    Node* node = new Node{std::move(update), head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(node->next, node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+        // node->next was refreshed by the failed CAS; retry
+    }
+
+    if (pending_.fetch_add(1, std::memory_order_relaxed) + 1 == batch_size_) {
+        wake_cv_.notify_one();
+    }
+}
+
+bool StatusJournal::flush() {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+
+    // Detach the whole list at once; it is newest-first, so reverse it
+    Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+    if (!node && failed_.empty()) return true;
+
+    // A batch that failed before goes first, so per-row order still holds
+    std::vector<StatusUpdate> updates = std::move(failed_);
+    failed_.clear();
+    updates.reserve(updates.size() + pending_.load(std::memory_order_relaxed));
+    size_t carried = updates.size();
+    Node* reversed = nullptr;
+    while (node) {
+        Node* next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+    while (reversed) {
+        Node* next = reversed->next;
+        updates.push_back(std::move(reversed->update));
+        delete reversed;
+        reversed = next;
+    }
+    pending_.fetch_sub(updates.size() - carried, std::memory_order_relaxed);
+
+    if (!db_.apply_status_updates(updates)) {
+        std::cerr << "[StatusJournal] Failed to apply " << updates.size()
+                  << " status updates, will retry: " << db_.get_last_error() << std::endl;
+        retrying_.store(updates.size(), std::memory_order_relaxed);
+        failed_ = std::move(updates);
+        return false;
+    }
+
+    retrying_.store(0, std::memory_order_relaxed);
+    flushed_total_ += static_cast<int64_t>(updates.size());
+    transactions_++;
+    return true;
+}
+
+void StatusJournal::stop() {
+    if (stop_.exchange(true)) return;
+
+    wake_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Whatever still fails is left to crash recovery (see class comment)
+    auto delay = flush_interval_;
+    for (int attempt = 1; !flush() && attempt < STATUS_STOP_ATTEMPTS; ++attempt) {
+        std::this_thread::sleep_for(delay);
+        delay *= 2;
+    }
+}
+
+void StatusJournal::flusher_thread() {
+    const auto max_delay = std::max(flush_interval_, std::chrono::milliseconds(STATUS_RETRY_MAX_MS));
+    auto delay = flush_interval_;
+    while (!stop_) {
+        bool backing_off = delay > flush_interval_;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            // A full batch doesn't cut a backoff short
+            wake_cv_.wait_for(lock, delay, [this, backing_off] {
+                return stop_.load() ||
+                       (!backing_off && pending_.load(std::memory_order_relaxed) >= batch_size_);
+            });
+        }
+        if (stop_) break;
+        delay = flush() ? flush_interval_
+                        : std::min(max_delay, std::max(delay * 2, std::chrono::milliseconds(1)));
+    }
+}
+
+} // namespace efgrabber
@@ -22,13 +22,25 @@
  */
 
 #include "efgrabber/thread_pool.h"
+#include <algorithm>
 #include <iostream>
 
 namespace efgrabber {
 
-ThreadPool::ThreadPool(size_t num_threads) {
+namespace {
+// The pool and deque of the worker running on this thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+}
+
+ThreadPool::ThreadPool(size_t num_threads, size_t max_queued)
+    : max_queued_(max_queued) {
+    num_threads = std::max<size_t>(1, num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
     for (size_t i = 0; i < num_threads; ++i) {
-        workers_.emplace_back(&ThreadPool::worker_thread, this);
+        workers_.emplace_back(&ThreadPool::worker_thread, this, i);
     }
 }
 
@@ -36,25 +48,179 @@ ThreadPool::~ThreadPool() {
     shutdown();
 }
 
-void ThreadPool::worker_thread() {
-    while (true) {
-        std::function<void()> task;
+void ThreadPool::WorkerQueue::push_back(Task task) {
+    if (count == ring.size()) {
+        std::vector<Task> grown(std::max<size_t>(16, ring.size() * 2));
+        for (size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(ring[(head + i) % ring.size()]);
+        }
+        ring = std::move(grown);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = std::move(task);
+    count++;
+    size.store(count, std::memory_order_relaxed);
+}
 
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            condition_.wait(lock, [this] {
-                return stop_ || !tasks_.empty();
-            });
+bool ThreadPool::WorkerQueue::pop_front(Task& task) {
+    if (count == 0) return false;
+    task = std::move(ring[head]);
+    head = (head + 1) % ring.size();
+    count--;
+    size.store(count, std::memory_order_relaxed);
+    return true;
+}
 
-            if (stop_ && tasks_.empty()) {
-                return;
+int ThreadPool::worker_index() const {
+    return current_pool == this ? static_cast<int>(current_index) : -1;
+}
+
+size_t ThreadPool::reserve(bool wait) {
+    size_t queued;
+    if (max_queued_ == 0 || worker_index() >= 0) {
+        queued = queued_.fetch_add(1) + 1;
+    } else {
+        queued = queued_.load();
+        while (true) {
+            if (queued >= max_queued_) {
+                if (!wait) {
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return 0;
+                }
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                waiting_submitters_++;
+                space_condition_.wait(lock, [this] {
+                    return stop_ || queued_.load() < max_queued_;
+                });
+                waiting_submitters_--;
+                if (stop_) return 0;
+                queued = queued_.load();
+                continue;
             }
+            if (queued_.compare_exchange_weak(queued, queued + 1)) {
+                queued++;
+                break;
+            }
+        }
+    }
 
-            task = std::move(tasks_.front());
-            tasks_.pop();
+    // Checked after counting the task: either shutdown() sees it and the
+    // workers wait for it, or we see stop_ and back out
+    if (stop_) {
+        queued_--;
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
         }
+        work_condition_.notify_all();
+        return 0;
+    }
+    return queued;
+}
 
+void ThreadPool::enqueue(Task task, size_t queued) {
+    int own = worker_index();
+    size_t index = own >= 0 ? static_cast<size_t>(own)
+                            : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->push_back(std::move(task));
+    }
+
+    size_t peak = peak_queued_.load(std::memory_order_relaxed);
+    while (queued > peak && !peak_queued_.compare_exchange_weak(peak, queued, std::memory_order_relaxed)) {
+    }
+
+    // The first task into an empty pool always wakes a worker; later ones only
+    // while sleepers outnumber the wakeups already under way
+    wake_worker(queued == 1);
+}
+
+void ThreadPool::wake_worker(bool force) {
+    // A worker about to sleep counts itself idle before checking queued_, so
+    // either it sees the new task or we see it; the lock orders the wakeup
+    // after its predicate check
+    size_t idle = idle_workers_.load();
+    if (idle == 0 || (!force && waking_.load() >= idle)) return;
+
+    waking_++;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    work_condition_.notify_one();
+}
+
+bool ThreadPool::take(size_t index, Task& task) {
+    // Oldest first everywhere, so tasks start roughly in submission order.
+    // Victims that look empty or are locked are skipped rather than waited on.
+    for (size_t offset = 0; offset < queues_.size(); ++offset) {
+        WorkerQueue& queue = *queues_[(index + offset) % queues_.size()];
+        if (queue.size.load(std::memory_order_relaxed) == 0) continue;
+
+        std::unique_lock<std::mutex> lock(queue.mutex, std::defer_lock);
+        if (offset == 0) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            continue;
+        }
+        if (!queue.pop_front(task)) continue;
+        lock.unlock();
+
+        // Count it active before it leaves queued_, so wait_all() cannot slip
+        // in between
+        if (offset > 0) steals_.fetch_add(1, std::memory_order_relaxed);
         active_tasks_++;
+        size_t queued = queued_.fetch_sub(1) - 1;
+
+        if (queued > 0) {
+            // More work behind this one: bring in another worker to share it
+            wake_worker(false);
+        } else if (stop_) {
+            // Idle workers may exit now
+            {
+                std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+            }
+            work_condition_.notify_all();
+        }
+        if (waiting_submitters_.load() > 0) {
+            {
+                std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+            }
+            space_condition_.notify_one();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::worker_thread(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        Task task;
+        if (!take(index, task)) {
+            if (queued_.load() > 0) {
+                // Work exists but is still being pushed, or every deque
+                // holding it was busy: let that thread run
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            idle_workers_++;
+            work_condition_.wait(lock, [this] {
+                return stop_ || queued_.load() > 0;
+            });
+            idle_workers_--;
+            size_t waking = waking_.load();
+            while (waking > 0 && !waking_.compare_exchange_weak(waking, waking - 1)) {
+            }
+            if (stop_ && queued_.load() == 0) {
+                return;
+            }
+            continue;
+        }
+
         try {
             task();
         } catch (...) {
@@ -71,46 +237,48 @@ void ThreadPool::worker_thread() {
                 }
             }
         }
-        active_tasks_--;
-        completed_tasks_++;
-
-        completion_condition_.notify_all();
+        // Destroy captures before the task counts as finished
+        task = Task();
+        completed_tasks_.fetch_add(1, std::memory_order_relaxed);
+        if (active_tasks_.fetch_sub(1) == 1 && queued_.load() == 0) {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+            }
+            completion_condition_.notify_all();
+        }
     }
 }
 
-void ThreadPool::submit_detached(std::function<void()> task) {
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        if (stop_) {
-            // Silently ignore submissions to stopped pool instead of throwing
-            return;
-        }
-        tasks_.emplace(std::move(task));
-        total_tasks_++;
+void ThreadPool::submit_detached(Task task) {
+    // Silently ignore submissions to stopped pool instead of throwing
+    if (size_t queued = reserve(true)) {
+        enqueue(std::move(task), queued);
     }
-    condition_.notify_one();
 }
 
-size_t ThreadPool::queue_size() const {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
-    return tasks_.size();
+bool ThreadPool::try_submit_detached(Task task) {
+    size_t queued = reserve(false);
+    if (queued == 0) return false;
+    enqueue(std::move(task), queued);
+    return true;
 }
 
 void ThreadPool::wait_all() {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
     completion_condition_.wait(lock, [this] {
-        return tasks_.empty() && active_tasks_ == 0;
+        return queued_.load() == 0 && active_tasks_.load() == 0;
     });
 }
 
 void ThreadPool::shutdown() {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
         if (stop_) return;
         stop_ = true;
     }
 
-    condition_.notify_all();
+    work_condition_.notify_all();
+    space_condition_.notify_all();
 
     for (auto& worker : workers_) {
         if (worker.joinable()) {
@@ -0,0 +1,176 @@
+/*
+ * work_queue.cpp - Implementation of the leased download work queue
+ * Copyright © 2026 Kirn Gill II <segin2005@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "efgrabber/work_queue.h"
+#include <algorithm>
+#include <iostream>
+
+namespace efgrabber {
+
+WorkQueue::WorkQueue(RefillFunction refill, size_t batch_size, size_t low_water,
+                     std::chrono::milliseconds idle_refill_interval)
+    : refill_(std::move(refill)),
+      batch_size_(std::max<size_t>(1, batch_size)),
+      low_water_(std::min(low_water, std::max<size_t>(1, batch_size))),
+      idle_refill_interval_(idle_refill_interval) {
+}
+
+WorkQueue::~WorkQueue() {
+    stop();
+}
+
+void WorkQueue::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) return;
+    stop_ = false;
+    exhausted_ = false;
+    thread_ = std::thread(&WorkQueue::refill_thread, this);
+}
+
+std::vector<FileRecord> WorkQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    refill_cv_.notify_all();
+    items_cv_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FileRecord> remaining(std::make_move_iterator(items_.begin()),
+                                      std::make_move_iterator(items_.end()));
+    items_.clear();
+    return remaining;
+}
+
+std::optional<FileRecord> WorkQueue::pop(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    items_cv_.wait_for(lock, timeout, [this] { return stop_ || !items_.empty(); });
+
+    if (stop_ || items_.empty()) {
+        return std::nullopt;
+    }
+
+    FileRecord record = std::move(items_.front());
+    items_.pop_front();
+
+    // Start refilling before the queue runs dry
+    if (items_.size() < low_water_) {
+        refill_cv_.notify_one();
+    }
+    return record;
+}
+
+void WorkQueue::notify() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notified_ = true;
+    }
+    refill_cv_.notify_one();
+}
+
+void WorkQueue::notify_at(std::chrono::steady_clock::time_point deadline) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (wake_at_ && *wake_at_ <= deadline) return;
+        wake_at_ = deadline;
+    }
+    // Let the refill thread shorten its current wait
+    refill_cv_.notify_one();
+}
+
+void WorkQueue::set_batch_size(size_t batch_size, size_t low_water) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch_size_ = std::max<size_t>(1, batch_size);
+        low_water_ = std::min(low_water, batch_size_);
+    }
+    refill_cv_.notify_one();
+}
+
+size_t WorkQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+}
+
+bool WorkQueue::drained() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.empty() && exhausted_ && !notified_ && !refilling_;
+}
+
+void WorkQueue::refill_thread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_) {
+        // Wake on demand or at the next notify_at() deadline; fall through on
+        // timeout so rows added without notify are still picked up eventually
+        auto wake = std::chrono::steady_clock::now() + idle_refill_interval_;
+        if (wake_at_ && *wake_at_ < wake) wake = *wake_at_;
+        auto current_wake_at = wake_at_;
+        refill_cv_.wait_until(lock, wake, [this, &current_wake_at] {
+            return stop_ || wake_at_ != current_wake_at ||
+                   (items_.size() < low_water_ && (!exhausted_ || notified_));
+        });
+
+        if (stop_) break;
+        if (wake_at_ != current_wake_at && std::chrono::steady_clock::now() < *wake_at_) {
+            continue;  // An earlier deadline arrived; wait for that one instead
+        }
+        if (wake_at_ && std::chrono::steady_clock::now() >= *wake_at_) {
+            wake_at_.reset();
+            notified_ = true;
+        }
+        if (items_.size() >= low_water_) continue;
+
+        size_t want = batch_size_ > items_.size() ? batch_size_ - items_.size() : 1;
+        notified_ = false;
+        refilling_ = true;
+        lock.unlock();
+
+        std::vector<FileRecord> claimed;
+        try {
+            claimed = refill_(want);
+        } catch (const std::exception& e) {
+            std::cerr << "[WorkQueue] Refill exception: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "[WorkQueue] Refill unknown exception" << std::endl;
+        }
+
+        lock.lock();
+        refilling_ = false;
+        exhausted_ = claimed.size() < want;
+
+        // Keep claimed rows even when stopping so stop() can hand them back
+        for (auto& record : claimed) {
+            items_.push_back(std::move(record));
+        }
+        if (!claimed.empty()) {
+            items_cv_.notify_all();
+        }
+    }
+}
+
+} // namespace efgrabber
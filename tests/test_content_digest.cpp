@@ -0,0 +1,79 @@
+#include "efgrabber/content_digest.h"
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <string>
+
+using namespace efgrabber;
+
+static std::string digest_of(const std::string& data) {
+    Sha256 sha;
+    sha.update(data.data(), data.size());
+    return Sha256::hex(sha.finish());
+}
+
+// Same data fed in uneven pieces, so block boundaries fall mid-update
+static std::string digest_in_pieces(const std::string& data, size_t piece) {
+    Sha256 sha;
+    for (size_t offset = 0; offset < data.size(); offset += piece) {
+        sha.update(data.data() + offset, std::min(piece, data.size() - offset));
+    }
+    return Sha256::hex(sha.finish());
+}
+
+void test_standard_vectors() {
+    assert(digest_of("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assert(digest_of("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assert(digest_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    std::string million(1000000, 'a');
+    assert(digest_of(million) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    assert(digest_in_pieces(million, 1000) == digest_of(million));
+
+    std::cout << "test_standard_vectors passed!" << std::endl;
+}
+
+void test_padding_boundaries() {
+    // 55 bytes is the longest message whose length fits in its last block,
+    // 56 forces an extra block and 64 fills one exactly
+    assert(digest_of(std::string(55, 'a')) == "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318");
+    assert(digest_of(std::string(56, 'a')) == "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a");
+    assert(digest_of(std::string(64, 'a')) == "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb");
+
+    for (size_t length : {55, 56, 63, 64, 65, 119, 120, 128}) {
+        std::string data(length, 'x');
+        for (size_t piece : {1, 7, 64}) {
+            assert(digest_in_pieces(data, piece) == digest_of(data));
+        }
+    }
+
+    std::cout << "test_padding_boundaries passed!" << std::endl;
+}
+
+void test_reset() {
+    Sha256 sha;
+    sha.update("junk", 4);
+    sha.finish();
+    sha.reset();
+    sha.update("abc", 3);
+    assert(Sha256::hex(sha.finish()) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    std::cout << "test_reset passed!" << std::endl;
+}
+
+int main() {
+    try {
+        test_standard_vectors();
+        test_padding_boundaries();
+        test_reset();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+    return 0;
+}
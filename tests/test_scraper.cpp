@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cassert>
 #include <vector>
+#include <algorithm>
 
 using namespace efgrabber;
 
@@ -76,11 +77,114 @@ void test_duplicate_removal() {
     std::cout << "test_duplicate_removal passed!" << std::endl;
 }
 
+void test_attribute_syntax() {
+    DataSetConfig config = get_data_set_config(1);
+    Scraper scraper(config);
+
+    // Case, whitespace around '=', single quotes and an upper-case extension
+    std::string html = "<A HREF = 'https://www.justice.gov/epstein/files/DataSet%201/EFTA00000001.PDF'>a</A>"
+                       "<a href=\n\"/epstein/files/dataset 1/EFTA00000002.pdf\">b</a>"
+                       "<a href=\"/epstein/files/DataSet%2011/EFTA00000003.pdf\">other set</a>"
+                       "<a href=\"/epstein/files/DataSet%201/EFTA00000004.pdf?download=1\">query</a>"
+                       "<a href=\"/epstein/files/DataSet%201/EFTA00000005.pdf";  // Unterminated
+    auto links = scraper.extract_pdf_links(html);
+    assert(links.size() == 2);
+    assert(links[0].file_id == "EFTA00000001");
+    assert(links[0].url == "https://www.justice.gov/epstein/files/DataSet%201/EFTA00000001.PDF");
+    assert(links[1].file_id == "EFTA00000002");
+    assert(links[1].url == "https://www.justice.gov/epstein/files/dataset 1/EFTA00000002.pdf");
+
+    std::cout << "test_attribute_syntax passed!" << std::endl;
+}
+
+void test_file_id_helpers() {
+    DataSetConfig config = get_data_set_config(11);
+    Scraper scraper(config);
+
+    assert(scraper.extract_file_id("/files/DataSet%2011/EFTA02205655.pdf") == "EFTA02205655");
+    assert(scraper.extract_file_id("EFTA123.pdf EFTA02205655") == "EFTA02205655");
+    assert(scraper.extract_file_id("efta02205655.pdf").empty());
+    assert(scraper.parse_file_id_number("EFTA02205655") == 2205655);
+    assert(scraper.parse_file_id_number("EFTA0220565") == 0);
+    assert(scraper.is_valid_file_id("EFTA02205655"));
+    assert(!scraper.is_valid_file_id("EFTA022056550"));
+    assert(!scraper.is_valid_file_id("XEFTA02205655"));
+    assert(scraper.format_file_id(2205655) == "EFTA02205655");
+
+    std::cout << "test_file_id_helpers passed!" << std::endl;
+}
+
+void test_streaming_scanner() {
+    DataSetConfig config = get_data_set_config(11);
+    Scraper scraper(config);
+
+    std::string html = "<a href=\"/epstein/files/DataSet%2011/EFTA02205655.pdf\">1</a>"
+                       "<a data=\"x=y\" HREF \n= 'https://www.justice.gov/epstein/files/DataSet 11/EFTA02205656.pdf'>2</a>"
+                       "<a href=\"/epstein/files/DataSet%2012/EFTA02730265.pdf\">other set</a>"
+                       "<a href=\"/epstein/files/DataSet%2011/EFTA02205655.pdf\">duplicate</a>"
+                       "<a href=\"epstein/files/DataSet%2011/EFTA02205657.pdf\">3</a>";
+    auto expected = scraper.extract_pdf_links(html);
+    assert(expected.size() == 3);
+
+    // Every chunk size must give the same links, however the hrefs are split
+    for (size_t chunk = 1; chunk <= html.size(); ++chunk) {
+        std::vector<PdfLink> links;
+        LinkScanner scanner(scraper, [&](PdfLink&& link) { links.push_back(std::move(link)); });
+        for (size_t pos = 0; pos < html.size(); pos += chunk) {
+            scanner.feed(html.data() + pos, std::min(chunk, html.size() - pos));
+        }
+        scanner.finish();
+
+        assert(links.size() == expected.size());
+        assert(scanner.links_found() == expected.size());
+        assert(links[0].file_id == "EFTA02205655");
+        assert(links[1].url == "https://www.justice.gov/epstein/files/DataSet 11/EFTA02205656.pdf");
+        assert(links[2].url == "https://www.justice.gov/epstein/files/DataSet%2011/EFTA02205657.pdf");
+    }
+
+    std::cout << "test_streaming_scanner passed!" << std::endl;
+}
+
+void test_links_hash() {
+    DataSetConfig config = get_data_set_config(11);
+    Scraper scraper(config);
+
+    auto hash_of = [&](const std::string& html, size_t chunk) {
+        LinkScanner scanner(scraper, [](PdfLink&&) {});
+        for (size_t pos = 0; pos < html.size(); pos += chunk) {
+            scanner.feed(html.data() + pos, std::min(chunk, html.size() - pos));
+        }
+        scanner.finish();
+        return scanner.links_hash();
+    };
+
+    std::string links = "<a href=\"/epstein/files/DataSet%2011/EFTA02205655.pdf\">1</a>"
+                        "<a href=\"/epstein/files/DataSet%2011/EFTA02205656.pdf\">2</a>";
+    uint64_t base = hash_of(links, links.size());
+
+    // Markup around the links (tokens, timestamps) and chunking do not matter
+    assert(hash_of("<input name=\"form_token\" value=\"a1\">" + links, 7) == base);
+    assert(hash_of(links + "<footer>Generated 12:00:01</footer>", 1) == base);
+    // A new link does, and so does the order of the existing ones
+    assert(hash_of(links + "<a href=\"/epstein/files/DataSet%2011/EFTA02205657.pdf\">3</a>",
+                   links.size()) != base);
+    assert(hash_of("<a href=\"/epstein/files/DataSet%2011/EFTA02205656.pdf\">2</a>"
+                   "<a href=\"/epstein/files/DataSet%2011/EFTA02205655.pdf\">1</a>", 64) != base);
+    // An empty page still has a (non-zero) hash, so it can be revalidated too
+    assert(hash_of("<html>No results</html>", 5) != 0);
+
+    std::cout << "test_links_hash passed!" << std::endl;
+}
+
 int main() {
     try {
         test_relative_url_resolution();
         test_dataset_filtering();
         test_duplicate_removal();
+        test_attribute_syntax();
+        test_file_id_helpers();
+        test_streaming_scanner();
+        test_links_hash();
         std::cout << "All tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Test failed with exception: " << e.what() << std::endl;
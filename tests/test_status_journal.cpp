@@ -0,0 +1,156 @@
+#include "efgrabber/status_journal.h"
+#include "efgrabber/database.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace efgrabber;
+namespace fs = std::filesystem;
+
+static std::string temp_db_path(const char* name) {
+    fs::path path = fs::temp_directory_path() / (std::string(name) + "-" + std::to_string(::getpid()) + ".db");
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        fs::remove(path.string() + suffix);
+    }
+    return path.string();
+}
+
+static std::vector<int64_t> add_rows(Database& db, int count) {
+    std::vector<FileRecord> records;
+    for (int i = 0; i < count; ++i) {
+        FileRecord record{};
+        record.data_set = 11;
+        record.file_id = "EFTA0220" + std::to_string(5600 + i);
+        record.url = "https://www.justice.gov/epstein/files/DataSet%2011/" + record.file_id + ".pdf";
+        record.local_path = "/tmp/" + record.file_id + ".pdf";
+        record.status = DownloadStatus::PENDING;
+        records.push_back(record);
+    }
+    bool added = db.add_files_batch(records);
+    assert(added);
+
+    std::vector<int64_t> ids;
+    for (const auto& record : records) {
+        auto row = db.get_file_by_file_id(record.file_id, record.data_set);
+        assert(row);
+        ids.push_back(row->id);
+    }
+    return ids;
+}
+
+static StatusUpdate completed(int64_t id) {
+    StatusUpdate update;
+    update.id = id;
+    update.status = DownloadStatus::COMPLETED;
+    update.file_size = 1000;
+    return update;
+}
+
+static bool all_completed(Database& db, const std::vector<int64_t>& ids) {
+    for (int64_t id : ids) {
+        auto row = db.get_file(id);
+        if (!row || row->status != DownloadStatus::COMPLETED) return false;
+    }
+    return true;
+}
+
+// A second connection holding the write lock makes apply_status_updates() fail
+struct WriteLock {
+    sqlite3* db = nullptr;
+
+    explicit WriteLock(const std::string& path) {
+        int rc = sqlite3_open(path.c_str(), &db);
+        if (rc == SQLITE_OK) rc = sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr);
+        assert(rc == SQLITE_OK);
+        (void)rc;
+    }
+    void release() {
+        if (!db) return;
+        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+        db = nullptr;
+    }
+    ~WriteLock() { release(); }
+};
+
+void test_failed_flush_is_retried() {
+    std::string path = temp_db_path("test_status_journal");
+    Database db(path);
+    bool initialized = db.initialize();
+    assert(initialized);
+    auto ids = add_rows(db, 3);
+
+    // An interval long enough that only the explicit flushes below run
+    StatusJournal journal(db, std::chrono::hours(1));
+    WriteLock lock(path);
+
+    journal.push(completed(ids[0]));
+    journal.push(completed(ids[1]));
+    bool flushed = journal.flush();
+    assert(!flushed);
+    assert(journal.pending() == 2);
+    assert(journal.flushed_total() == 0);
+
+    // The kept batch goes out with what was pushed since
+    journal.push(completed(ids[2]));
+    assert(journal.pending() == 3);
+    lock.release();
+    flushed = journal.flush();
+    assert(flushed);
+    assert(journal.pending() == 0);
+    assert(journal.flushed_total() == 3);
+    assert(all_completed(db, ids));
+
+    std::cout << "test_failed_flush_is_retried passed!" << std::endl;
+}
+
+void test_flusher_retries_in_background() {
+    std::string path = temp_db_path("test_status_journal_bg");
+    Database db(path);
+    bool initialized = db.initialize();
+    assert(initialized);
+    auto ids = add_rows(db, 4);
+
+    StatusJournal journal(db, std::chrono::milliseconds(5));
+    WriteLock lock(path);
+    for (int64_t id : ids) {
+        journal.push(completed(id));
+    }
+
+    // Several failed attempts, then the lock goes away and the backoff retry lands
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(journal.flushed_total() == 0);
+    assert(journal.pending() == ids.size());
+    lock.release();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(STATUS_RETRY_MAX_MS / 1000 + 5);
+    while (journal.flushed_total() < static_cast<int64_t>(ids.size()) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(journal.flushed_total() == static_cast<int64_t>(ids.size()));
+    assert(all_completed(db, ids));
+
+    std::cout << "test_flusher_retries_in_background passed!" << std::endl;
+}
+
+int main() {
+    try {
+        test_failed_flush_is_retried();
+        test_flusher_retries_in_background();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Test failed with unknown exception" << std::endl;
+        return 1;
+    }
+    return 0;
+}